@@ -171,6 +171,15 @@
 
 #endif // _MSC_VER
 
+//
+// Disable the AddressSanitizer check of a function, for the page safe over-reads.
+//
+#if defined(__clang__) || (defined(__GNUC__) && (__GNUC__ >= 5))
+#define JSTD_NO_SANITIZE_ADDRESS    __attribute__((no_sanitize_address))
+#else
+#define JSTD_NO_SANITIZE_ADDRESS
+#endif
+
 //
 // Aligned prefix and suffix declare
 //
@@ -23,6 +23,7 @@
 #include <vector>
 #include <type_traits>
 #include <utility>
+#include <tuple>        // For std::forward_as_tuple()
 #include <algorithm>    // For std::max(), std::min()
 
 #include "jstd/allocator.h"
@@ -425,11 +426,181 @@ public:
 
     typedef std::pair<iterator, bool>   insert_return_type;
 
+    //
+    // The node handle of extract(key).
+    //
+    // The extracted entry is unlinked from the buckets, but it stays pinned in
+    // the entries of the source dictionary, so the value isn't moved until it's
+    // inserted to another dictionary (moved once) or to the source dictionary
+    // (relinked, not moved). The node also keeps the hash code, so that
+    // insert(node_handle &&) don't need to rehash the key, unless the key may
+    // be changed by the mutable key().
+    //
+    // Before the source dictionary reallocates, destroys or reuses the pinned
+    // entries, the value is moved into the node's own storage. It invalidates
+    // the references returned by key() and mapped().
+    //
+    class node_handle {
+    public:
+        typedef Key             key_type;
+        typedef Value           mapped_type;
+        typedef Allocator       allocator_type;
+
+    private:
+        typedef typename std::aligned_storage<sizeof(nc_value_type),
+                                              std::alignment_of<nc_value_type>::value>::type
+                                storage_type;
+
+        BasicDictionary *   owner_;
+        entry_type *        entry_;
+        node_handle *       prev_;
+        node_handle *       next_;
+        storage_type        storage_;
+        hash_code_t         hash_code_;
+        bool                has_value_;
+        mutable bool        key_changed_;
+
+        friend class BasicDictionary<Key, Value, HashFunc, Alignment, Hasher, KeyEqual, Allocator>;
+
+        node_handle(BasicDictionary * owner, entry_type * entry)
+            : owner_(owner), entry_(entry), prev_(nullptr), next_(nullptr),
+              hash_code_(entry->hash_code), has_value_(true), key_changed_(false) {
+            owner->pin_node(this);
+        }
+
+        nc_value_type * value_ptr() {
+            if (likely(this->owner_ != nullptr))
+                return reinterpret_cast<nc_value_type *>(&this->entry_->value);
+            else
+                return reinterpret_cast<nc_value_type *>(&this->storage_);
+        }
+
+        const nc_value_type * value_ptr() const {
+            if (likely(this->owner_ != nullptr))
+                return reinterpret_cast<const nc_value_type *>(&this->entry_->value);
+            else
+                return reinterpret_cast<const nc_value_type *>(&this->storage_);
+        }
+
+    public:
+        node_handle() noexcept
+            : owner_(nullptr), entry_(nullptr), prev_(nullptr), next_(nullptr),
+              hash_code_(0), has_value_(false), key_changed_(false) {}
+
+        node_handle(node_handle && other)
+            : owner_(nullptr), entry_(nullptr), prev_(nullptr), next_(nullptr),
+              hash_code_(0), has_value_(false), key_changed_(false) {
+            this->take(other);
+        }
+
+        node_handle(const node_handle & other) = delete;
+
+        ~node_handle() {
+            this->reset();
+        }
+
+        node_handle & operator = (node_handle && other) {
+            if (&other != this) {
+                this->reset();
+                this->take(other);
+            }
+            return *this;
+        }
+
+        node_handle & operator = (const node_handle & other) = delete;
+
+        bool empty() const noexcept { return !this->has_value_; }
+        explicit operator bool () const noexcept { return this->has_value_; }
+
+        // The key may be changed by the caller, so the stored hash code is stale.
+        key_type & key() const {
+            assert(this->has_value_);
+            this->key_changed_ = true;
+            return const_cast<nc_value_type *>(this->value_ptr())->first;
+        }
+
+        mapped_type & mapped() const {
+            assert(this->has_value_);
+            return const_cast<nc_value_type *>(this->value_ptr())->second;
+        }
+
+        hash_code_t hash_code() const { return this->hash_code_; }
+
+        void swap(node_handle & other) {
+            node_handle tmp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
+
+    private:
+        void take(node_handle & other) {
+            assert(!this->has_value_);
+            if (other.has_value_) {
+                if (likely(other.owner_ != nullptr)) {
+                    // Take over the pinned entry, the value is not moved.
+                    this->owner_ = other.owner_;
+                    this->entry_ = other.entry_;
+                    this->owner_->repin_node(&other, this);
+                    other.owner_ = nullptr;
+                    other.entry_ = nullptr;
+                }
+                else {
+                    new (&this->storage_) nc_value_type(std::move(*other.value_ptr()));
+                    other.value_ptr()->~nc_value_type();
+                }
+                this->hash_code_ = other.hash_code_;
+                this->key_changed_ = other.key_changed_;
+                this->has_value_ = true;
+                other.has_value_ = false;
+                other.key_changed_ = false;
+            }
+        }
+
+        // Move the value into the node's own storage and release the pinned entry.
+        void unpin() {
+            assert(this->has_value_);
+            assert(this->owner_ != nullptr);
+            BasicDictionary * owner = this->owner_;
+            nc_value_type * n_value = this->value_ptr();
+            new (&this->storage_) nc_value_type(std::move(*n_value));
+            owner->release_node(this);
+            this->owner_ = nullptr;
+            this->entry_ = nullptr;
+        }
+
+        void reset() {
+            if (this->has_value_) {
+                if (likely(this->owner_ != nullptr)) {
+                    // Use lazy destroy, the value is destroyed when the entry is reused.
+                    this->owner_->release_node(this);
+                    this->owner_ = nullptr;
+                    this->entry_ = nullptr;
+                }
+                else {
+                    this->value_ptr()->~nc_value_type();
+                }
+                this->has_value_ = false;
+                this->key_changed_ = false;
+            }
+        }
+    };
+
+    struct node_insert_return_type {
+        iterator    position;
+        bool        inserted;
+        node_handle   node;
+
+        node_insert_return_type(const iterator & position, bool inserted, node_handle && node)
+            : position(position), inserted(inserted), node(std::move(node)) {}
+    };
+
     typedef free_list<entry_type>       free_list_t;
     typedef hash_entry_chunk_list<entry_type, allocator_type, entry_allocator_type>
                                         entry_chunk_list_t;
     typedef typename entry_chunk_list_t::entry_chunk_t
                                         entry_chunk_t;
+    typedef typename entry_chunk_list_t::recycler_type
+                                        chunk_recycler_type;
 
 private:
     entry_type **           buckets_;
@@ -447,6 +618,7 @@ private:
     mutable
     entry_chunk_list_t      chunk_list_;
     float                   load_factor_;
+    node_handle *           pinned_;
 
     hasher_type             hasher_;
     key_equal               key_equal_;
@@ -469,7 +641,21 @@ public:
           version_(1),  /* Since 0 means that the version attribute is not supported,
                            the initial value of version starts from 1. */
 #endif
-          load_factor_(kDefaultLoadFactor) {
+          load_factor_(kDefaultLoadFactor), pinned_(nullptr) {
+        this->init(initialCapacity);
+    }
+
+    BasicDictionary(size_type initialCapacity, const hasher & hash,
+                    const key_equal & equal = key_equal())
+        : buckets_(nullptr), entries_(nullptr),
+          bucket_mask_(0), bucket_capacity_(0),
+          entry_size_(0), entry_capacity_(0), entry_threshold_(0),
+#if DICTIONARY_SUPPORT_VERSION
+          version_(1),  /* Since 0 means that the version attribute is not supported,
+                           the initial value of version starts from 1. */
+#endif
+          load_factor_(kDefaultLoadFactor), pinned_(nullptr),
+          hasher_(hash), key_equal_(equal) {
         this->init(initialCapacity);
     }
 
@@ -481,7 +667,7 @@ public:
           version_(1),  /* Since 0 means that the version attribute is not supported,
                            the initial value of version starts from 1. */
 #endif
-          load_factor_(kDefaultLoadFactor) {
+          load_factor_(kDefaultLoadFactor), pinned_(nullptr) {
         size_type initialSize = other.size();
         this->init(initialSize);
 
@@ -498,7 +684,7 @@ public:
           version_(1),  /* Since 0 means that the version attribute is not supported,
                            the initial value of version starts from 1. */
 #endif
-          load_factor_(kDefaultLoadFactor) {
+          load_factor_(kDefaultLoadFactor), pinned_(nullptr) {
         this->swap(other);
     }
 
@@ -550,6 +736,9 @@ public:
         return const_local_iterator(this, nullptr);
     }
 
+    hasher hash_function() const { return this->hasher_; }
+    key_equal key_eq() const { return this->key_equal_; }
+
     bool valid() const { return (this->buckets() != nullptr); }
     bool empty() const { return (this->size() == 0); }
     bool full() const  { return (this->size() == this->entry_count()); }
@@ -581,6 +770,12 @@ public:
     size_type max_chunk_bytes() const { return kMaxEntryChunkBytes; }
     size_type actual_chunk_bytes() const { return (kMaxEntryChunkSize * sizeof(entry_type)); }
 
+    // The entry chunk cache shared by all the instances of this dictionary type,
+    // it's disabled by default, use chunk_recycler().set_max_bytes(n) to enable it.
+    static chunk_recycler_type & chunk_recycler() {
+        return chunk_recycler_type::instance();
+    }
+
     float load_factor() const {
         return (static_cast<float>(this->size()) / this->bucket_count());
     }
@@ -689,12 +884,12 @@ public:
     }
 
     size_type count(const key_type & key) const {
-        entry_type * entry = this->find_entry(key);
+        const entry_type * entry = this->find_entry(key);
         return (entry != nullptr) ? 1 : 0;
     }
 
     bool contains(const key_type & key) const {
-        entry_type * entry = this->find_entry(key);
+        const entry_type * entry = this->find_entry(key);
         return (entry != nullptr);
     }
 
@@ -748,8 +943,8 @@ public:
 
     const_iterator find(const key_type & key) const {
         if (likely(this->buckets() != nullptr)) {
-            entry_type * entry = this->find_entry(key);
-            return const_iterator(this, entry);
+            const entry_type * entry = this->find_entry(key);
+            return const_iterator(this, const_cast<entry_type *>(entry));
         }
 
         return const_iterator(this, nullptr);
@@ -841,10 +1036,149 @@ public:
             std::forward<Args>(args)...);
     }
 
+    //
+    // try_emplace(key, args...)
+    //
+    // If the key is not exists, construct the mapped value from args in place,
+    // otherwise nothing is constructed. The key is hashed and probed only once.
+    //
+    template <typename ...Args>
+    insert_return_type try_emplace(const key_type & key, Args && ... args) {
+        return this->try_emplace_args_impl(key, std::forward<Args>(args)...);
+    }
+
+    template <typename ...Args>
+    insert_return_type try_emplace(key_type && key, Args && ... args) {
+        return this->try_emplace_args_impl(std::forward<key_type>(key), std::forward<Args>(args)...);
+    }
+
+    //
+    // upsert(key, init, combine)
+    //
+    // If the key is not exists, insert (key, init), otherwise call
+    // combine(mapped_value, init) to update the mapped value in place.
+    // The key is hashed and probed only once, it's used to aggregate.
+    //
+    template <typename Combine>
+    insert_return_type upsert(const key_type & key, const mapped_type & init, Combine && combine) {
+        return this->upsert_impl<insert_return_type>(key, init, std::forward<Combine>(combine));
+    }
+
+    template <typename Combine>
+    void upsert_no_return(const key_type & key, const mapped_type & init, Combine && combine) {
+        this->upsert_impl<void_wrapper>(key, init, std::forward<Combine>(combine));
+    }
+
     size_type erase(const key_type & key) {
         return this->erase_key(key);
     }
 
+    //
+    // extract(key)
+    //
+    // Unlink the entry and pin it to a node handle, the value is not moved,
+    // the node keeps the hash code, so insert(node_handle &&) don't rehash the key.
+    //
+    node_handle extract(const key_type & key) {
+        return this->extract_key(key);
+    }
+
+    node_handle extract(const_iterator pos) {
+        return this->extract_entry(const_cast<entry_type *>(pos.node()));
+    }
+
+    //
+    // insert(node_handle &&)
+    //
+    node_insert_return_type insert(node_handle && node) {
+        if (unlikely(node.empty())) {
+            return node_insert_return_type(this->end(), false, node_handle());
+        }
+
+        // Reuse the stored hash code, rehash only if key() was called.
+        const key_type & key = node.value_ptr()->first;
+        if (unlikely(node.key_changed_)) {
+            node.hash_code_ = this->get_hash(key);
+            node.key_changed_ = false;
+        }
+        hash_code_t hash_code = node.hash_code_;
+        index_type index = this->index_for(hash_code);
+
+        entry_type * entry = this->find_entry(key, hash_code, index);
+        if (likely(entry == nullptr)) {
+            if (likely(node.owner_ != this)) {
+                // Move the value from the pinned entry or the node storage, only once.
+                entry = this->insert_new_entry(hash_code, index, std::move(*node.value_ptr()));
+                node.reset();
+            }
+            else {
+                // The entry is pinned in this dictionary, relink it.
+                entry = node.entry_;
+                this->unlink_node(&node);
+                node.owner_ = nullptr;
+                node.entry_ = nullptr;
+                node.has_value_ = false;
+                node.key_changed_ = false;
+
+                entry->attrib.setInUseEntry();
+                this->insert_to_bucket(entry, hash_code, index);
+                this->entry_size_++;
+            }
+            this->update_version();
+            return node_insert_return_type(iterator(this, entry), true, node_handle());
+        }
+        else {
+            return node_insert_return_type(iterator(this, entry), false, std::move(node));
+        }
+    }
+
+    //
+    // merge(other)
+    //
+    // Move the entries whose key don't exist in this dictionary from other,
+    // the stored hash code is reused and the value is moved only once,
+    // the entries that already exist are left in other.
+    //
+    void merge(this_type & other) {
+        if (&other == this || other.entry_size_ == 0)
+            return;
+
+        size_type bucket_capacity = other.bucket_capacity_;
+        for (size_type i = 0; i < bucket_capacity; i++) {
+            entry_type * prev = nullptr;
+            entry_type * entry = other.buckets_[i];
+            while (entry != nullptr) {
+                entry_type * next = entry->next;
+                hash_code_t hash_code = entry->hash_code;
+                index_type index = this->index_for(hash_code);
+                if (likely(this->find_entry(entry->value.first, hash_code, index) == nullptr)) {
+                    nc_value_type * n_value = reinterpret_cast<nc_value_type *>(&entry->value);
+                    this->insert_new_entry(hash_code, index, std::move(*n_value));
+
+                    if (likely(prev != nullptr))
+                        prev->next = next;
+                    else
+                        other.buckets_[i] = next;
+
+                    // Use lazy destroy
+                    other.destroy_entry(entry);
+                    other.entry_size_--;
+                }
+                else {
+                    prev = entry;
+                }
+                entry = next;
+            }
+        }
+
+        this->update_version();
+        other.update_version();
+    }
+
+    void merge(this_type && other) {
+        this->merge(other);
+    }
+
     void swap(this_type & other) {
         if (&other != this) {
             using std::swap;
@@ -863,6 +1197,11 @@ public:
 
             this->freelist_.swap(other.freelist_);
             this->chunk_list_.swap(other.chunk_list_);
+
+            // The pinned entries are swapped with the chunk lists.
+            swap(this->pinned_, other.pinned_);
+            this->retarget_nodes();
+            other.retarget_nodes();
         }
     }
 
@@ -949,6 +1288,8 @@ private:
     }
 
     void destroy() {
+        this->unpin_nodes();
+
         // Destroy the resources.
         this->destory_resources();
 
@@ -1048,6 +1389,16 @@ private:
 
 #if USE_CHUNKLIST_ITERATOR
 
+    // The erased entries stay in place (reusable), so the scanning must reach the
+    // high-water mark of the chunk, not the count of entries in use. All chunks
+    // are full except the last one.
+    entry_type * chunk_entries_end(size_type chunk_index, const entry_chunk_t & chunk) const {
+        if (chunk_index == this->chunk_list_.lastChunkId())
+            return (chunk.entries + this->chunk_list_.lastChunkSize());
+        else
+            return (chunk.entries + chunk.capacity);
+    }
+
     entry_type * find_first_valid_entry() const {
         entry_type * first_entry = nullptr;
         entry_type * last_entry;
@@ -1059,7 +1410,7 @@ private:
             const entry_chunk_t & cur_chunk = this->chunk_list_[chunk_index];
             if (cur_chunk.entries != nullptr) {
                 first_entry = cur_chunk.entries;
-                last_entry = cur_chunk.entries + cur_chunk.size;
+                last_entry = this->chunk_entries_end(chunk_index, cur_chunk);
                 while (first_entry < last_entry) {
                     // Find first of in use entry.
                     if (likely(!first_entry->attrib.isInUseEntry()))
@@ -1071,7 +1422,7 @@ private:
             chunk_index++;
         }
 
-        return first_entry;
+        return nullptr;
     }
 
     entry_type * next_link_entry(entry_type * entry) const {
@@ -1084,7 +1435,7 @@ private:
         assert(cur_chunk.entries != nullptr);
 
         entry_type * next_entry = ++entry;
-        entry_type * last_entry = cur_chunk.entries + cur_chunk.size;
+        entry_type * last_entry = this->chunk_entries_end(chunk_index, cur_chunk);
         assert(next_entry >= cur_chunk.entries);
 
         while (next_entry < last_entry) {
@@ -1103,7 +1454,7 @@ private:
             const entry_chunk_t & cur_chunk2 = this->chunk_list_[chunk_index];
             if (cur_chunk2.entries != nullptr) {
                 next_entry = cur_chunk2.entries;
-                last_entry = cur_chunk2.entries + cur_chunk2.size;
+                last_entry = this->chunk_entries_end(chunk_index, cur_chunk2);
                 while (next_entry < last_entry) {
                     // Find first of in use entry.
                     if (likely(!next_entry->attrib.isInUseEntry()))
@@ -1115,7 +1466,7 @@ private:
             chunk_index++;
         }
 
-        return next_entry;
+        return nullptr;
     }
 
     const entry_type * next_const_link_entry(const entry_type * centry) {
@@ -1136,7 +1487,7 @@ private:
             const entry_chunk_t & cur_chunk = this->chunk_list_[chunk_index];
             if (cur_chunk.entries != nullptr) {
                 first_entry = cur_chunk.entries + entry_index;
-                last_entry = cur_chunk.entries + cur_chunk.size;
+                last_entry = this->chunk_entries_end(chunk_index, cur_chunk);
                 while (first_entry < last_entry) {
                     // Find first of in use entry.
                     if (likely(!first_entry->attrib.isInUseEntry()))
@@ -1149,7 +1500,7 @@ private:
             chunk_index++;
         }
 
-        return first_entry;
+        return nullptr;
     }
 
 #else
@@ -1282,7 +1633,7 @@ private:
             this->bucket_capacity_ = bucket_capacity;
 
             // The array of entries.
-            entry_type * new_entries = entry_allocator_.allocate(entry_capacity);
+            entry_type * new_entries = this->chunk_list_.allocateChunk(entry_capacity);
             //if (likely(entry_allocator_.is_ok(new_entries)))
             {
                 this->entries_ = new_entries;
@@ -1543,7 +1894,7 @@ private:
         // don't need to inflate.
         size_type actual_entry_capacity = this->entry_size_ + new_chunk_capacity;
         if (likely(actual_entry_capacity > this->entry_capacity_)) {
-            entry_type * new_entries = entry_allocator_.allocate(new_chunk_capacity);
+            entry_type * new_entries = this->chunk_list_.allocateChunk(new_chunk_capacity);
             //if (likely(entry_allocator_.is_ok(new_entries)))
             {
                 // Needn't change the entry_size_.
@@ -1869,8 +2220,17 @@ private:
     entry_type * got_prepare_entry() {
         if (unlikely(this->freelist_.is_empty())) {
             if (likely(this->chunk_list_.lastChunk().is_full())) {
-                // Inflate the entry size for 1.
-                this->inflate_entries(1);
+                if (likely(this->pinned_ == nullptr)) {
+                    // Inflate the entry size for 1.
+                    this->inflate_entries(1);
+                }
+                else {
+                    // Reuse the entries pinned by the node handles.
+                    this->unpin_nodes();
+                    entry_type * free_entry = this->freelist_.pop_front();
+                    this->chunk_list_.appendFreeEntry(free_entry);
+                    return free_entry;
+                }
             }
 
             // Get a unused entry.
@@ -1895,11 +2255,20 @@ private:
     entry_type * got_free_entry(hash_code_t hash_code, index_type & index) {
         if (unlikely(this->freelist_.is_empty())) {
             if (likely(this->chunk_list_.lastChunk().is_full())) {
-                // Inflate the entry size for 1.
-                this->inflate_entries(1);
+                if (likely(this->pinned_ == nullptr)) {
+                    // Inflate the entry size for 1.
+                    this->inflate_entries(1);
 
-                // Recalculate the bucket index.
-                index = this->index_for(hash_code);
+                    // Recalculate the bucket index.
+                    index = this->index_for(hash_code);
+                }
+                else {
+                    // Reuse the entries pinned by the node handles.
+                    this->unpin_nodes();
+                    entry_type * free_entry = this->freelist_.pop_front();
+                    this->chunk_list_.appendFreeEntry(free_entry);
+                    return free_entry;
+                }
             }
 
             // Get a unused entry.
@@ -2014,7 +2383,7 @@ private:
 #if USE_FAST_FIND_ENTRY
 
     JSTD_FORCED_INLINE
-    entry_type * find_entry(const key_type & key) {
+    const entry_type * find_entry(const key_type & key) const {
         hash_code_t hash_code = this->get_hash(key);
         index_type index = this->index_for(hash_code);
 
@@ -2043,7 +2412,7 @@ private:
     }
 
     JSTD_FORCED_INLINE
-    entry_type * find_entry(const key_type & key, hash_code_t hash_code, index_type index) {
+    const entry_type * find_entry(const key_type & key, hash_code_t hash_code, index_type index) const {
         assert(this->buckets() != nullptr);
         entry_type * first = this->buckets_[index];
         if (likely(first != nullptr)) {
@@ -2072,7 +2441,7 @@ private:
 #else // !USE_FAST_FIND_ENTRY
 
     JSTD_FORCED_INLINE
-    entry_type * find_entry(const key_type & key) {
+    const entry_type * find_entry(const key_type & key) const {
         hash_code_t hash_code = this->get_hash(key);
         index_type index = this->index_for(hash_code);
 
@@ -2093,7 +2462,7 @@ private:
     }
 
     JSTD_FORCED_INLINE
-    entry_type * find_entry(const key_type & key, hash_code_t hash_code, index_type index) {
+    const entry_type * find_entry(const key_type & key, hash_code_t hash_code, index_type index) const {
         assert(this->buckets() != nullptr);
         entry_type * entry = this->buckets_[index];
         while (entry != nullptr) {
@@ -2113,6 +2482,18 @@ private:
 
 #endif // USE_FAST_FIND_ENTRY
 
+    JSTD_FORCED_INLINE
+    entry_type * find_entry(const key_type & key) {
+        const this_type * const_this = this;
+        return const_cast<entry_type *>(const_this->find_entry(key));
+    }
+
+    JSTD_FORCED_INLINE
+    entry_type * find_entry(const key_type & key, hash_code_t hash_code, index_type index) {
+        const this_type * const_this = this;
+        return const_cast<entry_type *>(const_this->find_entry(key, hash_code, index));
+    }
+
     JSTD_FORCED_INLINE
     entry_type * find_before(const key_type & key, entry_type *& before, size_type & index) {
         hash_code_t hash_code = this->get_hash(key);
@@ -2373,6 +2754,54 @@ private:
         return ReturnType(iterator(this, entry), inserted);
     }
 
+    template <typename ReturnType, typename Combine>
+    JSTD_FORCED_INLINE
+    ReturnType upsert_impl(const key_type & key, const mapped_type & init, Combine && combine) {
+        assert(this->buckets() != nullptr);
+        bool inserted;
+
+        hash_code_t hash_code = this->get_hash(key);
+        index_type index = this->index_for(hash_code);
+
+        entry_type * entry = this->find_entry(key, hash_code, index);
+        if (entry == nullptr) {
+            entry = this->insert_new_entry(key, init, hash_code, index);
+            inserted = true;
+        }
+        else {
+            combine(entry->value.second, init);
+            inserted = false;
+        }
+
+        this->update_version();
+
+        return ReturnType(iterator(this, entry), inserted);
+    }
+
+    template <typename KeyT, typename ...Args>
+    JSTD_FORCED_INLINE
+    insert_return_type try_emplace_args_impl(KeyT && key, Args && ... args) {
+        assert(this->buckets() != nullptr);
+        bool inserted;
+
+        hash_code_t hash_code = this->get_hash(key);
+        index_type index = this->index_for(hash_code);
+
+        entry_type * entry = this->find_entry(key, hash_code, index);
+        if (likely(entry == nullptr)) {
+            entry = this->emplace_new_entry_args(hash_code, index, std::piecewise_construct,
+                                                 std::forward_as_tuple(std::forward<KeyT>(key)),
+                                                 std::forward_as_tuple(std::forward<Args>(args)...));
+            this->update_version();
+            inserted = true;
+        }
+        else {
+            inserted = false;
+        }
+
+        return insert_return_type(iterator(this, entry), inserted);
+    }
+
     JSTD_FORCED_INLINE
     entry_type * try_emplace_impl(const key_type & key) {
         assert(this->buckets() != nullptr);
@@ -2458,6 +2887,119 @@ private:
         return size_type(0);
     }
 
+    node_handle extract_key(const key_type & key) {
+        assert(this->buckets_ != nullptr);
+
+        if (likely(this->entry_size_ != 0)) {
+            hash_code_t hash_code = this->get_hash(key);
+            size_type index = this->index_for(hash_code);
+
+            entry_type * prev = nullptr;
+            entry_type * entry = this->buckets_[index];
+            while (likely(entry != nullptr)) {
+                if (likely(entry->hash_code == hash_code &&
+                           this->key_equal_(key, entry->value.first))) {
+                    return this->pin_entry(entry, prev, index);
+                }
+
+                prev = entry;
+                entry = entry->next;
+            }
+        }
+
+        // Not found
+        return node_handle();
+    }
+
+    node_handle extract_entry(entry_type * target) {
+        assert(this->buckets_ != nullptr);
+        assert(target != nullptr);
+
+        // Use the stored hash code, needn't to rehash the key.
+        size_type index = this->index_for(target->hash_code);
+
+        entry_type * prev = nullptr;
+        entry_type * entry = this->buckets_[index];
+        while (likely(entry != nullptr)) {
+            if (likely(entry == target)) {
+                return this->pin_entry(entry, prev, index);
+            }
+
+            prev = entry;
+            entry = entry->next;
+        }
+
+        // Not found
+        assert(false);
+        return node_handle();
+    }
+
+    node_handle pin_entry(entry_type * entry, entry_type * prev, size_type index) {
+        if (likely(prev != nullptr))
+            prev->next = entry->next;
+        else
+            this->buckets_[index] = entry->next;
+
+        // The entry is skipped by the iterators, but it's not in the freelist
+        // until the node handle releases it.
+        assert(entry->attrib.isInUseEntry());
+        entry->attrib.setReusableEntry();
+        this->entry_size_--;
+
+        this->update_version();
+        return node_handle(this, entry);
+    }
+
+    void pin_node(node_handle * node) {
+        node->prev_ = nullptr;
+        node->next_ = this->pinned_;
+        if (this->pinned_ != nullptr)
+            this->pinned_->prev_ = node;
+        this->pinned_ = node;
+    }
+
+    void repin_node(node_handle * old_node, node_handle * new_node) {
+        new_node->prev_ = old_node->prev_;
+        new_node->next_ = old_node->next_;
+        if (new_node->prev_ != nullptr)
+            new_node->prev_->next_ = new_node;
+        else
+            this->pinned_ = new_node;
+        if (new_node->next_ != nullptr)
+            new_node->next_->prev_ = new_node;
+        old_node->prev_ = nullptr;
+        old_node->next_ = nullptr;
+    }
+
+    void unlink_node(node_handle * node) {
+        if (node->prev_ != nullptr)
+            node->prev_->next_ = node->next_;
+        else
+            this->pinned_ = node->next_;
+        if (node->next_ != nullptr)
+            node->next_->prev_ = node->prev_;
+        node->prev_ = nullptr;
+        node->next_ = nullptr;
+    }
+
+    void release_node(node_handle * node) {
+        this->unlink_node(node);
+        this->destroy_prepare_entry(node->entry_);
+    }
+
+    // Move the values of all the pinned entries into their node handles.
+    void unpin_nodes() {
+        while (this->pinned_ != nullptr) {
+            this->pinned_->unpin();
+        }
+    }
+
+    void retarget_nodes() {
+        for (node_handle * node = this->pinned_; node != nullptr; node = node->next_) {
+            node->owner_ = this;
+        }
+    }
+
     JSTD_FORCED_INLINE
     void update_version() {
 #if DICTIONARY_SUPPORT_VERSION
@@ -2492,7 +3034,7 @@ private:
             entry_type * entries = this->chunk_list_[last_chunk_id].entries;
             size_type   capacity = this->chunk_list_[last_chunk_id].capacity;
             if (entries != nullptr) {
-                this->entry_allocator_.deallocate(entries, capacity);
+                this->chunk_list_.deallocateChunk(entries, capacity);
                 this->chunk_list_[last_chunk_id].set_entries(nullptr);
                 this->chunk_list_[last_chunk_id].set_capacity(0);
 
@@ -2530,7 +3072,7 @@ private:
             entry_type * entries = this->chunk_list_[i].entries;
             size_type   capacity = this->chunk_list_[i].capacity;
             if (entries != nullptr) {
-                this->entry_allocator_.deallocate(entries, capacity);
+                this->chunk_list_.deallocateChunk(entries, capacity);
                 this->chunk_list_[i].set_entries(nullptr);
                 this->chunk_list_[i].set_capacity(0);
             }
@@ -2822,6 +3364,8 @@ private:
     }
 
     void reorder_shrink_to(size_type new_entry_capacity) {
+        this->unpin_nodes();
+
         new_entry_capacity = pow2::round_up(new_entry_capacity);
         new_entry_capacity = (std::max)(new_entry_capacity, kMinimumCapacity);
         assert(this->entry_size_ <= new_entry_capacity);
@@ -2849,7 +3393,7 @@ private:
                     entry_type * entries = this->chunk_list_[i].entries;
                     if (entries != nullptr) {
                         size_type capacity = this->chunk_list_[i].capacity;
-                        this->entry_allocator_.deallocate(entries, capacity);
+                        this->chunk_list_.deallocateChunk(entries, capacity);
                         this->chunk_list_[i].set_entries(nullptr);
                         this->chunk_list_[i].set_capacity(0);
                     }
@@ -3308,6 +3852,8 @@ private:
     }
 
     void realloc_buckets_and_entries(size_type new_entry_capacity, size_type new_bucket_capacity) {
+        this->unpin_nodes();
+
         assert_entry_capacity(new_entry_capacity);
         assert_bucket_capacity(new_bucket_capacity);
         assert(new_bucket_capacity != this->bucket_capacity_);
@@ -3315,7 +3861,7 @@ private:
         entry_type ** new_buckets = bucket_allocator_.allocate(new_bucket_capacity);
         //if (likely(bucket_allocator_.is_ok(new_buckets)))
         {
-            entry_type * new_entries = entry_allocator_.allocate(new_entry_capacity);
+            entry_type * new_entries = this->chunk_list_.allocateChunk(new_entry_capacity);
             //if (likely(entry_allocator_.is_ok(new_entries)))
             if (1)
             {
@@ -3361,9 +3907,11 @@ private:
     }
 
     void realloc_entries(size_type new_entry_capacity) {
+        this->unpin_nodes();
+
         assert_entry_capacity(new_entry_capacity);
 
-        entry_type * new_entries = entry_allocator_.allocate(new_entry_capacity);
+        entry_type * new_entries = this->chunk_list_.allocateChunk(new_entry_capacity);
         //if (likely(entry_allocator_.is_ok(new_entries)))
         {
             if (likely(this->entry_size_ != 0)) {
@@ -0,0 +1,370 @@
+
+#ifndef JSTD_HASH_HASH_AGGREGATOR_H
+#define JSTD_HASH_HASH_AGGREGATOR_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+#include "jstd/basic/stdsize.h"
+
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>      // For std::size_t
+#include <vector>
+#include <thread>       // For std::thread
+
+#include "jstd/hash/dictionary.h"
+
+//
+// The group-by aggregation on the hash maps.
+//
+// An aggregator maps a input value to a partial result by init(value),
+// and combines two partial results by combine(result, partial), so the
+// same combine() is used to add a row and to merge the partial tables.
+//
+namespace jstd {
+
+template <typename T>
+struct CountAggregator {
+    typedef T               value_type;
+    typedef std::size_t     result_type;
+
+    static const char * name() { return "count"; }
+
+    static result_type init(const value_type & value) {
+        (void)value;
+        return result_type(1);
+    }
+
+    static void combine(result_type & result, const result_type & partial) {
+        result += partial;
+    }
+};
+
+template <typename T, typename ResultType = T>
+struct SumAggregator {
+    typedef T               value_type;
+    typedef ResultType      result_type;
+
+    static const char * name() { return "sum"; }
+
+    static result_type init(const value_type & value) {
+        return static_cast<result_type>(value);
+    }
+
+    static void combine(result_type & result, const result_type & partial) {
+        result += partial;
+    }
+};
+
+template <typename T>
+struct MinAggregator {
+    typedef T               value_type;
+    typedef T               result_type;
+
+    static const char * name() { return "min"; }
+
+    static result_type init(const value_type & value) {
+        return value;
+    }
+
+    static void combine(result_type & result, const result_type & partial) {
+        if (partial < result)
+            result = partial;
+    }
+};
+
+template <typename T>
+struct MaxAggregator {
+    typedef T               value_type;
+    typedef T               result_type;
+
+    static const char * name() { return "max"; }
+
+    static result_type init(const value_type & value) {
+        return value;
+    }
+
+    static void combine(result_type & result, const result_type & partial) {
+        if (result < partial)
+            result = partial;
+    }
+};
+
+//
+// hash_upsert<Map>::apply(map, key, init, combine)
+//
+// The generic version is find() and emplace(), it probes twice when the key
+// is a new key. The BasicDictionary version uses upsert(), it probes only once.
+//
+template <typename Map>
+struct hash_upsert {
+    typedef typename Map::key_type      key_type;
+    typedef typename Map::mapped_type   mapped_type;
+
+    template <typename Combine>
+    static void apply(Map & map, const key_type & key, const mapped_type & init, Combine & combine) {
+        typename Map::iterator iter = map.find(key);
+        if (iter != map.end())
+            combine(iter->second, init);
+        else
+            map.emplace(key, init);
+    }
+};
+
+template <typename Key, typename Value, std::size_t HashFunc, std::size_t Alignment,
+          typename Hasher, typename KeyEqual, typename Allocator>
+struct hash_upsert<BasicDictionary<Key, Value, HashFunc, Alignment, Hasher, KeyEqual, Allocator>> {
+    typedef BasicDictionary<Key, Value, HashFunc, Alignment, Hasher, KeyEqual, Allocator>
+                                        map_type;
+    typedef typename map_type::key_type     key_type;
+    typedef typename map_type::mapped_type  mapped_type;
+
+    template <typename Combine>
+    static void apply(map_type & map, const key_type & key, const mapped_type & init, Combine & combine) {
+        map.upsert_no_return(key, init, combine);
+    }
+};
+
+//
+// HashAggregator<Key, Aggregator, Map>
+//
+// Aggregate the (key, value) rows into a single hash map, one upsert per row.
+//
+template <typename Key, typename Aggregator,
+          typename Map = Dictionary<Key, typename Aggregator::result_type>>
+class HashAggregator {
+public:
+    typedef Key                                 key_type;
+    typedef Aggregator                          aggregator_type;
+    typedef typename Aggregator::value_type     value_type;
+    typedef typename Aggregator::result_type    result_type;
+    typedef Map                                 map_type;
+    typedef std::size_t                         size_type;
+
+    struct combiner {
+        void operator () (result_type & result, const result_type & partial) const {
+            Aggregator::combine(result, partial);
+        }
+    };
+
+private:
+    map_type    table_;
+    combiner    combine_;
+
+public:
+    HashAggregator() {}
+    ~HashAggregator() {}
+
+    size_type size() const { return this->table_.size(); }
+    bool empty() const { return (this->size() == 0); }
+
+    map_type & table() { return this->table_; }
+    const map_type & table() const { return this->table_; }
+
+    void clear() {
+        this->table_.clear();
+    }
+
+    void reserve(size_type new_size) {
+        this->table_.reserve(new_size);
+    }
+
+    void add(const key_type & key, const value_type & value) {
+        hash_upsert<map_type>::apply(this->table_, key, Aggregator::init(value), this->combine_);
+    }
+
+    void add(const key_type * keys, const value_type * values, size_type count) {
+        for (size_type i = 0; i < count; i++) {
+            this->add(keys[i], values[i]);
+        }
+    }
+
+    void merge(const map_type & partial) {
+        for (typename map_type::const_iterator iter = partial.cbegin(); iter != partial.cend(); ++iter) {
+            hash_upsert<map_type>::apply(this->table_, iter->first, iter->second, this->combine_);
+        }
+    }
+
+    void merge(const HashAggregator & other) {
+        this->merge(other.table());
+    }
+};
+
+//
+// PartitionedAggregator<Key, Aggregator, Map>
+//
+// For the high cardinality, a single table is too large for the cache and
+// can't be shared by the threads without locks. So the rows are aggregated
+// in two lock-free phases:
+//
+//   1. Each thread aggregates it's slice of the rows into it's own thread-local
+//      tables, one table per partition, the partition is chosen by the hash of key.
+//   2. Each thread merges the thread-local tables of it's partitions into
+//      the final table of the partition.
+//
+// The final partitions are disjoint, so the result is all the partitions.
+// The partition is chosen by the high bits of the mixed hash code, because
+// the hash maps choose the buckets by the low bits.
+//
+template <typename Key, typename Aggregator,
+          typename Map = Dictionary<Key, typename Aggregator::result_type>>
+class PartitionedAggregator {
+public:
+    typedef Key                                 key_type;
+    typedef Aggregator                          aggregator_type;
+    typedef typename Aggregator::value_type     value_type;
+    typedef typename Aggregator::result_type    result_type;
+    typedef Map                                 map_type;
+    typedef typename Map::hasher                hasher;
+    typedef std::size_t                         size_type;
+
+    typedef HashAggregator<Key, Aggregator, Map>    aggregator_table;
+
+private:
+    size_type                                   threads_;
+    size_type                                   partitions_;
+    std::uint32_t                               partition_shift_;
+    hasher                                      hasher_;
+
+    std::vector<std::vector<aggregator_table>>  locals_;
+    std::vector<aggregator_table>               results_;
+
+public:
+    explicit PartitionedAggregator(size_type threads = 0, size_type partitions = 0)
+        : threads_(threads), partitions_(partitions), partition_shift_(64) {
+        if (this->threads_ == 0) {
+            this->threads_ = std::thread::hardware_concurrency();
+            if (this->threads_ == 0)
+                this->threads_ = 1;
+        }
+        if (this->partitions_ == 0)
+            this->partitions_ = this->threads_;
+
+        // Round up the partitions to power of 2.
+        std::uint32_t bits = 0;
+        while ((size_type(1) << bits) < this->partitions_) {
+            bits++;
+        }
+        this->partitions_ = size_type(1) << bits;
+        this->partition_shift_ = 64 - bits;
+
+        this->locals_.resize(this->threads_);
+        for (size_type t = 0; t < this->threads_; t++) {
+            this->locals_[t].resize(this->partitions_);
+        }
+        this->results_.resize(this->partitions_);
+    }
+
+    ~PartitionedAggregator() {}
+
+    size_type threads() const { return this->threads_; }
+    size_type partitions() const { return this->partitions_; }
+
+    const map_type & partition(size_type index) const {
+        assert(index < this->partitions_);
+        return this->results_[index].table();
+    }
+
+    size_type size() const {
+        size_type total = 0;
+        for (size_type p = 0; p < this->partitions_; p++) {
+            total += this->results_[p].size();
+        }
+        return total;
+    }
+
+    void clear() {
+        for (size_type p = 0; p < this->partitions_; p++) {
+            this->results_[p].clear();
+        }
+    }
+
+    size_type partition_of(const key_type & key) const {
+        if (this->partition_shift_ >= 64)
+            return 0;
+        // Fibonacci hashing, mix all the bits of hash code into the high bits.
+        std::uint64_t hash_code = static_cast<std::uint64_t>(this->hasher_(key));
+        return static_cast<size_type>((hash_code * 0x9E3779B97F4A7C15ull) >> this->partition_shift_);
+    }
+
+    //
+    // Aggregate the rows, the results are accumulated to the previous results.
+    //
+    void aggregate(const key_type * keys, const value_type * values, size_type count) {
+        if (this->threads_ == 1) {
+            this->local_aggregate(0, keys, values, count);
+            this->merge_partitions(0);
+            return;
+        }
+
+        std::vector<std::thread> workers;
+        workers.reserve(this->threads_);
+        for (size_type t = 0; t < this->threads_; t++) {
+            workers.emplace_back([this, t, keys, values, count]() {
+                this->local_aggregate(t, keys, values, count);
+            });
+        }
+        for (size_type t = 0; t < this->threads_; t++) {
+            workers[t].join();
+        }
+
+        workers.clear();
+        for (size_type t = 0; t < this->threads_; t++) {
+            workers.emplace_back([this, t]() {
+                this->merge_partitions(t);
+            });
+        }
+        for (size_type t = 0; t < this->threads_; t++) {
+            workers[t].join();
+        }
+    }
+
+    bool find(const key_type & key, result_type & result) const {
+        const map_type & table = this->results_[this->partition_of(key)].table();
+        typename map_type::const_iterator iter = table.find(key);
+        if (iter != table.end()) {
+            result = iter->second;
+            return true;
+        }
+        return false;
+    }
+
+private:
+    void local_aggregate(size_type thread_id, const key_type * keys,
+                         const value_type * values, size_type count) {
+        size_type first = count * thread_id / this->threads_;
+        size_type last  = count * (thread_id + 1) / this->threads_;
+
+        std::vector<aggregator_table> & tables = this->locals_[thread_id];
+        for (size_type i = first; i < last; i++) {
+            size_type p = this->partition_of(keys[i]);
+            tables[p].add(keys[i], values[i]);
+        }
+    }
+
+    void merge_partitions(size_type thread_id) {
+        for (size_type p = thread_id; p < this->partitions_; p += this->threads_) {
+            aggregator_table & result = this->results_[p];
+            for (size_type t = 0; t < this->threads_; t++) {
+                aggregator_table & local = this->locals_[t][p];
+                if (result.empty()) {
+                    // The first partial table is swapped, not merged.
+                    result.table().swap(local.table());
+                }
+                else {
+                    result.merge(local);
+                    local.clear();
+                }
+            }
+        }
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_HASH_HASH_AGGREGATOR_H
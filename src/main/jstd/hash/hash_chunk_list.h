@@ -19,6 +19,8 @@
 #include <type_traits>  // For std::forward<T>
 #include <stdexcept>    // For std::out_of_range()
 
+#include "jstd/hash/hash_chunk_recycler.h"
+
 namespace jstd {
 
 //
@@ -144,6 +146,9 @@ public:
     typedef hash_entry_chunk_list<T, Allocator, EntryAllocator>
                                                     this_type;
 
+    typedef hash_entry_chunk_recycler<T, EntryAllocator>
+                                                    recycler_type;
+
 protected:
     entry_chunk_t               last_chunk_;
     std::vector<element_type>   chunk_list_;
@@ -219,6 +224,25 @@ public:
             throw std::out_of_range("hash_entry_chunk_list<T>::at(pos) out of range.");
     }
 
+    static recycler_type & recycler() {
+        return recycler_type::instance();
+    }
+
+    entry_type * allocateChunk(size_type entry_capacity) {
+        entry_type * entries = recycler().acquire(entry_capacity);
+        if (likely(entries == nullptr)) {
+            entries = this->entry_allocator_.allocate(entry_capacity);
+        }
+        return entries;
+    }
+
+    void deallocateChunk(entry_type * entries, size_type entry_capacity) {
+        assert(entries != nullptr);
+        if (likely(!recycler().release(entries, entry_capacity))) {
+            this->entry_allocator_.deallocate(entries, entry_capacity);
+        }
+    }
+
     void destory() {
         if (likely(this->chunk_list_.size() > 0)) {
             size_type last_index = this->chunk_list_.size() - 1;
@@ -236,7 +260,7 @@ public:
                     }
 
                     // Free the entries buffer.
-                    this->entry_allocator_.deallocate(entries, capacity);
+                    this->deallocateChunk(entries, capacity);
                 }
             }
 
@@ -257,7 +281,7 @@ public:
                     }
 
                     // Free the entries buffer.
-                    this->entry_allocator_.deallocate(last_entries, last_capacity);
+                    this->deallocateChunk(last_entries, last_capacity);
                 }
             }
         }
@@ -0,0 +1,253 @@
+
+#ifndef JSTD_HASH_CHUNK_RECYCLER_H
+#define JSTD_HASH_CHUNK_RECYCLER_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+#include "jstd/basic/stdsize.h"
+
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>      // For std::ptrdiff_t, std::size_t
+#include <vector>
+#include <atomic>
+#include <mutex>        // For std::mutex, std::lock_guard<T>
+#include <type_traits>  // For std::is_empty<T>
+
+#include "jstd/support/BitUtils.h"
+
+namespace jstd {
+
+//
+// hash_entry_chunk_recycler<T, EntryAllocator>
+//
+// A bounded, thread-safe cache of the entry chunks, it's shared by all
+// the dictionary instances that have the same entry type. The cached chunks
+// are grouped by capacity class (only power of 2 capacities are cached),
+// they are already touched (page faulted), and hold no constructed value.
+//
+// It's disabled by default, call set_max_bytes(n) to enable it. Only the
+// stateless entry allocators can be recycled, because a chunk may be returned
+// to another dictionary instance.
+//
+template <typename T, typename EntryAllocator>
+class hash_entry_chunk_recycler {
+public:
+    typedef T                                       entry_type;
+    typedef EntryAllocator                          entry_allocator_type;
+    typedef std::size_t                             size_type;
+
+    typedef hash_entry_chunk_recycler<T, EntryAllocator>
+                                                    this_type;
+
+    static constexpr bool kIsRecyclable = std::is_empty<EntryAllocator>::value;
+
+    static constexpr size_type kMaxSizeClass = sizeof(size_type) * 8;
+    static constexpr size_type kPageSize = 4096;
+
+private:
+    std::atomic<bool>           enabled_;
+    mutable std::mutex          mutex_;
+    std::vector<entry_type *>   chunks_[kMaxSizeClass];
+
+    size_type                   max_bytes_;
+    size_type                   cached_bytes_;
+
+    size_type                   hits_;
+    size_type                   misses_;
+    size_type                   recycled_;
+    size_type                   dropped_;
+
+    entry_allocator_type        entry_allocator_;
+
+public:
+    hash_entry_chunk_recycler()
+        : enabled_(false), max_bytes_(0), cached_bytes_(0),
+          hits_(0), misses_(0), recycled_(0), dropped_(0) {}
+
+    ~hash_entry_chunk_recycler() {
+        this->enabled_.store(false, std::memory_order_relaxed);
+        this->purge();
+    }
+
+    hash_entry_chunk_recycler(const hash_entry_chunk_recycler &) = delete;
+    hash_entry_chunk_recycler & operator = (const hash_entry_chunk_recycler &) = delete;
+
+    static this_type & instance() {
+        static this_type s_recycler;
+        return s_recycler;
+    }
+
+    bool enabled() const {
+        return (kIsRecyclable && this->enabled_.load(std::memory_order_relaxed));
+    }
+
+    size_type max_bytes() const {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        return this->max_bytes_;
+    }
+
+    size_type cached_bytes() const {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        return this->cached_bytes_;
+    }
+
+    size_type hits() const {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        return this->hits_;
+    }
+
+    size_type misses() const {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        return this->misses_;
+    }
+
+    size_type recycled() const {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        return this->recycled_;
+    }
+
+    size_type dropped() const {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        return this->dropped_;
+    }
+
+    void reset_counters() {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->hits_ = 0;
+        this->misses_ = 0;
+        this->recycled_ = 0;
+        this->dropped_ = 0;
+    }
+
+    // Set the limit of the cached bytes, 0 means disable the recycler.
+    void set_max_bytes(size_type max_bytes) {
+        {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            this->max_bytes_ = max_bytes;
+            this->enabled_.store(kIsRecyclable && (max_bytes != 0), std::memory_order_relaxed);
+            this->trim_to(max_bytes);
+        }
+    }
+
+    // Pre-fault and cache some chunks, return the number of chunks be cached.
+    size_type reserve(size_type capacity, size_type count) {
+        size_type reserved = 0;
+        if (this->enabled() && is_cacheable(capacity)) {
+            for (size_type i = 0; i < count; i++) {
+                entry_type * entries = this->entry_allocator_.allocate(capacity);
+                touch_pages(entries, capacity);
+                if (!this->push_chunk(entries, capacity, false)) {
+                    this->entry_allocator_.deallocate(entries, capacity);
+                    break;
+                }
+                reserved++;
+            }
+        }
+        return reserved;
+    }
+
+    // Return nullptr if there is no cached chunk of the capacity.
+    entry_type * acquire(size_type capacity) {
+        if (likely(!this->enabled()))
+            return nullptr;
+
+        if (likely(is_cacheable(capacity))) {
+            size_type size_class = BitUtils::bsr64(static_cast<std::uint64_t>(capacity));
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            std::vector<entry_type *> & chunk_list = this->chunks_[size_class];
+            if (likely(!chunk_list.empty())) {
+                entry_type * entries = chunk_list.back();
+                chunk_list.pop_back();
+                assert(this->cached_bytes_ >= chunk_bytes(capacity));
+                this->cached_bytes_ -= chunk_bytes(capacity);
+                this->hits_++;
+                return entries;
+            }
+            this->misses_++;
+        }
+        else {
+            std::lock_guard<std::mutex> lock(this->mutex_);
+            this->misses_++;
+        }
+        return nullptr;
+    }
+
+    // Return false if the chunk is not cached, the caller must deallocate it.
+    bool release(entry_type * entries, size_type capacity) {
+        assert(entries != nullptr);
+        if (likely(!this->enabled()))
+            return false;
+
+        if (likely(is_cacheable(capacity)))
+            return this->push_chunk(entries, capacity, true);
+        else
+            return false;
+    }
+
+    void purge() {
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        this->trim_to(0);
+    }
+
+private:
+    static size_type chunk_bytes(size_type capacity) {
+        return (capacity * sizeof(entry_type));
+    }
+
+    static bool is_cacheable(size_type capacity) {
+        return ((capacity != 0) && ((capacity & (capacity - 1)) == 0));
+    }
+
+    static void touch_pages(entry_type * entries, size_type capacity) {
+        volatile char * first = reinterpret_cast<volatile char *>(entries);
+        size_type total_bytes = chunk_bytes(capacity);
+        for (size_type offset = 0; offset < total_bytes; offset += kPageSize) {
+            first[offset] = 0;
+        }
+    }
+
+    bool push_chunk(entry_type * entries, size_type capacity, bool is_recycled) {
+        size_type size_class = BitUtils::bsr64(static_cast<std::uint64_t>(capacity));
+        std::lock_guard<std::mutex> lock(this->mutex_);
+        if (likely((this->cached_bytes_ + chunk_bytes(capacity)) <= this->max_bytes_)) {
+            this->chunks_[size_class].push_back(entries);
+            this->cached_bytes_ += chunk_bytes(capacity);
+            if (is_recycled)
+                this->recycled_++;
+            return true;
+        }
+        else {
+            if (is_recycled)
+                this->dropped_++;
+            return false;
+        }
+    }
+
+    // Must be called under the lock.
+    void trim_to(size_type max_bytes) {
+        // Release the biggest chunks first.
+        for (size_type size_class = kMaxSizeClass; size_class > 0; size_class--) {
+            std::vector<entry_type *> & chunk_list = this->chunks_[size_class - 1];
+            size_type capacity = size_type(1) << (size_class - 1);
+            while (!chunk_list.empty() && (this->cached_bytes_ > max_bytes)) {
+                entry_type * entries = chunk_list.back();
+                chunk_list.pop_back();
+                this->entry_allocator_.deallocate(entries, capacity);
+                this->cached_bytes_ -= chunk_bytes(capacity);
+            }
+            if (chunk_list.empty()) {
+                std::vector<entry_type *>().swap(chunk_list);
+            }
+        }
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_HASH_CHUNK_RECYCLER_H
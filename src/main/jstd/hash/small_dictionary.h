@@ -0,0 +1,637 @@
+
+#ifndef JSTD_HASH_SMALL_DICTIONARY_H
+#define JSTD_HASH_SMALL_DICTIONARY_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+#include "jstd/basic/stdsize.h"
+
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>      // For std::ptrdiff_t, std::size_t
+#include <memory>       // For std::allocator<T>
+#include <new>          // For placement new
+#include <iterator>     // For std::forward_iterator_tag
+#include <tuple>        // For std::forward_as_tuple()
+#include <utility>      // For std::pair<K, V>, std::swap()
+#include <type_traits>  // For std::aligned_storage<Len, Align>
+
+#include "jstd/support/x86_intrin.h"
+#include "jstd/support/BitUtils.h"
+#include "jstd/hash/dictionary.h"
+
+namespace jstd {
+
+//
+// BasicSmallDictionary<Key, Value, N>: up to N entries are stored inline in a flat
+// array and found by linear scan, no bucket and no entry chunk are allocated.
+// When N is bigger than kMaxKeyScanSize, the 32 bit hash codes are stored as tags,
+// and if there are more than kMaxKeyScanSize entries, the lookup compares the tags
+// with SIMD first, so only the matched tags compare the keys.
+//
+// On overflow, it switches to the hashed layout (BasicDictionary), and switches
+// back to the flat layout when it shrinks to N / 2 entries or less.
+//
+template < typename Key, typename Value, std::size_t N = 16,
+           std::size_t HashFunc = HashFunc_Default,
+           std::size_t Alignment = std::alignment_of<std::pair<const Key, Value>>::value,
+           typename Hasher = hash<Key, std::uint32_t, HashFunc>,
+           typename KeyEqual = equal_to<Key>,
+           typename Allocator = std::allocator<std::pair<const Key, Value>>
+        >
+class BasicSmallDictionary {
+public:
+    typedef BasicDictionary<Key, Value, HashFunc, Alignment, Hasher, KeyEqual, Allocator>
+                                                    dictionary_type;
+
+    typedef Key                                     key_type;
+    typedef Value                                   mapped_type;
+    typedef std::pair<const Key, Value>             value_type;
+    typedef std::pair<Key, Value>                   nc_value_type;
+
+    typedef Hasher                                  hasher;
+    typedef KeyEqual                                key_equal;
+    typedef Allocator                               allocator_type;
+
+    typedef std::size_t                             size_type;
+    typedef std::uint32_t                           hash_code_t;
+    typedef BasicSmallDictionary<Key, Value, N, HashFunc, Alignment, Hasher, KeyEqual, Allocator>
+                                                    this_type;
+
+    static_assert((N > 0), "BasicSmallDictionary<K, V, N>: N must be greater than 0.");
+
+    static const size_type kSmallCapacity = N;
+    static const size_type kShrinkThreshold = N / 2;
+
+    // If the size is not bigger than it, compare the keys directly, don't need to hash.
+    static const size_type kMaxKeyScanSize = 4;
+    static const bool kUseHashTag = (N > kMaxKeyScanSize);
+
+    // The tags array is padded to the SIMD width.
+    static const size_type kTagCapacity = (N + 7) / 8 * 8;
+
+    template <typename ValueType, typename DictIterator>
+    class basic_iterator {
+    public:
+        typedef std::forward_iterator_tag   iterator_category;
+        typedef ValueType                   value_type;
+        typedef std::ptrdiff_t              difference_type;
+        typedef ValueType *                 pointer;
+        typedef ValueType &                 reference;
+
+    private:
+        // The small mode use pointer, the hashed mode use the dictionary iterator.
+        pointer         ptr_;
+        DictIterator    iter_;
+
+        template <typename, typename> friend class basic_iterator;
+        friend class BasicSmallDictionary<Key, Value, N, HashFunc, Alignment, Hasher, KeyEqual, Allocator>;
+
+    public:
+        basic_iterator() : ptr_(nullptr), iter_(nullptr) {}
+        explicit basic_iterator(pointer ptr) : ptr_(ptr), iter_(nullptr) {}
+        explicit basic_iterator(const DictIterator & iter) : ptr_(nullptr), iter_(iter) {}
+        template <typename OtherValue, typename OtherIterator>
+        basic_iterator(const basic_iterator<OtherValue, OtherIterator> & src)
+            : ptr_(src.ptr_), iter_(src.iter_) {}
+
+        reference operator * () const {
+            return (this->ptr_ != nullptr) ? *(this->ptr_) : *(this->iter_);
+        }
+
+        pointer operator -> () const {
+            return (this->ptr_ != nullptr) ? this->ptr_ : &(*(this->iter_));
+        }
+
+        basic_iterator & operator ++ () {
+            if (this->ptr_ != nullptr)
+                ++(this->ptr_);
+            else
+                ++(this->iter_);
+            return *this;
+        }
+
+        basic_iterator operator ++ (int) {
+            basic_iterator copy(*this);
+            ++(*this);
+            return copy;
+        }
+
+        bool operator == (const basic_iterator & rhs) const {
+            return ((this->ptr_ == rhs.ptr_) &&
+                    ((this->ptr_ != nullptr) || (this->iter_ == rhs.iter_)));
+        }
+
+        bool operator != (const basic_iterator & rhs) const {
+            return !(*this == rhs);
+        }
+    };
+
+    typedef basic_iterator<value_type, typename dictionary_type::iterator>
+                                                    iterator;
+    typedef basic_iterator<const value_type, typename dictionary_type::const_iterator>
+                                                    const_iterator;
+
+    typedef std::pair<iterator, bool>               insert_return_type;
+
+private:
+    typedef typename std::aligned_storage<sizeof(nc_value_type),
+                                          std::alignment_of<nc_value_type>::value>::type
+                                                    slot_type;
+    typedef typename std::allocator_traits<allocator_type>::template rebind_alloc<dictionary_type>
+                                                    dict_allocator_type;
+
+    slot_type           slots_[N];
+    hash_code_t         tags_[kTagCapacity];
+    size_type           small_size_;
+    dictionary_type *   dict_;
+    hasher              hasher_;
+    key_equal           key_equal_;
+    dict_allocator_type dict_allocator_;
+
+public:
+    BasicSmallDictionary() : small_size_(0), dict_(nullptr) {}
+
+    explicit BasicSmallDictionary(size_type initialCapacity)
+        : small_size_(0), dict_(nullptr) {
+        this->reserve(initialCapacity);
+    }
+
+    BasicSmallDictionary(const this_type & other)
+        : small_size_(0), dict_(nullptr),
+          hasher_(other.hasher_), key_equal_(other.key_equal_) {
+        this->reserve(other.size());
+        for (const_iterator iter = other.cbegin(); iter != other.cend(); ++iter) {
+            this->insert(*iter);
+        }
+    }
+
+    BasicSmallDictionary(this_type && other)
+        : small_size_(0), dict_(nullptr),
+          hasher_(other.hasher_), key_equal_(other.key_equal_) {
+        this->move_from(other);
+    }
+
+    ~BasicSmallDictionary() {
+        this->destroy();
+    }
+
+    this_type & operator = (const this_type & other) {
+        if (&other != this) {
+            this->clear();
+            this->hasher_ = other.hasher_;
+            this->key_equal_ = other.key_equal_;
+            this->reserve(other.size());
+            for (const_iterator iter = other.cbegin(); iter != other.cend(); ++iter) {
+                this->insert(*iter);
+            }
+        }
+        return *this;
+    }
+
+    this_type & operator = (this_type && other) {
+        if (&other != this) {
+            this->destroy();
+            this->hasher_ = other.hasher_;
+            this->key_equal_ = other.key_equal_;
+            this->move_from(other);
+        }
+        return *this;
+    }
+
+    iterator begin() {
+        if (likely(this->is_small()))
+            return iterator(this->small_data());
+        else
+            return iterator(this->dict_->begin());
+    }
+
+    iterator end() {
+        if (likely(this->is_small()))
+            return iterator(this->small_data() + this->small_size_);
+        else
+            return iterator(this->dict_->end());
+    }
+
+    const_iterator begin() const {
+        if (likely(this->is_small()))
+            return const_iterator(this->small_data());
+        else
+            return const_iterator(const_cast<const dictionary_type *>(this->dict_)->begin());
+    }
+
+    const_iterator end() const {
+        if (likely(this->is_small()))
+            return const_iterator(this->small_data() + this->small_size_);
+        else
+            return const_iterator(const_cast<const dictionary_type *>(this->dict_)->end());
+    }
+
+    const_iterator cbegin() const { return this->begin(); }
+    const_iterator cend() const   { return this->end();   }
+
+    bool is_small() const { return (this->dict_ == nullptr); }
+    bool empty() const { return (this->size() == 0); }
+
+    size_type size() const {
+        return (likely(this->is_small()) ? this->small_size_ : this->dict_->size());
+    }
+
+    size_type capacity() const {
+        return (likely(this->is_small()) ? kSmallCapacity : this->dict_->capacity());
+    }
+
+    const dictionary_type * dictionary() const { return this->dict_; }
+
+    hasher hash_function() const { return this->hasher_; }
+    key_equal key_eq() const { return this->key_equal_; }
+
+    void clear() {
+        this->destroy();
+    }
+
+    void reserve(size_type new_size) {
+        if (new_size > kSmallCapacity) {
+            if (likely(this->is_small()))
+                this->switch_to_hashed(new_size);
+            else
+                this->dict_->reserve(new_size);
+        }
+    }
+
+    void shrink_to_fit() {
+        if (!this->is_small()) {
+            if (this->dict_->size() <= kSmallCapacity)
+                this->switch_to_small();
+            else
+                this->dict_->shrink_to_fit();
+        }
+    }
+
+    size_type count(const key_type & key) const {
+        return (this->contains(key) ? 1 : 0);
+    }
+
+    bool contains(const key_type & key) const {
+        if (likely(this->is_small()))
+            return (this->find_small(key) < this->small_size_);
+        else
+            return this->dict_->contains(key);
+    }
+
+    iterator find(const key_type & key) {
+        if (likely(this->is_small())) {
+            size_type index = this->find_small(key);
+            return iterator(this->small_data() + index);
+        }
+        else {
+            return iterator(this->dict_->find(key));
+        }
+    }
+
+    const_iterator find(const key_type & key) const {
+        if (likely(this->is_small())) {
+            size_type index = this->find_small(key);
+            return const_iterator(this->small_data() + index);
+        }
+        else {
+            return const_iterator(const_cast<const dictionary_type *>(this->dict_)->find(key));
+        }
+    }
+
+    insert_return_type insert(const key_type & key, const mapped_type & value) {
+        return this->emplace_impl(key, value);
+    }
+
+    insert_return_type insert(const key_type & key, mapped_type && value) {
+        return this->emplace_impl(key, std::forward<mapped_type>(value));
+    }
+
+    insert_return_type insert(key_type && key, mapped_type && value) {
+        return this->emplace_impl(std::forward<key_type>(key), std::forward<mapped_type>(value));
+    }
+
+    insert_return_type insert(const value_type & value) {
+        return this->emplace_impl(value.first, value.second);
+    }
+
+    insert_return_type insert(value_type && value) {
+        return this->emplace_impl(value.first, std::move(value.second));
+    }
+
+    insert_return_type insert(nc_value_type && value) {
+        return this->emplace_impl(std::move(value.first), std::move(value.second));
+    }
+
+    void insert_no_return(const key_type & key, const mapped_type & value) {
+        this->emplace_impl(key, value);
+    }
+
+    void insert_no_return(const key_type & key, mapped_type && value) {
+        this->emplace_impl(key, std::forward<mapped_type>(value));
+    }
+
+    template <typename ...Args>
+    insert_return_type emplace(const key_type & key, Args && ... args) {
+        return this->emplace_impl(key, std::forward<Args>(args)...);
+    }
+
+    template <typename ...Args>
+    insert_return_type emplace(key_type && key, Args && ... args) {
+        return this->emplace_impl(std::forward<key_type>(key), std::forward<Args>(args)...);
+    }
+
+    mapped_type & operator [] (const key_type & key) {
+        return this->emplace_impl(key).first->second;
+    }
+
+    mapped_type & operator [] (key_type && key) {
+        return this->emplace_impl(std::forward<key_type>(key)).first->second;
+    }
+
+    size_type erase(const key_type & key) {
+        if (likely(this->is_small())) {
+            size_type index = this->find_small(key);
+            if (likely(index < this->small_size_)) {
+                this->erase_small(index);
+                return 1;
+            }
+            return 0;
+        }
+        else {
+            size_type erased = this->dict_->erase(key);
+            if (erased != 0 && this->dict_->size() <= kShrinkThreshold) {
+                this->switch_to_small();
+            }
+            return erased;
+        }
+    }
+
+    void swap(this_type & other) {
+        if (&other != this) {
+            this_type tmp(std::move(other));
+            other = std::move(*this);
+            *this = std::move(tmp);
+        }
+    }
+
+    static const char * name() {
+        switch (HashFunc) {
+        case HashFunc_CRC32C:
+            return "jstd::SmallDictionary<K, V> (CRC32c)";
+        case HashFunc_Time31:
+            return "jstd::SmallDictionary<K, V> (Time31)";
+        case HashFunc_Time31Std:
+            return "jstd::SmallDictionary<K, V> (Time31Std)";
+        default:
+            return "jstd::SmallDictionary<K, V> (Unknown)";
+        }
+    }
+
+private:
+    nc_value_type * small_slot(size_type index) {
+        return reinterpret_cast<nc_value_type *>(&this->slots_[index]);
+    }
+
+    const nc_value_type * small_slot(size_type index) const {
+        return reinterpret_cast<const nc_value_type *>(&this->slots_[index]);
+    }
+
+    value_type * small_data() {
+        return reinterpret_cast<value_type *>(&this->slots_[0]);
+    }
+
+    const value_type * small_data() const {
+        return reinterpret_cast<const value_type *>(&this->slots_[0]);
+    }
+
+    hash_code_t get_hash(const key_type & key) const {
+        return static_cast<hash_code_t>(this->hasher_(key));
+    }
+
+    // Return small_size_ if the key is not found.
+    size_type find_small(const key_type & key) const {
+        if (kUseHashTag && (this->small_size_ > kMaxKeyScanSize))
+            return this->find_small_by_tag(key, this->get_hash(key));
+        else
+            return this->find_small_by_key(key);
+    }
+
+    size_type find_small_by_key(const key_type & key) const {
+        size_type index;
+        for (index = 0; index < this->small_size_; index++) {
+            if (this->key_equal_(this->small_slot(index)->first, key))
+                break;
+        }
+        return index;
+    }
+
+    size_type find_small_by_tag(const key_type & key, hash_code_t hash_code) const {
+        size_type small_size = this->small_size_;
+        size_type index = 0;
+#if defined(__AVX2__)
+        __m256i hash_code_vec = _mm256_set1_epi32(static_cast<int>(hash_code));
+        for (; index < small_size; index += 8) {
+            __m256i tags = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(&this->tags_[index]));
+            __m256i equal_mask = _mm256_cmpeq_epi32(tags, hash_code_vec);
+            std::uint32_t mask = static_cast<std::uint32_t>(
+                                    _mm256_movemask_ps(_mm256_castsi256_ps(equal_mask)));
+            if (small_size - index < 8)
+                mask &= (1U << (small_size - index)) - 1;
+            while (mask != 0) {
+                size_type pos = index + BitUtils::bsf32(mask);
+                if (likely(this->key_equal_(this->small_slot(pos)->first, key)))
+                    return pos;
+                mask &= mask - 1;
+            }
+        }
+#elif defined(__SSE2__)
+        __m128i hash_code_vec = _mm_set1_epi32(static_cast<int>(hash_code));
+        for (; index < small_size; index += 4) {
+            __m128i tags = _mm_loadu_si128(reinterpret_cast<const __m128i *>(&this->tags_[index]));
+            __m128i equal_mask = _mm_cmpeq_epi32(tags, hash_code_vec);
+            std::uint32_t mask = static_cast<std::uint32_t>(
+                                    _mm_movemask_ps(_mm_castsi128_ps(equal_mask)));
+            if (small_size - index < 4)
+                mask &= (1U << (small_size - index)) - 1;
+            while (mask != 0) {
+                size_type pos = index + BitUtils::bsf32(mask);
+                if (likely(this->key_equal_(this->small_slot(pos)->first, key)))
+                    return pos;
+                mask &= mask - 1;
+            }
+        }
+#else
+        for (; index < small_size; index++) {
+            if (this->tags_[index] == hash_code) {
+                if (likely(this->key_equal_(this->small_slot(index)->first, key)))
+                    return index;
+            }
+        }
+#endif
+        return small_size;
+    }
+
+    template <typename KeyT, typename ...Args>
+    insert_return_type emplace_impl(KeyT && key, Args && ... args) {
+        if (likely(this->is_small())) {
+            hash_code_t hash_code = 0;
+            size_type index;
+            if (kUseHashTag) {
+                hash_code = this->get_hash(key);
+                index = this->find_small_by_tag(key, hash_code);
+            }
+            else {
+                index = this->find_small_by_key(key);
+            }
+            if (index < this->small_size_) {
+                return insert_return_type(iterator(this->small_data() + index), false);
+            }
+            if (likely(this->small_size_ < kSmallCapacity)) {
+                index = this->small_size_;
+                ::new (static_cast<void *>(this->small_slot(index)))
+                    nc_value_type(std::piecewise_construct,
+                                  std::forward_as_tuple(std::forward<KeyT>(key)),
+                                  std::forward_as_tuple(std::forward<Args>(args)...));
+                if (kUseHashTag)
+                    this->tags_[index] = hash_code;
+                this->small_size_++;
+                return insert_return_type(iterator(this->small_data() + index), true);
+            }
+
+            // Overflow, switch to the hashed layout.
+            this->switch_to_hashed(kSmallCapacity * 2);
+        }
+
+        // Hash and probe only once, the value is constructed in place.
+        typename dictionary_type::insert_return_type result =
+            this->dict_->try_emplace(std::forward<KeyT>(key), std::forward<Args>(args)...);
+        return insert_return_type(iterator(result.first), result.second);
+    }
+
+    void erase_small(size_type index) {
+        assert(index < this->small_size_);
+        size_type last = this->small_size_ - 1;
+        if (index != last) {
+            nc_value_type * slot = this->small_slot(index);
+            nc_value_type * last_slot = this->small_slot(last);
+            *slot = std::move(*last_slot);
+            if (kUseHashTag)
+                this->tags_[index] = this->tags_[last];
+        }
+        this->small_slot(last)->~nc_value_type();
+        this->small_size_--;
+    }
+
+    void destroy_small() {
+        for (size_type i = 0; i < this->small_size_; i++) {
+            this->small_slot(i)->~nc_value_type();
+        }
+        this->small_size_ = 0;
+    }
+
+    void destroy() {
+        if (likely(this->is_small())) {
+            this->destroy_small();
+        }
+        else {
+            this->delete_dictionary(this->dict_);
+            this->dict_ = nullptr;
+        }
+    }
+
+    dictionary_type * new_dictionary(size_type initialCapacity) {
+        dictionary_type * dict = this->dict_allocator_.allocate(1);
+        ::new (static_cast<void *>(dict)) dictionary_type(initialCapacity, this->hasher_, this->key_equal_);
+        return dict;
+    }
+
+    void delete_dictionary(dictionary_type * dict) {
+        assert(dict != nullptr);
+        dict->~dictionary_type();
+        this->dict_allocator_.deallocate(dict, 1);
+    }
+
+    void switch_to_hashed(size_type new_capacity) {
+        assert(this->is_small());
+        dictionary_type * dict = this->new_dictionary(new_capacity);
+        for (size_type i = 0; i < this->small_size_; i++) {
+            dict->insert(std::move(*this->small_slot(i)));
+        }
+        this->destroy_small();
+        this->dict_ = dict;
+    }
+
+    void switch_to_small() {
+        assert(!this->is_small());
+        assert(this->dict_->size() <= kSmallCapacity);
+        dictionary_type * dict = this->dict_;
+        this->dict_ = nullptr;
+        this->small_size_ = 0;
+        for (typename dictionary_type::iterator iter = dict->begin(); iter != dict->end(); ++iter) {
+            size_type index = this->small_size_;
+            ::new (static_cast<void *>(this->small_slot(index)))
+                nc_value_type(std::move(const_cast<key_type &>(iter->first)), std::move(iter->second));
+            if (kUseHashTag)
+                this->tags_[index] = this->get_hash(this->small_slot(index)->first);
+            this->small_size_++;
+        }
+        this->delete_dictionary(dict);
+    }
+
+    void move_from(this_type & other) {
+        assert(this->is_small() && this->small_size_ == 0);
+        if (likely(other.is_small())) {
+            for (size_type i = 0; i < other.small_size_; i++) {
+                ::new (static_cast<void *>(this->small_slot(i)))
+                    nc_value_type(std::move(*other.small_slot(i)));
+                if (kUseHashTag)
+                    this->tags_[i] = other.tags_[i];
+            }
+            this->small_size_ = other.small_size_;
+            other.destroy_small();
+        }
+        else {
+            this->dict_ = other.dict_;
+            this->dict_allocator_ = other.dict_allocator_;
+            other.dict_ = nullptr;
+            other.small_size_ = 0;
+        }
+    }
+};
+
+template <typename Key, typename Value, std::size_t N, std::size_t HashFunc, std::size_t Alignment,
+          typename Hasher, typename KeyEqual, typename Allocator>
+inline void swap(BasicSmallDictionary<Key, Value, N, HashFunc, Alignment, Hasher, KeyEqual, Allocator> & lhs,
+                 BasicSmallDictionary<Key, Value, N, HashFunc, Alignment, Hasher, KeyEqual, Allocator> & rhs) {
+    lhs.swap(rhs);
+}
+
+template <typename Key, typename Value, std::size_t N = 16,
+          typename Hasher = hash<Key, std::uint32_t, HashFunc_Time31>,
+          typename KeyEqual = equal_to<Key>,
+          std::size_t Alignment = std::alignment_of<std::pair<const Key, Value>>::value>
+using SmallDictionary_Time31 = BasicSmallDictionary<Key, Value, N, HashFunc_Time31, Alignment, Hasher, KeyEqual>;
+
+#if JSTD_HAVE_SSE42_CRC32C
+template <typename Key, typename Value, std::size_t N = 16,
+          typename Hasher = hash<Key, std::uint32_t, HashFunc_CRC32C>,
+          typename KeyEqual = equal_to<Key>,
+          std::size_t Alignment = std::alignment_of<std::pair<const Key, Value>>::value>
+using SmallDictionary = BasicSmallDictionary<Key, Value, N, HashFunc_CRC32C, Alignment, Hasher, KeyEqual>;
+#else
+template <typename Key, typename Value, std::size_t N = 16,
+          typename Hasher = hash<Key, std::uint32_t, HashFunc_Time31>,
+          typename KeyEqual = equal_to<Key>,
+          std::size_t Alignment = std::alignment_of<std::pair<const Key, Value>>::value>
+using SmallDictionary = BasicSmallDictionary<Key, Value, N, HashFunc_Time31, Alignment, Hasher, KeyEqual>;
+#endif // JSTD_HAVE_SSE42_CRC32C
+
+} // namespace jstd
+
+#endif // JSTD_HASH_SMALL_DICTIONARY_H
@@ -0,0 +1,596 @@
+
+#ifndef JSTD_HASH_STRING_DICTIONARY_H
+#define JSTD_HASH_STRING_DICTIONARY_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+#include "jstd/basic/stdsize.h"
+
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>      // For std::ptrdiff_t, std::size_t
+#include <cstring>      // For std::memcpy(), std::memcmp()
+#include <memory>       // For std::allocator<T>
+#include <vector>
+#include <string>
+#include <utility>      // For std::pair<K, V>, std::swap()
+#include <stdexcept>    // For std::length_error()
+#include <type_traits>
+
+#include "jstd/hasher/hash_helper.h"
+#include "jstd/hash/dictionary.h"
+#include "jstd/string/string_view.h"
+
+namespace jstd {
+
+//
+// The key stored in the dictionary entry: the length, a small inline prefix
+// and the offset of a length-prefixed record in the string_key_arena.
+//
+// A probe key (built from a caller's string to look up) has no record in the
+// arena, its offset is kExternalOffset and it points to the caller's bytes.
+//
+struct interned_key {
+    typedef std::uint32_t   size_type;
+    typedef std::uint32_t   offset_type;
+
+    enum : size_type { kPrefixSize = 8 };
+
+    static const offset_type kExternalOffset = 0xFFFFFFFFUL;
+
+    size_type       length;
+    offset_type     offset;
+    union {
+        char            prefix[kPrefixSize];
+        const char *    external;
+    };
+
+    interned_key() noexcept : length(0), offset(kExternalOffset), external(nullptr) {
+    }
+
+    bool is_external() const { return (this->offset == kExternalOffset); }
+
+    static interned_key make_probe(const char * data, std::size_t length) {
+        interned_key key;
+        key.length = static_cast<size_type>(length);
+        key.offset = kExternalOffset;
+        key.external = data;
+        return key;
+    }
+
+    // Read the first kPrefixSize bytes, zero padded, as one 64 bit word.
+    static std::uint64_t load_prefix(const char * data, size_type length) {
+        std::uint64_t prefix = 0;
+        std::memcpy(&prefix, data, (length < kPrefixSize) ? length : kPrefixSize);
+        return prefix;
+    }
+
+    std::uint64_t get_prefix() const {
+        if (likely(!this->is_external())) {
+            std::uint64_t prefix;
+            std::memcpy(&prefix, this->prefix, sizeof(prefix));
+            return prefix;
+        }
+        else {
+            return load_prefix(this->external, this->length);
+        }
+    }
+};
+
+//
+// Append-only arena of length-prefixed key records: [uint32_t length][bytes].
+//
+// The records never move, so the string_view of a interned key is stable
+// until clear(). The offset is (chunk_index << kChunkShift) | chunk_pos,
+// a key longer than kMaxChunkSize get a dedicated chunk.
+//
+template <typename Allocator = std::allocator<char>>
+class basic_string_key_arena {
+public:
+    typedef std::size_t                     size_type;
+    typedef interned_key::offset_type       offset_type;
+    typedef Allocator                       allocator_type;
+    typedef basic_string_key_arena<Allocator>
+                                            this_type;
+
+    static const size_type kChunkShift = 20;
+    static const size_type kMaxChunkSize = size_type(1) << kChunkShift;
+    static const size_type kChunkPosMask = kMaxChunkSize - 1;
+    static const size_type kMaxChunkCount = size_type(1) << (32 - kChunkShift);
+    static const size_type kFirstChunkSize = 4096;
+
+    static const size_type kRecordHeader = sizeof(std::uint32_t);
+    static const size_type kRecordAlign = sizeof(std::uint32_t);
+
+private:
+    struct chunk_info {
+        char *      data;
+        size_type   capacity;
+    };
+
+    std::vector<chunk_info> chunks_;
+    size_type               chunk_used_;
+    size_type               chunk_capacity_;
+    size_type               total_bytes_;
+    allocator_type          allocator_;
+
+public:
+    basic_string_key_arena()
+        : chunk_used_(0), chunk_capacity_(0), total_bytes_(0) {
+    }
+
+    basic_string_key_arena(const this_type & other) = delete;
+    this_type & operator = (const this_type & other) = delete;
+
+    ~basic_string_key_arena() {
+        this->destroy();
+    }
+
+    size_type chunk_count() const { return this->chunks_.size(); }
+
+    // The bytes used by the records, include the length prefix and padding.
+    size_type used_bytes() const {
+        return (this->total_bytes_ - this->chunk_capacity_ + this->chunk_used_);
+    }
+
+    // The bytes allocated by all chunks.
+    size_type allocated_bytes() const { return this->total_bytes_; }
+
+    const char * record(offset_type offset) const {
+        size_type index = size_type(offset) >> kChunkShift;
+        size_type pos   = size_type(offset) & kChunkPosMask;
+        assert(index < this->chunks_.size());
+        return (this->chunks_[index].data + pos);
+    }
+
+    const char * data(const interned_key & key) const {
+        if (likely(!key.is_external()))
+            return (this->record(key.offset) + kRecordHeader);
+        else
+            return key.external;
+    }
+
+    jstd::string_view to_string_view(const interned_key & key) const {
+        return jstd::string_view(this->data(key), key.length);
+    }
+
+    interned_key intern(const char * data, size_type length) {
+        size_type record_size = (kRecordHeader + length + (kRecordAlign - 1)) & ~(kRecordAlign - 1);
+        if (unlikely(record_size > (this->chunk_capacity_ - this->chunk_used_))) {
+            this->add_chunk(record_size);
+        }
+
+        size_type index = this->chunks_.size() - 1;
+        char * record = this->chunks_[index].data + this->chunk_used_;
+        std::uint32_t record_len = static_cast<std::uint32_t>(length);
+        std::memcpy(record, &record_len, kRecordHeader);
+        std::memcpy(record + kRecordHeader, data, length);
+
+        interned_key key;
+        key.length = static_cast<interned_key::size_type>(length);
+        key.offset = static_cast<offset_type>((index << kChunkShift) | this->chunk_used_);
+        std::memset(key.prefix, 0, sizeof(key.prefix));
+        std::memcpy(key.prefix, data,
+                    (length < interned_key::kPrefixSize) ? length : interned_key::kPrefixSize);
+
+        this->chunk_used_ += record_size;
+        return key;
+    }
+
+    // Drop the last interned record, the key must be the latest one.
+    void rollback(const interned_key & key) {
+        assert(!key.is_external());
+        size_type index = size_type(key.offset) >> kChunkShift;
+        size_type pos   = size_type(key.offset) & kChunkPosMask;
+        assert(index == (this->chunks_.size() - 1));
+        if (likely(index == (this->chunks_.size() - 1))) {
+            this->chunk_used_ = pos;
+        }
+    }
+
+    void clear() {
+        this->destroy();
+    }
+
+    void swap(this_type & other) {
+        if (&other != this) {
+            using std::swap;
+            this->chunks_.swap(other.chunks_);
+            swap(this->chunk_used_,     other.chunk_used_);
+            swap(this->chunk_capacity_, other.chunk_capacity_);
+            swap(this->total_bytes_,    other.total_bytes_);
+        }
+    }
+
+private:
+    void add_chunk(size_type min_size) {
+        if (this->chunks_.size() >= kMaxChunkCount) {
+            throw std::length_error("basic_string_key_arena<A>::add_chunk(): the arena is full.");
+        }
+
+        size_type capacity;
+        if (likely(min_size <= kMaxChunkSize)) {
+            capacity = (this->chunk_capacity_ != 0) ? (this->chunk_capacity_ * 2) : kFirstChunkSize;
+            if (capacity > kMaxChunkSize)
+                capacity = kMaxChunkSize;
+            while (capacity < min_size)
+                capacity *= 2;
+        }
+        else {
+            // A dedicated chunk for a large key.
+            capacity = min_size;
+        }
+
+        chunk_info chunk;
+        chunk.data = this->allocator_.allocate(capacity);
+        chunk.capacity = capacity;
+        this->chunks_.push_back(chunk);
+
+        this->chunk_used_ = 0;
+        this->chunk_capacity_ = capacity;
+        this->total_bytes_ += capacity;
+    }
+
+    void destroy() {
+        for (size_type i = 0; i < this->chunks_.size(); i++) {
+            this->allocator_.deallocate(this->chunks_[i].data, this->chunks_[i].capacity);
+        }
+        this->chunks_.clear();
+        this->chunk_used_ = 0;
+        this->chunk_capacity_ = 0;
+        this->total_bytes_ = 0;
+    }
+};
+
+typedef basic_string_key_arena<std::allocator<char>> string_key_arena;
+
+template <typename Arena, std::size_t HashFunc = HashFunc_Default>
+struct interned_key_hash {
+    typedef interned_key    argument_type;
+    typedef std::uint32_t   result_type;
+
+    const Arena * arena_;
+
+    interned_key_hash(const Arena * arena = nullptr) : arena_(arena) {}
+
+    result_type operator () (const interned_key & key) const {
+        assert(this->arena_ != nullptr);
+        const char * data = this->arena_->data(key);
+        if (HashFunc == HashFunc_CRC32C)
+            return static_cast<result_type>(hashes::hash_crc32c(data, key.length));
+        else if (HashFunc == HashFunc_Time31)
+            return static_cast<result_type>(hashes::Times31(data, key.length));
+        else if (HashFunc == HashFunc_Time31Std)
+            return static_cast<result_type>(hashes::Times31Std(data, key.length));
+        else
+            return static_cast<result_type>(hashes::hash_crc32c(data, key.length));
+    }
+};
+
+template <typename Arena>
+struct interned_key_equal {
+    typedef interned_key    key_type;
+
+    const Arena * arena_;
+
+    interned_key_equal(const Arena * arena = nullptr) : arena_(arena) {}
+
+    bool operator () (const interned_key & key1, const interned_key & key2) const {
+        if (key1.length != key2.length)
+            return false;
+
+        // Compare the inline prefix first, it doesn't touch the arena.
+        if (key1.get_prefix() != key2.get_prefix())
+            return false;
+        if (likely(key1.length <= interned_key::kPrefixSize))
+            return true;
+
+        assert(this->arena_ != nullptr);
+        const char * data1 = this->arena_->data(key1) + interned_key::kPrefixSize;
+        const char * data2 = this->arena_->data(key2) + interned_key::kPrefixSize;
+        return (std::memcmp(data1, data2, key1.length - interned_key::kPrefixSize) == 0);
+    }
+};
+
+//
+// BasicStringDictionary<Value>: a string key dictionary, the key bytes are
+// interned into a contiguous arena, the entry only keep a 16 bytes key
+// (length + offset + 8 bytes prefix), the keys are returned as string_view.
+//
+// The arena is append-only, the bytes of the erased keys are reclaimed by
+// clear() only.
+//
+template <typename Value, std::size_t HashFunc = HashFunc_Default,
+          typename Arena = string_key_arena,
+          typename Allocator = std::allocator<std::pair<const interned_key, Value>>>
+class BasicStringDictionary {
+public:
+    typedef Arena                                   arena_type;
+    typedef interned_key_hash<Arena, HashFunc>      hasher;
+    typedef interned_key_equal<Arena>               key_equal;
+
+    typedef BasicDictionary<interned_key, Value, HashFunc,
+                            std::alignment_of<std::pair<const interned_key, Value>>::value,
+                            hasher, key_equal, Allocator>
+                                                    dictionary_type;
+
+    typedef jstd::string_view                       key_type;
+    typedef Value                                   mapped_type;
+    typedef std::size_t                             size_type;
+    typedef BasicStringDictionary<Value, HashFunc, Arena, Allocator>
+                                                    this_type;
+
+    static const size_type kDefaultInitialCapacity = dictionary_type::kDefaultInitialCapacity;
+
+    template <typename DictIterator, typename MappedType>
+    class basic_iterator {
+    public:
+        struct reference {
+            jstd::string_view   first;
+            MappedType &        second;
+
+            reference(const jstd::string_view & key, MappedType & value)
+                : first(key), second(value) {}
+        };
+
+        struct pointer {
+            reference ref;
+
+            pointer(const reference & ref) : ref(ref) {}
+            reference * operator -> () { return &this->ref; }
+        };
+
+    private:
+        const arena_type *  arena_;
+        DictIterator        iter_;
+
+        template <typename, typename> friend class basic_iterator;
+        friend class BasicStringDictionary<Value, HashFunc, Arena, Allocator>;
+
+    public:
+        basic_iterator() : arena_(nullptr), iter_() {}
+        basic_iterator(const arena_type * arena, const DictIterator & iter)
+            : arena_(arena), iter_(iter) {}
+        template <typename OtherIterator, typename OtherMapped>
+        basic_iterator(const basic_iterator<OtherIterator, OtherMapped> & src)
+            : arena_(src.arena_), iter_(src.iter_) {}
+
+        jstd::string_view key() const {
+            return this->arena_->to_string_view(this->iter_->first);
+        }
+
+        MappedType & value() const {
+            return this->iter_->second;
+        }
+
+        reference operator * () const {
+            return reference(this->key(), this->value());
+        }
+
+        pointer operator -> () const {
+            return pointer(**this);
+        }
+
+        basic_iterator & operator ++ () {
+            ++(this->iter_);
+            return *this;
+        }
+
+        basic_iterator operator ++ (int) {
+            basic_iterator copy(*this);
+            ++(this->iter_);
+            return copy;
+        }
+
+        bool operator == (const basic_iterator & rhs) const {
+            return (this->iter_ == rhs.iter_);
+        }
+
+        bool operator != (const basic_iterator & rhs) const {
+            return (this->iter_ != rhs.iter_);
+        }
+    };
+
+    typedef basic_iterator<typename dictionary_type::iterator, mapped_type>
+                                                    iterator;
+    typedef basic_iterator<typename dictionary_type::const_iterator, const mapped_type>
+                                                    const_iterator;
+
+    typedef std::pair<iterator, bool>               insert_return_type;
+
+private:
+    // The arena must be declared before the dictionary, the hasher and
+    // key_equal of the dictionary refer to it.
+    arena_type          arena_;
+    dictionary_type     dict_;
+
+public:
+    explicit BasicStringDictionary(size_type initialCapacity = kDefaultInitialCapacity)
+        : arena_(), dict_(initialCapacity, hasher(&arena_), key_equal(&arena_)) {
+    }
+
+    BasicStringDictionary(const this_type & other)
+        : arena_(), dict_(other.size(), hasher(&arena_), key_equal(&arena_)) {
+        for (const_iterator iter = other.cbegin(); iter != other.cend(); ++iter) {
+            this->insert(iter.key(), iter.value());
+        }
+    }
+
+    BasicStringDictionary(this_type && other)
+        : arena_(), dict_(kDefaultInitialCapacity, hasher(&arena_), key_equal(&arena_)) {
+        this->swap(other);
+    }
+
+    this_type & operator = (const this_type & other) {
+        if (&other != this) {
+            this_type copy(other);
+            this->swap(copy);
+        }
+        return *this;
+    }
+
+    this_type & operator = (this_type && other) {
+        if (&other != this) {
+            this->clear();
+            this->swap(other);
+        }
+        return *this;
+    }
+
+    iterator begin() { return iterator(&this->arena_, this->dict_.begin()); }
+    iterator end()   { return iterator(&this->arena_, this->dict_.end());   }
+
+    const_iterator begin() const { return const_iterator(&this->arena_, this->dict_.begin()); }
+    const_iterator end() const   { return const_iterator(&this->arena_, this->dict_.end());   }
+
+    const_iterator cbegin() const { return const_iterator(&this->arena_, this->dict_.cbegin()); }
+    const_iterator cend() const   { return const_iterator(&this->arena_, this->dict_.cend());   }
+
+    bool empty() const { return this->dict_.empty(); }
+    size_type size() const { return this->dict_.size(); }
+    size_type capacity() const { return this->dict_.capacity(); }
+    size_type bucket_count() const { return this->dict_.bucket_count(); }
+    float load_factor() const { return this->dict_.load_factor(); }
+
+    const arena_type & arena() const { return this->arena_; }
+    const dictionary_type & dictionary() const { return this->dict_; }
+
+    void clear() {
+        this->dict_.clear();
+        this->arena_.clear();
+    }
+
+    void rehash(size_type bucket_count) {
+        this->dict_.rehash(bucket_count);
+    }
+
+    void reserve(size_type new_size) {
+        this->dict_.reserve(new_size);
+    }
+
+    void shrink_to_fit(size_type bucket_count = 0) {
+        this->dict_.shrink_to_fit(bucket_count);
+    }
+
+    size_type count(const key_type & key) const {
+        return this->dict_.count(this->make_probe(key));
+    }
+
+    bool contains(const key_type & key) const {
+        return this->dict_.contains(this->make_probe(key));
+    }
+
+    iterator find(const key_type & key) {
+        return iterator(&this->arena_, this->dict_.find(this->make_probe(key)));
+    }
+
+    const_iterator find(const key_type & key) const {
+        return const_iterator(&this->arena_, this->dict_.find(this->make_probe(key)));
+    }
+
+    //
+    // The key is interned before the lookup, so insert() only probe once,
+    // if the key already exists, the new record is dropped from the arena.
+    //
+    insert_return_type insert(const key_type & key, const mapped_type & value) {
+        interned_key ikey = this->arena_.intern(key.data(), key.size());
+        typename dictionary_type::insert_return_type result = this->dict_.insert(ikey, value);
+        if (!result.second)
+            this->arena_.rollback(ikey);
+        return insert_return_type(iterator(&this->arena_, result.first), result.second);
+    }
+
+    insert_return_type insert(const key_type & key, mapped_type && value) {
+        interned_key ikey = this->arena_.intern(key.data(), key.size());
+        typename dictionary_type::insert_return_type result =
+            this->dict_.insert(ikey, std::forward<mapped_type>(value));
+        if (!result.second)
+            this->arena_.rollback(ikey);
+        return insert_return_type(iterator(&this->arena_, result.first), result.second);
+    }
+
+    void insert_no_return(const key_type & key, const mapped_type & value) {
+        this->insert(key, value);
+    }
+
+    void insert_no_return(const key_type & key, mapped_type && value) {
+        this->insert(key, std::forward<mapped_type>(value));
+    }
+
+    template <typename ...Args>
+    insert_return_type emplace(const key_type & key, Args && ... args) {
+        return this->insert(key, mapped_type(std::forward<Args>(args)...));
+    }
+
+    //
+    // Same as insert(), the key is interned first and the dictionary is probed
+    // only once, if no new entry was added, the record is dropped from the arena.
+    //
+    mapped_type & operator [] (const key_type & key) {
+        interned_key ikey = this->arena_.intern(key.data(), key.size());
+        size_type old_size = this->dict_.size();
+        mapped_type & value = this->dict_[ikey];
+        if (this->dict_.size() == old_size)
+            this->arena_.rollback(ikey);
+        return value;
+    }
+
+    size_type erase(const key_type & key) {
+        return this->dict_.erase(this->make_probe(key));
+    }
+
+    void swap(this_type & other) {
+        if (&other != this) {
+            // The hasher and key_equal keep pointing to their own arena.
+            this->arena_.swap(other.arena_);
+            this->dict_.swap(other.dict_);
+        }
+    }
+
+    static const char * name() {
+        switch (HashFunc) {
+        case HashFunc_CRC32C:
+            return "jstd::StringDictionary<V> (CRC32c)";
+        case HashFunc_Time31:
+            return "jstd::StringDictionary<V> (Time31)";
+        case HashFunc_Time31Std:
+            return "jstd::StringDictionary<V> (Time31Std)";
+        default:
+            return "jstd::StringDictionary<V> (Unknown)";
+        }
+    }
+
+private:
+    static interned_key make_probe(const key_type & key) {
+        return interned_key::make_probe(key.data(), key.size());
+    }
+};
+
+template <typename Value, std::size_t HashFunc, typename Arena, typename Allocator>
+inline void swap(BasicStringDictionary<Value, HashFunc, Arena, Allocator> & lhs,
+                 BasicStringDictionary<Value, HashFunc, Arena, Allocator> & rhs) {
+    lhs.swap(rhs);
+}
+
+template <typename Value>
+using StringDictionary_Time31 = BasicStringDictionary<Value, HashFunc_Time31>;
+
+template <typename Value>
+using StringDictionary_Time31Std = BasicStringDictionary<Value, HashFunc_Time31Std>;
+
+#if JSTD_HAVE_SSE42_CRC32C
+template <typename Value>
+using StringDictionary = BasicStringDictionary<Value, HashFunc_CRC32C>;
+#else
+template <typename Value>
+using StringDictionary = BasicStringDictionary<Value, HashFunc_Time31>;
+#endif // JSTD_HAVE_SSE42_CRC32C
+
+} // namespace jstd
+
+#endif // JSTD_HASH_STRING_DICTIONARY_H
@@ -0,0 +1,261 @@
+
+#ifndef JSTD_MEMORY_TRACKING_ALLOCATOR_H
+#define JSTD_MEMORY_TRACKING_ALLOCATOR_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+#include "jstd/basic/stdsize.h"
+
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>       // For std::atomic<T>
+#include <memory>       // For std::allocator<T>, std::allocator_traits<T>
+#include <new>          // For placement new
+#include <type_traits>  // For std::true_type, std::false_type
+#include <utility>      // For std::forward<T>
+
+#include "jstd/allocator.h"
+#include "jstd/type_traits.h"
+#include "jstd/support/BitUtils.h"
+
+namespace jstd {
+
+//
+// The allocation statistics of a container instance.
+//
+// The counters are relaxed atomics, because the global() fallback is shared
+// by all the threads (e.g. the multithreaded benchmarks). The counters are
+// consistent with each other only when no allocation is in progress, and
+// peak_bytes is the peak of live_bytes observed by the allocating thread.
+//
+struct allocation_stats {
+    typedef std::size_t size_type;
+    typedef std::atomic<size_type> counter_type;
+
+    // The size histogram is grouped by power of 2: [2^n, 2^(n+1)) bytes.
+    static const size_type kHistogramSize = sizeof(size_type) * 8;
+
+    counter_type live_bytes;
+    counter_type peak_bytes;
+    counter_type total_bytes;
+    counter_type alloc_count;
+    counter_type dealloc_count;
+    counter_type histogram[kHistogramSize];
+
+    allocation_stats() {
+        this->reset();
+    }
+
+    allocation_stats(const allocation_stats &) = delete;
+    allocation_stats & operator = (const allocation_stats &) = delete;
+
+    void reset() {
+        this->live_bytes.store(0, std::memory_order_relaxed);
+        this->peak_bytes.store(0, std::memory_order_relaxed);
+        this->total_bytes.store(0, std::memory_order_relaxed);
+        this->alloc_count.store(0, std::memory_order_relaxed);
+        this->dealloc_count.store(0, std::memory_order_relaxed);
+        for (size_type i = 0; i < kHistogramSize; i++) {
+            this->histogram[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    size_type live_count() const {
+        return (this->alloc_count.load(std::memory_order_relaxed) -
+                this->dealloc_count.load(std::memory_order_relaxed));
+    }
+
+    static size_type size_class(size_type bytes) {
+        return (bytes != 0) ? size_type(BitUtils::bsr64(static_cast<std::uint64_t>(bytes))) : 0;
+    }
+
+    void on_allocate(size_type bytes) {
+        size_type live_bytes = this->live_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+        this->total_bytes.fetch_add(bytes, std::memory_order_relaxed);
+        this->alloc_count.fetch_add(1, std::memory_order_relaxed);
+        this->histogram[size_class(bytes)].fetch_add(1, std::memory_order_relaxed);
+
+        size_type peak_bytes = this->peak_bytes.load(std::memory_order_relaxed);
+        while (live_bytes > peak_bytes) {
+            if (this->peak_bytes.compare_exchange_weak(peak_bytes, live_bytes,
+                                                       std::memory_order_relaxed))
+                break;
+        }
+    }
+
+    void on_deallocate(size_type bytes) {
+        size_type live_bytes = this->live_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+        assert(live_bytes >= bytes);
+        (void)live_bytes;
+        this->dealloc_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    double bytes_per_entry(size_type entries) const {
+        return (entries != 0) ?
+               (double(this->live_bytes.load(std::memory_order_relaxed)) / entries) : 0.0;
+    }
+
+    // The statistics of the allocators which are created out of any tracking scope.
+    static allocation_stats & global() {
+        static allocation_stats s_global_stats;
+        return s_global_stats;
+    }
+
+    static allocation_stats *& current_ptr() {
+        static thread_local allocation_stats * s_current_stats = nullptr;
+        return s_current_stats;
+    }
+
+    static allocation_stats * current() {
+        allocation_stats * stats = current_ptr();
+        return (stats != nullptr) ? stats : &global();
+    }
+};
+
+//
+// The tracking_allocator<T> created (default constructed) in the scope will
+// record the allocations to the specified allocation_stats, even if it's used
+// after the scope is end, so create the container in the scope.
+//
+class allocation_tracking_scope {
+private:
+    allocation_stats * prev_stats_;
+
+public:
+    explicit allocation_tracking_scope(allocation_stats & stats)
+        : prev_stats_(allocation_stats::current_ptr()) {
+        allocation_stats::current_ptr() = &stats;
+    }
+
+    ~allocation_tracking_scope() {
+        allocation_stats::current_ptr() = this->prev_stats_;
+    }
+
+    allocation_tracking_scope(const allocation_tracking_scope &) = delete;
+    allocation_tracking_scope & operator = (const allocation_tracking_scope &) = delete;
+};
+
+//
+// Rebind a allocator, support the jstd allocators (rebind<U>::type)
+// and the standard allocators (rebind<U>::other or Alloc<U, Args...>).
+//
+template <typename Alloc, typename U, typename = void>
+struct rebind_allocator {
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<U> type;
+};
+
+template <typename Alloc, typename U>
+struct rebind_allocator<Alloc, U, void_t<typename Alloc::template rebind<U>::type>> {
+    typedef typename Alloc::template rebind<U>::type type;
+};
+
+//
+// tracking_allocator<T, Inner>
+//
+// A adaptor of the Inner allocator, it records the live bytes, the peak bytes,
+// the allocation counts and the size histogram to a allocation_stats.
+//
+template <typename T, typename Inner = std::allocator<T>>
+struct tracking_allocator : public allocator_base<tracking_allocator<T, Inner>, T> {
+    typedef tracking_allocator<T, Inner>                this_type;
+    typedef allocator_base<this_type, T>                base_type;
+    typedef typename rebind_allocator<Inner, T>::type   inner_type;
+
+    typedef typename base_type::value_type          value_type;
+    typedef typename base_type::pointer             pointer;
+    typedef typename base_type::const_pointer       const_pointer;
+    typedef typename base_type::reference           reference;
+    typedef typename base_type::const_reference     const_reference;
+
+    typedef typename base_type::difference_type     difference_type;
+    typedef typename base_type::size_type           size_type;
+
+    typedef std::true_type  propagate_on_container_copy_assignment;
+    typedef std::true_type  propagate_on_container_move_assignment;
+    typedef std::true_type  propagate_on_container_swap;
+    typedef std::false_type is_always_equal;
+
+    template <typename Other>
+    struct rebind {
+        typedef tracking_allocator<Other, typename rebind_allocator<Inner, Other>::type> other;
+        typedef other type;
+    };
+
+private:
+    inner_type          inner_;
+    allocation_stats *  stats_;
+
+    template <typename, typename> friend struct tracking_allocator;
+
+public:
+    tracking_allocator() noexcept
+        : inner_(), stats_(allocation_stats::current()) {}
+    explicit tracking_allocator(allocation_stats & stats) noexcept
+        : inner_(), stats_(&stats) {}
+    tracking_allocator(const this_type & other) noexcept
+        : inner_(other.inner_), stats_(other.stats_) {}
+    template <typename U, typename OtherInner>
+    tracking_allocator(const tracking_allocator<U, OtherInner> & other) noexcept
+        : inner_(other.inner_), stats_(other.stats_) {}
+
+    this_type & operator = (const this_type & other) noexcept {
+        this->inner_ = other.inner_;
+        this->stats_ = other.stats_;
+        return *this;
+    }
+
+    ~tracking_allocator() {}
+
+    allocation_stats & stats() const { return *(this->stats_); }
+    const inner_type & inner() const { return this->inner_; }
+
+    pointer allocate(size_type count, const void * = nullptr) {
+        pointer ptr = this->inner_.allocate(count);
+        if (likely(ptr != nullptr)) {
+            this->stats_->on_allocate(count * sizeof(value_type));
+        }
+        return ptr;
+    }
+
+    void deallocate(pointer ptr, size_type count) {
+        assert(ptr != nullptr);
+        this->stats_->on_deallocate(count * sizeof(value_type));
+        this->inner_.deallocate(ptr, count);
+    }
+
+    // The standard allocator semantics, allocator_base<T>::destroy() will also deallocate.
+    template <typename U, typename ...Args>
+    void construct(U * ptr, Args && ... args) {
+        assert(ptr != nullptr);
+        ::new (static_cast<void *>(ptr)) U(std::forward<Args>(args)...);
+    }
+
+    template <typename U>
+    void destroy(U * ptr) {
+        assert(ptr != nullptr);
+        ptr->~U();
+    }
+
+    bool is_auto_release() const { return true; }
+    bool is_nothrow() const { return false; }
+
+    template <typename U, typename OtherInner>
+    bool operator == (const tracking_allocator<U, OtherInner> & other) const {
+        return (this->stats_ == other.stats_);
+    }
+
+    template <typename U, typename OtherInner>
+    bool operator != (const tracking_allocator<U, OtherInner> & other) const {
+        return (this->stats_ != other.stats_);
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_MEMORY_TRACKING_ALLOCATOR_H
@@ -0,0 +1,547 @@
+
+#ifndef JSTD_STRING_DTOA_H
+#define JSTD_STRING_DTOA_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+#include "jstd/basic/stdsize.h"
+
+#include <stdio.h>      // For snprintf()
+#include <string.h>     // For memcpy()
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "jstd/support/BitUtils.h"
+
+//
+// The shortest round-trip double/float to string conversion, it's base on
+// the Grisu2 algorithm of Florian Loitsch:
+//
+//   "Printing Floating-Point Numbers Quickly and Accurately with Integers" (PLDI 2010).
+//
+// The output always parses back (strtod / strtof) to the same value, and is
+// the shortest in about 99.9% cases, otherwise it's one digit longer.
+//
+
+namespace jstd {
+
+// The max length of dtoa() and ftoa() output, include the sign, exclude the null terminator.
+static const std::size_t kMaxDtoaSize = 32;
+
+// The max precision of dtoa_fixed(), a larger precision is clamped.
+static const int kMaxFixedPrecision = 64;
+
+// The max length of dtoa_fixed() output: sign + 309 integer digits + '.' + precision.
+static const std::size_t kMaxDtoaFixedSize = 1 + 309 + 1 + kMaxFixedPrecision;
+
+namespace detail {
+
+struct diy_fp {
+    uint64_t f;
+    int      e;
+
+    diy_fp() noexcept : f(0), e(0) {}
+    diy_fp(uint64_t _f, int _e) noexcept : f(_f), e(_e) {}
+
+    diy_fp operator - (const diy_fp & rhs) const {
+        assert(this->e == rhs.e);
+        assert(this->f >= rhs.f);
+        return diy_fp(this->f - rhs.f, this->e);
+    }
+
+    // The high 64 bits of the 128 bits product, rounded.
+    diy_fp operator * (const diy_fp & rhs) const {
+        static const uint64_t kMask32 = 0xFFFFFFFFULL;
+        uint64_t a = this->f >> 32;
+        uint64_t b = this->f & kMask32;
+        uint64_t c = rhs.f >> 32;
+        uint64_t d = rhs.f & kMask32;
+        uint64_t ac = a * c;
+        uint64_t bc = b * c;
+        uint64_t ad = a * d;
+        uint64_t bd = b * d;
+        uint64_t tmp = (bd >> 32) + (ad & kMask32) + (bc & kMask32);
+        tmp += (1ULL << 31);    // Round
+        return diy_fp(ac + (ad >> 32) + (bc >> 32) + (tmp >> 32), this->e + rhs.e + 64);
+    }
+
+    diy_fp normalize() const {
+        assert(this->f != 0);
+        int shift = 63 - static_cast<int>(BitUtils::bsr64(this->f));
+        return diy_fp(this->f << shift, this->e - shift);
+    }
+};
+
+//
+// The floating point layout: double (52, 11) or float (23, 8).
+//
+template <typename FloatT>
+struct float_layout;
+
+template <>
+struct float_layout<double> {
+    typedef uint64_t bits_type;
+    static const int kSignificandSize = 52;
+    static const int kExponentBias = 0x3FF + kSignificandSize;
+    static const int kMinExponent = 1 - kExponentBias;
+    static const bits_type kSignMask = 0x8000000000000000ULL;
+    static const bits_type kExponentMask = 0x7FF0000000000000ULL;
+    static const bits_type kSignificandMask = 0x000FFFFFFFFFFFFFULL;
+    static const bits_type kHiddenBit = 0x0010000000000000ULL;
+};
+
+template <>
+struct float_layout<float> {
+    typedef uint32_t bits_type;
+    static const int kSignificandSize = 23;
+    static const int kExponentBias = 0x7F + kSignificandSize;
+    static const int kMinExponent = 1 - kExponentBias;
+    static const bits_type kSignMask = 0x80000000UL;
+    static const bits_type kExponentMask = 0x7F800000UL;
+    static const bits_type kSignificandMask = 0x007FFFFFUL;
+    static const bits_type kHiddenBit = 0x00800000UL;
+};
+
+template <typename FloatT>
+static inline
+typename float_layout<FloatT>::bits_type float_to_bits(FloatT value) {
+    typename float_layout<FloatT>::bits_type bits;
+    std::memcpy(&bits, &value, sizeof(value));
+    return bits;
+}
+
+// The value must be finite and positive.
+template <typename FloatT>
+static inline
+void float_to_diy_fp(FloatT value, diy_fp & v, diy_fp & m_minus, diy_fp & m_plus) {
+    typedef float_layout<FloatT> layout;
+    typedef typename layout::bits_type bits_type;
+
+    bits_type bits = float_to_bits(value);
+    int biased_e = static_cast<int>((bits & layout::kExponentMask) >> layout::kSignificandSize);
+    bits_type significand = bits & layout::kSignificandMask;
+    if (likely(biased_e != 0)) {
+        v.f = static_cast<uint64_t>(significand + layout::kHiddenBit);
+        v.e = biased_e - layout::kExponentBias;
+    }
+    else {
+        v.f = static_cast<uint64_t>(significand);
+        v.e = layout::kMinExponent;
+    }
+
+    // The boundaries are the middle points to the neighbour values.
+    m_plus = diy_fp((v.f << 1) + 1, v.e - 1).normalize();
+    if ((v.f == static_cast<uint64_t>(layout::kHiddenBit)) && (biased_e > 1))
+        m_minus = diy_fp((v.f << 2) - 1, v.e - 2);
+    else
+        m_minus = diy_fp((v.f << 1) - 1, v.e - 1);
+    m_minus.f <<= (m_minus.e - m_plus.e);
+    m_minus.e = m_plus.e;
+}
+
+// The normalized 10^k (k = -348, -340, ..., 340).
+static inline
+diy_fp get_cached_power(int e, int & K) {
+    static const uint64_t kCachedPowers_F[] = {
+    UINT64_C(0xfa8fd5a0081c0288), UINT64_C(0xbaaee17fa23ebf76), UINT64_C(0x8b16fb203055ac76), UINT64_C(0xcf42894a5dce35ea),
+    UINT64_C(0x9a6bb0aa55653b2d), UINT64_C(0xe61acf033d1a45df), UINT64_C(0xab70fe17c79ac6ca), UINT64_C(0xff77b1fcbebcdc4f),
+    UINT64_C(0xbe5691ef416bd60c), UINT64_C(0x8dd01fad907ffc3c), UINT64_C(0xd3515c2831559a83), UINT64_C(0x9d71ac8fada6c9b5),
+    UINT64_C(0xea9c227723ee8bcb), UINT64_C(0xaecc49914078536d), UINT64_C(0x823c12795db6ce57), UINT64_C(0xc21094364dfb5637),
+    UINT64_C(0x9096ea6f3848984f), UINT64_C(0xd77485cb25823ac7), UINT64_C(0xa086cfcd97bf97f4), UINT64_C(0xef340a98172aace5),
+    UINT64_C(0xb23867fb2a35b28e), UINT64_C(0x84c8d4dfd2c63f3b), UINT64_C(0xc5dd44271ad3cdba), UINT64_C(0x936b9fcebb25c996),
+    UINT64_C(0xdbac6c247d62a584), UINT64_C(0xa3ab66580d5fdaf6), UINT64_C(0xf3e2f893dec3f126), UINT64_C(0xb5b5ada8aaff80b8),
+    UINT64_C(0x87625f056c7c4a8b), UINT64_C(0xc9bcff6034c13053), UINT64_C(0x964e858c91ba2655), UINT64_C(0xdff9772470297ebd),
+    UINT64_C(0xa6dfbd9fb8e5b88f), UINT64_C(0xf8a95fcf88747d94), UINT64_C(0xb94470938fa89bcf), UINT64_C(0x8a08f0f8bf0f156b),
+    UINT64_C(0xcdb02555653131b6), UINT64_C(0x993fe2c6d07b7fac), UINT64_C(0xe45c10c42a2b3b06), UINT64_C(0xaa242499697392d3),
+    UINT64_C(0xfd87b5f28300ca0e), UINT64_C(0xbce5086492111aeb), UINT64_C(0x8cbccc096f5088cc), UINT64_C(0xd1b71758e219652c),
+    UINT64_C(0x9c40000000000000), UINT64_C(0xe8d4a51000000000), UINT64_C(0xad78ebc5ac620000), UINT64_C(0x813f3978f8940984),
+    UINT64_C(0xc097ce7bc90715b3), UINT64_C(0x8f7e32ce7bea5c70), UINT64_C(0xd5d238a4abe98068), UINT64_C(0x9f4f2726179a2245),
+    UINT64_C(0xed63a231d4c4fb27), UINT64_C(0xb0de65388cc8ada8), UINT64_C(0x83c7088e1aab65db), UINT64_C(0xc45d1df942711d9a),
+    UINT64_C(0x924d692ca61be758), UINT64_C(0xda01ee641a708dea), UINT64_C(0xa26da3999aef774a), UINT64_C(0xf209787bb47d6b85),
+    UINT64_C(0xb454e4a179dd1877), UINT64_C(0x865b86925b9bc5c2), UINT64_C(0xc83553c5c8965d3d), UINT64_C(0x952ab45cfa97a0b3),
+    UINT64_C(0xde469fbd99a05fe3), UINT64_C(0xa59bc234db398c25), UINT64_C(0xf6c69a72a3989f5c), UINT64_C(0xb7dcbf5354e9bece),
+    UINT64_C(0x88fcf317f22241e2), UINT64_C(0xcc20ce9bd35c78a5), UINT64_C(0x98165af37b2153df), UINT64_C(0xe2a0b5dc971f303a),
+    UINT64_C(0xa8d9d1535ce3b396), UINT64_C(0xfb9b7cd9a4a7443c), UINT64_C(0xbb764c4ca7a44410), UINT64_C(0x8bab8eefb6409c1a),
+    UINT64_C(0xd01fef10a657842c), UINT64_C(0x9b10a4e5e9913129), UINT64_C(0xe7109bfba19c0c9d), UINT64_C(0xac2820d9623bf429),
+    UINT64_C(0x80444b5e7aa7cf85), UINT64_C(0xbf21e44003acdd2d), UINT64_C(0x8e679c2f5e44ff8f), UINT64_C(0xd433179d9c8cb841),
+    UINT64_C(0x9e19db92b4e31ba9), UINT64_C(0xeb96bf6ebadf77d9), UINT64_C(0xaf87023b9bf0ee6b)
+    };
+    static const int16_t kCachedPowers_E[] = {
+    -1220, -1193, -1166, -1140, -1113, -1087, -1060, -1034, -1007, -980,
+    -954, -927, -901, -874, -847, -821, -794, -768, -741, -715,
+    -688, -661, -635, -608, -582, -555, -529, -502, -475, -449,
+    -422, -396, -369, -343, -316, -289, -263, -236, -210, -183,
+    -157, -130, -103, -77, -50, -24, 3, 30, 56, 83,
+    109, 136, 162, 189, 216, 242, 269, 295, 322, 348,
+    375, 402, 428, 455, 481, 508, 534, 561, 588, 614,
+    641, 667, 694, 720, 747, 774, 800, 827, 853, 880,
+    907, 933, 960, 986, 1013, 1039, 1066
+    };
+
+    // 0.30102999566398114 = 1 / lg(10)
+    double dk = (-61 - e) * 0.30102999566398114 + 347;
+    int k = static_cast<int>(dk);
+    if (dk - k > 0.0)
+        k++;
+
+    unsigned int index = static_cast<unsigned int>((k >> 3) + 1);
+    K = -(-348 + static_cast<int>(index * 8));
+    assert(index < sizeof(kCachedPowers_F) / sizeof(kCachedPowers_F[0]));
+    return diy_fp(kCachedPowers_F[index], kCachedPowers_E[index]);
+}
+
+static inline
+int count_decimal_digit32(uint32_t n) {
+    if (n < 10) return 1;
+    if (n < 100) return 2;
+    if (n < 1000) return 3;
+    if (n < 10000) return 4;
+    if (n < 100000) return 5;
+    if (n < 1000000) return 6;
+    if (n < 10000000) return 7;
+    if (n < 100000000) return 8;
+    if (n < 1000000000) return 9;
+    return 10;
+}
+
+static inline
+void grisu_round(char * buffer, int len, uint64_t delta, uint64_t rest,
+                 uint64_t ten_kappa, uint64_t wp_w) {
+    while ((rest < wp_w) && ((delta - rest) >= ten_kappa) &&
+           (((rest + ten_kappa) < wp_w) ||      // closer
+            ((wp_w - rest) > (rest + ten_kappa - wp_w)))) {
+        buffer[len - 1]--;
+        rest += ten_kappa;
+    }
+}
+
+static inline
+int digit_gen(const diy_fp & W, const diy_fp & Mp, uint64_t delta,
+              char * buffer, int & K) {
+    static const uint64_t kPow10[20] = {
+        1ULL, 10ULL, 100ULL, 1000ULL, 10000ULL,
+        100000ULL, 1000000ULL, 10000000ULL, 100000000ULL, 1000000000ULL,
+        10000000000ULL, 100000000000ULL, 1000000000000ULL,
+        10000000000000ULL, 100000000000000ULL, 1000000000000000ULL,
+        10000000000000000ULL, 100000000000000000ULL,
+        1000000000000000000ULL, 10000000000000000000ULL
+    };
+
+    const diy_fp one(1ULL << -Mp.e, Mp.e);
+    const diy_fp wp_w = Mp - W;
+    uint32_t p1 = static_cast<uint32_t>(Mp.f >> -one.e);
+    uint64_t p2 = Mp.f & (one.f - 1);
+    int kappa = count_decimal_digit32(p1);
+    int len = 0;
+
+    while (kappa > 0) {
+        uint32_t d = p1 / static_cast<uint32_t>(kPow10[kappa - 1]);
+        p1 %= static_cast<uint32_t>(kPow10[kappa - 1]);
+        if ((d != 0) || (len != 0))
+            buffer[len++] = static_cast<char>('0' + d);
+        kappa--;
+        uint64_t tmp = (static_cast<uint64_t>(p1) << -one.e) + p2;
+        if (tmp <= delta) {
+            K += kappa;
+            grisu_round(buffer, len, delta, tmp, kPow10[kappa] << -one.e, wp_w.f);
+            return len;
+        }
+    }
+
+    // kappa = 0
+    for (;;) {
+        p2 *= 10;
+        delta *= 10;
+        char d = static_cast<char>(p2 >> -one.e);
+        if ((d != 0) || (len != 0))
+            buffer[len++] = static_cast<char>('0' + d);
+        p2 &= (one.f - 1);
+        kappa--;
+        if (p2 < delta) {
+            K += kappa;
+            int index = -kappa;
+            grisu_round(buffer, len, delta, p2, one.f,
+                        wp_w.f * ((index < 20) ? kPow10[index] : 0));
+            return len;
+        }
+    }
+}
+
+// Generate the shortest digits, value = digits * 10^K, return the count of digits.
+template <typename FloatT>
+static inline
+int grisu2(FloatT value, char * buffer, int & K) {
+    diy_fp v, w_m, w_p;
+    float_to_diy_fp(value, v, w_m, w_p);
+
+    const diy_fp c_mk = get_cached_power(w_p.e, K);
+    const diy_fp W = v.normalize() * c_mk;
+    diy_fp Wp = w_p * c_mk;
+    diy_fp Wm = w_m * c_mk;
+    Wm.f++;
+    Wp.f--;
+    return digit_gen(W, Wp, Wp.f - Wm.f, buffer, K);
+}
+
+static inline
+char * write_exponent(int K, char * buffer) {
+    if (K < 0) {
+        *buffer++ = '-';
+        K = -K;
+    }
+    else {
+        *buffer++ = '+';
+    }
+
+    if (K >= 100) {
+        *buffer++ = static_cast<char>('0' + K / 100);
+        K %= 100;
+        *buffer++ = static_cast<char>('0' + K / 10);
+        *buffer++ = static_cast<char>('0' + K % 10);
+    }
+    else {
+        *buffer++ = static_cast<char>('0' + K / 10);
+        *buffer++ = static_cast<char>('0' + K % 10);
+    }
+    return buffer;
+}
+
+//
+// Layout the digits like printf("%g"): the decimal notation if the decimal
+// exponent is in [-4, 17), otherwise the scientific notation.
+//
+static inline
+std::size_t prettify(char * buffer, int length, int k) {
+    // 10^(kk - 1) <= value < 10^kk
+    const int kk = length + k;
+
+    if ((length <= kk) && (kk <= 17)) {
+        // 1234e7 -> 12340000000
+        for (int i = length; i < kk; i++)
+            buffer[i] = '0';
+        return static_cast<std::size_t>(kk);
+    }
+    else if ((0 < kk) && (kk <= 17)) {
+        // 1234e-2 -> 12.34
+        std::memmove(&buffer[kk + 1], &buffer[kk], static_cast<std::size_t>(length - kk));
+        buffer[kk] = '.';
+        return static_cast<std::size_t>(length + 1);
+    }
+    else if ((-4 < kk) && (kk <= 0)) {
+        // 1234e-6 -> 0.001234
+        const int offset = 2 - kk;
+        std::memmove(&buffer[offset], &buffer[0], static_cast<std::size_t>(length));
+        buffer[0] = '0';
+        buffer[1] = '.';
+        for (int i = 2; i < offset; i++)
+            buffer[i] = '0';
+        return static_cast<std::size_t>(length + offset);
+    }
+    else if (length == 1) {
+        // 1e30
+        buffer[1] = 'e';
+        return static_cast<std::size_t>(write_exponent(kk - 1, &buffer[2]) - buffer);
+    }
+    else {
+        // 1234e30 -> 1.234e+33
+        std::memmove(&buffer[2], &buffer[1], static_cast<std::size_t>(length - 1));
+        buffer[1] = '.';
+        buffer[length + 1] = 'e';
+        return static_cast<std::size_t>(write_exponent(kk - 1, &buffer[length + 2]) - buffer);
+    }
+}
+
+template <typename FloatT>
+static inline
+std::size_t write_special(FloatT value, char * buffer, bool & is_special) {
+    typedef float_layout<FloatT> layout;
+    typename layout::bits_type bits = float_to_bits(value);
+    char * first = buffer;
+    if ((bits & layout::kSignMask) != 0)
+        *buffer++ = '-';
+
+    is_special = true;
+    if ((bits & layout::kExponentMask) == layout::kExponentMask) {
+        if ((bits & layout::kSignificandMask) != 0) {
+            std::memcpy(buffer, "nan", 3);
+        }
+        else {
+            std::memcpy(buffer, "inf", 3);
+        }
+        return static_cast<std::size_t>(buffer + 3 - first);
+    }
+    else if ((bits & ~layout::kSignMask) == 0) {
+        *buffer = '0';
+        return static_cast<std::size_t>(buffer + 1 - first);
+    }
+
+    is_special = false;
+    return static_cast<std::size_t>(buffer - first);
+}
+
+template <typename FloatT>
+static inline
+std::size_t shortest_to_chars(FloatT value, char * buffer) {
+    bool is_special;
+    std::size_t sign = write_special(value, buffer, is_special);
+    if (is_special)
+        return sign;
+
+    if (sign != 0)
+        value = -value;
+
+    int K;
+    int length = grisu2(value, buffer + sign, K);
+    return sign + prettify(buffer + sign, length, K);
+}
+
+static inline
+char * write_uint64(uint64_t value, char * buffer) {
+    char digits[24];
+    char * last = digits + sizeof(digits);
+    char * first = last;
+    do {
+        *--first = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value != 0);
+    std::size_t length = static_cast<std::size_t>(last - first);
+    std::memcpy(buffer, first, length);
+    return buffer + length;
+}
+
+} // namespace detail
+
+//
+// The shortest round-trip string of a double, like printf("%g") with
+// just enough digits. The buffer size must be at least kMaxDtoaSize.
+// Return the length, no null terminator is appended.
+//
+static inline
+std::size_t dtoa(double value, char * buffer) {
+    return detail::shortest_to_chars<double>(value, buffer);
+}
+
+//
+// The shortest round-trip string of a float (parse it back with strtof()).
+//
+static inline
+std::size_t ftoa(float value, char * buffer) {
+    return detail::shortest_to_chars<float>(value, buffer);
+}
+
+//
+// Like printf("%.*f", precision, value), correctly rounded (round half to even).
+// The buffer size must be at least kMaxDtoaFixedSize.
+// Return the length, no null terminator is appended.
+//
+static inline
+std::size_t dtoa_fixed(double value, int precision, char * buffer) {
+    typedef detail::float_layout<double> layout;
+
+    if (precision < 0)
+        precision = 0;
+    else if (precision > kMaxFixedPrecision)
+        precision = kMaxFixedPrecision;
+
+    uint64_t bits = detail::float_to_bits(value);
+    int biased_e = static_cast<int>((bits & layout::kExponentMask) >> layout::kSignificandSize);
+    uint64_t f = bits & layout::kSignificandMask;
+    int e;
+    if (likely(biased_e != 0)) {
+        f += layout::kHiddenBit;
+        e = biased_e - layout::kExponentBias;
+    }
+    else {
+        e = layout::kMinExponent;
+    }
+
+    // Remove the trailing zero bits, value = f * 2^e.
+    if (f != 0) {
+        int zeros = static_cast<int>(BitUtils::bsf64(f));
+        f >>= zeros;
+        e += zeros;
+    }
+    else {
+        e = 0;
+    }
+
+    // The exact path: the integer part fit in uint64_t, and the fraction
+    // part has at most 60 bits, so that (fraction * 10) never overflow.
+    if (unlikely((biased_e == 0x7FF) || (e > 10) || (e < -60))) {
+        int len = ::snprintf(buffer, kMaxDtoaFixedSize + 1, "%.*f", precision, value);
+        return (len > 0) ? static_cast<std::size_t>(len) : 0;
+    }
+
+    char * first = buffer;
+    if ((bits & layout::kSignMask) != 0)
+        *buffer++ = '-';
+
+    uint64_t integer, fraction, mask;
+    int k;
+    if (e >= 0) {
+        integer = f << e;
+        fraction = 0;
+        mask = 0;
+        k = 0;
+    }
+    else {
+        k = -e;
+        integer = f >> k;
+        mask = (1ULL << k) - 1;
+        fraction = f & mask;
+    }
+
+    char * int_first = buffer;
+    buffer = detail::write_uint64(integer, buffer);
+    char * int_last = buffer;
+
+    if (precision > 0) {
+        *buffer++ = '.';
+        for (int i = 0; i < precision; i++) {
+            fraction *= 10;
+            *buffer++ = static_cast<char>('0' + (fraction >> k));
+            fraction &= mask;
+        }
+    }
+
+    // Round half to even.
+    if (k > 0) {
+        uint64_t half = 1ULL << (k - 1);
+        char last_digit = (precision > 0) ? *(buffer - 1) : *(int_last - 1);
+        if ((fraction > half) || ((fraction == half) && (((last_digit - '0') & 1) != 0))) {
+            char * digit = buffer - 1;
+            for (;;) {
+                if (*digit == '.') {
+                    digit--;
+                    continue;
+                }
+                if (*digit != '9') {
+                    (*digit)++;
+                    break;
+                }
+                *digit = '0';
+                if (digit == int_first) {
+                    // 9.99 -> 10.00
+                    std::memmove(int_first + 1, int_first, static_cast<std::size_t>(buffer - int_first));
+                    *int_first = '1';
+                    buffer++;
+                    break;
+                }
+                digit--;
+            }
+        }
+    }
+
+    return static_cast<std::size_t>(buffer - first);
+}
+
+} // namespace jstd
+
+#endif // JSTD_STRING_DTOA_H
@@ -30,6 +30,7 @@
 
 #include "jstd/string/char_traits.h"
 #include "jstd/string/string_view.h"
+#include "jstd/string/dtoa.h"
 #include "jstd/math/log10_int.h"
 
 namespace jstd {
@@ -193,7 +194,7 @@ std::ssize_t count_digits(int32_t i32) {
         u32 = static_cast<uint32_t>(i32);
     }
     else {
-        u32 = static_cast<uint32_t>(-i32);
+        u32 = ~static_cast<uint32_t>(i32) + 1;
     }
     return std::ssize_t(i32 < 0) + count_digits<delta>(u32);
 }
@@ -290,7 +291,7 @@ std::ssize_t count_digits(int64_t i64) {
         u64 = static_cast<uint64_t>(i64);
     }
     else {
-        u64 = static_cast<uint64_t>(-i64);
+        u64 = ~static_cast<uint64_t>(i64) + 1;
     }
     return std::ssize_t(i64 < 0) + count_digits<delta>(u64);
 }
@@ -360,7 +361,7 @@ std::size_t itoa(std::basic_string<CharTy> & str, int32_t i32) {
     }
     else {
         str.push_back(CharTy('-'));
-        u32 = static_cast<uint32_t>(-i32);
+        u32 = ~static_cast<uint32_t>(i32) + 1;
         sign = 1;
     }
     std::size_t data_len = itoa(str, u32);
@@ -370,9 +371,9 @@ std::size_t itoa(std::basic_string<CharTy> & str, int32_t i32) {
 template <typename CharTy>
 inline
 std::size_t itoa(std::basic_string<CharTy> & str, uint64_t u64) {
-    CharTy buf[32]; // Maximum usage is 19
-    CharTy * buf_end  = &buf[sizeof(buf) - 14];
-    CharTy * buf_last = &buf[sizeof(buf) - 13]; // 32 - 19 = 13
+    CharTy buf[32]; // Maximum usage is 20
+    CharTy * buf_end  = &buf[sizeof(buf) - 11];
+    CharTy * buf_last = &buf[sizeof(buf) - 12]; // 32 - 20 = 12
 
     uint64_t num;
     while (u64 >= 100ULL) {
@@ -417,7 +418,7 @@ std::size_t itoa(std::basic_string<CharTy> & str, int64_t i64) {
     }
     else {
         str.push_back(CharTy('-'));
-        u64 = static_cast<uint64_t>(-i64);
+        u64 = ~static_cast<uint64_t>(i64) + 1;
         sign = 1;
     }
     std::size_t data_len = itoa(str, u64);
@@ -438,7 +439,7 @@ inline
 std::size_t itoa(jstd::basic_string_view<CharTy> & str,
                  uint32_t u32, std::size_t digits) {
     assert(digits > 0);
-    CharTy * buf_last = const_cast<CharTy *>(str.c_str() + digits - 1);
+    CharTy * buf_last = const_cast<CharTy *>(str.c_str() + str.size() + digits - 1);
     CharTy * buf_end = buf_last;
 
     uint32_t num;
@@ -513,10 +514,10 @@ std::size_t itoa(jstd::basic_string_view<CharTy> & str,
             break;
     }
 
-    assert((const CharTy *)buf_last < str.c_str());
+    assert((const CharTy *)buf_last < (str.c_str() + str.size()));
     assert(buf_end > buf_last);
 
-    str.commit(digits);
+    str.expand(digits);
 
     std::size_t data_len = std::size_t(buf_end - buf_last);
     assert(data_len == digits);
@@ -530,7 +531,7 @@ inline
 std::size_t itoa_slow(jstd::basic_string_view<CharTy> & str,
                       uint32_t u32, std::size_t digits) {
     assert(digits > 0);
-    CharTy * buf_last = const_cast<CharTy *>(str.c_str() + digits - 1);
+    CharTy * buf_last = const_cast<CharTy *>(str.c_str() + str.size() + digits - 1);
     CharTy * buf_end = buf_last;
 
     uint32_t num;
@@ -557,10 +558,10 @@ std::size_t itoa_slow(jstd::basic_string_view<CharTy> & str,
     *buf_last = static_cast<CharTy>(u32) + CharTy('0');
     buf_last--;
 
-    assert((const CharTy *)buf_last < str.c_str());
+    assert((const CharTy *)buf_last < (str.c_str() + str.size()));
     assert(buf_last < buf_end);
 
-    str.commit(digits);
+    str.expand(digits);
 
     std::size_t data_len = std::size_t(buf_end - buf_last);
     assert(data_len == digits);
@@ -581,7 +582,7 @@ std::size_t itoa(jstd::basic_string_view<CharTy> & str,
     }
     else {
         str.push_back(CharTy('-'));
-        u32 = static_cast<uint32_t>(-i32);
+        u32 = ~static_cast<uint32_t>(i32) + 1;
         sign = 1;
     }
     std::size_t data_len = itoa(str, u32, digits - sign) + sign;
@@ -594,11 +595,17 @@ template <typename CharTy>
 inline
 std::size_t itoa(jstd::basic_string_view<CharTy> & str,
                  uint64_t u64, std::size_t digits) {
-    CharTy * buf_last = const_cast<CharTy *>(str.c_str() + digits - 1);
+    CharTy * buf_last = const_cast<CharTy *>(str.c_str() + str.size() + digits - 1);
     CharTy * buf_end = buf_last;
 
     uint64_t num;
     switch (digits) {
+        case 20:
+            num = u64 % 10ULL;
+            u64 /= 10ULL;
+            *buf_last = static_cast<CharTy>(num) + CharTy('0');
+            buf_last--;
+
         case 19:
             num = u64 % 10ULL;
             u64 /= 10ULL;
@@ -723,10 +730,10 @@ std::size_t itoa(jstd::basic_string_view<CharTy> & str,
             break;
     }
 
-    assert((const CharTy *)buf_last < str.c_str());
+    assert((const CharTy *)buf_last < (str.c_str() + str.size()));
     assert(buf_last < buf_end);
 
-    str.commit(digits);
+    str.expand(digits);
 
     std::size_t data_len = std::size_t(buf_end - buf_last);
     assert(data_len == digits);
@@ -747,7 +754,7 @@ std::size_t itoa(jstd::basic_string_view<CharTy> & str,
     }
     else {
         str.push_back(CharTy('-'));
-        u64 = static_cast<uint64_t>(-i64);
+        u64 = ~static_cast<uint64_t>(i64) + 1;
         sign = 1;
     }
     std::size_t data_len = itoa(str, u64, digits - sign) + sign;
@@ -869,7 +876,7 @@ std::size_t itoa(std::basic_string<CharTy> & str,
     }
     else {
         str.push_back(CharTy('-'));
-        u32 = static_cast<uint32_t>(-i32);
+        u32 = ~static_cast<uint32_t>(i32) + 1;
         sign = 1;
     }
     std::size_t data_len = itoa(str, u32, digits - sign) + sign;
@@ -882,12 +889,18 @@ template <typename CharTy>
 inline
 std::size_t itoa(std::basic_string<CharTy> & str,
                  uint64_t u64, std::size_t digits) {
-    CharTy buf[32]; // Maximum usage is 19
-    CharTy * buf_end  = &buf[sizeof(buf) - 14];
-    CharTy * buf_last = &buf[sizeof(buf) - 13]; // 32 - 19 = 13
+    CharTy buf[32]; // Maximum usage is 20
+    CharTy * buf_end  = &buf[sizeof(buf) - 11];
+    CharTy * buf_last = &buf[sizeof(buf) - 12]; // 32 - 20 = 12
 
     uint64_t num;
     switch (digits) {
+        case 20:
+            num = u64 % 10ULL;
+            u64 /= 10ULL;
+            *buf_last = static_cast<CharTy>(num) + CharTy('0');
+            buf_last--;
+
         case 19:
             num = u64 % 10ULL;
             u64 /= 10ULL;
@@ -1035,7 +1048,7 @@ std::size_t itoa(std::basic_string<CharTy> & str,
     }
     else {
         str.push_back(CharTy('-'));
-        u64 = static_cast<uint64_t>(-i64);
+        u64 = ~static_cast<uint64_t>(i64) + 1;
         sign = 1;
     }
     std::size_t data_len = itoa(str, u64, digits - sign) + sign;
@@ -1044,6 +1057,23 @@ std::size_t itoa(std::basic_string<CharTy> & str,
     return digits;
 }
 
+//
+// The count of the floating point arguments, the size pass keeps the digits
+// of them in a buffer of sprintf_float_count<Args...>::value * kMaxDtoaFixedSize
+// chars, so the output pass doesn't convert them again.
+//
+template <typename ...Args>
+struct sprintf_float_count {
+    static constexpr std::size_t value = 0;
+};
+
+template <typename Arg1, typename ...Args>
+struct sprintf_float_count<Arg1, Args...> {
+    static constexpr std::size_t value =
+        (std::is_floating_point<typename std::decay<Arg1>::type>::value ? 1 : 0) +
+        sprintf_float_count<Args...>::value;
+};
+
 template <typename CharTy>
 struct sprintf_fmt_node {
     typedef CharTy          char_type;
@@ -1181,6 +1211,375 @@ void throw_sprintf_exception(std::ssize_t err_code, std::ssize_t pos, std::size_
     }
 }
 
+//
+// The specifier after '%': "[.precision]type", the precision is -1 if it's omitted.
+//
+template <typename CharTy>
+struct sprintf_spec {
+    int     precision;
+    CharTy  type;
+};
+
+//
+// Parse the specifier "[.N]c", fmt points to the char after '%', and it's advanced
+// to the next char of the type char. The size pass, the output pass and the
+// precompiled format all use it, so they always agree on where a specifier ends.
+// Return false if the format is ended before the type char, fmt is not changed.
+//
+template <typename CharTy>
+inline
+bool parse_sprintf_spec(const CharTy * & fmt, sprintf_spec<CharTy> & spec) {
+    const CharTy * cur = fmt;
+    spec.precision = -1;
+    if (*cur == CharTy('.')) {
+        cur++;
+        spec.precision = 0;
+        while ((*cur >= CharTy('0')) && (*cur <= CharTy('9'))) {
+            if (spec.precision <= kMaxFixedPrecision)
+                spec.precision = spec.precision * 10 + static_cast<int>(*cur - CharTy('0'));
+            cur++;
+        }
+        if (spec.precision > kMaxFixedPrecision)
+            spec.precision = kMaxFixedPrecision;
+    }
+
+    spec.type = *cur;
+    if (spec.type == CharTy('\0'))
+        return false;
+
+    fmt = cur + 1;
+    return true;
+}
+
+//
+// Format a floating point value by the specifier ("f", ".Nf", "g", "e" and so on),
+// fmt points to the char after '%', and it's advanced to the next char of the
+// specifier. "%f" and "%g" are native, "%g" without precision is the shortest
+// round-trip string. The others fall back to snprintf(), long double is formatted
+// as double. The buf size must be at least (kMaxDtoaFixedSize + 1).
+//
+template <typename CharTy, typename FloatT>
+inline
+bool format_float_spec(char * buf, const CharTy * & fmt, FloatT value, std::size_t & length) {
+    typedef typename make_unsigned_char<CharTy>::type UCharTy;
+
+    const CharTy * spec = fmt;
+    sprintf_spec<CharTy> float_spec;
+    if (!parse_sprintf_spec(spec, float_spec)) {
+        length = 0;
+        return false;
+    }
+
+    int precision = float_spec.precision;
+
+    bool use_libc = false;
+    UCharTy sp = static_cast<UCharTy>(float_spec.type);
+    switch (sp) {
+    case UCharTy('f'):
+        length = dtoa_fixed(static_cast<double>(value), (precision >= 0) ? precision : 6, buf);
+        break;
+
+    case UCharTy('g'):
+        if (precision < 0) {
+            if (std::is_same<FloatT, float>::value)
+                length = ftoa(static_cast<float>(value), buf);
+            else
+                length = dtoa(static_cast<double>(value), buf);
+        }
+        else {
+            use_libc = true;
+        }
+        break;
+
+    case UCharTy('A'):
+    case UCharTy('E'):
+    case UCharTy('F'):
+    case UCharTy('G'):
+    case UCharTy('a'):
+    case UCharTy('e'):
+        use_libc = true;
+        break;
+
+    default:
+        length = 0;
+        return false;
+    }
+
+    if (use_libc) {
+        char libc_fmt[8] = { '%', '.', '*', static_cast<char>(sp), '\0' };
+        int len = ::snprintf(buf, kMaxDtoaFixedSize + 1, libc_fmt,
+                             precision, static_cast<double>(value));
+        if (len < 0)
+            len = 0;
+        else if (len > static_cast<int>(kMaxDtoaFixedSize))
+            len = static_cast<int>(kMaxDtoaFixedSize);
+        length = static_cast<std::size_t>(len);
+    }
+
+    fmt = spec;
+    return true;
+}
+
+//
+// basic_precompiled_format<CharTy, MaxNodes>
+//
+// A format string that is parsed only once, it holds the sprintf_fmt_node list
+// in a fixed storage. Declare it as a (function local) static object to parse
+// the literal format at first use, and then basic_formatter::sprintf() only
+// sizes and writes the arguments, no any heap allocation per call:
+//
+//   static const jstd::precompiled_format s_fmt("id = %d, value = %u\n");
+//   fmt.sprintf(str, s_fmt, id, value);
+//
+// The format string must be outlive the precompiled format object.
+//
+template <typename CharTy, std::size_t MaxNodes = 32>
+class basic_precompiled_format {
+public:
+    typedef CharTy                      char_type;
+    typedef std::size_t                 size_type;
+    typedef std::ssize_t                ssize_type;
+    typedef sprintf_fmt_node<CharTy>    fmt_node_t;
+
+    static constexpr size_type kMaxNodes = MaxNodes;
+
+    static_assert((MaxNodes > 0), "basic_precompiled_format<CharTy, MaxNodes>: MaxNodes must be greater than 0.");
+
+private:
+    const char_type *   fmt_;
+    size_type           node_count_;
+    size_type           arg_count_;
+    size_type           literal_size_;
+    fmt_node_t          nodes_[kMaxNodes];
+
+public:
+    explicit basic_precompiled_format(const char_type * fmt)
+        : fmt_(fmt), node_count_(0), arg_count_(0), literal_size_(0) {
+        assert(fmt != nullptr);
+        this->parse(fmt);
+    }
+
+    ~basic_precompiled_format() {}
+
+    basic_precompiled_format(const basic_precompiled_format &) = default;
+    basic_precompiled_format & operator = (const basic_precompiled_format &) = default;
+
+    const char_type * format() const { return this->fmt_; }
+
+    size_type node_count() const { return this->node_count_; }
+    size_type arg_count() const { return this->arg_count_; }
+    size_type literal_size() const { return this->literal_size_; }
+
+    const fmt_node_t * nodes() const { return &this->nodes_[0]; }
+    const fmt_node_t & node(size_type index) const {
+        assert(index < this->node_count_);
+        return this->nodes_[index];
+    }
+
+private:
+    void push_node(const char_type * first, const char_type * last,
+                   size_type arg_type, const char_type * fmt_first) {
+        if (likely(this->node_count_ < kMaxNodes)) {
+            this->nodes_[this->node_count_].init(first, last, arg_type, 0);
+            this->node_count_++;
+            this->literal_size_ += size_type(last - first);
+        }
+        else {
+            throw std::length_error(
+                "Bad format: too many format nodes, *fmt pos: "
+                + std::to_string(last - fmt_first)
+            );
+        }
+    }
+
+    //
+    // The node layout is the same as sprintf_prepare_space_impl():
+    //   the argument node: [first, last) is the literal, *last is '%', *(last + 1) is the specifier.
+    //   the "%%" node:     [first, last) is the literal, include the first '%'.
+    //
+    void parse(const char_type * fmt) {
+        const char_type * fmt_begin = fmt;
+        const char_type * fmt_first = fmt;
+        while (*fmt != char_type('\0')) {
+            if (likely(*fmt != char_type('%'))) {
+                // is not "%": direct output
+                fmt++;
+            }
+            else {
+                const char_type * arg_first = fmt;
+                fmt++;
+                if (likely(*fmt != char_type('%'))) {
+                    // "%?": specifier
+                    if (*fmt == char_type('\0')) {
+                        throw_sprintf_exception(Sprintf_BadFormat_BrokenEscapeChar,
+                                                (fmt - fmt_begin), 0);
+                    }
+                    this->push_node(fmt_first, arg_first, fmt_node_t::isArg, fmt_begin);
+                    this->arg_count_++;
+                    sprintf_spec<char_type> spec;
+                    if (!parse_sprintf_spec(fmt, spec)) {
+                        throw_sprintf_exception(Sprintf_BadFormat_BrokenEscapeChar,
+                                                (fmt - fmt_begin), 0);
+                    }
+                    fmt_first = fmt;
+                }
+                else {
+                    // "%%" = "%"
+                    this->push_node(fmt_first, fmt, fmt_node_t::isNotArg, fmt_begin);
+                    fmt++;
+                    fmt_first = fmt;
+                }
+            }
+        }
+
+        if (fmt > fmt_first) {
+            this->push_node(fmt_first, fmt, fmt_node_t::isNotArg, fmt_begin);
+        }
+    }
+};
+
+typedef basic_precompiled_format<char>      precompiled_format;
+typedef basic_precompiled_format<wchar_t>   wprecompiled_format;
+
+//
+// The result of basic_formatter::format_to(), size is the full formatted size,
+// if it's greater than the capacity, the output is truncated.
+//
+template <typename OutputIt>
+struct format_to_result {
+    OutputIt    out;
+    std::size_t size;
+    bool        truncated;
+};
+
+//
+// Write the formatted output to a fixed buffer, never write past the capacity,
+// and no null terminator is appended.
+//
+template <typename CharTy>
+class sprintf_buffer_sink {
+public:
+    typedef CharTy          char_type;
+    typedef std::size_t     size_type;
+
+    // Enough for the longest integer and pointer.
+    static constexpr size_type kMaxArgSize = 64;
+
+private:
+    char_type * buf_;
+    size_type   capacity_;
+    size_type   size_;
+
+public:
+    sprintf_buffer_sink(char_type * buf, size_type capacity) noexcept
+        : buf_(buf), capacity_(capacity), size_(0) {
+        assert(buf != nullptr || capacity == 0);
+    }
+
+    char_type * data() const { return this->buf_; }
+    size_type capacity() const { return this->capacity_; }
+    size_type size() const { return this->size_; }
+
+    char_type * out() const {
+        return this->buf_ + ((this->size_ <= this->capacity_) ? this->size_ : this->capacity_);
+    }
+
+    bool truncated() const { return (this->size_ > this->capacity_); }
+
+    void append(const char_type * first, const char_type * last) {
+        assert(last >= first);
+        size_type length = size_type(last - first);
+        if (likely((this->size_ + length) <= this->capacity_)) {
+            std::char_traits<char_type>::copy(this->buf_ + this->size_, first, length);
+        }
+        else if (this->size_ < this->capacity_) {
+            std::char_traits<char_type>::copy(this->buf_ + this->size_, first,
+                                              this->capacity_ - this->size_);
+        }
+        this->size_ += length;
+    }
+
+    template <typename Arg>
+    void append_arg(Arg && arg, size_type data_len) {
+        if (unlikely(data_len == 0))
+            return;
+        // Some itoa() write a null terminator after the digits, so keep a spare char.
+        if (likely((this->size_ + data_len) < this->capacity_)) {
+            jstd::basic_string_view<char_type> str_view(this->buf_ + this->size_, size_type(0));
+            itoa(str_view, std::forward<Arg>(arg), data_len);
+            this->size_ += data_len;
+        }
+        else {
+            char_type arg_buf[kMaxArgSize + 1];
+            if (likely(data_len <= kMaxArgSize)) {
+                jstd::basic_string_view<char_type> str_view(arg_buf, size_type(0));
+                itoa(str_view, std::forward<Arg>(arg), data_len);
+            }
+            else {
+                std::char_traits<char_type>::assign(arg_buf, kMaxArgSize, char_type('?'));
+            }
+            size_type length = (data_len <= kMaxArgSize) ? data_len : kMaxArgSize;
+            this->append(arg_buf, arg_buf + length);
+            this->size_ += (data_len - length);
+        }
+    }
+};
+
+//
+// Write the formatted output to a output iterator, at most limit chars.
+//
+template <typename CharTy, typename OutputIt>
+class sprintf_iterator_sink {
+public:
+    typedef CharTy          char_type;
+    typedef std::size_t     size_type;
+
+    static constexpr size_type kMaxArgSize = sprintf_buffer_sink<CharTy>::kMaxArgSize;
+
+private:
+    OutputIt    out_;
+    size_type   limit_;
+    size_type   size_;
+
+public:
+    explicit sprintf_iterator_sink(OutputIt out, size_type limit = size_type(-1))
+        : out_(out), limit_(limit), size_(0) {
+    }
+
+    OutputIt out() const { return this->out_; }
+    size_type size() const { return this->size_; }
+    bool truncated() const { return (this->size_ > this->limit_); }
+
+    void append(const char_type * first, const char_type * last) {
+        assert(last >= first);
+        while (first != last) {
+            if (likely(this->size_ < this->limit_)) {
+                *this->out_ = *first;
+                ++this->out_;
+            }
+            ++first;
+            this->size_++;
+        }
+    }
+
+    template <typename Arg>
+    void append_arg(Arg && arg, size_type data_len) {
+        if (unlikely(data_len == 0))
+            return;
+        char_type arg_buf[kMaxArgSize + 1];
+        if (likely(data_len <= kMaxArgSize)) {
+            jstd::basic_string_view<char_type> str_view(arg_buf, size_type(0));
+            itoa(str_view, std::forward<Arg>(arg), data_len);
+        }
+        else {
+            std::char_traits<char_type>::assign(arg_buf, kMaxArgSize, char_type('?'));
+        }
+        size_type length = (data_len <= kMaxArgSize) ? data_len : kMaxArgSize;
+        this->append(arg_buf, arg_buf + length);
+        this->size_ += (data_len - length);
+    }
+};
+
 template <typename CharTy>
 struct basic_formatter {
     typedef std::size_t     size_type;
@@ -1192,11 +1591,79 @@ struct basic_formatter {
     typedef sprintf_fmt_node<CharTy>                    fmt_node_t;
     typedef basic_formatter<CharTy>                     this_type;
 
+    // Format a floating point argument to buf, and advance the fmt.
+    template <typename Arg>
+    static bool sprintf_format_float(char_type * buf, const char_type * &fmt,
+                                     Arg && arg, size_type & data_len) {
+        typedef typename std::decay<Arg>::type  ArgT;
+
+        char float_buf[kMaxDtoaFixedSize + 1];
+        bool is_ok;
+        if (std::is_same<ArgT, float>::value)
+            is_ok = format_float_spec(float_buf, fmt, static_cast<float>(arg), data_len);
+        else
+            is_ok = format_float_spec(float_buf, fmt, static_cast<double>(arg), data_len);
+
+        for (size_type i = 0; i < data_len; i++) {
+            buf[i] = static_cast<char_type>(float_buf[i]);
+        }
+        return is_ok;
+    }
+
+    // Size a floating point argument, if float_cache is not nullptr, the digits
+    // are kept in it for the output pass, and float_cache is advanced.
+    template <typename Arg>
+    static bool sprintf_float_length(const char_type * &fmt, Arg && arg, size_type & data_len,
+                                     char_type * &float_cache) {
+        if (float_cache != nullptr) {
+            bool is_ok = sprintf_format_float(float_cache, fmt, std::forward<Arg>(arg), data_len);
+            float_cache += data_len;
+            return is_ok;
+        }
+        else {
+            char_type float_buf[kMaxDtoaFixedSize + 1];
+            return sprintf_format_float(float_buf, fmt, std::forward<Arg>(arg), data_len);
+        }
+    }
+
+    template <typename Arg>
+    static size_type sprintf_append_float(std::basic_string<char_type> & str,
+                                          const char_type * &fmt, Arg && arg) {
+        char_type float_buf[kMaxDtoaFixedSize + 1];
+        size_type data_len = 0;
+        sprintf_format_float(float_buf, fmt, std::forward<Arg>(arg), data_len);
+        str.append(float_buf, data_len);
+        return data_len;
+    }
+
+    // Write a argument with the prepared size, a floating point argument is
+    // copied from the digits kept by the size pass, and float_digits is advanced.
+    template <typename StringType, typename Arg>
+    static size_type sprintf_write_arg(StringType & str, Arg && arg, size_type arg_size,
+                                       const char_type * &float_digits) {
+        typedef typename std::decay<Arg>::type  ArgT;
+
+        if (std::is_floating_point<ArgT>::value) {
+            assert(float_digits != nullptr || arg_size == 0);
+            str.append(float_digits, float_digits + arg_size);
+            float_digits += arg_size;
+            return arg_size;
+        }
+        else if (likely(arg_size != 0)) {
+            return itoa(str, std::forward<Arg>(arg), arg_size);
+        }
+        else {
+            // The argument type is mismatched with the specifier.
+            return 0;
+        }
+    }
+
     template <typename Arg>
     ssize_type sprintf_handle_specifier(const char_type * &fmt,
                                         Arg && arg,
                                         size_type & data_len,
-                                        size_type & ex_arg1) {
+                                        size_type & ex_arg1,
+                                        char_type * &float_cache) {
         typedef typename std::decay<Arg>::type  ArgT;
 
         ssize_type err_code = Sprintf_Success;
@@ -1234,12 +1701,23 @@ struct basic_formatter {
                 break;
             }
 
+        case uchar_type('.'):
+            // "%.Nf": the precision of floating point
+            if (std::is_floating_point<ArgT>::value &&
+                sprintf_float_length(fmt, std::forward<Arg>(arg), data_len, float_cache))
+            {
+                break;
+            }
+            ex_arg1 = sp;
+            err_code = Sprintf_BadFormat_UnknownSpecifier;
+            break;
+
         case uchar_type('A'):
             if (std::is_same<ArgT, float>::value ||
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
+                sprintf_float_length(fmt, std::forward<Arg>(arg), data_len, float_cache);
             }
             break;
 
@@ -1248,7 +1726,7 @@ struct basic_formatter {
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
+                sprintf_float_length(fmt, std::forward<Arg>(arg), data_len, float_cache);
             }
             break;
 
@@ -1257,7 +1735,7 @@ struct basic_formatter {
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
+                sprintf_float_length(fmt, std::forward<Arg>(arg), data_len, float_cache);
             }
             break;
 
@@ -1266,7 +1744,7 @@ struct basic_formatter {
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
+                sprintf_float_length(fmt, std::forward<Arg>(arg), data_len, float_cache);
             }
             break;
 
@@ -1282,7 +1760,7 @@ struct basic_formatter {
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
+                sprintf_float_length(fmt, std::forward<Arg>(arg), data_len, float_cache);
             }
             break;
 
@@ -1314,7 +1792,7 @@ struct basic_formatter {
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
+                sprintf_float_length(fmt, std::forward<Arg>(arg), data_len, float_cache);
             }
             break;
 
@@ -1323,22 +1801,7 @@ struct basic_formatter {
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
-                if (sizeof(Arg) == sizeof(float)) {
-                    f = static_cast<float>(arg);
-                }
-                else if (sizeof(Arg) == sizeof(double)) {
-                    d = static_cast<double>(arg);
-                }
-                else if (sizeof(Arg) == sizeof(long double)) {
-                    ld = static_cast<long double>(arg);
-                }
-                else {
-                    err_code = Sprintf_InvalidArgmument_ErrorFloatType;
-                    return err_code;
-                }
-
-                data_len = 6;
+                sprintf_float_length(fmt, std::forward<Arg>(arg), data_len, float_cache);
             }
             break;
 
@@ -1347,7 +1810,7 @@ struct basic_formatter {
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
+                sprintf_float_length(fmt, std::forward<Arg>(arg), data_len, float_cache);
             }
             break;
 
@@ -1474,12 +1937,27 @@ struct basic_formatter {
                 break;
             }
 
+        case uchar_type('.'):
+            // "%.Nf": the precision of floating point
+            if (std::is_floating_point<ArgT>::value)
+            {
+                const char_type * spec = fmt;
+                data_len = sprintf_append_float(str, spec, std::forward<Arg>(arg));
+                if (likely(spec != fmt)) {
+                    fmt = spec;
+                    break;
+                }
+            }
+            ex_arg1 = sp;
+            err_code = Sprintf_BadFormat_UnknownSpecifier;
+            break;
+
         case uchar_type('A'):
             if (std::is_same<ArgT, float>::value ||
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
+                data_len = sprintf_append_float(str, fmt, std::forward<Arg>(arg));
             }
             break;
 
@@ -1488,7 +1966,7 @@ struct basic_formatter {
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
+                data_len = sprintf_append_float(str, fmt, std::forward<Arg>(arg));
             }
             break;
 
@@ -1497,7 +1975,7 @@ struct basic_formatter {
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
+                data_len = sprintf_append_float(str, fmt, std::forward<Arg>(arg));
             }
             break;
 
@@ -1506,7 +1984,7 @@ struct basic_formatter {
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
+                data_len = sprintf_append_float(str, fmt, std::forward<Arg>(arg));
             }
             break;
 
@@ -1522,7 +2000,7 @@ struct basic_formatter {
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
+                data_len = sprintf_append_float(str, fmt, std::forward<Arg>(arg));
             }
             break;
 
@@ -1554,7 +2032,7 @@ struct basic_formatter {
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
+                data_len = sprintf_append_float(str, fmt, std::forward<Arg>(arg));
             }
             break;
 
@@ -1563,22 +2041,7 @@ struct basic_formatter {
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
-                if (sizeof(Arg) == sizeof(float)) {
-                    f = static_cast<float>(arg);
-                }
-                else if (sizeof(Arg) == sizeof(double)) {
-                    d = static_cast<double>(arg);
-                }
-                else if (sizeof(Arg) == sizeof(long double)) {
-                    ld = static_cast<long double>(arg);
-                }
-                else {
-                    err_code = Sprintf_InvalidArgmument_ErrorFloatType;
-                    return err_code;
-                }
-
-                data_len = 6;
+                data_len = sprintf_append_float(str, fmt, std::forward<Arg>(arg));
             }
             break;
 
@@ -1587,7 +2050,7 @@ struct basic_formatter {
                 std::is_same<ArgT, double>::value ||
                 std::is_same<ArgT, long double>::value)
             {
-                fmt++;
+                data_len = sprintf_append_float(str, fmt, std::forward<Arg>(arg));
             }
             break;
 
@@ -1722,11 +2185,12 @@ Sprintf_Throw_Except:
                 const char_type * arg_first = fmt;
                 fmt++;
                 if (likely(*fmt != char_type('%'))) {
-                    // "%?": specifier
+                    // "%?": specifier, only the size is needed
                     size_type data_len = 0;
+                    char_type * float_cache = nullptr;
                     err_code = sprintf_handle_specifier<Arg1>(
                                     fmt, std::forward<Arg1>(arg1),
-                                    data_len, ex_arg1);
+                                    data_len, ex_arg1, float_cache);
 
                     if (err_code < 0) {
                         goto Sprintf_Throw_Except;
@@ -1756,9 +2220,9 @@ Sprintf_Throw_Except:
         }
 
 Sprintf_Exit:
-        assert(rest_size >= 0);
         ssize_type scan_len = (fmt - fmt_first);
         assert(scan_len >= 0);
+        assert((scan_len + rest_size) >= 0);
 
         size_type total_size = scan_len + rest_size;
         return total_size;
@@ -1770,11 +2234,14 @@ Sprintf_Exit:
     }
 
     size_type sprintf_prepare_space_impl(std::vector<fmt_node_t> & fmt_list,
-                                         const char_type * fmt) {
+                                         const char_type * fmt,
+                                         char_type * &float_cache) {
         assert(fmt != nullptr);
+        JSTD_UNUSED_VAR(float_cache);
         ssize_type rest_size = 0;
         ssize_type err_code = Sprintf_Success;
         size_type ex_arg1 = 0;
+        const char_type * fmt_begin = fmt;
         const char_type * fmt_first = fmt;
         fmt_node_t fmt_info;
         while (*fmt != char_type('\0')) {
@@ -1803,7 +2270,7 @@ Sprintf_Exit:
 
         if (err_code != Sprintf_Success) {
 Sprintf_Throw_Except:
-            ssize_type pos = (fmt - fmt_first);
+            ssize_type pos = (fmt - fmt_begin);
             throw_sprintf_exception(err_code, pos, ex_arg1);
         }
 
@@ -1812,7 +2279,7 @@ Sprintf_Throw_Except:
             fmt_list.push_back(fmt_info);
         }
 
-        ssize_type scan_len = (fmt - fmt_first);
+        ssize_type scan_len = (fmt - fmt_begin);
         assert(scan_len >= 0);
         assert(scan_len >= rest_size);
 
@@ -1823,12 +2290,14 @@ Sprintf_Throw_Except:
     template <typename Arg1, typename ...Args>
     size_type sprintf_prepare_space_impl(std::vector<fmt_node_t> & fmt_list,
                                          const char_type * fmt,
+                                         char_type * &float_cache,
                                          Arg1 && arg1,
                                          Args && ... args) {
         assert(fmt != nullptr);
         ssize_type rest_size = 0;
         ssize_type err_code = Sprintf_Success;
         size_type ex_arg1 = 0;
+        const char_type * fmt_begin = fmt;
         const char_type * fmt_first = fmt;
         const char_type * arg_first = nullptr;
         fmt_node_t fmt_info;
@@ -1845,7 +2314,7 @@ Sprintf_Throw_Except:
                     size_type data_len = 0;
                     err_code = sprintf_handle_specifier<Arg1>(
                                     fmt, std::forward<Arg1>(arg1),
-                                    data_len, ex_arg1);
+                                    data_len, ex_arg1, float_cache);
 
                     if (err_code < 0) {
                         goto Sprintf_Throw_Except;
@@ -1859,7 +2328,7 @@ Sprintf_Throw_Except:
 
                     rest_size += (ssize_type(data_len) - (fmt - arg_first));
                     size_type remain_size = sprintf_prepare_space_impl(
-                                                fmt_list, fmt,
+                                                fmt_list, fmt, float_cache,
                                                 std::forward<Args>(args)...);
                     rest_size += remain_size;
                     goto Sprintf_Exit;
@@ -1879,7 +2348,7 @@ Sprintf_Throw_Except:
 
         if (err_code != Sprintf_Success) {
 Sprintf_Throw_Except:
-            ssize_type pos = (fmt - fmt_first);
+            ssize_type pos = (fmt - fmt_begin);
             throw_sprintf_exception(err_code, pos, ex_arg1);
         }
 
@@ -1891,9 +2360,9 @@ Sprintf_Endof_Exit:
         }
 
 Sprintf_Exit:
-        assert(rest_size >= 0);
-        ssize_type scan_len = (fmt - fmt_first);
+        ssize_type scan_len = (fmt - fmt_begin);
         assert(scan_len >= 0);
+        assert((scan_len + rest_size) >= 0);
 
         size_type total_size = scan_len + rest_size;
         return total_size;
@@ -2001,24 +2470,26 @@ Sprintf_Exit:
         assert(scan_len >= 0);
     }
 
+    //
+    // The fmt_list is built by sprintf_prepare_space(), the literal nodes ("%%")
+    // are written until the next argument node, and all the rest nodes are
+    // written after the last argument.
+    //
     size_type sprintf_direct_output_impl(std::basic_string<char_type> & str,
                                          std::vector<fmt_node_t> & fmt_list,
-                                         size_type index) {
+                                         size_type index,
+                                         const char_type * &float_digits) {
+        JSTD_UNUSED_VAR(float_digits);
         size_type total_size = 0;
-        if (index < fmt_list.size()) {
+        for (; index < fmt_list.size(); index++) {
             fmt_node_t & fmt_info = fmt_list[index];
+            if (fmt_info.is_arg()) {
+                throw std::runtime_error("Error: Wrong fmt_list!");
+            }
             if (fmt_info.fmt_length() > 0) {
                 total_size += fmt_info.fmt_length();
                 str.append(fmt_info.first, fmt_info.last);
             }
-
-            bool is_arg = fmt_info.is_arg();
-            if (!is_arg) {
-                //index++;
-            }
-            else {
-                throw std::runtime_error("Error: Wrong fmt_list!");
-            }
         }
 
         return total_size;
@@ -2028,60 +2499,51 @@ Sprintf_Exit:
     size_type sprintf_direct_output_impl(std::basic_string<char_type> & str,
                                          std::vector<fmt_node_t> & fmt_list,
                                          size_type index,
+                                         const char_type * &float_digits,
                                          Arg1 && arg1,
                                          Args && ... args) {
         size_type total_size = 0;
-        if (index < fmt_list.size()) {
+        while (index < fmt_list.size()) {
             fmt_node_t & fmt_info = fmt_list[index];
+            index++;
             if (fmt_info.fmt_length() > 0) {
                 total_size += fmt_info.fmt_length();
                 str.append(fmt_info.first, fmt_info.last);
             }
-            bool is_arg = fmt_info.is_arg();
-            if (is_arg) {
+            if (fmt_info.is_arg()) {
                 size_type arg_size = fmt_info.arg_size;
-                size_type data_len = itoa(str,
-                                            std::forward<Arg1>(arg1),
-                                            arg_size);
+                size_type data_len = sprintf_write_arg(str, std::forward<Arg1>(arg1),
+                                                       arg_size, float_digits);
 
                 total_size += data_len;
                 size_type remain_size = sprintf_direct_output_impl(
-                                            str, fmt_list, index + 1,
+                                            str, fmt_list, index, float_digits,
                                             std::forward<Args>(args)...);
                 total_size += remain_size;
-            }
-            else {
-                size_type rest_args = sizeof...(args);
-                if (rest_args > 0) {
-                    throw std::runtime_error("Error: Missing argument!");
-                }
+                break;
             }
         }
 
+        // If the format is ended before this argument, the rest arguments
+        // are ignored, the same as sprintf_prepare_space().
         return total_size;
     }
 
     size_type sprintf_prepare_output_impl(jstd::basic_string_view<char_type> & str,
                                           std::vector<fmt_node_t> & fmt_list,
-                                          size_type index) {
+                                          size_type index,
+                                          const char_type * &float_digits) {
+        JSTD_UNUSED_VAR(float_digits);
         size_type total_size = 0;
-        if (index < fmt_list.size()) {
+        for (; index < fmt_list.size(); index++) {
             fmt_node_t & fmt_info = fmt_list[index];
+            if (fmt_info.is_arg()) {
+                throw std::runtime_error("Error: Wrong fmt_list!");
+            }
             if (fmt_info.fmt_length() > 0) {
                 total_size += fmt_info.fmt_length();
                 str.append(fmt_info.first, fmt_info.last);
             }
-
-            bool is_arg = fmt_info.is_arg();
-            if (!is_arg) {
-                //index++;
-            }
-            else {
-                throw std::runtime_error("Error: Wrong fmt_list!");
-            }
-        }
-        else {
-            throw std::runtime_error("Error: fmt_list out of bound!");
         }
 
         return total_size;
@@ -2091,47 +2553,42 @@ Sprintf_Exit:
     size_type sprintf_prepare_output_impl(jstd::basic_string_view<char_type> & str,
                                           std::vector<fmt_node_t> & fmt_list,
                                           size_type index,
+                                          const char_type * &float_digits,
                                           Arg1 && arg1,
                                           Args && ... args) {
         size_type total_size = 0;
-        if (index < fmt_list.size()) {
+        while (index < fmt_list.size()) {
             fmt_node_t & fmt_info = fmt_list[index];
+            index++;
             if (fmt_info.fmt_length() > 0) {
                 total_size += fmt_info.fmt_length();
                 str.append(fmt_info.first, fmt_info.last);
             }
-            bool is_arg = fmt_info.is_arg();
-            if (is_arg) {
+            if (fmt_info.is_arg()) {
                 size_type arg_size = fmt_info.arg_size;
-                size_type data_len = itoa(str,
-                                            std::forward<Arg1>(arg1),
-                                            arg_size);
+                size_type data_len = sprintf_write_arg(str, std::forward<Arg1>(arg1),
+                                                       arg_size, float_digits);
 
                 total_size += data_len;
                 size_type remain_size = sprintf_prepare_output_impl(
-                                            str, fmt_list, index + 1,
+                                            str, fmt_list, index, float_digits,
                                             std::forward<Args>(args)...);
                 total_size += remain_size;
+                break;
             }
-            else {
-                size_type rest_args = sizeof...(args);
-                if (rest_args > 0) {
-                    throw std::runtime_error("Error: Missing argument!");
-                }
-            }
-        }
-        else {
-            throw std::runtime_error("Error: fmt_list out of bound!");
         }
 
+        // If the format is ended before this argument, the rest arguments
+        // are ignored, the same as sprintf_prepare_space().
         return total_size;
     }
 
     template <typename ...Args>
     size_type sprintf_prepare_space(std::vector<fmt_node_t> & fmt_list,
                                     const char_type * fmt,
+                                    char_type * &float_cache,
                                     Args && ... args) {
-        return sprintf_prepare_space_impl(fmt_list, fmt, std::forward<Args>(args)...);
+        return sprintf_prepare_space_impl(fmt_list, fmt, float_cache, std::forward<Args>(args)...);
     }
 
     template <typename ...Args>
@@ -2144,15 +2601,17 @@ Sprintf_Exit:
     template <typename ...Args>
     size_type sprintf_direct_output(std::basic_string<char_type> & str,
                                     std::vector<fmt_node_t> & fmt_list,
+                                    const char_type * float_digits,
                                     Args && ... args) {
-        return sprintf_direct_output_impl(str, fmt_list, 0, std::forward<Args>(args)...);
+        return sprintf_direct_output_impl(str, fmt_list, 0, float_digits, std::forward<Args>(args)...);
     }
 
     template <typename ...Args>
     size_type sprintf_prepare_output(jstd::basic_string_view<char_type> & str,
                                      std::vector<fmt_node_t> & fmt_list,
+                                     const char_type * float_digits,
                                      Args && ... args) {
-        return sprintf_prepare_output_impl(str, fmt_list, 0, std::forward<Args>(args)...);
+        return sprintf_prepare_output_impl(str, fmt_list, 0, float_digits, std::forward<Args>(args)...);
     }
 
     template <typename ...Args>
@@ -2177,9 +2636,13 @@ Sprintf_Exit:
             std::vector<fmt_node_t> fmt_list;
             size_type sz = sizeof...(args);
             fmt_list.reserve(sz * 2);
-            size_type prepare_size = sprintf_prepare_space(fmt_list, fmt, std::forward<Args>(args)...);
+            char_type float_digits[sprintf_float_count<Args...>::value * kMaxDtoaFixedSize + 1];
+            char_type * float_cache = float_digits;
+            size_type prepare_size = sprintf_prepare_space(fmt_list, fmt, float_cache,
+                                                           std::forward<Args>(args)...);
             size_type old_size = str.size();
-            size_type output_size = sprintf_direct_output(str, fmt_list, std::forward<Args>(args)...);
+            size_type output_size = sprintf_direct_output(str, fmt_list, float_digits,
+                                                          std::forward<Args>(args)...);
             assert(output_size == prepare_size);
             size_type new_size = str.size();
             assert(new_size == old_size + output_size);
@@ -2197,13 +2660,18 @@ Sprintf_Exit:
             std::vector<fmt_node_t> fmt_list;
             size_type sz = sizeof...(args);
             fmt_list.reserve(sz * 2);
-            size_type prepare_size = sprintf_prepare_space(fmt_list, fmt, std::forward<Args>(args)...);
+            char_type float_digits[sprintf_float_count<Args...>::value * kMaxDtoaFixedSize + 1];
+            char_type * float_cache = float_digits;
+            size_type prepare_size = sprintf_prepare_space(fmt_list, fmt, float_cache,
+                                                           std::forward<Args>(args)...);
 #if 1
             size_type old_size = str.size();
             // Allocate the prepare buffer space.
             str.resize(old_size + prepare_size);
-            jstd::basic_string_view<char_type> str_view(str);
-            size_type output_size = sprintf_prepare_output(str_view, fmt_list, std::forward<Args>(args)...);
+            // Write from the end of the old string.
+            jstd::basic_string_view<char_type> str_view(&str[0] + old_size, size_type(0));
+            size_type output_size = sprintf_prepare_output(str_view, fmt_list, float_digits,
+                                                           std::forward<Args>(args)...);
             assert(output_size == prepare_size);
 #else
 #ifdef NDEBUG
@@ -2211,13 +2679,15 @@ Sprintf_Exit:
             // Reserve prepare buffer space.
             str_buf.reserve(prepare_size);
             jstd::basic_string_view<char_type> str_view(str_buf);
-            size_type output_size = sprintf_prepare_output(str_view, fmt_list, std::forward<Args>(args)...);
+            size_type output_size = sprintf_prepare_output(str_view, fmt_list, float_digits,
+                                                           std::forward<Args>(args)...);
             assert(output_size == prepare_size);
             str.append(str_buf.begin(), str_buf.begin() + output_size);
 #else
             std::vector<char_type> str_buf(prepare_size);
             jstd::basic_string_view<char_type> str_view(str_buf);
-            size_type output_size = sprintf_prepare_output(str_view, fmt_list, std::forward<Args>(args)...);
+            size_type output_size = sprintf_prepare_output(str_view, fmt_list, float_digits,
+                                                           std::forward<Args>(args)...);
             assert(output_size == prepare_size);
             str.append(str_buf.begin(), str_buf.end());
 #endif
@@ -2228,6 +2698,281 @@ Sprintf_Exit:
         return 0;
     }
 
+    template <std::size_t MaxNodes>
+    size_type sprintf_precompiled_space_impl(const basic_precompiled_format<char_type, MaxNodes> & pfmt,
+                                             size_type index,
+                                             size_type * arg_sizes,
+                                             char_type * &float_cache) {
+        JSTD_UNUSED_VAR(pfmt);
+        JSTD_UNUSED_VAR(index);
+        JSTD_UNUSED_VAR(arg_sizes);
+        JSTD_UNUSED_VAR(float_cache);
+        return 0;
+    }
+
+    template <std::size_t MaxNodes, typename Arg1, typename ...Args>
+    size_type sprintf_precompiled_space_impl(const basic_precompiled_format<char_type, MaxNodes> & pfmt,
+                                             size_type index,
+                                             size_type * arg_sizes,
+                                             char_type * &float_cache,
+                                             Arg1 && arg1,
+                                             Args && ... args) {
+        while (pfmt.node(index).not_is_arg()) {
+            index++;
+        }
+
+        // The specifier is after the '%'.
+        const char_type * fmt = pfmt.node(index).get_arg_first() + 1;
+        size_type data_len = 0;
+        size_type ex_arg1 = 0;
+        ssize_type err_code = sprintf_handle_specifier<Arg1>(
+                                    fmt, std::forward<Arg1>(arg1),
+                                    data_len, ex_arg1, float_cache);
+        if (err_code != Sprintf_Success) {
+            ssize_type pos = (fmt - pfmt.format());
+            throw_sprintf_exception(err_code, pos, ex_arg1);
+        }
+
+        *arg_sizes = data_len;
+        size_type remain_size = sprintf_precompiled_space_impl(
+                                    pfmt, index + 1, arg_sizes + 1, float_cache,
+                                    std::forward<Args>(args)...);
+        return (data_len + remain_size);
+    }
+
+    static inline
+    void sprintf_precompiled_append(jstd::basic_string_view<char_type> & str,
+                                    const fmt_node_t & fmt_info) {
+        // The buffer space is prepared, so copy the literal in a block.
+        size_type length = static_cast<size_type>(fmt_info.fmt_length());
+        std::char_traits<char_type>::copy(str.data() + str.size(), fmt_info.first, length);
+        str.expand(length);
+    }
+
+    template <std::size_t MaxNodes>
+    void sprintf_precompiled_output_impl(jstd::basic_string_view<char_type> & str,
+                                         const basic_precompiled_format<char_type, MaxNodes> & pfmt,
+                                         size_type index,
+                                         const size_type * arg_sizes,
+                                         const char_type * &float_digits) {
+        JSTD_UNUSED_VAR(arg_sizes);
+        JSTD_UNUSED_VAR(float_digits);
+        for (; index < pfmt.node_count(); index++) {
+            const fmt_node_t & fmt_info = pfmt.node(index);
+            assert(fmt_info.not_is_arg());
+            sprintf_precompiled_append(str, fmt_info);
+        }
+    }
+
+    template <std::size_t MaxNodes, typename Arg1, typename ...Args>
+    void sprintf_precompiled_output_impl(jstd::basic_string_view<char_type> & str,
+                                         const basic_precompiled_format<char_type, MaxNodes> & pfmt,
+                                         size_type index,
+                                         const size_type * arg_sizes,
+                                         const char_type * &float_digits,
+                                         Arg1 && arg1,
+                                         Args && ... args) {
+        const fmt_node_t * arg_info;
+        do {
+            arg_info = &pfmt.node(index);
+            sprintf_precompiled_append(str, *arg_info);
+            index++;
+        } while (arg_info->not_is_arg());
+
+        if (likely(*arg_sizes > 0)) {
+            sprintf_write_arg(str, std::forward<Arg1>(arg1), *arg_sizes, float_digits);
+        }
+        sprintf_precompiled_output_impl(str, pfmt, index, arg_sizes + 1, float_digits,
+                                        std::forward<Args>(args)...);
+    }
+
+    //
+    // Use a precompiled format, the format string is not scanned again,
+    // and there is no heap allocation except the growing of str.
+    //
+    template <std::size_t MaxNodes, typename ...Args>
+    size_type sprintf(std::basic_string<char_type> & str,
+                      const basic_precompiled_format<char_type, MaxNodes> & pfmt,
+                      Args && ... args) {
+        if (unlikely(pfmt.arg_count() != sizeof...(Args))) {
+            throw std::invalid_argument(
+                "Invalid argmument: the precompiled format need "
+                + std::to_string(pfmt.arg_count()) + " arguments, but got "
+                + std::to_string(sizeof...(Args))
+            );
+        }
+
+        size_type arg_sizes[sizeof...(Args) + 1];
+        char_type float_digits[sprintf_float_count<Args...>::value * kMaxDtoaFixedSize + 1];
+        char_type * float_cache = float_digits;
+        size_type prepare_size = pfmt.literal_size() +
+                                 sprintf_precompiled_space_impl(pfmt, 0, arg_sizes, float_cache,
+                                                                std::forward<Args>(args)...);
+        size_type old_size = str.size();
+        // Allocate the prepare buffer space.
+        str.resize(old_size + prepare_size);
+        jstd::basic_string_view<char_type> str_view(&str[0] + old_size, size_type(0));
+        const char_type * float_first = float_digits;
+        sprintf_precompiled_output_impl(str_view, pfmt, 0, arg_sizes, float_first,
+                                        std::forward<Args>(args)...);
+        assert(str_view.size() == prepare_size);
+        return prepare_size;
+    }
+
+    template <typename Sink>
+    void format_to_impl(Sink & sink, const char_type * fmt) {
+        assert(fmt != nullptr);
+        ssize_type err_code = Sprintf_Success;
+        size_type ex_arg1 = 0;
+        const char_type * fmt_first = fmt;
+        while (*fmt != char_type('\0')) {
+            if (likely(*fmt != char_type('%'))) {
+                // is not "%": direct output
+                fmt++;
+            }
+            else {
+                fmt++;
+                if (likely(*fmt != char_type('%'))) {
+                    // "%?": specifier
+                    err_code = Sprintf_InvalidArgmument_MissingParameter;
+                    goto Sprintf_Throw_Except;
+                }
+                else {
+                    // "%%" = "%"
+                    sink.append(fmt_first, fmt);
+                    fmt++;
+                    fmt_first = fmt;
+                }
+            }
+        }
+
+        if (err_code != Sprintf_Success) {
+Sprintf_Throw_Except:
+            ssize_type pos = (fmt - fmt_first);
+            throw_sprintf_exception(err_code, pos, ex_arg1);
+        }
+
+        sink.append(fmt_first, fmt);
+    }
+
+    template <typename Sink, typename Arg1, typename ...Args>
+    void format_to_impl(Sink & sink, const char_type * fmt,
+                        Arg1 && arg1, Args && ... args) {
+        assert(fmt != nullptr);
+        ssize_type err_code = Sprintf_Success;
+        size_type ex_arg1 = 0;
+        const char_type * fmt_first = fmt;
+        const char_type * arg_first = nullptr;
+        while (*fmt != char_type('\0')) {
+            if (likely(*fmt != char_type('%'))) {
+                // is not "%": direct output
+                fmt++;
+            }
+            else {
+                arg_first = fmt;
+                fmt++;
+                if (likely(*fmt != char_type('%'))) {
+                    // "%?": specifier, a floating point argument is formatted once
+                    size_type data_len = 0;
+                    char_type float_buf[sprintf_float_count<Arg1>::value * kMaxDtoaFixedSize + 1];
+                    char_type * float_cache = float_buf;
+                    err_code = sprintf_handle_specifier<Arg1>(
+                                    fmt, std::forward<Arg1>(arg1),
+                                    data_len, ex_arg1, float_cache);
+
+                    if (err_code < 0) {
+                        goto Sprintf_Throw_Except;
+                    }
+                    else if (err_code == Sprintf_Reached_Endof) {
+                        goto Sprintf_Endof_Exit;
+                    }
+
+                    sink.append(fmt_first, arg_first);
+                    if (std::is_floating_point<typename std::decay<Arg1>::type>::value) {
+                        sink.append(float_buf, float_buf + data_len);
+                    }
+                    else {
+                        sink.append_arg(std::forward<Arg1>(arg1), data_len);
+                    }
+                    format_to_impl(sink, fmt, std::forward<Args>(args)...);
+                    return;
+                }
+                else {
+                    // "%%" = "%"
+                    sink.append(fmt_first, fmt);
+                    arg_first = nullptr;
+                    fmt++;
+                    fmt_first = fmt;
+                }
+            }
+        }
+
+        if (err_code != Sprintf_Success) {
+Sprintf_Throw_Except:
+            ssize_type pos = (fmt - fmt_first);
+            throw_sprintf_exception(err_code, pos, ex_arg1);
+        }
+
+Sprintf_Endof_Exit:
+        arg_first = (arg_first != nullptr) ? arg_first : fmt_first;
+        sink.append(arg_first, fmt);
+    }
+
+    //
+    // The size of the formatted output, not include the null terminator.
+    //
+    template <typename ...Args>
+    size_type formatted_size(const char_type * fmt, Args && ... args) {
+        if (likely(fmt != nullptr))
+            return sprintf_calc_space(fmt, std::forward<Args>(args)...);
+        else
+            return 0;
+    }
+
+    template <std::size_t MaxNodes, typename ...Args>
+    size_type formatted_size(const basic_precompiled_format<char_type, MaxNodes> & pfmt,
+                             Args && ... args) {
+        size_type arg_sizes[sizeof...(Args) + 1];
+        char_type * float_cache = nullptr;
+        return pfmt.literal_size() +
+               sprintf_precompiled_space_impl(pfmt, 0, arg_sizes, float_cache,
+                                              std::forward<Args>(args)...);
+    }
+
+    //
+    // Write to a fixed buffer, at most capacity chars and no null terminator.
+    // The result.size is the full formatted size, no heap allocation.
+    //
+    template <typename ...Args>
+    format_to_result<char_type *>
+    format_to(char_type * buf, size_type capacity,
+              const char_type * fmt, Args && ... args) {
+        sprintf_buffer_sink<char_type> sink(buf, capacity);
+        if (likely(fmt != nullptr)) {
+            format_to_impl(sink, fmt, std::forward<Args>(args)...);
+        }
+        format_to_result<char_type *> result = { sink.out(), sink.size(), sink.truncated() };
+        return result;
+    }
+
+    template <typename OutputIt, typename ...Args>
+    format_to_result<OutputIt>
+    format_to(OutputIt out, size_type limit,
+              const char_type * fmt, Args && ... args) {
+        sprintf_iterator_sink<char_type, OutputIt> sink(out, limit);
+        if (likely(fmt != nullptr)) {
+            format_to_impl(sink, fmt, std::forward<Args>(args)...);
+        }
+        format_to_result<OutputIt> result = { sink.out(), sink.size(), sink.truncated() };
+        return result;
+    }
+
+    template <typename OutputIt, typename ...Args>
+    format_to_result<OutputIt>
+    format_to(OutputIt out, const char_type * fmt, Args && ... args) {
+        return format_to(out, size_type(-1), fmt, std::forward<Args>(args)...);
+    }
+
     template <typename ...Args>
     size_type output(const char_type * &buf, const char_type * fmt, Args && ... args) {
         int fmt_size = ::snprintf(nullptr, 0, fmt, std::forward<Args>(args)...);
@@ -0,0 +1,385 @@
+
+#ifndef JSTD_STRING_ITOA_SIMD_H
+#define JSTD_STRING_ITOA_SIMD_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+#include "jstd/basic/stdsize.h"
+
+#include <string.h>     // For memcpy()
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#include "jstd/support/x86_intrin.h"
+#include "jstd/support/BitUtils.h"
+
+//
+// The SIMD integer to string kernels, they convert 8 digits (SSE2) or 16 digits
+// (AVX2) at a time by multiply-shift, no division per digit. The algorithm is
+// from Wojciech Mula's SSE2 itoa and the itoa-benchmark of Milo Yip.
+//
+// The kernels may write up to kItoaSimdPadding bytes past the returned length,
+// so the buffer must have the padding space. The output is exactly the same
+// as jstd::itoa() in formatter.h, no null terminator is appended.
+//
+
+// _mm_cvtsi128_si64() is only available on x86_64.
+#if (defined(__SSE2__) && (defined(__amd64__) || defined(__x86_64__))) \
+ || defined(_M_X64) || defined(_M_AMD64)
+#define JSTD_ITOA_HAVE_SSE2     1
+#else
+#define JSTD_ITOA_HAVE_SSE2     0
+#endif
+
+#if defined(__AVX2__) && JSTD_ITOA_HAVE_SSE2
+#define JSTD_ITOA_HAVE_AVX2     1
+#else
+#define JSTD_ITOA_HAVE_AVX2     0
+#endif
+
+namespace jstd {
+
+// The max bytes may be written by a kernel: 20 digits + sign, round up to 32.
+static const std::size_t kItoaSimdPadding = 32;
+
+namespace detail {
+
+static const char s_digits_100[200] = {
+    '0','0', '0','1', '0','2', '0','3', '0','4', '0','5', '0','6', '0','7', '0','8', '0','9',
+    '1','0', '1','1', '1','2', '1','3', '1','4', '1','5', '1','6', '1','7', '1','8', '1','9',
+    '2','0', '2','1', '2','2', '2','3', '2','4', '2','5', '2','6', '2','7', '2','8', '2','9',
+    '3','0', '3','1', '3','2', '3','3', '3','4', '3','5', '3','6', '3','7', '3','8', '3','9',
+    '4','0', '4','1', '4','2', '4','3', '4','4', '4','5', '4','6', '4','7', '4','8', '4','9',
+    '5','0', '5','1', '5','2', '5','3', '5','4', '5','5', '5','6', '5','7', '5','8', '5','9',
+    '6','0', '6','1', '6','2', '6','3', '6','4', '6','5', '6','6', '6','7', '6','8', '6','9',
+    '7','0', '7','1', '7','2', '7','3', '7','4', '7','5', '7','6', '7','7', '7','8', '7','9',
+    '8','0', '8','1', '8','2', '8','3', '8','4', '8','5', '8','6', '8','7', '8','8', '8','9',
+    '9','0', '9','1', '9','2', '9','3', '9','4', '9','5', '9','6', '9','7', '9','8', '9','9'
+};
+
+// value < 10000, write 1 ~ 4 digits.
+static inline
+char * write_digits_4(uint32_t value, char * buf) {
+    assert(value < 10000);
+    if (value < 100) {
+        if (value < 10) {
+            *buf++ = static_cast<char>('0' + value);
+        }
+        else {
+            std::memcpy(buf, &s_digits_100[value * 2], 2);
+            buf += 2;
+        }
+    }
+    else {
+        uint32_t hi = value / 100;
+        uint32_t lo = value % 100;
+        if (hi < 10) {
+            *buf++ = static_cast<char>('0' + hi);
+        }
+        else {
+            std::memcpy(buf, &s_digits_100[hi * 2], 2);
+            buf += 2;
+        }
+        std::memcpy(buf, &s_digits_100[lo * 2], 2);
+        buf += 2;
+    }
+    return buf;
+}
+
+// value < 100000000, write 8 digits with the leading zeros.
+static inline
+char * write_digits_8_scalar(uint32_t value, char * buf) {
+    assert(value < 100000000);
+    uint32_t hi = value / 10000;
+    uint32_t lo = value % 10000;
+    std::memcpy(buf + 0, &s_digits_100[(hi / 100) * 2], 2);
+    std::memcpy(buf + 2, &s_digits_100[(hi % 100) * 2], 2);
+    std::memcpy(buf + 4, &s_digits_100[(lo / 100) * 2], 2);
+    std::memcpy(buf + 6, &s_digits_100[(lo % 100) * 2], 2);
+    return (buf + 8);
+}
+
+#if JSTD_ITOA_HAVE_SSE2
+
+//
+// The divisors of 10^3, 10^2, 10^1, 10^0 by mulhi_epu16(), see:
+// http://0x80.pl/articles/sse-itoa.html
+//
+#define JSTD_ITOA_DIV_POWERS    8389, 5243, 13108, 32768
+#define JSTD_ITOA_SHIFT_POWERS  (1 << (16 - (23 + 2 - 16))), \
+                                (1 << (16 - (19 + 2 - 16))), \
+                                (1 << (16 - 1 - 2)), \
+                                (1 << 15)
+
+// value < 100000000, return 8 digits in 8 x uint16 (not ascii).
+static inline
+__m128i convert_8digits_sse2(uint32_t value) {
+    assert(value < 100000000);
+    const __m128i kDiv10000 = _mm_set1_epi32(static_cast<int>(0xD1B71759UL));
+    const __m128i k10000    = _mm_set1_epi32(10000);
+    const __m128i kDivPowers   = _mm_setr_epi16(JSTD_ITOA_DIV_POWERS, JSTD_ITOA_DIV_POWERS);
+    const __m128i kShiftPowers = _mm_setr_epi16(JSTD_ITOA_SHIFT_POWERS, JSTD_ITOA_SHIFT_POWERS);
+    const __m128i k10 = _mm_set1_epi16(10);
+
+    // abcd, efgh = abcdefgh divmod 10000
+    const __m128i abcdefgh = _mm_cvtsi32_si128(static_cast<int>(value));
+    const __m128i abcd = _mm_srli_epi64(_mm_mul_epu32(abcdefgh, kDiv10000), 45);
+    const __m128i efgh = _mm_sub_epi32(abcdefgh, _mm_mul_epu32(abcd, k10000));
+
+    // v1 = [ abcd, efgh, 0, 0, 0, 0, 0, 0 ]
+    const __m128i v1 = _mm_unpacklo_epi16(abcd, efgh);
+    // v1a = v1 * 4
+    const __m128i v1a = _mm_slli_epi64(v1, 2);
+    // v2 = [ abcd * 4 (x4), efgh * 4 (x4) ]
+    const __m128i v2a = _mm_unpacklo_epi16(v1a, v1a);
+    const __m128i v2  = _mm_unpacklo_epi32(v2a, v2a);
+    // v4 = v2 div 10^3, 10^2, 10^1, 10^0 = [ a, ab, abc, abcd, e, ef, efg, efgh ]
+    const __m128i v3 = _mm_mulhi_epu16(v2, kDivPowers);
+    const __m128i v4 = _mm_mulhi_epu16(v3, kShiftPowers);
+    // v5 = v4 * 10 = [ a0, ab0, abc0, abcd0, e0, ef0, efg0, efgh0 ]
+    const __m128i v5 = _mm_mullo_epi16(v4, k10);
+    // v6 = v5 << 16 = [ 0, a0, ab0, abc0, 0, e0, ef0, efg0 ]
+    const __m128i v6 = _mm_slli_epi64(v5, 16);
+    // v7 = v4 - v6 = [ a, b, c, d, e, f, g, h ]
+    const __m128i v7 = _mm_sub_epi16(v4, v6);
+    return v7;
+}
+
+#endif // JSTD_ITOA_HAVE_SSE2
+
+#if JSTD_ITOA_HAVE_AVX2
+
+// hi, lo < 100000000, return 16 digits in 16 x uint8 (not ascii), hi first.
+static inline
+__m128i convert_16digits_avx2(uint32_t hi, uint32_t lo) {
+    assert(hi < 100000000);
+    assert(lo < 100000000);
+    const __m256i kDiv10000 = _mm256_set1_epi32(static_cast<int>(0xD1B71759UL));
+    const __m256i k10000    = _mm256_set1_epi32(10000);
+    const __m256i kDivPowers   = _mm256_setr_epi16(JSTD_ITOA_DIV_POWERS, JSTD_ITOA_DIV_POWERS,
+                                                   JSTD_ITOA_DIV_POWERS, JSTD_ITOA_DIV_POWERS);
+    const __m256i kShiftPowers = _mm256_setr_epi16(JSTD_ITOA_SHIFT_POWERS, JSTD_ITOA_SHIFT_POWERS,
+                                                   JSTD_ITOA_SHIFT_POWERS, JSTD_ITOA_SHIFT_POWERS);
+    const __m256i k10 = _mm256_set1_epi16(10);
+
+    // The same steps as convert_8digits_sse2(), hi in the low lane, lo in the high lane.
+    const __m256i abcdefgh = _mm256_setr_epi32(static_cast<int>(hi), 0, 0, 0,
+                                               static_cast<int>(lo), 0, 0, 0);
+    const __m256i abcd = _mm256_srli_epi64(_mm256_mul_epu32(abcdefgh, kDiv10000), 45);
+    const __m256i efgh = _mm256_sub_epi32(abcdefgh, _mm256_mul_epu32(abcd, k10000));
+
+    const __m256i v1  = _mm256_unpacklo_epi16(abcd, efgh);
+    const __m256i v1a = _mm256_slli_epi64(v1, 2);
+    const __m256i v2a = _mm256_unpacklo_epi16(v1a, v1a);
+    const __m256i v2  = _mm256_unpacklo_epi32(v2a, v2a);
+    const __m256i v3  = _mm256_mulhi_epu16(v2, kDivPowers);
+    const __m256i v4  = _mm256_mulhi_epu16(v3, kShiftPowers);
+    const __m256i v5  = _mm256_mullo_epi16(v4, k10);
+    const __m256i v6  = _mm256_slli_epi64(v5, 16);
+    const __m256i v7  = _mm256_sub_epi16(v4, v6);
+
+    // [ hi (8 bytes), 0 (8 bytes) | lo (8 bytes), 0 (8 bytes) ] -> [ hi, lo ]
+    const __m256i packed = _mm256_packus_epi16(v7, _mm256_setzero_si256());
+    const __m256i result = _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0));
+    return _mm256_castsi256_si128(result);
+}
+
+#endif // JSTD_ITOA_HAVE_AVX2
+
+// 10000 <= value < 100000000, write 5 ~ 8 digits.
+static inline
+char * write_digits_5_8(uint32_t value, char * buf) {
+    assert(value >= 10000 && value < 100000000);
+#if JSTD_ITOA_HAVE_SSE2
+    const __m128i digits = convert_8digits_sse2(value);
+    const __m128i bytes = _mm_packus_epi16(digits, _mm_setzero_si128());
+    // The leading zeros are in the low bytes.
+    unsigned int zero_mask = static_cast<unsigned int>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_setzero_si128())));
+    unsigned int leading_zeros = static_cast<unsigned int>(BitUtils::bsf32(~zero_mask));
+    uint64_t ascii = static_cast<uint64_t>(_mm_cvtsi128_si64(
+                        _mm_add_epi8(bytes, _mm_set1_epi8('0'))));
+    ascii >>= (leading_zeros * 8);
+    std::memcpy(buf, &ascii, sizeof(ascii));
+    return (buf + (8 - leading_zeros));
+#else
+    uint32_t hi = value / 10000;
+    uint32_t lo = value % 10000;
+    buf = write_digits_4(hi, buf);
+    std::memcpy(buf + 0, &s_digits_100[(lo / 100) * 2], 2);
+    std::memcpy(buf + 2, &s_digits_100[(lo % 100) * 2], 2);
+    return (buf + 4);
+#endif
+}
+
+// value < 100000000, write 8 digits with the leading zeros.
+static inline
+char * write_digits_8(uint32_t value, char * buf) {
+#if JSTD_ITOA_HAVE_SSE2
+    const __m128i digits = convert_8digits_sse2(value);
+    const __m128i bytes = _mm_packus_epi16(digits, _mm_setzero_si128());
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(buf), _mm_add_epi8(bytes, _mm_set1_epi8('0')));
+    return (buf + 8);
+#else
+    return write_digits_8_scalar(value, buf);
+#endif
+}
+
+// hi, lo < 100000000, write 16 digits with the leading zeros.
+static inline
+char * write_digits_16(uint32_t hi, uint32_t lo, char * buf) {
+#if JSTD_ITOA_HAVE_AVX2
+    const __m128i digits = convert_16digits_avx2(hi, lo);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(buf), _mm_add_epi8(digits, _mm_set1_epi8('0')));
+    return (buf + 16);
+#elif JSTD_ITOA_HAVE_SSE2
+    const __m128i digits = _mm_packus_epi16(convert_8digits_sse2(hi), convert_8digits_sse2(lo));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(buf), _mm_add_epi8(digits, _mm_set1_epi8('0')));
+    return (buf + 16);
+#else
+    buf = write_digits_8_scalar(hi, buf);
+    return write_digits_8_scalar(lo, buf);
+#endif
+}
+
+// 100000000 <= value < 10^16, write 9 ~ 16 digits.
+static inline
+char * write_digits_9_16(uint64_t value, char * buf) {
+    uint32_t hi = static_cast<uint32_t>(value / 100000000ULL);
+    uint32_t lo = static_cast<uint32_t>(value % 100000000ULL);
+#if JSTD_ITOA_HAVE_AVX2
+    const __m128i digits = convert_16digits_avx2(hi, lo);
+    unsigned int zero_mask = static_cast<unsigned int>(
+        _mm_movemask_epi8(_mm_cmpeq_epi8(digits, _mm_setzero_si128())));
+    // hi != 0, so there are 0 ~ 7 leading zeros.
+    unsigned int leading_zeros = static_cast<unsigned int>(BitUtils::bsf32(~zero_mask));
+    const __m128i ascii = _mm_add_epi8(digits, _mm_set1_epi8('0'));
+    uint64_t ascii_hi = static_cast<uint64_t>(_mm_cvtsi128_si64(ascii)) >> (leading_zeros * 8);
+    std::memcpy(buf, &ascii_hi, sizeof(ascii_hi));
+    buf += (8 - leading_zeros);
+    _mm_storel_epi64(reinterpret_cast<__m128i *>(buf), _mm_unpackhi_epi64(ascii, ascii));
+    return (buf + 8);
+#else
+    if (hi < 10000)
+        buf = write_digits_4(hi, buf);
+    else
+        buf = write_digits_5_8(hi, buf);
+    return write_digits_8(lo, buf);
+#endif
+}
+
+} // namespace detail
+
+//
+// Return the length of the output, the buf must have kItoaSimdPadding bytes.
+//
+static inline
+std::size_t u32toa_simd(uint32_t value, char * buf) {
+    char * first = buf;
+    if (value < 10000) {
+        buf = detail::write_digits_4(value, buf);
+    }
+    else if (value < 100000000) {
+        buf = detail::write_digits_5_8(value, buf);
+    }
+    else {
+        // 9 ~ 10 digits
+        uint32_t hi = value / 100000000;
+        uint32_t lo = value % 100000000;
+        buf = detail::write_digits_4(hi, buf);
+        buf = detail::write_digits_8(lo, buf);
+    }
+    return static_cast<std::size_t>(buf - first);
+}
+
+static inline
+std::size_t i32toa_simd(int32_t value, char * buf) {
+    uint32_t u32 = static_cast<uint32_t>(value);
+    if (value < 0) {
+        *buf++ = '-';
+        u32 = ~u32 + 1;
+        return (u32toa_simd(u32, buf) + 1);
+    }
+    return u32toa_simd(u32, buf);
+}
+
+static inline
+std::size_t u64toa_simd(uint64_t value, char * buf) {
+    char * first = buf;
+    if (value < 100000000ULL) {
+        return u32toa_simd(static_cast<uint32_t>(value), buf);
+    }
+    else if (value < 10000000000000000ULL) {
+        buf = detail::write_digits_9_16(value, buf);
+    }
+    else {
+        // 17 ~ 20 digits
+        uint32_t top = static_cast<uint32_t>(value / 10000000000000000ULL);
+        uint64_t rest = value % 10000000000000000ULL;
+        buf = detail::write_digits_4(top, buf);
+        buf = detail::write_digits_16(static_cast<uint32_t>(rest / 100000000ULL),
+                                      static_cast<uint32_t>(rest % 100000000ULL), buf);
+    }
+    return static_cast<std::size_t>(buf - first);
+}
+
+static inline
+std::size_t i64toa_simd(int64_t value, char * buf) {
+    uint64_t u64 = static_cast<uint64_t>(value);
+    if (value < 0) {
+        *buf++ = '-';
+        u64 = ~u64 + 1;
+        return (u64toa_simd(u64, buf) + 1);
+    }
+    return u64toa_simd(u64, buf);
+}
+
+//
+// The batch API: convert an array of integers to a delimited buffer,
+// the delimiter is only written between the values.
+//
+template <typename T>
+inline
+std::size_t itoa_batch_max_size(std::size_t count) {
+    // The max digits of uint32_t is 10, uint64_t is 20, and a delimiter.
+    return (count * ((sizeof(T) <= 4) ? 11 : 21) + kItoaSimdPadding);
+}
+
+static inline
+std::size_t itoa_batch(const uint32_t * values, std::size_t count,
+                       char * buf, char delimiter = ',') {
+    char * first = buf;
+    if (likely(count > 0)) {
+        buf += u32toa_simd(values[0], buf);
+        for (std::size_t i = 1; i < count; i++) {
+            *buf++ = delimiter;
+            buf += u32toa_simd(values[i], buf);
+        }
+    }
+    return static_cast<std::size_t>(buf - first);
+}
+
+static inline
+std::size_t itoa_batch(const uint64_t * values, std::size_t count,
+                       char * buf, char delimiter = ',') {
+    char * first = buf;
+    if (likely(count > 0)) {
+        buf += u64toa_simd(values[0], buf);
+        for (std::size_t i = 1; i < count; i++) {
+            *buf++ = delimiter;
+            buf += u64toa_simd(values[i], buf);
+        }
+    }
+    return static_cast<std::size_t>(buf - first);
+}
+
+} // namespace jstd
+
+#endif // JSTD_STRING_ITOA_SIMD_H
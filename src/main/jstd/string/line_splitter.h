@@ -0,0 +1,387 @@
+
+#ifndef JSTD_STRING_LINE_SPLITTER_H
+#define JSTD_STRING_LINE_SPLITTER_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>      // For std::size_t
+#include <cstring>      // For std::memcpy(), std::memmove()
+#include <vector>
+
+#include "jstd/string/string_view.h"
+#include "jstd/support/x86_intrin.h"
+#include "jstd/support/BitUtils.h"
+
+namespace jstd {
+
+//
+// line_splitter
+//
+// Split a buffer into the lines, and the lines into the fields by a delimiter.
+// The separators ('\n' and the delimiter) of every 64 bytes block are found by
+// SIMD compare and movemask, into a 64 bits bitmap, then the bits are visited
+// by bsf. The lines and the fields are string views of the buffer, no copy.
+//
+// The trailing '\r' of a line is removed. The buffer must be valid while the
+// views are in use.
+//
+class line_splitter {
+public:
+    typedef std::size_t size_type;
+
+    static const size_type kBlockSize = 64;
+
+private:
+    const char *    data_;
+    size_type       size_;
+    size_type       pos_;           // The start of the next line or field.
+    size_type       block_;         // The offset of the current block.
+    std::uint64_t   mask_;          // The remaining separators of the current block.
+    char            delimiter_;
+    bool            after_delimiter_;
+
+public:
+    line_splitter() : data_(nullptr), size_(0), pos_(0), block_(0), mask_(0),
+                      delimiter_('\n'), after_delimiter_(false) {
+    }
+
+    line_splitter(const char * data, size_type size, char delimiter = '\0') {
+        this->reset(data, size, delimiter);
+    }
+
+    line_splitter(const jstd::string_view & text, char delimiter = '\0') {
+        this->reset(text.data(), text.size(), delimiter);
+    }
+
+    ~line_splitter() {}
+
+    const char * data() const { return this->data_; }
+    size_type size() const    { return this->size_; }
+    // The offset of the unconsumed bytes.
+    size_type position() const {
+        return ((this->pos_ <= this->size_) ? this->pos_ : this->size_);
+    }
+
+    // The delimiter '\0' means there is no field delimiter.
+    void reset(const char * data, size_type size, char delimiter = '\0') {
+        this->data_ = data;
+        this->size_ = size;
+        this->pos_ = 0;
+        this->block_ = 0;
+        this->delimiter_ = (delimiter != '\0') ? delimiter : '\n';
+        this->after_delimiter_ = false;
+        this->mask_ = (size != 0) ? this->block_mask(0) : 0;
+    }
+
+    // Get the next line, the delimiter is ignored. Return false at the end.
+    bool next_line(jstd::string_view & line) {
+        if (unlikely(this->pos_ >= this->size_))
+            return false;
+
+        size_type sep = this->next_separator();
+        if (this->delimiter_ != '\n') {
+            while ((sep != this->size_) && (this->data_[sep] != '\n')) {
+                sep = this->next_separator();
+            }
+        }
+        line = this->make_line(sep);
+        this->pos_ = sep + 1;
+        this->after_delimiter_ = false;
+        return true;
+    }
+
+    //
+    // Get the next field, is_line_end is true if it's the last field of a line.
+    // Return false at the end. "a,b,\n" has 3 fields, the last one is empty.
+    //
+    bool next_field(jstd::string_view & field, bool & is_line_end) {
+        if (unlikely(this->pos_ >= this->size_)) {
+            if ((this->pos_ == this->size_) && this->after_delimiter_) {
+                // The empty last field after a delimiter.
+                field = jstd::string_view(this->data_ + this->size_, size_type(0));
+                is_line_end = true;
+                this->pos_ = this->size_ + 1;
+                this->after_delimiter_ = false;
+                return true;
+            }
+            return false;
+        }
+
+        size_type sep = this->next_separator();
+        if ((sep == this->size_) || (this->data_[sep] == '\n')) {
+            field = this->make_line(sep);
+            is_line_end = true;
+            this->after_delimiter_ = false;
+        }
+        else {
+            field = jstd::string_view(this->data_ + this->pos_, sep - this->pos_);
+            is_line_end = false;
+            this->after_delimiter_ = true;
+        }
+        this->pos_ = sep + 1;
+        return true;
+    }
+
+    //
+    // Split the next line into the fields, return the number of fields,
+    // or 0 at the end. The fields more than max_fields are joined into the last one.
+    //
+    size_type next_record(jstd::string_view * fields, size_type max_fields) {
+        assert(fields != nullptr);
+        assert(max_fields > 0);
+        size_type count = 0;
+        bool is_line_end = false;
+        while (!is_line_end) {
+            jstd::string_view field;
+            if (!this->next_field(field, is_line_end))
+                break;
+            if (likely(count < max_fields)) {
+                fields[count++] = field;
+            }
+            else {
+                // Extend the last field to the end of this field.
+                jstd::string_view & last = fields[max_fields - 1];
+                last = jstd::string_view(last.data(), size_type(field.data() + field.size() - last.data()));
+            }
+        }
+        return count;
+    }
+
+    // Count the '\n' in the buffer.
+    static size_type count_newlines(const char * data, size_type size) {
+        size_type count = 0;
+        size_type offset = 0;
+        while (offset < size) {
+            std::uint64_t mask = line_splitter::separator_mask(data, size, offset, '\n', '\n');
+            count += static_cast<size_type>(BitUtils::popcnt64(mask));
+            offset += kBlockSize;
+        }
+        return count;
+    }
+
+    // The number of lines, the last line may be has no '\n'.
+    static size_type count_lines(const char * data, size_type size) {
+        size_type count = line_splitter::count_newlines(data, size);
+        if ((size != 0) && (data[size - 1] != '\n'))
+            count++;
+        return count;
+    }
+
+private:
+    jstd::string_view make_line(size_type sep) const {
+        size_type end = sep;
+        if ((end > this->pos_) && (this->data_[end - 1] == '\r'))
+            end--;
+        return jstd::string_view(this->data_ + this->pos_, end - this->pos_);
+    }
+
+    // Return the offset of the next separator, or size_ if there is no more.
+    size_type next_separator() {
+        while (this->mask_ == 0) {
+            this->block_ += kBlockSize;
+            if (unlikely(this->block_ >= this->size_)) {
+                this->block_ = this->size_;
+                return this->size_;
+            }
+            this->mask_ = this->block_mask(this->block_);
+        }
+        size_type sep = this->block_ + BitUtils::bsf64(this->mask_);
+        this->mask_ &= (this->mask_ - 1);
+        return sep;
+    }
+
+    std::uint64_t block_mask(size_type offset) const {
+        return line_splitter::separator_mask(this->data_, this->size_, offset, '\n', this->delimiter_);
+    }
+
+    // The bitmap of the separators of 64 bytes at offset, the bytes
+    // out of the buffer are never read.
+    static std::uint64_t separator_mask(const char * data, size_type size, size_type offset,
+                                        char ch1, char ch2) {
+        assert(offset < size);
+        const char * p = data + offset;
+        size_type remain = size - offset;
+        if (likely(remain >= kBlockSize)) {
+            return line_splitter::separator_mask_64(p, ch1, ch2);
+        }
+        else {
+            // Copy the tail into a buffer, the zeros never match ch1 and ch2.
+            alignas(64) char buf[kBlockSize] = { 0 };
+            std::memcpy(buf, p, remain);
+            std::uint64_t mask = line_splitter::separator_mask_64(buf, ch1, ch2);
+            return (mask & ((std::uint64_t(1) << remain) - 1));
+        }
+    }
+
+    static std::uint64_t separator_mask_64(const char * p, char ch1, char ch2) {
+#if defined(__AVX512BW__)
+        __m512i chars = _mm512_loadu_si512((const void *)p);
+        return (_mm512_cmpeq_epi8_mask(chars, _mm512_set1_epi8(ch1)) |
+                _mm512_cmpeq_epi8_mask(chars, _mm512_set1_epi8(ch2)));
+#elif defined(__AVX2__)
+        __m256i sep1 = _mm256_set1_epi8(ch1);
+        __m256i sep2 = _mm256_set1_epi8(ch2);
+        __m256i chars0 = _mm256_loadu_si256((const __m256i *)p);
+        __m256i chars1 = _mm256_loadu_si256((const __m256i *)(p + 32));
+        __m256i eq0 = _mm256_or_si256(_mm256_cmpeq_epi8(chars0, sep1), _mm256_cmpeq_epi8(chars0, sep2));
+        __m256i eq1 = _mm256_or_si256(_mm256_cmpeq_epi8(chars1, sep1), _mm256_cmpeq_epi8(chars1, sep2));
+        return (std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(eq0))) |
+               (std::uint64_t(static_cast<std::uint32_t>(_mm256_movemask_epi8(eq1))) << 32));
+#elif defined(__SSE2__)
+        __m128i sep1 = _mm_set1_epi8(ch1);
+        __m128i sep2 = _mm_set1_epi8(ch2);
+        std::uint64_t mask = 0;
+        for (size_type i = 0; i < kBlockSize; i += 16) {
+            __m128i chars = _mm_loadu_si128((const __m128i *)(p + i));
+            __m128i eq = _mm_or_si128(_mm_cmpeq_epi8(chars, sep1), _mm_cmpeq_epi8(chars, sep2));
+            mask |= std::uint64_t(static_cast<std::uint32_t>(_mm_movemask_epi8(eq))) << i;
+        }
+        return mask;
+#else
+        std::uint64_t mask = 0;
+        for (size_type i = 0; i < kBlockSize; i++) {
+            if ((p[i] == ch1) || (p[i] == ch2))
+                mask |= std::uint64_t(1) << i;
+        }
+        return mask;
+#endif
+    }
+};
+
+//
+// file_line_reader
+//
+// Read a file by the big chunks and split it by line_splitter, for the files
+// that are too big to map. The buffer only holds the complete lines, the views
+// are valid until the next call of next_line().
+//
+class file_line_reader {
+public:
+    typedef std::size_t size_type;
+
+    static const size_type kDefaultBufferSize = 1024 * 1024;
+
+private:
+    FILE *              fp_;
+    std::vector<char>   buffer_;
+    size_type           buf_size_;      // The valid bytes in buffer_.
+    line_splitter       splitter_;
+    size_type           total_bytes_;
+    bool                eof_;
+
+public:
+    file_line_reader()
+        : fp_(nullptr), buf_size_(0), total_bytes_(0), eof_(true) {
+    }
+
+    explicit file_line_reader(const char * filename, size_type buffer_size = kDefaultBufferSize)
+        : fp_(nullptr), buf_size_(0), total_bytes_(0), eof_(true) {
+        this->open(filename, buffer_size);
+    }
+
+    file_line_reader(const file_line_reader & src) = delete;
+    file_line_reader & operator = (const file_line_reader & rhs) = delete;
+
+    ~file_line_reader() {
+        this->close();
+    }
+
+    bool is_open() const { return (this->fp_ != nullptr); }
+    // The bytes be read from the file.
+    size_type total_bytes() const { return this->total_bytes_; }
+
+    bool open(const char * filename, size_type buffer_size = kDefaultBufferSize) {
+        this->close();
+        assert(filename != nullptr);
+        this->fp_ = ::fopen(filename, "rb");
+        if (this->fp_ == nullptr)
+            return false;
+        this->buffer_.resize((buffer_size >= 64) ? buffer_size : 64);
+        this->buf_size_ = 0;
+        this->total_bytes_ = 0;
+        this->eof_ = false;
+        this->splitter_.reset(this->buffer_.data(), 0);
+        return true;
+    }
+
+    void close() {
+        if (this->fp_ != nullptr) {
+            ::fclose(this->fp_);
+            this->fp_ = nullptr;
+        }
+        this->buf_size_ = 0;
+        this->eof_ = true;
+        this->splitter_.reset(nullptr, 0);
+    }
+
+    bool next_line(jstd::string_view & line) {
+        while (!this->splitter_.next_line(line)) {
+            if (!this->refill())
+                return false;
+        }
+        return true;
+    }
+
+private:
+    // Move the incomplete line to the front, then read more bytes.
+    bool refill() {
+        if (this->eof_)
+            return false;
+
+        size_type consumed = this->splitter_.size();
+        size_type remain = this->buf_size_ - consumed;
+        if (remain != 0)
+            std::memmove(&this->buffer_[0], &this->buffer_[consumed], remain);
+        this->buf_size_ = remain;
+
+        size_type lines_end;
+        for (;;) {
+            if (this->buf_size_ == this->buffer_.size()) {
+                // A line is longer than the buffer.
+                this->buffer_.resize(this->buffer_.size() * 2);
+            }
+            size_type read_bytes = ::fread(&this->buffer_[this->buf_size_], 1,
+                                           this->buffer_.size() - this->buf_size_, this->fp_);
+            this->buf_size_ += read_bytes;
+            this->total_bytes_ += read_bytes;
+            if (read_bytes == 0) {
+                // The last line has no '\n'.
+                this->eof_ = true;
+                lines_end = this->buf_size_;
+                break;
+            }
+            lines_end = this->last_line_end(remain);
+            if (lines_end != 0)
+                break;
+            remain = this->buf_size_;
+        }
+
+        this->splitter_.reset(this->buffer_.data(), lines_end);
+        return (lines_end != 0);
+    }
+
+    // The end of the last complete line, search from the new bytes only.
+    size_type last_line_end(size_type searched) const {
+        size_type pos = this->buf_size_;
+        while (pos > searched) {
+            if (this->buffer_[pos - 1] == '\n')
+                return pos;
+            pos--;
+        }
+        return 0;
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_STRING_LINE_SPLITTER_H
@@ -56,6 +56,38 @@ struct string_traits {
     static int compare(const char_type * s1, size_type len1, const char_type * s2, size_type len2) {
         return str_utils::compare_safe(s1, len1, s2, len2);
     }
+
+    static const char_type * find(const char_type * s, size_type n, char_type ch) {
+        return str_utils::find(s, n, ch);
+    }
+
+    static const char_type * find(const char_type * s, size_type n, const char_type * needle, size_type m) {
+        return str_utils::find(s, n, needle, m);
+    }
+
+    static const char_type * rfind(const char_type * s, size_type n, char_type ch) {
+        return str_utils::rfind(s, n, ch);
+    }
+
+    static const char_type * rfind(const char_type * s, size_type n, const char_type * needle, size_type m) {
+        return str_utils::rfind(s, n, needle, m);
+    }
+
+    static const char_type * find_first_of(const char_type * s, size_type n, const char_type * set, size_type m) {
+        return str_utils::find_first_of(s, n, set, m);
+    }
+
+    static const char_type * find_last_of(const char_type * s, size_type n, const char_type * set, size_type m) {
+        return str_utils::find_last_of(s, n, set, m);
+    }
+
+    static const char_type * find_first_not_of(const char_type * s, size_type n, const char_type * set, size_type m) {
+        return str_utils::find_first_not_of(s, n, set, m);
+    }
+
+    static const char_type * find_last_not_of(const char_type * s, size_type n, const char_type * set, size_type m) {
+        return str_utils::find_last_not_of(s, n, set, m);
+    }
 };
 
 } // namespace jstd
@@ -27,9 +27,54 @@
 #include "jstd/string/string_stl.h"
 #include "jstd/string/char_traits.h"
 #include "jstd/support/SSEHelper.h"
+#include "jstd/support/x86_intrin.h"
+#include "jstd/support/BitUtils.h"
 
 #include "jstd/type_traits.h"
 
+//
+// The implementation of str_utils::is_equal() and str_utils::compare(),
+// define STRING_UTILS_MODE before include this file. STRING_UTILS_SIMD
+// selects the widest kernel of AVX512BW, AVX2 and SSE 4.2 automatically.
+//
+#ifndef STRING_UTILS_STL
+#define STRING_UTILS_STL        0
+#define STRING_UTILS_U64        1
+#define STRING_UTILS_SSE42      2
+#define STRING_UTILS_LIBC       3
+#endif
+
+#ifndef STRING_UTILS_AVX2
+#define STRING_UTILS_AVX2       4
+#define STRING_UTILS_AVX512     5
+#define STRING_UTILS_SIMD       6
+#endif
+
+#ifndef STRING_UTILS_MODE
+#define STRING_UTILS_MODE       STRING_UTILS_SIMD
+#endif
+
+// The kernel be used actually, it's limited by the instruction set.
+#if defined(__AVX512BW__) && ((STRING_UTILS_MODE == STRING_UTILS_AVX512) || \
+                              (STRING_UTILS_MODE == STRING_UTILS_SIMD))
+#define STRING_UTILS_KERNEL     STRING_UTILS_AVX512
+#elif defined(__AVX2__) && ((STRING_UTILS_MODE == STRING_UTILS_AVX512) || \
+                            (STRING_UTILS_MODE == STRING_UTILS_AVX2) || \
+                            (STRING_UTILS_MODE == STRING_UTILS_SIMD))
+#define STRING_UTILS_KERNEL     STRING_UTILS_AVX2
+#elif defined(__SSE4_2__) && ((STRING_UTILS_MODE == STRING_UTILS_AVX512) || \
+                              (STRING_UTILS_MODE == STRING_UTILS_AVX2) || \
+                              (STRING_UTILS_MODE == STRING_UTILS_SSE42) || \
+                              (STRING_UTILS_MODE == STRING_UTILS_SIMD))
+#define STRING_UTILS_KERNEL     STRING_UTILS_SSE42
+#elif (STRING_UTILS_MODE == STRING_UTILS_U64)
+#define STRING_UTILS_KERNEL     STRING_UTILS_U64
+#elif (STRING_UTILS_MODE == STRING_UTILS_STL)
+#define STRING_UTILS_KERNEL     STRING_UTILS_STL
+#else
+#define STRING_UTILS_KERNEL     STRING_UTILS_LIBC
+#endif
+
 namespace jstd {
 namespace str_utils {
 
@@ -176,11 +221,15 @@ bool is_equal(const CharTy * str1, const CharTy * str2, std::size_t length)
     return true;
 }
 
-#elif (defined(__SSE4_2__) && (STRING_UTILS_MODE == STRING_UTILS_SSE42))
+#endif // 0
+
+namespace detail {
+
+#if defined(__SSE4_2__)
 
 template <typename CharTy>
 static inline
-bool is_equal(const CharTy * str1, const CharTy * str2, std::size_t length)
+bool is_equal_sse42(const CharTy * str1, const CharTy * str2, std::size_t length)
 {
     assert(str1 != nullptr && str2 != nullptr);
 
@@ -214,11 +263,12 @@ bool is_equal(const CharTy * str1, const CharTy * str2, std::size_t length)
     return true;
 }
 
-#elif (STRING_UTILS_MODE == STRING_UTILS_U64)
+#endif // __SSE4_2__
 
+// Note: it maybe read over the end of strings (less than 8 bytes).
 template <typename CharTy>
 static inline
-bool is_equal(const CharTy * str1, const CharTy * str2, std::size_t length)
+bool is_equal_u64(const CharTy * str1, const CharTy * str2, std::size_t length)
 {
     assert(str1 != nullptr && str2 != nullptr);
 
@@ -273,26 +323,254 @@ bool is_equal(const CharTy * str1, const CharTy * str2, std::size_t length)
     return true;
 }
 
-#elif (STRING_UTILS_MODE == STRING_UTILS_STL)
+static constexpr std::size_t kPageSize = 4096;
+
+// Whether a load of the size bytes at p can't cross a page boundary, it's
+// safe to read over the end of a string in the same page.
+static inline
+bool is_page_safe_load(const void * p, std::size_t size)
+{
+    return ((reinterpret_cast<std::uintptr_t>(p) & (kPageSize - 1)) <= (kPageSize - size));
+}
+
+#if defined(__AVX2__)
+
+static inline
+std::size_t mismatch_avx2_long(const char * s1, const char * s2, std::size_t n)
+{
+    assert(n >= 32);
+    std::size_t i = 0;
+    while ((n - i) >= 64) {
+        __m256i eq0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(s1 + i)),
+                                        _mm256_loadu_si256((const __m256i *)(s2 + i)));
+        __m256i eq1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(s1 + i + 32)),
+                                        _mm256_loadu_si256((const __m256i *)(s2 + i + 32)));
+        uint32_t mask0 = static_cast<uint32_t>(_mm256_movemask_epi8(eq0));
+        uint32_t mask1 = static_cast<uint32_t>(_mm256_movemask_epi8(eq1));
+        if (unlikely((mask0 & mask1) != 0xFFFFFFFFUL)) {
+            if (mask0 != 0xFFFFFFFFUL)
+                return (i + BitUtils::bsf32(~mask0));
+            else
+                return (i + 32 + BitUtils::bsf32(~mask1));
+        }
+        i += 64;
+    }
+    if ((n - i) >= 32) {
+        __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(s1 + i)),
+                                       _mm256_loadu_si256((const __m256i *)(s2 + i)));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+        if (mask != 0xFFFFFFFFUL)
+            return (i + BitUtils::bsf32(~mask));
+        i += 32;
+    }
+    if (i != n) {
+        // The last block overlaps the previous block.
+        i = n - 32;
+        __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(s1 + i)),
+                                       _mm256_loadu_si256((const __m256i *)(s2 + i)));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+        if (mask != 0xFFFFFFFFUL)
+            return (i + BitUtils::bsf32(~mask));
+    }
+    return n;
+}
+
+//
+// The strings are less than 32 bytes, use one 32 bytes load and mask the
+// result if both loads are page safe, otherwise compare them byte by byte.
+//
+JSTD_NO_SANITIZE_ADDRESS
+static inline
+std::size_t mismatch_avx2_short(const char * s1, const char * s2, std::size_t n)
+{
+    assert(n < 32);
+    // The empty string maybe at the end of a page.
+    if (unlikely(n == 0))
+        return 0;
+    if (likely(is_page_safe_load(s1, 32) && is_page_safe_load(s2, 32))) {
+        __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)s1),
+                                       _mm256_loadu_si256((const __m256i *)s2));
+        uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+        mask &= (1UL << n) - 1;
+        return ((mask != 0) ? BitUtils::bsf32(mask) : n);
+    }
+    else {
+        for (std::size_t i = 0; i < n; i++) {
+            if (s1[i] != s2[i])
+                return i;
+        }
+        return n;
+    }
+}
+
+// Return the index of the first different byte, or n if they are equal.
+static inline
+std::size_t mismatch_avx2(const char * s1, const char * s2, std::size_t n)
+{
+    if (likely(n < 32))
+        return mismatch_avx2_short(s1, s2, n);
+    else
+        return mismatch_avx2_long(s1, s2, n);
+}
+
+#endif // __AVX2__
+
+#if defined(__AVX512BW__)
+
+static inline
+std::size_t mismatch_avx512_long(const char * s1, const char * s2, std::size_t n)
+{
+    assert(n >= 64);
+    std::size_t i = 0;
+    while ((n - i) >= 128) {
+        __mmask64 neq0 = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512((const void *)(s1 + i)),
+                                                 _mm512_loadu_si512((const void *)(s2 + i)));
+        __mmask64 neq1 = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512((const void *)(s1 + i + 64)),
+                                                 _mm512_loadu_si512((const void *)(s2 + i + 64)));
+        if (unlikely((neq0 | neq1) != 0)) {
+            if (neq0 != 0)
+                return (i + BitUtils::bsf64(neq0));
+            else
+                return (i + 64 + BitUtils::bsf64(neq1));
+        }
+        i += 128;
+    }
+    if ((n - i) >= 64) {
+        __mmask64 neq = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512((const void *)(s1 + i)),
+                                                _mm512_loadu_si512((const void *)(s2 + i)));
+        if (neq != 0)
+            return (i + BitUtils::bsf64(neq));
+        i += 64;
+    }
+    if (i != n) {
+        // The last block overlaps the previous block.
+        i = n - 64;
+        __mmask64 neq = _mm512_cmpneq_epi8_mask(_mm512_loadu_si512((const void *)(s1 + i)),
+                                                _mm512_loadu_si512((const void *)(s2 + i)));
+        if (neq != 0)
+            return (i + BitUtils::bsf64(neq));
+    }
+    return n;
+}
 
+//
+// The strings are less than 64 bytes, use the masked loads,
+// the masked out bytes never fault.
+//
+static inline
+std::size_t mismatch_avx512_short(const char * s1, const char * s2, std::size_t n)
+{
+    assert(n < 64);
+    __mmask64 mask = (1ULL << n) - 1;
+    __m512i chars1 = _mm512_maskz_loadu_epi8(mask, (const void *)s1);
+    __m512i chars2 = _mm512_maskz_loadu_epi8(mask, (const void *)s2);
+    __mmask64 neq = _mm512_mask_cmpneq_epi8_mask(mask, chars1, chars2);
+    return ((neq != 0) ? BitUtils::bsf64(neq) : n);
+}
+
+// Return the index of the first different byte, or n if they are equal.
+static inline
+std::size_t mismatch_avx512(const char * s1, const char * s2, std::size_t n)
+{
+    if (likely(n < 64))
+        return mismatch_avx512_short(s1, s2, n);
+    else
+        return mismatch_avx512_long(s1, s2, n);
+}
+
+#endif // __AVX512BW__
+
+// The compare result of the chars at the first different byte.
 template <typename CharTy>
 static inline
-bool is_equal(const CharTy * str1, const CharTy * str2, std::size_t count)
+int compare_mismatch(const CharTy * str1, const CharTy * str2, std::size_t byte_index)
 {
-    return stl::StrEqual(str1, str2, count);
+    typedef typename jstd::char_traits<CharTy>::uchar_type UCharTy;
+
+    std::size_t index = byte_index / sizeof(CharTy);
+    UCharTy ch1 = static_cast<UCharTy>(str1[index]);
+    UCharTy ch2 = static_cast<UCharTy>(str2[index]);
+    // The value of ch1 and ch2 must be not equal!
+    assert(ch1 != ch2);
+    if (ch1 > ch2)
+        return CompareResult::IsBigger;
+    else
+        return CompareResult::IsSmaller;
 }
 
-#else
+#if defined(__AVX2__)
+
+template <typename CharTy>
+static inline
+bool is_equal_avx2(const CharTy * str1, const CharTy * str2, std::size_t count)
+{
+    assert(str1 != nullptr && str2 != nullptr);
+    std::size_t n = count * sizeof(CharTy);
+    return (mismatch_avx2((const char *)str1, (const char *)str2, n) == n);
+}
+
+template <typename CharTy>
+static inline
+int compare_avx2(const CharTy * str1, const CharTy * str2, std::size_t count)
+{
+    assert(str1 != nullptr && str2 != nullptr);
+    std::size_t n = count * sizeof(CharTy);
+    std::size_t index = mismatch_avx2((const char *)str1, (const char *)str2, n);
+    if (likely(index == n))
+        return CompareResult::IsEqual;
+    else
+        return compare_mismatch(str1, str2, index);
+}
+
+#endif // __AVX2__
+
+#if defined(__AVX512BW__)
+
+template <typename CharTy>
+static inline
+bool is_equal_avx512(const CharTy * str1, const CharTy * str2, std::size_t count)
+{
+    assert(str1 != nullptr && str2 != nullptr);
+    std::size_t n = count * sizeof(CharTy);
+    return (mismatch_avx512((const char *)str1, (const char *)str2, n) == n);
+}
+
+template <typename CharTy>
+static inline
+int compare_avx512(const CharTy * str1, const CharTy * str2, std::size_t count)
+{
+    assert(str1 != nullptr && str2 != nullptr);
+    std::size_t n = count * sizeof(CharTy);
+    std::size_t index = mismatch_avx512((const char *)str1, (const char *)str2, n);
+    if (likely(index == n))
+        return CompareResult::IsEqual;
+    else
+        return compare_mismatch(str1, str2, index);
+}
+
+#endif // __AVX512BW__
+
+} // namespace detail
 
 template <typename CharTy>
 static inline
 bool is_equal(const CharTy * str1, const CharTy * str2, std::size_t count)
 {
+#if (STRING_UTILS_KERNEL == STRING_UTILS_AVX512)
+    return detail::is_equal_avx512(str1, str2, count);
+#elif (STRING_UTILS_KERNEL == STRING_UTILS_AVX2)
+    return detail::is_equal_avx2(str1, str2, count);
+#elif (STRING_UTILS_KERNEL == STRING_UTILS_SSE42)
+    return detail::is_equal_sse42(str1, str2, count);
+#elif (STRING_UTILS_KERNEL == STRING_UTILS_U64)
+    return detail::is_equal_u64(str1, str2, count);
+#elif (STRING_UTILS_KERNEL == STRING_UTILS_STL)
+    return stl::StrEqual(str1, str2, count);
+#else
     return libc::StrEqual(str1, str2, count);
+#endif // STRING_UTILS_KERNEL
 }
 
-#endif // STRING_UTILS_MODE
-
 template <typename CharTy>
 static inline
 bool is_equal(const CharTy * str1, std::size_t len1, const CharTy * str2, std::size_t len2)
@@ -414,11 +692,14 @@ int compare(const CharTy * str1, const CharTy * str2)
 #endif
 }
 
+namespace detail {
+
+#if defined(__SSE4_2__)
+
 template <typename CharTy>
 static inline
-int compare(const CharTy * str1, const CharTy * str2, std::size_t count)
+int compare_sse42(const CharTy * str1, const CharTy * str2, std::size_t count)
 {
-#if (defined(__SSE4_2__) && (STRING_UTILS_MODE == STRING_UTILS_SSE42))
     assert(str1 != nullptr);
     assert(str2 != nullptr);
 
@@ -469,67 +750,40 @@ int compare(const CharTy * str1, const CharTy * str2, std::size_t count)
 
     // It's matched, or the length is equal 0.
     return CompareResult::IsEqual;
+}
 
-#elif (STRING_UTILS_MODE == STRING_UTILS_STL)
+#endif // __SSE4_2__
+
+} // namespace detail
+
+template <typename CharTy>
+static inline
+int compare(const CharTy * str1, const CharTy * str2, std::size_t count)
+{
+#if (STRING_UTILS_KERNEL == STRING_UTILS_AVX512)
+    return detail::compare_avx512(str1, str2, count);
+#elif (STRING_UTILS_KERNEL == STRING_UTILS_AVX2)
+    return detail::compare_avx2(str1, str2, count);
+#elif (STRING_UTILS_KERNEL == STRING_UTILS_SSE42)
+    return detail::compare_sse42(str1, str2, count);
+#elif (STRING_UTILS_KERNEL == STRING_UTILS_STL)
     return stl::StrCmp(str1, str2, count);
 #else
     return libc::StrCmp(str1, str2, count);
-#endif // STRING_UTILS_MODE
+#endif // STRING_UTILS_KERNEL
 }
 
 template <typename CharTy>
 static inline
 int compare(const CharTy * str1, std::size_t len1, const CharTy * str2, std::size_t len2)
 {
-#if (defined(__SSE4_2__) && (STRING_UTILS_MODE == STRING_UTILS_SSE42))
-    assert(str1 != nullptr);
-    assert(str2 != nullptr);
-
-    static constexpr int kMaxSize = jstd::SSEHelper<CharTy>::kMaxSize;
-    static constexpr uint8_t _SIDD_CHAR_OPS = jstd::SSEHelper<CharTy>::_SIDD_CHAR_OPS;
-    static constexpr uint8_t kEqualEach = _SIDD_CHAR_OPS | _SIDD_CMP_EQUAL_EACH
-                                | _SIDD_NEGATIVE_POLARITY | _SIDD_LEAST_SIGNIFICANT;
-
-    typedef typename jstd::char_traits<CharTy>::uchar_type UCharTy;
-
+#if (STRING_UTILS_KERNEL == STRING_UTILS_AVX512) || \
+    (STRING_UTILS_KERNEL == STRING_UTILS_AVX2) || \
+    (STRING_UTILS_KERNEL == STRING_UTILS_SSE42)
     std::size_t count = (len1 <= len2) ? len1 : len2;
-    int slen = (int)count;
-
-    while (likely(slen > 0)) {
-        __m128i __str1 = _mm_loadu_si128((const __m128i *)str1);
-        __m128i __str2 = _mm_loadu_si128((const __m128i *)str2);
-        int len = (slen >= kMaxSize) ? kMaxSize : slen;
-        assert(len > 0);
-
-        int full_matched = _mm_cmpestrc(__str1, len, __str2, len, (uint8_t)kEqualEach);
-        int matched_index = _mm_cmpestri(__str1, len, __str2, len, (uint8_t)kEqualEach);
-        str1 += kMaxSize;
-        str2 += kMaxSize;
-        slen -= kMaxSize;
-        if (likely(full_matched == 0)) {
-            // Full matched, continue match next kMaxSize bytes.
-            assert(matched_index >= kMaxSize);
-            if (slen <= 0) {
-                assert((matched_index == kMaxSize) ||
-                       (len == (matched_index - 1)));
-            }
-            continue;
-        }
-        else {
-            // It's dismatched.
-            assert(matched_index >= 0 && matched_index < kMaxSize);
-            assert(matched_index <= len);
-            int offset = (kMaxSize - matched_index);
-            UCharTy ch1 = *((const UCharTy *)str1 - offset);
-            UCharTy ch2 = *((const UCharTy *)str2 - offset);
-            // The value of ch1 and ch2 must be not equal!
-            assert(ch1 != ch2);
-            if (ch1 > ch2)
-                return CompareResult::IsBigger;
-            else
-                return CompareResult::IsSmaller;
-        }
-    }
+    int result = str_utils::compare(str1, str2, count);
+    if (likely(result != CompareResult::IsEqual))
+        return result;
 
     // It's matched, or the length is equal 0.
     if (len1 > len2)
@@ -539,11 +793,11 @@ int compare(const CharTy * str1, std::size_t len1, const CharTy * str2, std::siz
     else
         return CompareResult::IsEqual;
 
-#elif (STRING_UTILS_MODE == STRING_UTILS_STL)
+#elif (STRING_UTILS_KERNEL == STRING_UTILS_STL)
     return stl::StrCmp(str1, len1, str2, len2);
 #else
     return libc::StrCmp(str1, len1, str2, len2);
-#endif // STRING_UTILS_MODE
+#endif // STRING_UTILS_KERNEL
 }
 
 template <typename CharTy>
@@ -661,6 +915,734 @@ int compare_safe(const StringType & str1, const StringType & str2)
 
 //////////////////////////////////////////////////////////////////////////////////////
 
+////////////////////////////////// find() ////////////////////////////////////////////
+
+//
+// The search kernels return the pointer of the first (or last) match,
+// or nullptr if it's not found. The char versions use SSE2 / AVX2 (cmpeq
+// and movemask) and SSE 4.2 (pcmpestri), the other char types use the loops.
+//
+// The vector loads never read out of [s, s + n): the tail is done by a load
+// that overlaps the previous block, or by a copy if n is less than a vector.
+//
+
+namespace detail {
+
+#if defined(__SSE2__)
+
+// Copy len (<= 16) chars to a zero filled 16 bytes buffer.
+static inline
+__m128i load_tail_16(const char * s, std::size_t len)
+{
+    assert(len <= 16);
+    alignas(16) char buf[16] = { 0 };
+    std::memcpy(buf, s, len);
+    return _mm_load_si128((const __m128i *)buf);
+}
+
+#endif // __SSE2__
+
+template <typename CharTy>
+static inline
+bool equal_chars(const CharTy * s1, const CharTy * s2, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; i++) {
+        if (s1[i] != s2[i])
+            return false;
+    }
+    return true;
+}
+
+// The 256 bits lookup table of a chars set, for the big sets.
+struct char_set_table {
+    uint64_t bits[4];
+
+    char_set_table(const char * set, std::size_t count) {
+        bits[0] = bits[1] = bits[2] = bits[3] = 0;
+        for (std::size_t i = 0; i < count; i++) {
+            uint8_t ch = static_cast<uint8_t>(set[i]);
+            bits[ch >> 6] |= (uint64_t(1) << (ch & 63));
+        }
+    }
+
+    bool contains(char ch) const {
+        uint8_t uch = static_cast<uint8_t>(ch);
+        return ((bits[uch >> 6] & (uint64_t(1) << (uch & 63))) != 0);
+    }
+};
+
+template <typename CharTy>
+static inline
+bool contains_char(const CharTy * set, std::size_t count, CharTy ch)
+{
+    for (std::size_t i = 0; i < count; i++) {
+        if (set[i] == ch)
+            return true;
+    }
+    return false;
+}
+
+} // namespace detail
+
+//
+// find(s, n, ch), rfind(s, n, ch)
+//
+template <typename CharTy>
+static inline
+const CharTy * find(const CharTy * s, std::size_t n, CharTy ch)
+{
+    const CharTy * last = s + n;
+    for (; s != last; ++s) {
+        if (*s == ch)
+            return s;
+    }
+    return nullptr;
+}
+
+static inline
+const char * find(const char * s, std::size_t n, char ch)
+{
+    const char * p = s;
+    const char * last = s + n;
+#if defined(__AVX2__)
+    if (likely(n >= 32)) {
+        const __m256i pattern = _mm256_set1_epi8(ch);
+        while ((last - p) >= 128) {
+            __m256i eq0 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p +  0)), pattern);
+            __m256i eq1 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + 32)), pattern);
+            __m256i eq2 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + 64)), pattern);
+            __m256i eq3 = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + 96)), pattern);
+            __m256i any = _mm256_or_si256(_mm256_or_si256(eq0, eq1), _mm256_or_si256(eq2, eq3));
+            if (_mm256_movemask_epi8(any) != 0) {
+                uint64_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq0)) |
+                                (uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(eq1))) << 32);
+                if (mask != 0)
+                    return (p + BitUtils::bsf64(mask));
+                mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq2)) |
+                       (uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(eq3))) << 32);
+                return (p + 64 + BitUtils::bsf64(mask));
+            }
+            p += 128;
+        }
+        while ((last - p) >= 32) {
+            __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), pattern);
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+            if (mask != 0)
+                return (p + BitUtils::bsf32(mask));
+            p += 32;
+        }
+        if (p != last) {
+            p = last - 32;
+            __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), pattern);
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+            if (mask != 0)
+                return (p + BitUtils::bsf32(mask));
+        }
+        return nullptr;
+    }
+#endif // __AVX2__
+#if defined(__SSE2__)
+    const __m128i pattern = _mm_set1_epi8(ch);
+    if (likely(n >= 16)) {
+        while ((last - p) >= 16) {
+            __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), pattern);
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+            if (mask != 0)
+                return (p + BitUtils::bsf32(mask));
+            p += 16;
+        }
+        if (p != last) {
+            p = last - 16;
+            __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), pattern);
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+            if (mask != 0)
+                return (p + BitUtils::bsf32(mask));
+        }
+    }
+    else if (n != 0) {
+        __m128i eq = _mm_cmpeq_epi8(detail::load_tail_16(p, n), pattern);
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(eq)) & ((1U << n) - 1);
+        if (mask != 0)
+            return (p + BitUtils::bsf32(mask));
+    }
+    return nullptr;
+#else
+    return static_cast<const char *>(std::memchr(s, ch, n));
+#endif // __SSE2__
+}
+
+template <typename CharTy>
+static inline
+const CharTy * rfind(const CharTy * s, std::size_t n, CharTy ch)
+{
+    const CharTy * p = s + n;
+    while (p != s) {
+        --p;
+        if (*p == ch)
+            return p;
+    }
+    return nullptr;
+}
+
+static inline
+const char * rfind(const char * s, std::size_t n, char ch)
+{
+    const char * p = s + n;
+#if defined(__AVX2__)
+    if (likely(n >= 32)) {
+        const __m256i pattern = _mm256_set1_epi8(ch);
+        while ((p - s) >= 32) {
+            p -= 32;
+            __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), pattern);
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+            if (mask != 0)
+                return (p + BitUtils::bsr32(mask));
+        }
+        if (p != s) {
+            __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)s), pattern);
+            uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+            if (mask != 0)
+                return (s + BitUtils::bsr32(mask));
+        }
+        return nullptr;
+    }
+#endif // __AVX2__
+#if defined(__SSE2__)
+    const __m128i pattern = _mm_set1_epi8(ch);
+    if (likely(n >= 16)) {
+        while ((p - s) >= 16) {
+            p -= 16;
+            __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), pattern);
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+            if (mask != 0)
+                return (p + BitUtils::bsr32(mask));
+        }
+        if (p != s) {
+            __m128i eq = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)s), pattern);
+            uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+            if (mask != 0)
+                return (s + BitUtils::bsr32(mask));
+        }
+    }
+    else if (n != 0) {
+        __m128i eq = _mm_cmpeq_epi8(detail::load_tail_16(s, n), pattern);
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(eq)) & ((1U << n) - 1);
+        if (mask != 0)
+            return (s + BitUtils::bsr32(mask));
+    }
+    return nullptr;
+#else
+    while (p != s) {
+        --p;
+        if (*p == ch)
+            return p;
+    }
+    return nullptr;
+#endif // __SSE2__
+}
+
+//
+// find(s, n, needle, m), rfind(s, n, needle, m)
+//
+// The char versions use the two bytes filter: compare the first and the last char
+// of the needle at 16 or 32 positions at once, then verify the candidates.
+// See: http://0x80.pl/articles/simd-strfind.html
+//
+template <typename CharTy>
+static inline
+const CharTy * find(const CharTy * s, std::size_t n, const CharTy * needle, std::size_t m)
+{
+    if (unlikely(m == 0))
+        return s;
+    if (unlikely(m > n))
+        return nullptr;
+
+    const CharTy * p = s;
+    const CharTy * p_last = s + (n - m + 1);
+    for (; p != p_last; ++p) {
+        if (*p == needle[0] && detail::equal_chars(p + 1, needle + 1, m - 1))
+            return p;
+    }
+    return nullptr;
+}
+
+namespace detail {
+
+// Verify the candidates of the two bytes filter, from the lowest bit.
+static inline
+const char * verify_first_candidate(const char * p, uint32_t mask,
+                                    const char * needle, std::size_t m)
+{
+    do {
+        unsigned int index = BitUtils::bsf32(mask);
+        if (std::memcmp(p + index + 1, needle + 1, m - 2) == 0)
+            return (p + index);
+        mask &= (mask - 1);
+    } while (mask != 0);
+    return nullptr;
+}
+
+// Verify the candidates of the two bytes filter, from the highest bit.
+static inline
+const char * verify_last_candidate(const char * p, uint32_t mask,
+                                   const char * needle, std::size_t m)
+{
+    do {
+        unsigned int index = BitUtils::bsr32(mask);
+        if (std::memcmp(p + index + 1, needle + 1, m - 2) == 0)
+            return (p + index);
+        mask &= ~(1U << index);
+    } while (mask != 0);
+    return nullptr;
+}
+
+#if defined(__AVX2__)
+
+static inline
+uint32_t two_bytes_filter_avx2(const char * p, std::size_t m, __m256i first, __m256i last)
+{
+    __m256i eq_first = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)p), first);
+    __m256i eq_last  = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *)(p + m - 1)), last);
+    return static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_and_si256(eq_first, eq_last)));
+}
+
+#endif // __AVX2__
+
+#if defined(__SSE2__)
+
+static inline
+uint32_t two_bytes_filter_sse2(const char * p, std::size_t m, __m128i first, __m128i last)
+{
+    __m128i eq_first = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)p), first);
+    __m128i eq_last  = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(p + m - 1)), last);
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_and_si128(eq_first, eq_last)));
+}
+
+// Less than 16 candidate positions, don't read past the end of the string.
+static inline
+uint32_t two_bytes_filter_short(const char * s, std::size_t n,
+                                const char * needle, std::size_t m)
+{
+    std::size_t count = n - m + 1;
+    assert(count < 16);
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last  = _mm_set1_epi8(needle[m - 1]);
+    uint32_t first_mask, last_mask;
+    if (likely(n >= 16)) {
+        // The last 16 bytes of the string, the last char of candidate i is at (i + 16 - count).
+        first_mask = static_cast<uint32_t>(_mm_movemask_epi8(
+                        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)s), first)));
+        last_mask  = static_cast<uint32_t>(_mm_movemask_epi8(
+                        _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(s + n - 16)), last)));
+        last_mask >>= (16 - count);
+    }
+    else {
+        __m128i chars = load_tail_16(s, n);
+        first_mask = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chars, first)));
+        last_mask  = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chars, last)));
+        last_mask >>= (m - 1);
+    }
+    return (first_mask & last_mask & ((1U << count) - 1));
+}
+
+#endif // __SSE2__
+
+} // namespace detail
+
+static inline
+const char * find(const char * s, std::size_t n, const char * needle, std::size_t m)
+{
+    if (unlikely(m == 0))
+        return s;
+    if (unlikely(m > n))
+        return nullptr;
+    if (m == 1)
+        return str_utils::find(s, n, needle[0]);
+
+    // The candidate positions: [s, p_last)
+    const char * p = s;
+    const char * p_last = s + (n - m + 1);
+#if defined(__AVX2__)
+    if (likely((p_last - p) >= 32)) {
+        const __m256i first = _mm256_set1_epi8(needle[0]);
+        const __m256i last  = _mm256_set1_epi8(needle[m - 1]);
+        while ((p_last - p) >= 64) {
+            uint32_t mask0 = detail::two_bytes_filter_avx2(p, m, first, last);
+            uint32_t mask1 = detail::two_bytes_filter_avx2(p + 32, m, first, last);
+            if (unlikely((mask0 | mask1) != 0)) {
+                if (mask0 != 0) {
+                    const char * result = detail::verify_first_candidate(p, mask0, needle, m);
+                    if (result != nullptr)
+                        return result;
+                }
+                if (mask1 != 0) {
+                    const char * result = detail::verify_first_candidate(p + 32, mask1, needle, m);
+                    if (result != nullptr)
+                        return result;
+                }
+            }
+            p += 64;
+        }
+        if ((p_last - p) >= 32) {
+            uint32_t mask = detail::two_bytes_filter_avx2(p, m, first, last);
+            if (unlikely(mask != 0)) {
+                const char * result = detail::verify_first_candidate(p, mask, needle, m);
+                if (result != nullptr)
+                    return result;
+            }
+            p += 32;
+        }
+        if (p != p_last) {
+            // The last block overlaps the previous block.
+            p = p_last - 32;
+            uint32_t mask = detail::two_bytes_filter_avx2(p, m, first, last);
+            if (mask != 0)
+                return detail::verify_first_candidate(p, mask, needle, m);
+        }
+        return nullptr;
+    }
+#endif // __AVX2__
+#if defined(__SSE2__)
+    if (likely((p_last - p) >= 16)) {
+        const __m128i first = _mm_set1_epi8(needle[0]);
+        const __m128i last  = _mm_set1_epi8(needle[m - 1]);
+        while ((p_last - p) >= 16) {
+            uint32_t mask = detail::two_bytes_filter_sse2(p, m, first, last);
+            if (unlikely(mask != 0)) {
+                const char * result = detail::verify_first_candidate(p, mask, needle, m);
+                if (result != nullptr)
+                    return result;
+            }
+            p += 16;
+        }
+        if (p != p_last) {
+            p = p_last - 16;
+            uint32_t mask = detail::two_bytes_filter_sse2(p, m, first, last);
+            if (mask != 0)
+                return detail::verify_first_candidate(p, mask, needle, m);
+        }
+    }
+    else {
+        uint32_t mask = detail::two_bytes_filter_short(s, n, needle, m);
+        if (mask != 0)
+            return detail::verify_first_candidate(s, mask, needle, m);
+    }
+    return nullptr;
+#else
+    while (p != p_last) {
+        p = str_utils::find(p, std::size_t(p_last - p), needle[0]);
+        if (p == nullptr)
+            break;
+        if (p[m - 1] == needle[m - 1] && std::memcmp(p + 1, needle + 1, m - 2) == 0)
+            return p;
+        ++p;
+    }
+    return nullptr;
+#endif // __SSE2__
+}
+
+template <typename CharTy>
+static inline
+const CharTy * rfind(const CharTy * s, std::size_t n, const CharTy * needle, std::size_t m)
+{
+    if (unlikely(m == 0))
+        return (s + n);
+    if (unlikely(m > n))
+        return nullptr;
+
+    const CharTy * p = s + (n - m + 1);
+    while (p != s) {
+        --p;
+        if (*p == needle[0] && detail::equal_chars(p + 1, needle + 1, m - 1))
+            return p;
+    }
+    return nullptr;
+}
+
+static inline
+const char * rfind(const char * s, std::size_t n, const char * needle, std::size_t m)
+{
+    if (unlikely(m == 0))
+        return (s + n);
+    if (unlikely(m > n))
+        return nullptr;
+    if (m == 1)
+        return str_utils::rfind(s, n, needle[0]);
+
+    // The candidate positions: [s, p)
+    const char * p = s + (n - m + 1);
+#if defined(__AVX2__)
+    if (likely((p - s) >= 32)) {
+        const __m256i first = _mm256_set1_epi8(needle[0]);
+        const __m256i last  = _mm256_set1_epi8(needle[m - 1]);
+        while ((p - s) >= 32) {
+            p -= 32;
+            uint32_t mask = detail::two_bytes_filter_avx2(p, m, first, last);
+            if (unlikely(mask != 0)) {
+                const char * result = detail::verify_last_candidate(p, mask, needle, m);
+                if (result != nullptr)
+                    return result;
+            }
+        }
+        if (p != s) {
+            // The first block overlaps the next block.
+            uint32_t mask = detail::two_bytes_filter_avx2(s, m, first, last);
+            if (mask != 0)
+                return detail::verify_last_candidate(s, mask, needle, m);
+        }
+        return nullptr;
+    }
+#endif // __AVX2__
+#if defined(__SSE2__)
+    if (likely((p - s) >= 16)) {
+        const __m128i first = _mm_set1_epi8(needle[0]);
+        const __m128i last  = _mm_set1_epi8(needle[m - 1]);
+        while ((p - s) >= 16) {
+            p -= 16;
+            uint32_t mask = detail::two_bytes_filter_sse2(p, m, first, last);
+            if (unlikely(mask != 0)) {
+                const char * result = detail::verify_last_candidate(p, mask, needle, m);
+                if (result != nullptr)
+                    return result;
+            }
+        }
+        if (p != s) {
+            uint32_t mask = detail::two_bytes_filter_sse2(s, m, first, last);
+            if (mask != 0)
+                return detail::verify_last_candidate(s, mask, needle, m);
+        }
+    }
+    else {
+        uint32_t mask = detail::two_bytes_filter_short(s, n, needle, m);
+        if (mask != 0)
+            return detail::verify_last_candidate(s, mask, needle, m);
+    }
+    return nullptr;
+#else
+    while (p != s) {
+        p = str_utils::rfind(s, std::size_t(p - s), needle[0]);
+        if (p == nullptr)
+            break;
+        if (p[m - 1] == needle[m - 1] && std::memcmp(p + 1, needle + 1, m - 2) == 0)
+            return p;
+    }
+    return nullptr;
+#endif // __SSE2__
+}
+
+//
+// find_first_of(s, n, set, m), find_last_of(), find_first_not_of(), find_last_not_of()
+//
+// The char versions use SSE 4.2 pcmpestri for the sets of 1 ~ 16 chars,
+// and a 256 bits lookup table for the bigger sets.
+//
+template <typename CharTy>
+static inline
+const CharTy * find_first_of(const CharTy * s, std::size_t n, const CharTy * set, std::size_t m)
+{
+    const CharTy * last = s + n;
+    for (; s != last; ++s) {
+        if (detail::contains_char(set, m, *s))
+            return s;
+    }
+    return nullptr;
+}
+
+template <typename CharTy>
+static inline
+const CharTy * find_first_not_of(const CharTy * s, std::size_t n, const CharTy * set, std::size_t m)
+{
+    const CharTy * last = s + n;
+    for (; s != last; ++s) {
+        if (!detail::contains_char(set, m, *s))
+            return s;
+    }
+    return nullptr;
+}
+
+template <typename CharTy>
+static inline
+const CharTy * find_last_of(const CharTy * s, std::size_t n, const CharTy * set, std::size_t m)
+{
+    const CharTy * p = s + n;
+    while (p != s) {
+        --p;
+        if (detail::contains_char(set, m, *p))
+            return p;
+    }
+    return nullptr;
+}
+
+template <typename CharTy>
+static inline
+const CharTy * find_last_not_of(const CharTy * s, std::size_t n, const CharTy * set, std::size_t m)
+{
+    const CharTy * p = s + n;
+    while (p != s) {
+        --p;
+        if (!detail::contains_char(set, m, *p))
+            return p;
+    }
+    return nullptr;
+}
+
+namespace detail {
+
+#if defined(__SSE4_2__)
+
+// Mode: _SIDD_LEAST_SIGNIFICANT for find first, the match is the last 16 bytes
+// that overlaps with the previous block.
+template <int Mode>
+static inline
+const char * find_first_of_sse42(const char * s, std::size_t n, const char * set, std::size_t m)
+{
+    static constexpr int kMode = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_LEAST_SIGNIFICANT | Mode;
+    assert(m > 0 && m <= 16);
+
+    const __m128i char_set = detail::load_tail_16(set, m);
+    const int set_len = static_cast<int>(m);
+    const char * p = s;
+    const char * last = s + n;
+    if (likely(n >= 16)) {
+        while ((last - p) >= 16) {
+            int index = _mm_cmpestri(char_set, set_len, _mm_loadu_si128((const __m128i *)p), 16, kMode);
+            if (index < 16)
+                return (p + index);
+            p += 16;
+        }
+        if (p != last) {
+            p = last - 16;
+            int index = _mm_cmpestri(char_set, set_len, _mm_loadu_si128((const __m128i *)p), 16, kMode);
+            if (index < 16)
+                return (p + index);
+        }
+    }
+    else if (n != 0) {
+        int len = static_cast<int>(n);
+        int index = _mm_cmpestri(char_set, set_len, detail::load_tail_16(p, n), len, kMode);
+        if (index < len)
+            return (p + index);
+    }
+    return nullptr;
+}
+
+template <int Mode>
+static inline
+const char * find_last_of_sse42(const char * s, std::size_t n, const char * set, std::size_t m)
+{
+    static constexpr int kMode = _SIDD_UBYTE_OPS | _SIDD_CMP_EQUAL_ANY | _SIDD_MOST_SIGNIFICANT | Mode;
+    assert(m > 0 && m <= 16);
+
+    const __m128i char_set = detail::load_tail_16(set, m);
+    const int set_len = static_cast<int>(m);
+    const char * p = s + n;
+    if (likely(n >= 16)) {
+        while ((p - s) >= 16) {
+            p -= 16;
+            int index = _mm_cmpestri(char_set, set_len, _mm_loadu_si128((const __m128i *)p), 16, kMode);
+            if (index < 16)
+                return (p + index);
+        }
+        if (p != s) {
+            int index = _mm_cmpestri(char_set, set_len, _mm_loadu_si128((const __m128i *)s), 16, kMode);
+            if (index < 16)
+                return (s + index);
+        }
+    }
+    else if (n != 0) {
+        int len = static_cast<int>(n);
+        int index = _mm_cmpestri(char_set, set_len, detail::load_tail_16(s, n), len, kMode);
+        if (index < len)
+            return (s + index);
+    }
+    return nullptr;
+}
+
+#endif // __SSE4_2__
+
+template <bool IsMatch>
+static inline
+const char * find_first_of_table(const char * s, std::size_t n, const char * set, std::size_t m)
+{
+    char_set_table table(set, m);
+    const char * last = s + n;
+    for (; s != last; ++s) {
+        if (table.contains(*s) == IsMatch)
+            return s;
+    }
+    return nullptr;
+}
+
+template <bool IsMatch>
+static inline
+const char * find_last_of_table(const char * s, std::size_t n, const char * set, std::size_t m)
+{
+    char_set_table table(set, m);
+    const char * p = s + n;
+    while (p != s) {
+        --p;
+        if (table.contains(*p) == IsMatch)
+            return p;
+    }
+    return nullptr;
+}
+
+} // namespace detail
+
+static inline
+const char * find_first_of(const char * s, std::size_t n, const char * set, std::size_t m)
+{
+    if (unlikely(m == 0))
+        return nullptr;
+    if (m == 1)
+        return str_utils::find(s, n, set[0]);
+#if defined(__SSE4_2__)
+    if (likely(m <= 16))
+        return detail::find_first_of_sse42<_SIDD_POSITIVE_POLARITY>(s, n, set, m);
+#endif
+    return detail::find_first_of_table<true>(s, n, set, m);
+}
+
+static inline
+const char * find_first_not_of(const char * s, std::size_t n, const char * set, std::size_t m)
+{
+    if (unlikely(m == 0))
+        return ((n != 0) ? s : nullptr);
+#if defined(__SSE4_2__)
+    if (likely(m <= 16))
+        return detail::find_first_of_sse42<_SIDD_MASKED_NEGATIVE_POLARITY>(s, n, set, m);
+#endif
+    return detail::find_first_of_table<false>(s, n, set, m);
+}
+
+static inline
+const char * find_last_of(const char * s, std::size_t n, const char * set, std::size_t m)
+{
+    if (unlikely(m == 0))
+        return nullptr;
+    if (m == 1)
+        return str_utils::rfind(s, n, set[0]);
+#if defined(__SSE4_2__)
+    if (likely(m <= 16))
+        return detail::find_last_of_sse42<_SIDD_POSITIVE_POLARITY>(s, n, set, m);
+#endif
+    return detail::find_last_of_table<true>(s, n, set, m);
+}
+
+static inline
+const char * find_last_not_of(const char * s, std::size_t n, const char * set, std::size_t m)
+{
+    if (unlikely(m == 0))
+        return ((n != 0) ? (s + n - 1) : nullptr);
+#if defined(__SSE4_2__)
+    if (likely(m <= 16))
+        return detail::find_last_of_sse42<_SIDD_MASKED_NEGATIVE_POLARITY>(s, n, set, m);
+#endif
+    return detail::find_last_of_table<false>(s, n, set, m);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////
+
 } // namespace str_utils
 } // namespace jstd
 
@@ -499,6 +499,149 @@ public:
         return this->compare(s1, rcount1, s2, rcount2);
     }
 
+    //
+    // find(ch), find(sv), rfind(ch), rfind(sv)
+    //
+    size_type find(char_type ch, size_type pos = 0) const noexcept {
+        if (likely(pos < this->size())) {
+            const char_type * result = Traits::find(this->data() + pos, this->size() - pos, ch);
+            return this->to_pos(result);
+        }
+        return npos;
+    }
+
+    size_type find(const char_type * str, size_type pos, size_type count) const noexcept {
+        if (unlikely(count == 0))
+            return ((pos <= this->size()) ? pos : npos);
+        if (likely(pos < this->size())) {
+            const char_type * result = Traits::find(this->data() + pos, this->size() - pos, str, count);
+            return this->to_pos(result);
+        }
+        return npos;
+    }
+
+    size_type find(const this_type & sv, size_type pos = 0) const noexcept {
+        return this->find(sv.data(), pos, sv.size());
+    }
+
+    size_type find(const char_type * str, size_type pos = 0) const noexcept {
+        return this->find(str, pos, libc::StrLen(str));
+    }
+
+    size_type rfind(char_type ch, size_type pos = npos) const noexcept {
+        if (likely(this->size() != 0)) {
+            size_type count = ((pos < this->size()) ? pos : (this->size() - 1)) + 1;
+            const char_type * result = Traits::rfind(this->data(), count, ch);
+            return this->to_pos(result);
+        }
+        return npos;
+    }
+
+    size_type rfind(const char_type * str, size_type pos, size_type count) const noexcept {
+        if (likely(count <= this->size())) {
+            size_type max_pos = this->size() - count;
+            size_type last_pos = (pos < max_pos) ? pos : max_pos;
+            if (unlikely(count == 0))
+                return last_pos;
+            const char_type * result = Traits::rfind(this->data(), last_pos + count, str, count);
+            return this->to_pos(result);
+        }
+        return npos;
+    }
+
+    size_type rfind(const this_type & sv, size_type pos = npos) const noexcept {
+        return this->rfind(sv.data(), pos, sv.size());
+    }
+
+    size_type rfind(const char_type * str, size_type pos = npos) const noexcept {
+        return this->rfind(str, pos, libc::StrLen(str));
+    }
+
+    //
+    // find_first_of(), find_last_of(), find_first_not_of(), find_last_not_of()
+    //
+    size_type find_first_of(const char_type * str, size_type pos, size_type count) const noexcept {
+        if (likely(pos < this->size())) {
+            const char_type * result = Traits::find_first_of(this->data() + pos, this->size() - pos, str, count);
+            return this->to_pos(result);
+        }
+        return npos;
+    }
+
+    size_type find_first_of(const this_type & sv, size_type pos = 0) const noexcept {
+        return this->find_first_of(sv.data(), pos, sv.size());
+    }
+
+    size_type find_first_of(const char_type * str, size_type pos = 0) const noexcept {
+        return this->find_first_of(str, pos, libc::StrLen(str));
+    }
+
+    size_type find_first_of(char_type ch, size_type pos = 0) const noexcept {
+        return this->find(ch, pos);
+    }
+
+    size_type find_last_of(const char_type * str, size_type pos, size_type count) const noexcept {
+        if (likely(this->size() != 0)) {
+            size_type length = ((pos < this->size()) ? pos : (this->size() - 1)) + 1;
+            const char_type * result = Traits::find_last_of(this->data(), length, str, count);
+            return this->to_pos(result);
+        }
+        return npos;
+    }
+
+    size_type find_last_of(const this_type & sv, size_type pos = npos) const noexcept {
+        return this->find_last_of(sv.data(), pos, sv.size());
+    }
+
+    size_type find_last_of(const char_type * str, size_type pos = npos) const noexcept {
+        return this->find_last_of(str, pos, libc::StrLen(str));
+    }
+
+    size_type find_last_of(char_type ch, size_type pos = npos) const noexcept {
+        return this->rfind(ch, pos);
+    }
+
+    size_type find_first_not_of(const char_type * str, size_type pos, size_type count) const noexcept {
+        if (likely(pos < this->size())) {
+            const char_type * result = Traits::find_first_not_of(this->data() + pos, this->size() - pos, str, count);
+            return this->to_pos(result);
+        }
+        return npos;
+    }
+
+    size_type find_first_not_of(const this_type & sv, size_type pos = 0) const noexcept {
+        return this->find_first_not_of(sv.data(), pos, sv.size());
+    }
+
+    size_type find_first_not_of(const char_type * str, size_type pos = 0) const noexcept {
+        return this->find_first_not_of(str, pos, libc::StrLen(str));
+    }
+
+    size_type find_first_not_of(char_type ch, size_type pos = 0) const noexcept {
+        return this->find_first_not_of(&ch, pos, 1);
+    }
+
+    size_type find_last_not_of(const char_type * str, size_type pos, size_type count) const noexcept {
+        if (likely(this->size() != 0)) {
+            size_type length = ((pos < this->size()) ? pos : (this->size() - 1)) + 1;
+            const char_type * result = Traits::find_last_not_of(this->data(), length, str, count);
+            return this->to_pos(result);
+        }
+        return npos;
+    }
+
+    size_type find_last_not_of(const this_type & sv, size_type pos = npos) const noexcept {
+        return this->find_last_not_of(sv.data(), pos, sv.size());
+    }
+
+    size_type find_last_not_of(const char_type * str, size_type pos = npos) const noexcept {
+        return this->find_last_not_of(str, pos, libc::StrLen(str));
+    }
+
+    size_type find_last_not_of(char_type ch, size_type pos = npos) const noexcept {
+        return this->find_last_not_of(&ch, pos, 1);
+    }
+
     string_type to_string() const {
         // Use RVO (return value optimization)
         return string_type(this->data_, this->size_);
@@ -539,6 +682,10 @@ public:
     }
 
 private:
+    size_type to_pos(const char_type * result) const noexcept {
+        return ((result != nullptr) ? size_type(result - this->data()) : npos);
+    }
+
     inline void push_back_impl(char_type ch) {
         char_type * last_ptr = const_cast<char_type *>(this->data_ + this->size_);
         *last_ptr = ch;
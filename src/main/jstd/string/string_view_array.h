@@ -6,14 +6,25 @@
 #pragma once
 #endif
 
+#include "jstd/basic/stddef.h"
 #include "jstd/basic/stdint.h"
 #include "jstd/basic/stdsize.h"
 
+#include <string.h>
+#include <assert.h>
+
 #include <cstdint>
 #include <cstddef>
+#include <cstring>      // For std::memcpy()
 #include <memory>
 #include <vector>
 #include <exception>
+#include <stdexcept>    // For std::out_of_range
+#include <utility>      // For std::swap()
+
+#include "jstd/string/string_view.h"
+#include "jstd/string/line_splitter.h"
+#include "jstd/system/mapped_file.h"
 
 namespace jstd {
 
@@ -203,6 +214,342 @@ void swap(jstd::string_view_array<First, Second> & lhs, jstd::string_view_array<
     lhs.swap(rhs);
 }
 
+//
+// string_bytes_arena
+//
+// An append only storage of the string bytes. The bytes never move,
+// so the string views point into it are valid until clear().
+//
+class string_bytes_arena {
+public:
+    typedef std::size_t size_type;
+
+    static const size_type kFirstChunkSize = 4096;
+    static const size_type kMaxChunkSize = size_type(1) << 20;
+
+private:
+    std::vector<char *> chunks_;
+    char *              cur_;
+    size_type           remain_;
+    size_type           next_chunk_size_;
+    size_type           allocated_bytes_;
+
+public:
+    string_bytes_arena()
+        : cur_(nullptr), remain_(0), next_chunk_size_(kFirstChunkSize), allocated_bytes_(0) {
+    }
+
+    string_bytes_arena(const string_bytes_arena & src) = delete;
+    string_bytes_arena & operator = (const string_bytes_arena & rhs) = delete;
+
+    string_bytes_arena(string_bytes_arena && src)
+        : cur_(nullptr), remain_(0), next_chunk_size_(kFirstChunkSize), allocated_bytes_(0) {
+        this->swap(src);
+    }
+
+    ~string_bytes_arena() {
+        this->clear();
+    }
+
+    bool empty() const { return this->chunks_.empty(); }
+    size_type chunk_count() const { return this->chunks_.size(); }
+    size_type allocated_bytes() const { return this->allocated_bytes_; }
+
+    const char * append(const char * data, size_type length) {
+        if (unlikely(length > this->remain_)) {
+            if (length > (this->next_chunk_size_ / 4)) {
+                // The big string has its own chunk, keep the current chunk.
+                char * chunk = this->add_chunk(length);
+                std::memcpy(chunk, data, length);
+                return chunk;
+            }
+            this->cur_ = this->add_chunk(this->next_chunk_size_);
+            this->remain_ = this->next_chunk_size_;
+            if (this->next_chunk_size_ < kMaxChunkSize)
+                this->next_chunk_size_ *= 2;
+        }
+        char * dest = this->cur_;
+        if (length != 0)
+            std::memcpy(dest, data, length);
+        this->cur_ += length;
+        this->remain_ -= length;
+        return dest;
+    }
+
+    void clear() {
+        for (size_type i = 0; i < this->chunks_.size(); i++) {
+            delete[] this->chunks_[i];
+        }
+        this->chunks_.clear();
+        this->cur_ = nullptr;
+        this->remain_ = 0;
+        this->next_chunk_size_ = kFirstChunkSize;
+        this->allocated_bytes_ = 0;
+    }
+
+    void swap(string_bytes_arena & other) {
+        if (&other != this) {
+            std::swap(this->chunks_,          other.chunks_);
+            std::swap(this->cur_,             other.cur_);
+            std::swap(this->remain_,          other.remain_);
+            std::swap(this->next_chunk_size_, other.next_chunk_size_);
+            std::swap(this->allocated_bytes_, other.allocated_bytes_);
+        }
+    }
+
+private:
+    char * add_chunk(size_type size) {
+        char * chunk = new char[size];
+        this->chunks_.push_back(chunk);
+        this->allocated_bytes_ += size;
+        return chunk;
+    }
+};
+
+//
+// flat_string_view_array<First, Second>
+//
+// The flat variant of string_view_array<F, S>, the pairs are stored by value
+// in one vector. The string bytes can be owned by the array: push_back_copy()
+// copies them into an arena, load_file() keeps the whole file by one read or
+// by mmap, and the pairs point into it.
+//
+template <typename First, typename Second>
+class flat_string_view_array {
+public:
+    typedef First                                   first_type;
+    typedef Second                                  second_type;
+    typedef string_view_pair<First, Second>         element_type;
+    typedef element_type                            value_type;
+
+    typedef std::vector<value_type>                 vector_type;
+    typedef typename vector_type::iterator          iterator;
+    typedef typename vector_type::const_iterator    const_iterator;
+    typedef typename vector_type::pointer           pointer;
+    typedef typename vector_type::const_pointer     const_pointer;
+    typedef typename vector_type::reference         reference;
+    typedef typename vector_type::const_reference   const_reference;
+    typedef typename vector_type::size_type         size_type;
+
+    typedef typename std::make_signed<size_type>::type  ssize_type;
+
+private:
+    vector_type         array_;
+    string_bytes_arena  arena_;
+    std::vector<char>   file_buffer_;
+    mapped_file         mapped_file_;
+
+public:
+    flat_string_view_array() : array_() {
+    }
+
+    flat_string_view_array(const flat_string_view_array & src) : array_() {
+        this->copy(src);
+    }
+
+    // The owned bytes don't move, so the pairs are still valid.
+    flat_string_view_array(flat_string_view_array && src)
+        : array_(std::move(src.array_)), arena_(std::move(src.arena_)),
+          file_buffer_(std::move(src.file_buffer_)), mapped_file_(std::move(src.mapped_file_)) {
+    }
+
+    ~flat_string_view_array() {
+    }
+
+    flat_string_view_array & operator = (const flat_string_view_array & rhs) {
+        this->copy(rhs);
+        return *this;
+    }
+
+    flat_string_view_array & operator = (flat_string_view_array && rhs) {
+        this->swap(rhs);
+        return *this;
+    }
+
+    size_type size() const       { return array_.size();     }
+    size_type capacity() const   { return array_.capacity(); }
+    bool empty() const           { return array_.empty();    }
+
+    pointer data()               { return array_.data(); }
+    const_pointer data() const   { return array_.data(); }
+
+    iterator begin()             { return array_.begin();  }
+    iterator end()               { return array_.end();    }
+    const_iterator begin() const { return array_.begin();  }
+    const_iterator end() const   { return array_.end();    }
+
+    const_iterator cbegin() const { return array_.cbegin(); }
+    const_iterator cend() const   { return array_.cend();   }
+
+    reference front() { return array_.front(); }
+    reference back()  { return array_.back();  }
+
+    const_reference front() const { return array_.front(); }
+    const_reference back() const  { return array_.back();  }
+
+    // The bytes of the strings owned by the array.
+    size_type storage_bytes() const {
+        return (this->arena_.allocated_bytes() + this->file_buffer_.size() + this->mapped_file_.size());
+    }
+
+    bool owns_bytes() const {
+        return (!this->arena_.empty() || !this->file_buffer_.empty() || this->mapped_file_.is_open());
+    }
+
+    void clear() {
+        this->array_.clear();
+        this->arena_.clear();
+        this->file_buffer_.clear();
+        this->mapped_file_.close();
+    }
+
+    void reserve(size_type count) {
+        array_.reserve(count);
+    }
+
+    void resize(size_type new_size) {
+        array_.resize(new_size);
+    }
+
+    void push_back(const value_type & value) {
+        array_.push_back(value);
+    }
+
+    void push_back(value_type && value) {
+        array_.push_back(std::move(value));
+    }
+
+    // Copy the bytes of strings into the arena, the pair points to the copies.
+    void push_back_copy(const first_type & first, const second_type & second) {
+        const char * first_data = this->arena_.append(first.data(), first.size());
+        const char * second_data = this->arena_.append(second.data(), second.size());
+        array_.push_back(value_type(first_type(first_data, first.size()),
+                                    second_type(second_data, second.size())));
+    }
+
+    void pop_back() {
+        array_.pop_back();
+    }
+
+    reference operator [] (size_type pos) {
+        return array_[pos];
+    }
+
+    const_reference operator [] (size_type pos) const {
+        return array_[pos];
+    }
+
+    reference at(size_type pos) {
+        if (pos < size())
+            return array_[pos];
+        else
+            throw std::out_of_range("jstd::flat_string_view_array<F, S> outof of range.");
+    }
+
+    const_reference at(size_type pos) const {
+        if (pos < size())
+            return array_[pos];
+        else
+            throw std::out_of_range("jstd::flat_string_view_array<F, S> outof of range.");
+    }
+
+    //
+    // Load the lines of a text file, the empty lines are skipped and "\r\n" is
+    // accepted. If the separator is not '\0', the line is split at the first
+    // separator into the first and the second, otherwise the second is empty.
+    //
+    bool load_file(const char * filename, bool use_mmap = false, char separator = '\0') {
+        this->clear();
+        const char * data;
+        size_type size;
+        if (use_mmap) {
+            if (!this->mapped_file_.open(filename))
+                return false;
+            data = this->mapped_file_.data();
+            size = this->mapped_file_.size();
+        }
+        else {
+            if (!jstd::read_file(filename, this->file_buffer_))
+                return false;
+            data = this->file_buffer_.data();
+            size = this->file_buffer_.size();
+        }
+        this->append_lines(data, size, separator);
+        return true;
+    }
+
+    void copy(const flat_string_view_array & other) {
+        if (&other != this) {
+            this->copy_impl(other);
+        }
+    }
+
+    void swap(flat_string_view_array & other) noexcept {
+        if (&other != this) {
+            this->swap_impl(other);
+        }
+    }
+
+private:
+    void append_lines(const char * data, size_type size, char separator) {
+        this->array_.reserve(this->array_.size() + line_splitter::count_lines(data, size));
+        line_splitter splitter(data, size, separator);
+        if (separator == '\0') {
+            jstd::string_view line;
+            while (splitter.next_line(line)) {
+                if (likely(!line.empty())) {
+                    this->array_.push_back(value_type(first_type(line.data(), line.size()),
+                                                      second_type(line.data() + line.size(), size_type(0))));
+                }
+            }
+        }
+        else {
+            // The fields after the first separator are joined into the second.
+            jstd::string_view fields[2];
+            size_type count;
+            while ((count = splitter.next_record(fields, 2)) != 0) {
+                if (count == 1) {
+                    if (likely(!fields[0].empty())) {
+                        this->array_.push_back(value_type(first_type(fields[0].data(), fields[0].size()),
+                                                          second_type(fields[0].data() + fields[0].size(), size_type(0))));
+                    }
+                }
+                else {
+                    this->array_.push_back(value_type(first_type(fields[0].data(), fields[0].size()),
+                                                      second_type(fields[1].data(), fields[1].size())));
+                }
+            }
+        }
+    }
+
+    void copy_impl(const flat_string_view_array & other) {
+        this->clear();
+        if (other.owns_bytes()) {
+            this->array_.reserve(other.size());
+            for (size_type i = 0; i < other.size(); i++) {
+                this->push_back_copy(other[i].first, other[i].second);
+            }
+        }
+        else {
+            this->array_ = other.array_;
+        }
+    }
+
+    void swap_impl(flat_string_view_array & other) noexcept {
+        std::swap(this->array_, other.array_);
+        this->arena_.swap(other.arena_);
+        std::swap(this->file_buffer_, other.file_buffer_);
+        this->mapped_file_.swap(other.mapped_file_);
+    }
+};
+
+template <typename First, typename Second>
+inline
+void swap(jstd::flat_string_view_array<First, Second> & lhs,
+          jstd::flat_string_view_array<First, Second> & rhs) noexcept {
+    lhs.swap(rhs);
+}
+
 } // namespace jstd
 
 namespace std {
@@ -213,6 +560,13 @@ void swap(jstd::string_view_array<First, Second> & lhs, jstd::string_view_array<
     lhs.swap(rhs);
 }
 
+template <typename First, typename Second>
+inline
+void swap(jstd::flat_string_view_array<First, Second> & lhs,
+          jstd::flat_string_view_array<First, Second> & rhs) noexcept {
+    lhs.swap(rhs);
+}
+
 } // namespace std
 
 #endif // JSTD_STRING_STRING_VIEW_ARRAY_H
@@ -0,0 +1,1282 @@
+
+#ifndef JSTD_STRING_UTF_CONVERT_H
+#define JSTD_STRING_UTF_CONVERT_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+
+#include <string.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>      // For std::size_t
+#include <cstring>      // For std::memcpy()
+#include <string>
+
+#include "jstd/support/x86_intrin.h"
+#include "jstd/support/BitUtils.h"
+#include "jstd/string/string_view.h"
+
+//
+// The validated UTF-8 <==> UTF-16 / UTF-32 conversion.
+//
+// The UTF-8 validation is the lookup algorithm of:
+//
+//   John Keiser, Daniel Lemire, "Validating UTF-8 In Less Than One
+//   Instruction Per Byte" (2021).
+//
+// three 16 entries tables are looked up by pshufb with the nibbles of the
+// current and the previous byte, 32 bytes at a time with AVX2, 16 bytes with
+// SSSE3. The transcoding kernels (SSE 4.1) find the end of the code points
+// in 12 bytes, and decode them with a pshufb mask of a table indexed by the
+// bitmap, like simdutf. The ASCII blocks are widened or packed directly.
+//
+// The 4 bytes code points, the surrogates and the errors are handled by the
+// scalar code, which also reports the exact position of the first error.
+//
+
+#if defined(__AVX2__)
+#define JSTD_UTF_HAVE_AVX2      1
+#else
+#define JSTD_UTF_HAVE_AVX2      0
+#endif
+
+#if defined(__SSSE3__)
+#define JSTD_UTF_HAVE_SSSE3     1
+#else
+#define JSTD_UTF_HAVE_SSSE3     0
+#endif
+
+#if defined(__SSE4_1__)
+#define JSTD_UTF_HAVE_SSE41     1
+#else
+#define JSTD_UTF_HAVE_SSE41     0
+#endif
+
+namespace jstd {
+namespace utf {
+
+enum class error_code : int {
+    ok = 0,
+    header_bits,    // The byte 0xF8 - 0xFF.
+    too_short,      // The lead byte is not followed by enough continuation bytes.
+    too_long,       // A continuation byte without a lead byte.
+    overlong,       // The code point could be encoded in fewer bytes.
+    too_large,      // The code point is greater than 0x10FFFF.
+    surrogate       // The code point is a surrogate (UTF-8, UTF-32), or a unpaired surrogate (UTF-16).
+};
+
+//
+// If error is ok, count is the number of the output code units (or of the input for validation),
+// otherwise it's the position of the first invalid code unit in the input.
+//
+struct result {
+    error_code  error;
+    std::size_t count;
+};
+
+typedef jstd::basic_string_view<char16_t>   u16string_view;
+typedef jstd::basic_string_view<char32_t>   u32string_view;
+
+namespace detail {
+
+static inline
+bool is_continuation(std::uint8_t ch) {
+    return ((ch & 0xC0) == 0x80);
+}
+
+//
+// Validate and decode the code point at s[0], return the length,
+// or 0 if it's invalid.
+//
+static inline
+std::size_t decode_utf8_char(const std::uint8_t * s, std::size_t remain,
+                             char32_t & code_point, error_code & error)
+{
+    assert(remain > 0);
+    std::uint32_t lead = s[0];
+    if (lead < 0x80) {
+        code_point = lead;
+        return 1;
+    }
+    else if (lead < 0xC0) {
+        error = error_code::too_long;
+        return 0;
+    }
+    else if (lead < 0xE0) {
+        if ((remain < 2) || !is_continuation(s[1])) {
+            error = error_code::too_short;
+            return 0;
+        }
+        if (lead < 0xC2) {
+            error = error_code::overlong;
+            return 0;
+        }
+        code_point = ((lead & 0x1F) << 6) | (s[1] & 0x3F);
+        return 2;
+    }
+    else if (lead < 0xF0) {
+        if ((remain < 3) || !is_continuation(s[1]) || !is_continuation(s[2])) {
+            error = error_code::too_short;
+            return 0;
+        }
+        std::uint32_t cp = ((lead & 0x0F) << 12) | ((s[1] & 0x3F) << 6) | (s[2] & 0x3F);
+        if (cp < 0x800) {
+            error = error_code::overlong;
+            return 0;
+        }
+        if ((cp >= 0xD800) && (cp <= 0xDFFF)) {
+            error = error_code::surrogate;
+            return 0;
+        }
+        code_point = cp;
+        return 3;
+    }
+    else if (lead < 0xF8) {
+        if ((remain < 4) || !is_continuation(s[1]) || !is_continuation(s[2]) ||
+            !is_continuation(s[3])) {
+            error = error_code::too_short;
+            return 0;
+        }
+        std::uint32_t cp = ((lead & 0x07) << 18) | ((s[1] & 0x3F) << 12) |
+                           ((s[2] & 0x3F) << 6) | (s[3] & 0x3F);
+        if (cp < 0x10000) {
+            error = error_code::overlong;
+            return 0;
+        }
+        if (cp > 0x10FFFF) {
+            error = error_code::too_large;
+            return 0;
+        }
+        code_point = cp;
+        return 4;
+    }
+    else {
+        error = error_code::header_bits;
+        return 0;
+    }
+}
+
+static inline
+bool is_ascii_8bytes(const std::uint8_t * s) {
+    std::uint64_t value;
+    std::memcpy(&value, s, sizeof(value));
+    return ((value & 0x8080808080808080ULL) == 0);
+}
+
+static inline
+result validate_utf8_scalar(const std::uint8_t * s, std::size_t len, std::size_t pos)
+{
+    while (pos < len) {
+        if ((pos + 8 <= len) && is_ascii_8bytes(s + pos)) {
+            pos += 8;
+            continue;
+        }
+        char32_t code_point;
+        error_code error;
+        std::size_t n = decode_utf8_char(s + pos, len - pos, code_point, error);
+        if (unlikely(n == 0)) {
+            result res = { error, pos };
+            return res;
+        }
+        pos += n;
+    }
+    result res = { error_code::ok, len };
+    return res;
+}
+
+// Write a code point as UTF-16 (with a surrogate pair) or UTF-32.
+template <typename CharT>
+static inline
+CharT * write_code_point(CharT * out, char32_t code_point)
+{
+    if ((sizeof(CharT) == 2) && (code_point >= 0x10000)) {
+        code_point -= 0x10000;
+        out[0] = static_cast<CharT>(0xD800 + (code_point >> 10));
+        out[1] = static_cast<CharT>(0xDC00 + (code_point & 0x3FF));
+        return (out + 2);
+    }
+    else {
+        out[0] = static_cast<CharT>(code_point);
+        return (out + 1);
+    }
+}
+
+template <typename CharT>
+static inline
+result convert_utf8_scalar(const std::uint8_t * s, std::size_t len, std::size_t pos,
+                           CharT * out, CharT * out_first)
+{
+    while (pos < len) {
+        if ((pos + 8 <= len) && is_ascii_8bytes(s + pos)) {
+            for (std::size_t i = 0; i < 8; i++) {
+                out[i] = static_cast<CharT>(s[pos + i]);
+            }
+            out += 8;
+            pos += 8;
+            continue;
+        }
+        char32_t code_point;
+        error_code error;
+        std::size_t n = decode_utf8_char(s + pos, len - pos, code_point, error);
+        if (unlikely(n == 0)) {
+            result res = { error, pos };
+            return res;
+        }
+        out = write_code_point(out, code_point);
+        pos += n;
+    }
+    result res = { error_code::ok, static_cast<std::size_t>(out - out_first) };
+    return res;
+}
+
+static inline
+char * encode_utf8_char(char * out, char32_t cp)
+{
+    if (cp < 0x80) {
+        out[0] = static_cast<char>(cp);
+        return (out + 1);
+    }
+    else if (cp < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (cp >> 6));
+        out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+        return (out + 2);
+    }
+    else if (cp < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (cp >> 12));
+        out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+        return (out + 3);
+    }
+    else {
+        out[0] = static_cast<char>(0xF0 | (cp >> 18));
+        out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+        return (out + 4);
+    }
+}
+
+//
+// Encode the code units [pos, last) to UTF-8, a surrogate pair may be
+// read across the last. Return the position of the next code unit,
+// or the position of the error and set the error.
+//
+static inline
+std::size_t convert_utf16_scalar(const char16_t * s, std::size_t len, std::size_t pos,
+                                 std::size_t last, char *& out, error_code & error)
+{
+    while (pos < last) {
+        char32_t cp = s[pos];
+        if (likely((cp & 0xF800) != 0xD800)) {
+            out = encode_utf8_char(out, cp);
+            pos++;
+        }
+        else {
+            // A high surrogate must be followed by a low surrogate.
+            if ((cp >= 0xDC00) || (pos + 1 >= len) || ((s[pos + 1] & 0xFC00) != 0xDC00)) {
+                error = error_code::surrogate;
+                return pos;
+            }
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (s[pos + 1] - 0xDC00);
+            out = encode_utf8_char(out, cp);
+            pos += 2;
+        }
+    }
+    return pos;
+}
+
+static inline
+std::size_t convert_utf32_scalar(const char32_t * s, std::size_t pos, std::size_t last,
+                                 char *& out, error_code & error)
+{
+    while (pos < last) {
+        char32_t cp = s[pos];
+        if (unlikely(cp > 0x10FFFF)) {
+            error = error_code::too_large;
+            return pos;
+        }
+        if (unlikely((cp & 0xFFFFF800) == 0xD800)) {
+            error = error_code::surrogate;
+            return pos;
+        }
+        out = encode_utf8_char(out, cp);
+        pos++;
+    }
+    return pos;
+}
+
+//
+// The first char may be not validated before pos, at most 3 bytes before pos.
+// It's a char boundary if the bytes before pos are valid.
+//
+static inline
+std::size_t utf8_rewind(const std::uint8_t * s, std::size_t pos)
+{
+    std::size_t first = (pos >= 3) ? (pos - 3) : 0;
+    while ((first < pos) && is_continuation(s[first])) {
+        first++;
+    }
+    return first;
+}
+
+//
+// The error bits of the lookup tables.
+//
+enum utf8_error_bits {
+    kTooShort       = 1 << 0,   // 11______ 0_______, 11______ 11______
+    kTooLong        = 1 << 1,   // 0_______ 10______
+    kOverlong3      = 1 << 2,   // 11100000 100_____
+    kTooLarge       = 1 << 3,   // 11110100 1001____, 11110100 101_____, 11110101 1001____, ...
+    kSurrogate      = 1 << 4,   // 11101101 101_____
+    kOverlong2      = 1 << 5,   // 1100000_ 10______
+    kTooLarge1000   = 1 << 6,   // 11110101 1000____, ...
+    kOverlong4      = 1 << 6,   // 11110000 1000____
+    kTwoConts       = 1 << 7,   // 10______ 10______
+    kCarry          = kTooShort | kTooLong | kTwoConts
+};
+
+#if JSTD_UTF_HAVE_AVX2
+
+class utf8_checker_avx2 {
+private:
+    __m256i error_;
+    __m256i prev_input_;
+    __m256i prev_incomplete_;
+
+public:
+    utf8_checker_avx2() : error_(_mm256_setzero_si256()),
+                          prev_input_(_mm256_setzero_si256()),
+                          prev_incomplete_(_mm256_setzero_si256()) {
+    }
+
+    bool has_error() const {
+        return !_mm256_testz_si256(this->error_, this->error_);
+    }
+
+    // The error of the truncated last code point.
+    bool has_incomplete() const {
+        return !_mm256_testz_si256(this->prev_incomplete_, this->prev_incomplete_);
+    }
+
+    void check_64bytes(const std::uint8_t * s) {
+        __m256i input0 = _mm256_loadu_si256((const __m256i *)s);
+        __m256i input1 = _mm256_loadu_si256((const __m256i *)(s + 32));
+        if (_mm256_movemask_epi8(_mm256_or_si256(input0, input1)) == 0) {
+            this->error_ = _mm256_or_si256(this->error_, this->prev_incomplete_);
+            this->prev_incomplete_ = _mm256_setzero_si256();
+        }
+        else {
+            this->check_utf8_bytes(input0, this->prev_input_);
+            this->check_utf8_bytes(input1, input0);
+            this->prev_incomplete_ = is_incomplete(input1);
+        }
+        this->prev_input_ = input1;
+    }
+
+private:
+    template <int N>
+    static inline __m256i prev(__m256i input, __m256i prev_input) {
+        return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev_input, input, 0x21), 16 - N);
+    }
+
+    static inline __m256i is_incomplete(__m256i input) {
+        // 0xFF except the last 3 bytes: 0b11110000 - 1, 0b11100000 - 1, 0b11000000 - 1.
+        const __m256i max_value = _mm256_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            (char)0xEF, (char)0xDF, (char)0xBF);
+        return _mm256_subs_epu8(input, max_value);
+    }
+
+    void check_utf8_bytes(__m256i input, __m256i prev_input) {
+        const __m256i low_nibble = _mm256_set1_epi8(0x0F);
+        const __m256i byte_1_high_table = _mm256_setr_epi8(
+            kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+            (char)kTwoConts, (char)kTwoConts, (char)kTwoConts, (char)kTwoConts,
+            kTooShort | kOverlong2, kTooShort, kTooShort | kOverlong3 | kSurrogate,
+            kTooShort | kTooLarge | kTooLarge1000 | kOverlong4,
+            kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+            (char)kTwoConts, (char)kTwoConts, (char)kTwoConts, (char)kTwoConts,
+            kTooShort | kOverlong2, kTooShort, kTooShort | kOverlong3 | kSurrogate,
+            kTooShort | kTooLarge | kTooLarge1000 | kOverlong4);
+        const __m256i byte_1_low_table = _mm256_setr_epi8(
+            (char)(kCarry | kOverlong3 | kOverlong2 | kOverlong4), (char)(kCarry | kOverlong2),
+            (char)kCarry, (char)kCarry, (char)(kCarry | kTooLarge),
+            (char)(kCarry | kTooLarge | kTooLarge1000), (char)(kCarry | kTooLarge | kTooLarge1000),
+            (char)(kCarry | kTooLarge | kTooLarge1000), (char)(kCarry | kTooLarge | kTooLarge1000),
+            (char)(kCarry | kTooLarge | kTooLarge1000), (char)(kCarry | kTooLarge | kTooLarge1000),
+            (char)(kCarry | kTooLarge | kTooLarge1000), (char)(kCarry | kTooLarge | kTooLarge1000),
+            (char)(kCarry | kTooLarge | kTooLarge1000 | kSurrogate),
+            (char)(kCarry | kTooLarge | kTooLarge1000), (char)(kCarry | kTooLarge | kTooLarge1000),
+            (char)(kCarry | kOverlong3 | kOverlong2 | kOverlong4), (char)(kCarry | kOverlong2),
+            (char)kCarry, (char)kCarry, (char)(kCarry | kTooLarge),
+            (char)(kCarry | kTooLarge | kTooLarge1000), (char)(kCarry | kTooLarge | kTooLarge1000),
+            (char)(kCarry | kTooLarge | kTooLarge1000), (char)(kCarry | kTooLarge | kTooLarge1000),
+            (char)(kCarry | kTooLarge | kTooLarge1000), (char)(kCarry | kTooLarge | kTooLarge1000),
+            (char)(kCarry | kTooLarge | kTooLarge1000), (char)(kCarry | kTooLarge | kTooLarge1000),
+            (char)(kCarry | kTooLarge | kTooLarge1000 | kSurrogate),
+            (char)(kCarry | kTooLarge | kTooLarge1000), (char)(kCarry | kTooLarge | kTooLarge1000));
+        const __m256i byte_2_high_table = _mm256_setr_epi8(
+            kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+            (char)(kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4),
+            (char)(kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge),
+            (char)(kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge),
+            (char)(kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge),
+            kTooShort, kTooShort, kTooShort, kTooShort,
+            kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+            (char)(kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4),
+            (char)(kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge),
+            (char)(kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge),
+            (char)(kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge),
+            kTooShort, kTooShort, kTooShort, kTooShort);
+
+        __m256i prev1 = prev<1>(input, prev_input);
+        __m256i byte_1_high = _mm256_shuffle_epi8(byte_1_high_table,
+                                _mm256_and_si256(_mm256_srli_epi16(prev1, 4), low_nibble));
+        __m256i byte_1_low  = _mm256_shuffle_epi8(byte_1_low_table,
+                                _mm256_and_si256(prev1, low_nibble));
+        __m256i byte_2_high = _mm256_shuffle_epi8(byte_2_high_table,
+                                _mm256_and_si256(_mm256_srli_epi16(input, 4), low_nibble));
+        __m256i special_cases = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+        // The 3rd and 4th bytes must be continuation bytes, it's the 0x80 bit of special_cases.
+        __m256i prev2 = prev<2>(input, prev_input);
+        __m256i prev3 = prev<3>(input, prev_input);
+        __m256i is_third_byte  = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+        __m256i is_fourth_byte = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+        __m256i must23_80 = _mm256_and_si256(_mm256_or_si256(is_third_byte, is_fourth_byte),
+                                             _mm256_set1_epi8((char)0x80));
+        this->error_ = _mm256_or_si256(this->error_, _mm256_xor_si256(must23_80, special_cases));
+    }
+};
+
+typedef utf8_checker_avx2   utf8_checker;
+
+#elif JSTD_UTF_HAVE_SSSE3
+
+class utf8_checker_ssse3 {
+private:
+    __m128i error_;
+    __m128i prev_input_;
+    __m128i prev_incomplete_;
+
+public:
+    utf8_checker_ssse3() : error_(_mm_setzero_si128()),
+                           prev_input_(_mm_setzero_si128()),
+                           prev_incomplete_(_mm_setzero_si128()) {
+    }
+
+    bool has_error() const {
+        return (_mm_movemask_epi8(_mm_cmpeq_epi8(this->error_, _mm_setzero_si128())) != 0xFFFF);
+    }
+
+    bool has_incomplete() const {
+        return (_mm_movemask_epi8(_mm_cmpeq_epi8(this->prev_incomplete_, _mm_setzero_si128())) != 0xFFFF);
+    }
+
+    void check_64bytes(const std::uint8_t * s) {
+        __m128i input0 = _mm_loadu_si128((const __m128i *)s);
+        __m128i input1 = _mm_loadu_si128((const __m128i *)(s + 16));
+        __m128i input2 = _mm_loadu_si128((const __m128i *)(s + 32));
+        __m128i input3 = _mm_loadu_si128((const __m128i *)(s + 48));
+        __m128i any = _mm_or_si128(_mm_or_si128(input0, input1), _mm_or_si128(input2, input3));
+        if (_mm_movemask_epi8(any) == 0) {
+            this->error_ = _mm_or_si128(this->error_, this->prev_incomplete_);
+            this->prev_incomplete_ = _mm_setzero_si128();
+        }
+        else {
+            this->check_utf8_bytes(input0, this->prev_input_);
+            this->check_utf8_bytes(input1, input0);
+            this->check_utf8_bytes(input2, input1);
+            this->check_utf8_bytes(input3, input2);
+            this->prev_incomplete_ = is_incomplete(input3);
+        }
+        this->prev_input_ = input3;
+    }
+
+private:
+    static inline __m128i is_incomplete(__m128i input) {
+        const __m128i max_value = _mm_setr_epi8(
+            -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+            (char)0xEF, (char)0xDF, (char)0xBF);
+        return _mm_subs_epu8(input, max_value);
+    }
+
+    void check_utf8_bytes(__m128i input, __m128i prev_input) {
+        const __m128i low_nibble = _mm_set1_epi8(0x0F);
+        const __m128i byte_1_high_table = _mm_setr_epi8(
+            kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+            (char)kTwoConts, (char)kTwoConts, (char)kTwoConts, (char)kTwoConts,
+            kTooShort | kOverlong2, kTooShort, kTooShort | kOverlong3 | kSurrogate,
+            kTooShort | kTooLarge | kTooLarge1000 | kOverlong4);
+        const __m128i byte_1_low_table = _mm_setr_epi8(
+            (char)(kCarry | kOverlong3 | kOverlong2 | kOverlong4), (char)(kCarry | kOverlong2),
+            (char)kCarry, (char)kCarry, (char)(kCarry | kTooLarge),
+            (char)(kCarry | kTooLarge | kTooLarge1000), (char)(kCarry | kTooLarge | kTooLarge1000),
+            (char)(kCarry | kTooLarge | kTooLarge1000), (char)(kCarry | kTooLarge | kTooLarge1000),
+            (char)(kCarry | kTooLarge | kTooLarge1000), (char)(kCarry | kTooLarge | kTooLarge1000),
+            (char)(kCarry | kTooLarge | kTooLarge1000), (char)(kCarry | kTooLarge | kTooLarge1000),
+            (char)(kCarry | kTooLarge | kTooLarge1000 | kSurrogate),
+            (char)(kCarry | kTooLarge | kTooLarge1000), (char)(kCarry | kTooLarge | kTooLarge1000));
+        const __m128i byte_2_high_table = _mm_setr_epi8(
+            kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+            (char)(kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4),
+            (char)(kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge),
+            (char)(kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge),
+            (char)(kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge),
+            kTooShort, kTooShort, kTooShort, kTooShort);
+
+        __m128i prev1 = _mm_alignr_epi8(input, prev_input, 16 - 1);
+        __m128i byte_1_high = _mm_shuffle_epi8(byte_1_high_table,
+                                _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble));
+        __m128i byte_1_low  = _mm_shuffle_epi8(byte_1_low_table,
+                                _mm_and_si128(prev1, low_nibble));
+        __m128i byte_2_high = _mm_shuffle_epi8(byte_2_high_table,
+                                _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble));
+        __m128i special_cases = _mm_and_si128(_mm_and_si128(byte_1_high, byte_1_low), byte_2_high);
+
+        __m128i prev2 = _mm_alignr_epi8(input, prev_input, 16 - 2);
+        __m128i prev3 = _mm_alignr_epi8(input, prev_input, 16 - 3);
+        __m128i is_third_byte  = _mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80)));
+        __m128i is_fourth_byte = _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80)));
+        __m128i must23_80 = _mm_and_si128(_mm_or_si128(is_third_byte, is_fourth_byte),
+                                          _mm_set1_epi8((char)0x80));
+        this->error_ = _mm_or_si128(this->error_, _mm_xor_si128(must23_80, special_cases));
+    }
+};
+
+typedef utf8_checker_ssse3  utf8_checker;
+
+#endif // JSTD_UTF_HAVE_AVX2
+
+#if JSTD_UTF_HAVE_SSE41
+
+//
+// The pshufb masks to decode 12 bytes of UTF-8, indexed by the bitmap of
+// the last bytes of the code points. The masks [0, 64) decode 6 code points
+// of 1 - 2 bytes to the 16 bits lanes, [64, 145) decode 4 code points of
+// 1 - 3 bytes to the 32 bits lanes, [145, 209) decode 3 code points of
+// 1 - 4 bytes to the 32 bits lanes.
+//
+struct utf8_decode_tables {
+    // The mask id | (consumed bytes << 8).
+    std::uint16_t index[4096];
+    alignas(16) std::uint8_t shuffle[209][16];
+
+    utf8_decode_tables() {
+        for (std::uint32_t mask = 0; mask < 4096; mask++) {
+            std::uint32_t lengths[12];
+            std::uint32_t count = 0, first = 0;
+            for (std::uint32_t i = 0; i < 12; i++) {
+                if ((mask & (1u << i)) != 0) {
+                    lengths[count++] = i - first + 1;
+                    first = i + 1;
+                }
+            }
+            std::uint32_t id, consumed = 0;
+            if ((count >= 6) && max_length(lengths, 6) <= 2) {
+                id = 0;
+                for (std::uint32_t k = 0; k < 6; k++) {
+                    id |= (lengths[k] - 1) << k;
+                    consumed += lengths[k];
+                }
+            }
+            else if ((count >= 4) && max_length(lengths, 4) <= 3) {
+                std::uint32_t scale = 1;
+                id = 64;
+                for (std::uint32_t k = 0; k < 4; k++) {
+                    id += (lengths[k] - 1) * scale;
+                    scale *= 3;
+                    consumed += lengths[k];
+                }
+            }
+            else if ((count >= 3) && max_length(lengths, 3) <= 4) {
+                id = 145;
+                for (std::uint32_t k = 0; k < 3; k++) {
+                    id += (lengths[k] - 1) << (k * 2);
+                    consumed += lengths[k];
+                }
+            }
+            else {
+                // A code point longer than 4 bytes never occurs in the validated input,
+                // take them as 3 code points of 1 byte.
+                id = 145;
+                consumed = 3;
+            }
+            this->index[mask] = static_cast<std::uint16_t>(id | (consumed << 8));
+        }
+
+        for (std::uint32_t id = 0; id < 64; id++) {
+            std::uint8_t * mask = this->shuffle[id];
+            std::uint32_t pos = 0;
+            for (std::uint32_t k = 0; k < 8; k++) {
+                std::uint32_t length = 1 + ((id >> k) & 1);
+                if (k < 6) {
+                    // The low byte is the last byte, the high byte is the lead byte of 2 bytes.
+                    mask[k * 2 + 0] = static_cast<std::uint8_t>(pos + length - 1);
+                    mask[k * 2 + 1] = (length == 2) ? static_cast<std::uint8_t>(pos) : 0x80;
+                    pos += length;
+                }
+                else {
+                    mask[k * 2 + 0] = mask[k * 2 + 1] = 0x80;
+                }
+            }
+        }
+
+        for (std::uint32_t id = 64; id < 209; id++) {
+            // The 32 bits lane is the bytes of a code point in the reverse order.
+            std::uint8_t * mask = this->shuffle[id];
+            std::uint32_t lengths = (id < 145) ? (id - 64) : (id - 145);
+            std::uint32_t lanes = (id < 145) ? 4 : 3;
+            std::uint32_t pos = 0;
+            for (std::uint32_t k = 0; k < 4; k++) {
+                std::uint32_t length = 0;
+                if (k < lanes) {
+                    if (id < 145) {
+                        length = 1 + (lengths % 3);
+                        lengths /= 3;
+                    }
+                    else {
+                        length = 1 + (lengths & 3);
+                        lengths >>= 2;
+                    }
+                }
+                for (std::uint32_t i = 0; i < 4; i++) {
+                    mask[k * 4 + i] = (i < length) ? static_cast<std::uint8_t>(pos + length - 1 - i) : 0x80;
+                }
+                pos += length;
+            }
+        }
+    }
+
+    static const utf8_decode_tables & get() {
+        static const utf8_decode_tables tables;
+        return tables;
+    }
+
+private:
+    static std::uint32_t max_length(const std::uint32_t * lengths, std::uint32_t count) {
+        std::uint32_t max_len = 0;
+        for (std::uint32_t i = 0; i < count; i++) {
+            if (lengths[i] > max_len)
+                max_len = lengths[i];
+        }
+        return max_len;
+    }
+};
+
+//
+// The pshufb masks to pack the UTF-8 bytes of 8 lanes of 16 bits (1 - 2 bytes),
+// indexed by the bitmap of the ASCII lanes, and of 4 lanes of 32 bits (1 - 3 bytes),
+// indexed by the bitmap of (>= 0x80) | (>= 0x800) << 4.
+//
+struct utf16_encode_tables {
+    alignas(16) std::uint8_t pack2[256][16];
+    alignas(16) std::uint8_t pack3[256][16];
+    std::uint8_t pack2_length[256];
+    std::uint8_t pack3_length[256];
+
+    utf16_encode_tables() {
+        for (std::uint32_t mask = 0; mask < 256; mask++) {
+            std::uint32_t n = 0;
+            for (std::uint32_t k = 0; k < 8; k++) {
+                this->pack2[mask][n++] = static_cast<std::uint8_t>(k * 2);
+                if ((mask & (1u << k)) == 0)
+                    this->pack2[mask][n++] = static_cast<std::uint8_t>(k * 2 + 1);
+            }
+            this->pack2_length[mask] = static_cast<std::uint8_t>(n);
+            while (n < 16) {
+                this->pack2[mask][n++] = 0x80;
+            }
+
+            n = 0;
+            for (std::uint32_t k = 0; k < 4; k++) {
+                std::uint32_t length = 1 + ((mask >> k) & 1) + ((mask >> (k + 4)) & 1);
+                for (std::uint32_t i = 0; i < length; i++) {
+                    this->pack3[mask][n++] = static_cast<std::uint8_t>(k * 4 + i);
+                }
+            }
+            this->pack3_length[mask] = static_cast<std::uint8_t>(n);
+            while (n < 16) {
+                this->pack3[mask][n++] = 0x80;
+            }
+        }
+    }
+
+    static const utf16_encode_tables & get() {
+        static const utf16_encode_tables tables;
+        return tables;
+    }
+};
+
+//
+// Decode the validated UTF-8 of a 64 bytes block at s, from the start of a code point,
+// until more than 48 bytes are consumed, return the consumed bytes. The bitmaps of
+// the whole block are computed first, so the loop only depends on the consumed bytes.
+//
+template <typename CharT>
+static inline
+std::size_t decode_utf8_64bytes_sse41(const utf8_decode_tables & tables, const std::uint8_t * s, CharT *& out)
+{
+    std::uint64_t non_ascii = 0, continuation = 0;
+    for (std::size_t i = 0; i < 64; i += 16) {
+        __m128i input = _mm_loadu_si128((const __m128i *)(s + i));
+        non_ascii |= static_cast<std::uint64_t>(
+            static_cast<std::uint32_t>(_mm_movemask_epi8(input))) << i;
+        // The continuation bytes are 0x80 - 0xBF, less than -64 as the signed bytes.
+        continuation |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmplt_epi8(input, _mm_set1_epi8(-64))))) << i;
+    }
+    // The bit i is set if the byte i is the last byte of a code point (i < 63).
+    std::uint64_t end_mask = ~continuation >> 1;
+
+    CharT * dest = out;
+    std::size_t offset = 0;
+    do {
+        __m128i input = _mm_loadu_si128((const __m128i *)(s + offset));
+        std::uint32_t ascii_bits = static_cast<std::uint32_t>(non_ascii >> offset) & 0xFFFF;
+        if (ascii_bits == 0) {
+            if (sizeof(CharT) == 2) {
+                _mm_storeu_si128((__m128i *)dest, _mm_cvtepu8_epi16(input));
+                _mm_storeu_si128((__m128i *)(dest + 8), _mm_cvtepu8_epi16(_mm_srli_si128(input, 8)));
+            }
+            else {
+                _mm_storeu_si128((__m128i *)dest, _mm_cvtepu8_epi32(input));
+                _mm_storeu_si128((__m128i *)(dest + 4), _mm_cvtepu8_epi32(_mm_srli_si128(input, 4)));
+                _mm_storeu_si128((__m128i *)(dest + 8), _mm_cvtepu8_epi32(_mm_srli_si128(input, 8)));
+                _mm_storeu_si128((__m128i *)(dest + 12), _mm_cvtepu8_epi32(_mm_srli_si128(input, 12)));
+            }
+            dest += 16;
+            offset += 16;
+            continue;
+        }
+
+        std::uint32_t entry = tables.index[static_cast<std::uint32_t>(end_mask >> offset) & 0xFFF];
+        std::uint32_t id = entry & 0xFF;
+        __m128i perm = _mm_shuffle_epi8(input, _mm_load_si128((const __m128i *)tables.shuffle[id]));
+        if (id < 64) {
+            // 6 code points of 1 - 2 bytes.
+            __m128i ascii = _mm_and_si128(perm, _mm_set1_epi16(0x007F));
+            __m128i high  = _mm_and_si128(perm, _mm_set1_epi16(0x1F00));
+            __m128i composed = _mm_or_si128(ascii, _mm_srli_epi16(high, 2));
+            if (sizeof(CharT) == 2) {
+                _mm_storeu_si128((__m128i *)dest, composed);
+            }
+            else {
+                _mm_storeu_si128((__m128i *)dest, _mm_cvtepu16_epi32(composed));
+                _mm_storel_epi64((__m128i *)(dest + 4), _mm_cvtepu16_epi32(_mm_srli_si128(composed, 8)));
+            }
+            dest += 6;
+        }
+        else if (id < 145) {
+            // 4 code points of 1 - 3 bytes.
+            __m128i ascii  = _mm_and_si128(perm, _mm_set1_epi32(0x0000007F));
+            __m128i middle = _mm_and_si128(perm, _mm_set1_epi32(0x00003F00));
+            __m128i high   = _mm_and_si128(perm, _mm_set1_epi32(0x000F0000));
+            __m128i composed = _mm_or_si128(_mm_or_si128(ascii, _mm_srli_epi32(middle, 2)),
+                                            _mm_srli_epi32(high, 4));
+            if (sizeof(CharT) == 2) {
+                _mm_storel_epi64((__m128i *)dest, _mm_packus_epi32(composed, composed));
+            }
+            else {
+                _mm_storeu_si128((__m128i *)dest, composed);
+            }
+            dest += 4;
+        }
+        else {
+            // 3 code points of 1 - 4 bytes, the lead byte of 3 bytes (1110____) in
+            // the 3rd byte has a spurious bit 0x20 after masked by 0x3F, clear it.
+            __m128i ascii  = _mm_and_si128(perm, _mm_set1_epi32(0x0000007F));
+            __m128i middle = _mm_and_si128(perm, _mm_set1_epi32(0x00003F00));
+            __m128i middle_high = _mm_and_si128(perm, _mm_set1_epi32(0x003F0000));
+            __m128i spurious = _mm_srli_epi32(_mm_and_si128(perm, _mm_set1_epi32(0x00400000)), 1);
+            middle_high = _mm_xor_si128(middle_high, spurious);
+            __m128i high   = _mm_and_si128(perm, _mm_set1_epi32(0x07000000));
+            __m128i composed = _mm_or_si128(
+                _mm_or_si128(ascii, _mm_srli_epi32(middle, 2)),
+                _mm_or_si128(_mm_srli_epi32(middle_high, 4), _mm_srli_epi32(high, 6)));
+            if (sizeof(CharT) == 2) {
+                alignas(16) std::uint32_t code_points[4];
+                _mm_store_si128((__m128i *)code_points, composed);
+                dest = write_code_point(dest, code_points[0]);
+                dest = write_code_point(dest, code_points[1]);
+                dest = write_code_point(dest, code_points[2]);
+            }
+            else {
+                _mm_storeu_si128((__m128i *)dest, composed);
+                dest += 3;
+            }
+        }
+        offset += entry >> 8;
+    } while (offset <= 48);
+
+    out = dest;
+    return offset;
+}
+
+//
+// Validate the UTF-8 by 64 bytes blocks ahead, and decode the validated bytes.
+//
+template <typename CharT>
+static inline
+result convert_utf8_sse41(const std::uint8_t * s, std::size_t len, CharT * out_first)
+{
+    const utf8_decode_tables & tables = utf8_decode_tables::get();
+    utf8_checker checker;
+    CharT * out = out_first;
+    std::size_t pos = 0, validated = 0;
+    while (validated + 64 <= len) {
+        checker.check_64bytes(s + validated);
+        if (unlikely(checker.has_error()))
+            break;
+        validated += 64;
+        // The last 16 bytes load is at pos + 48, and there are at least 32 validated
+        // bytes after it, so the 16 bytes stores never overflow the output.
+        while (pos + 80 <= validated) {
+            pos += decode_utf8_64bytes_sse41(tables, s + pos, out);
+        }
+    }
+    return convert_utf8_scalar(s, len, pos, out, out_first);
+}
+
+//
+// Encode 8 code units < 0x10000 (without surrogates) in the 16 or 32 bits lanes.
+//
+static inline
+void encode_utf16_3bytes_sse41(const utf16_encode_tables & tables, __m128i units, char *& out)
+{
+    __m128i ge_80  = _mm_cmpgt_epi32(units, _mm_set1_epi32(0x7F));
+    __m128i ge_800 = _mm_cmpgt_epi32(units, _mm_set1_epi32(0x7FF));
+    const __m128i cont_bits = _mm_set1_epi32(0x80);
+    const __m128i low_6bits = _mm_set1_epi32(0x3F);
+    // 2 bytes: 110yyyyy 10xxxxxx
+    __m128i two_bytes = _mm_or_si128(
+        _mm_or_si128(_mm_srli_epi32(units, 6), _mm_set1_epi32(0xC0)),
+        _mm_slli_epi32(_mm_or_si128(_mm_and_si128(units, low_6bits), cont_bits), 8));
+    // 3 bytes: 1110zzzz 10yyyyyy 10xxxxxx
+    __m128i three_bytes = _mm_or_si128(
+        _mm_or_si128(_mm_srli_epi32(units, 12), _mm_set1_epi32(0xE0)),
+        _mm_or_si128(
+            _mm_slli_epi32(_mm_or_si128(_mm_and_si128(_mm_srli_epi32(units, 6), low_6bits), cont_bits), 8),
+            _mm_slli_epi32(_mm_or_si128(_mm_and_si128(units, low_6bits), cont_bits), 16)));
+    __m128i bytes = _mm_blendv_epi8(units, two_bytes, ge_80);
+    bytes = _mm_blendv_epi8(bytes, three_bytes, ge_800);
+
+    std::uint32_t key = static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(ge_80))) |
+                       (static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(ge_800))) << 4);
+    __m128i packed = _mm_shuffle_epi8(bytes, _mm_load_si128((const __m128i *)tables.pack3[key]));
+    _mm_storeu_si128((__m128i *)out, packed);
+    out += tables.pack3_length[key];
+}
+
+static inline
+result convert_utf16_sse41(const char16_t * s, std::size_t len, char * out_first)
+{
+    const utf16_encode_tables & tables = utf16_encode_tables::get();
+    char * out = out_first;
+    std::size_t pos = 0;
+    error_code error = error_code::ok;
+    // At least 20 code units left, so there are 16 units after the first half,
+    // the 16 bytes stores never overflow the output.
+    while (pos + 20 <= len) {
+        __m128i units = _mm_loadu_si128((const __m128i *)(s + pos));
+        if (_mm_testz_si128(units, _mm_set1_epi16((short)0xFF80))) {
+            __m128i units2 = _mm_loadu_si128((const __m128i *)(s + pos + 8));
+            if (_mm_testz_si128(units2, _mm_set1_epi16((short)0xFF80))) {
+                _mm_storeu_si128((__m128i *)out, _mm_packus_epi16(units, units2));
+                out += 16;
+                pos += 16;
+            }
+            else {
+                _mm_storel_epi64((__m128i *)out, _mm_packus_epi16(units, units));
+                out += 8;
+                pos += 8;
+            }
+        }
+        else if (_mm_testz_si128(units, _mm_set1_epi16((short)0xF800))) {
+            // 1 - 2 bytes: the ASCII lanes keep the low byte.
+            __m128i is_ascii = _mm_cmpeq_epi16(_mm_and_si128(units, _mm_set1_epi16((short)0xFF80)),
+                                               _mm_setzero_si128());
+            __m128i two_bytes = _mm_or_si128(
+                _mm_or_si128(_mm_srli_epi16(units, 6), _mm_set1_epi16(0xC0)),
+                _mm_slli_epi16(_mm_or_si128(_mm_and_si128(units, _mm_set1_epi16(0x3F)),
+                                            _mm_set1_epi16(0x80)), 8));
+            __m128i bytes = _mm_blendv_epi8(two_bytes, units, is_ascii);
+            std::uint32_t mask = static_cast<std::uint32_t>(
+                _mm_movemask_epi8(_mm_packs_epi16(is_ascii, is_ascii))) & 0xFF;
+            __m128i packed = _mm_shuffle_epi8(bytes, _mm_load_si128((const __m128i *)tables.pack2[mask]));
+            _mm_storeu_si128((__m128i *)out, packed);
+            out += tables.pack2_length[mask];
+            pos += 8;
+        }
+        else {
+            // By 4 code units, the surrogates are encoded by the scalar code.
+            std::size_t last = pos + 8;
+            while (pos + 4 <= last) {
+                __m128i units4 = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(s + pos)));
+                __m128i surrogates = _mm_cmpeq_epi32(_mm_and_si128(units4, _mm_set1_epi32(0xF800)),
+                                                     _mm_set1_epi32(0xD800));
+                if (_mm_movemask_epi8(surrogates) == 0) {
+                    encode_utf16_3bytes_sse41(tables, units4, out);
+                    pos += 4;
+                }
+                else {
+                    std::size_t next = convert_utf16_scalar(s, len, pos, pos + 4, out, error);
+                    if (unlikely(error != error_code::ok)) {
+                        result res = { error, next };
+                        return res;
+                    }
+                    pos = next;
+                }
+            }
+        }
+    }
+
+    pos = convert_utf16_scalar(s, len, pos, len, out, error);
+    if (unlikely(error != error_code::ok)) {
+        result res = { error, pos };
+        return res;
+    }
+    result res = { error_code::ok, static_cast<std::size_t>(out - out_first) };
+    return res;
+}
+
+static inline
+result convert_utf32_sse41(const char32_t * s, std::size_t len, char * out_first)
+{
+    const utf16_encode_tables & tables = utf16_encode_tables::get();
+    char * out = out_first;
+    std::size_t pos = 0;
+    error_code error = error_code::ok;
+    // At least 20 code units left, so there are 16 units after the first half,
+    // the 16 bytes stores never overflow the output.
+    while (pos + 20 <= len) {
+        __m128i units0 = _mm_loadu_si128((const __m128i *)(s + pos));
+        __m128i units1 = _mm_loadu_si128((const __m128i *)(s + pos + 4));
+        if (_mm_testz_si128(_mm_or_si128(units0, units1), _mm_set1_epi32((int)0xFFFFFF80))) {
+            __m128i packed = _mm_packus_epi32(units0, units1);
+            _mm_storel_epi64((__m128i *)out, _mm_packus_epi16(packed, packed));
+            out += 8;
+            pos += 8;
+            continue;
+        }
+        for (std::size_t half = 0; half < 2; half++) {
+            __m128i units = (half == 0) ? units0 : units1;
+            __m128i surrogates = _mm_cmpeq_epi32(_mm_and_si128(units, _mm_set1_epi32((int)0xFFFFF800)),
+                                                 _mm_set1_epi32(0xD800));
+            if (_mm_testz_si128(units, _mm_set1_epi32((int)0xFFFF0000)) &&
+                (_mm_movemask_epi8(surrogates) == 0)) {
+                encode_utf16_3bytes_sse41(tables, units, out);
+            }
+            else {
+                std::size_t next = convert_utf32_scalar(s, pos, pos + 4, out, error);
+                if (unlikely(error != error_code::ok)) {
+                    result res = { error, next };
+                    return res;
+                }
+            }
+            pos += 4;
+        }
+    }
+
+    pos = convert_utf32_scalar(s, pos, len, out, error);
+    if (unlikely(error != error_code::ok)) {
+        result res = { error, pos };
+        return res;
+    }
+    result res = { error_code::ok, static_cast<std::size_t>(out - out_first) };
+    return res;
+}
+
+#endif // JSTD_UTF_HAVE_SSE41
+
+// The number of bytes that are not continuation bytes, and are 4 bytes lead bytes.
+static inline
+void count_utf8_leads(const std::uint8_t * s, std::size_t len,
+                      std::size_t & non_continuations, std::size_t & four_bytes_leads)
+{
+    std::size_t count1 = 0, count4 = 0;
+    std::size_t pos = 0;
+#if JSTD_UTF_HAVE_AVX2
+    for (; pos + 32 <= len; pos += 32) {
+        __m256i input = _mm256_loadu_si256((const __m256i *)(s + pos));
+        std::uint32_t sign = static_cast<std::uint32_t>(_mm256_movemask_epi8(input));
+        std::uint32_t non_cont = static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpgt_epi8(input, _mm256_set1_epi8(-65))));
+        std::uint32_t ge_f0 = sign & static_cast<std::uint32_t>(
+            _mm256_movemask_epi8(_mm256_cmpgt_epi8(input, _mm256_set1_epi8(-17))));
+        count1 += BitUtils::popcnt(non_cont);
+        count4 += BitUtils::popcnt(ge_f0);
+    }
+#elif defined(__SSE2__)
+    for (; pos + 16 <= len; pos += 16) {
+        __m128i input = _mm_loadu_si128((const __m128i *)(s + pos));
+        std::uint32_t sign = static_cast<std::uint32_t>(_mm_movemask_epi8(input));
+        std::uint32_t non_cont = static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpgt_epi8(input, _mm_set1_epi8(-65))));
+        std::uint32_t ge_f0 = sign & static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpgt_epi8(input, _mm_set1_epi8(-17))));
+        count1 += BitUtils::popcnt(non_cont);
+        count4 += BitUtils::popcnt(ge_f0);
+    }
+#endif
+    for (; pos < len; pos++) {
+        count1 += is_continuation(s[pos]) ? 0 : 1;
+        count4 += (s[pos] >= 0xF0) ? 1 : 0;
+    }
+    non_continuations = count1;
+    four_bytes_leads = count4;
+}
+
+} // namespace detail
+
+//
+// Validation
+//
+
+static inline
+result validate_utf8_with_errors(const char * src, std::size_t len)
+{
+    const std::uint8_t * s = reinterpret_cast<const std::uint8_t *>(src);
+    std::size_t pos = 0;
+#if JSTD_UTF_HAVE_AVX2 || JSTD_UTF_HAVE_SSSE3
+    detail::utf8_checker checker;
+    while (pos + 64 <= len) {
+        checker.check_64bytes(s + pos);
+        if (unlikely(checker.has_error()))
+            break;
+        pos += 64;
+    }
+    // Find the exact error, or validate the tail.
+    pos = detail::utf8_rewind(s, pos);
+#endif
+    return detail::validate_utf8_scalar(s, len, pos);
+}
+
+static inline
+bool validate_utf8(const char * src, std::size_t len)
+{
+    return (validate_utf8_with_errors(src, len).error == error_code::ok);
+}
+
+static inline
+bool validate_utf8(const jstd::string_view & src)
+{
+    return validate_utf8(src.data(), src.size());
+}
+
+//
+// The lengths of the conversion, they are exact for the valid input.
+//
+
+static inline
+std::size_t utf16_length_from_utf8(const char * src, std::size_t len)
+{
+    std::size_t non_continuations, four_bytes_leads;
+    detail::count_utf8_leads(reinterpret_cast<const std::uint8_t *>(src), len,
+                             non_continuations, four_bytes_leads);
+    return (non_continuations + four_bytes_leads);
+}
+
+static inline
+std::size_t utf32_length_from_utf8(const char * src, std::size_t len)
+{
+    std::size_t non_continuations, four_bytes_leads;
+    detail::count_utf8_leads(reinterpret_cast<const std::uint8_t *>(src), len,
+                             non_continuations, four_bytes_leads);
+    return non_continuations;
+}
+
+static inline
+std::size_t utf8_length_from_utf16(const char16_t * src, std::size_t len)
+{
+    // A surrogate pair is 4 bytes, 2 bytes for each surrogate.
+    std::size_t length = len;
+    for (std::size_t i = 0; i < len; i++) {
+        std::uint32_t unit = src[i];
+        length += (unit >= 0x80) + (unit >= 0x800) - ((unit & 0xF800) == 0xD800);
+    }
+    return length;
+}
+
+static inline
+std::size_t utf8_length_from_utf32(const char32_t * src, std::size_t len)
+{
+    std::size_t length = len;
+    for (std::size_t i = 0; i < len; i++) {
+        std::uint32_t cp = src[i];
+        length += (cp >= 0x80) + (cp >= 0x800) + (cp >= 0x10000);
+    }
+    return length;
+}
+
+//
+// The conversions, the dest must have room for the length of the conversion.
+//
+
+static inline
+result convert_utf8_to_utf16(const char * src, std::size_t len, char16_t * dest)
+{
+    const std::uint8_t * s = reinterpret_cast<const std::uint8_t *>(src);
+#if JSTD_UTF_HAVE_SSE41
+    return detail::convert_utf8_sse41(s, len, dest);
+#else
+    return detail::convert_utf8_scalar(s, len, 0, dest, dest);
+#endif
+}
+
+static inline
+result convert_utf8_to_utf32(const char * src, std::size_t len, char32_t * dest)
+{
+    const std::uint8_t * s = reinterpret_cast<const std::uint8_t *>(src);
+#if JSTD_UTF_HAVE_SSE41
+    return detail::convert_utf8_sse41(s, len, dest);
+#else
+    return detail::convert_utf8_scalar(s, len, 0, dest, dest);
+#endif
+}
+
+static inline
+result convert_utf16_to_utf8(const char16_t * src, std::size_t len, char * dest)
+{
+#if JSTD_UTF_HAVE_SSE41
+    return detail::convert_utf16_sse41(src, len, dest);
+#else
+    char * out = dest;
+    error_code error = error_code::ok;
+    std::size_t pos = detail::convert_utf16_scalar(src, len, 0, len, out, error);
+    result res = { error, (error == error_code::ok) ? static_cast<std::size_t>(out - dest) : pos };
+    return res;
+#endif
+}
+
+static inline
+result convert_utf32_to_utf8(const char32_t * src, std::size_t len, char * dest)
+{
+#if JSTD_UTF_HAVE_SSE41
+    return detail::convert_utf32_sse41(src, len, dest);
+#else
+    char * out = dest;
+    error_code error = error_code::ok;
+    std::size_t pos = detail::convert_utf32_scalar(src, 0, len, out, error);
+    result res = { error, (error == error_code::ok) ? static_cast<std::size_t>(out - dest) : pos };
+    return res;
+#endif
+}
+
+//
+// The string conversions, return false if the input is invalid.
+//
+
+template <typename CharT>
+static inline
+bool utf8_to_utf16(const jstd::string_view & src, std::basic_string<CharT> & dest)
+{
+    static_assert((sizeof(CharT) == 2), "utf8_to_utf16(): CharT must be a 16 bits type.");
+    dest.resize(utf16_length_from_utf8(src.data(), src.size()));
+    result res = convert_utf8_to_utf16(src.data(), src.size(),
+                                       reinterpret_cast<char16_t *>(&dest[0]));
+    if (res.error != error_code::ok) {
+        dest.clear();
+        return false;
+    }
+    dest.resize(res.count);
+    return true;
+}
+
+template <typename CharT>
+static inline
+bool utf8_to_utf32(const jstd::string_view & src, std::basic_string<CharT> & dest)
+{
+    static_assert((sizeof(CharT) == 4), "utf8_to_utf32(): CharT must be a 32 bits type.");
+    dest.resize(utf32_length_from_utf8(src.data(), src.size()));
+    result res = convert_utf8_to_utf32(src.data(), src.size(),
+                                       reinterpret_cast<char32_t *>(&dest[0]));
+    if (res.error != error_code::ok) {
+        dest.clear();
+        return false;
+    }
+    dest.resize(res.count);
+    return true;
+}
+
+template <typename CharT>
+static inline
+bool utf16_to_utf8(const jstd::basic_string_view<CharT> & src, std::string & dest)
+{
+    static_assert((sizeof(CharT) == 2), "utf16_to_utf8(): CharT must be a 16 bits type.");
+    const char16_t * s = reinterpret_cast<const char16_t *>(src.data());
+    dest.resize(utf8_length_from_utf16(s, src.size()));
+    result res = convert_utf16_to_utf8(s, src.size(), &dest[0]);
+    if (res.error != error_code::ok) {
+        dest.clear();
+        return false;
+    }
+    dest.resize(res.count);
+    return true;
+}
+
+template <typename CharT>
+static inline
+bool utf32_to_utf8(const jstd::basic_string_view<CharT> & src, std::string & dest)
+{
+    static_assert((sizeof(CharT) == 4), "utf32_to_utf8(): CharT must be a 32 bits type.");
+    const char32_t * s = reinterpret_cast<const char32_t *>(src.data());
+    dest.resize(utf8_length_from_utf32(s, src.size()));
+    result res = convert_utf32_to_utf8(s, src.size(), &dest[0]);
+    if (res.error != error_code::ok) {
+        dest.clear();
+        return false;
+    }
+    dest.resize(res.count);
+    return true;
+}
+
+namespace detail {
+
+template <std::size_t WCharSize, typename WCharT = wchar_t>
+struct wchar_converter {
+    static bool from_utf8(const jstd::string_view & src, std::basic_string<WCharT> & dest) {
+        return utf8_to_utf32(src, dest);
+    }
+    static bool to_utf8(const jstd::basic_string_view<WCharT> & src, std::string & dest) {
+        return utf32_to_utf8(src, dest);
+    }
+};
+
+template <typename WCharT>
+struct wchar_converter<2, WCharT> {
+    static bool from_utf8(const jstd::string_view & src, std::basic_string<WCharT> & dest) {
+        return utf8_to_utf16(src, dest);
+    }
+    static bool to_utf8(const jstd::basic_string_view<WCharT> & src, std::string & dest) {
+        return utf16_to_utf8(src, dest);
+    }
+};
+
+} // namespace detail
+
+//
+// The wchar_t is UTF-16 on Windows, and UTF-32 on the others.
+//
+static inline
+bool utf8_to_wstring(const jstd::string_view & src, std::wstring & dest)
+{
+    return detail::wchar_converter<sizeof(wchar_t)>::from_utf8(src, dest);
+}
+
+static inline
+bool wstring_to_utf8(const jstd::wstring_view & src, std::string & dest)
+{
+    return detail::wchar_converter<sizeof(wchar_t)>::to_utf8(src, dest);
+}
+
+} // namespace utf
+} // namespace jstd
+
+#endif // JSTD_STRING_UTF_CONVERT_H
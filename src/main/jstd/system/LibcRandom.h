@@ -119,6 +119,18 @@ public:
         else
             return static_cast<std::size_t>(this->nextUInt64());
     }
+
+    void fill(std::uint32_t * out, size_type n) {
+        for (size_type i = 0; i < n; i++) {
+            out[i] = this->nextUInt32();
+        }
+    }
+
+    void fill(std::uint64_t * out, size_type n) {
+        for (size_type i = 0; i < n; i++) {
+            out[i] = this->nextUInt64();
+        }
+    }
 };
 
 } // namespace jstd
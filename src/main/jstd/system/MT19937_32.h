@@ -258,7 +258,16 @@ private:
     }
 
     value_type twist(value_type u, value_type v) const {
-        return ((this->mixbits(u, v) >> 1) ^ ((v & 1ul) ? 2567483615ul : 0ul));
+        // Branchless, so next_state() can be vectorized.
+        return ((this->mixbits(u, v) >> 1) ^ ((0ul - (v & 1ul)) & 2567483615ul));
+    }
+
+    static value_type tempering(value_type y) {
+        y ^= (y >> 11);
+        y ^= (y <<  7) & 0x9d2c5680ul;
+        y ^= (y << 15) & 0xefc60000ul;
+        y ^= (y >> 18);
+        return y;
     }
 
 public:
@@ -288,12 +297,7 @@ public:
         else
             y = static_cast<value_type>(LibcRand::rand32());
 
-        // Tempering
-        y ^= (y >> 11);
-        y ^= (y <<  7) & 0x9d2c5680ul;
-        y ^= (y << 15) & 0xefc60000ul;
-        y ^= (y >> 18);
-        return y;
+        return tempering(y);
     }
 
     std::int32_t nextInt32() {
@@ -327,6 +331,40 @@ public:
         else
             return static_cast<std::size_t>(this->nextUInt64());
     }
+
+    //
+    // The same values as n calls of nextUInt32(), bit by bit: the values up to
+    // the next next_state() are tempered in a tight loop.
+    //
+    void fill(std::uint32_t * out, size_type n) {
+        size_type i = 0;
+        while (i < n) {
+            if (this->next == nullptr && this->left != 1) {
+                out[i++] = this->nextUInt32();
+                continue;
+            }
+            if (0 == --this->left) {
+                this->next_state();
+            }
+            // The current value and (left - 1) more values before next_state().
+            size_type count = static_cast<size_type>(this->left);
+            if (count > (n - i))
+                count = n - i;
+            const value_type * p = this->next;
+            for (size_type k = 0; k < count; k++) {
+                out[i + k] = tempering(p[k]);
+            }
+            this->next += count;
+            this->left -= static_cast<value_type>(count - 1);
+            i += count;
+        }
+    }
+
+    void fill(std::uint64_t * out, size_type n) {
+        for (size_type i = 0; i < n; i++) {
+            out[i] = this->nextUInt64();
+        }
+    }
 };
 
 } // namespace jstd
@@ -258,7 +258,41 @@ private:
     }
 
     value_type twist(value_type u, value_type v) const {
-        return ((this->mixbits(u, v) >> 1) ^ ((v & 1ull) ? 0xB5026F5AA96619E9ull : 0ull));
+        // Branchless, so next_state() can be vectorized.
+        return ((this->mixbits(u, v) >> 1) ^ ((0ull - (v & 1ull)) & 0xB5026F5AA96619E9ull));
+    }
+
+    static value_type tempering(value_type y) {
+        y ^= (y >> 29) & 0x5555555555555555ull;
+        y ^= (y << 17) & 0x71D67FFFEDA60000ull;
+        y ^= (y << 37) & 0xFFF7EEE000000000ull;
+        y ^= (y >> 43);
+        return y;
+    }
+
+    template <typename T>
+    void fill_impl(T * out, size_type n) {
+        size_type i = 0;
+        while (i < n) {
+            if (this->next == nullptr && this->left != 1) {
+                out[i++] = static_cast<T>(this->rand());
+                continue;
+            }
+            if (0 == --this->left) {
+                this->next_state();
+            }
+            // The current value and (left - 1) more values before next_state().
+            size_type count = static_cast<size_type>(this->left);
+            if (count > (n - i))
+                count = n - i;
+            const value_type * p = this->next;
+            for (size_type k = 0; k < count; k++) {
+                out[i + k] = static_cast<T>(tempering(p[k]));
+            }
+            this->next += count;
+            this->left -= static_cast<value_type>(count - 1);
+            i += count;
+        }
     }
 
 public:
@@ -288,12 +322,7 @@ public:
         else
             y = static_cast<value_type>(LibcRand::rand64());
 
-        // Tempering
-        y ^= (y >> 29) & 0x5555555555555555ull;
-        y ^= (y << 17) & 0x71D67FFFEDA60000ull;
-        y ^= (y << 37) & 0xFFF7EEE000000000ull;
-        y ^= (y >> 43);
-        return y;
+        return tempering(y);
     }
 
     std::int32_t nextInt32() {
@@ -319,6 +348,18 @@ public:
     std::size_t nextUInt() {
         return static_cast<std::size_t>(this->rand());
     }
+
+    //
+    // The same values as n calls of nextUInt32() or nextUInt64(), bit by bit:
+    // the values up to the next next_state() are tempered in a tight loop.
+    //
+    void fill(std::uint32_t * out, size_type n) {
+        this->fill_impl<std::uint32_t>(out, n);
+    }
+
+    void fill(std::uint64_t * out, size_type n) {
+        this->fill_impl<std::uint64_t>(out, n);
+    }
 };
 
 } // namespace jstd
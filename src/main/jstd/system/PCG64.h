@@ -0,0 +1,233 @@
+
+#ifndef JSTD_SYSTEM_PCG64_H
+#define JSTD_SYSTEM_PCG64_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+#include "jstd/basic/stdsize.h"
+
+#include <time.h>
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64))
+#include <intrin.h>     // For _umul128()
+#endif
+
+//
+// PCG64 (PCG-XSL-RR 128/64, pcg_setseq_128_xsl_rr_64), a 128-bit LCG with
+// a 64-bit permuted output, the period is 2^128, and the streams are selectable.
+//
+//   Melissa E. O'Neill, "PCG: A Family of Simple Fast Space-Efficient Statistically
+//   Good Algorithms for Random Number Generation", HMC-CS-2014-0905.
+//   https://www.pcg-random.org/
+//
+// The seeding is the same as pcg64_srandom_r(), so the sequences match the reference.
+//
+namespace jstd {
+
+class PCG64
+{
+public:
+    typedef std::uint64_t value_type;
+    typedef std::size_t   size_type;
+
+    static const value_type kDefaultSeed = 20200831ull;
+    static const value_type kDefaultStream = 0xDA3E39CB94B95BDBull;
+    static const value_type kRandMax = 0xFFFFFFFFFFFFFFFFull;
+
+    // The default multiplier of the 128-bit LCG.
+    static const value_type kMultiplierHigh = 2549297995355413924ull;
+    static const value_type kMultiplierLow  = 4865540595714422341ull;
+
+private:
+#if defined(__SIZEOF_INT128__)
+    typedef unsigned __int128 uint128_t;
+
+    uint128_t state_;
+    uint128_t inc_;
+#else
+    struct uint128_t {
+        value_type low;
+        value_type high;
+    };
+
+    uint128_t state_;
+    uint128_t inc_;
+#endif
+
+public:
+    explicit PCG64(value_type initSeed = kDefaultSeed, value_type initStream = kDefaultStream) {
+        this->srand(initSeed, initStream);
+    }
+
+    ~PCG64() {}
+
+    value_type rand_max() const {
+        return static_cast<value_type>(kRandMax);
+    }
+
+private:
+#if defined(__SIZEOF_INT128__)
+    static uint128_t make_uint128(value_type high, value_type low) {
+        return ((static_cast<uint128_t>(high) << 64) | low);
+    }
+
+    static value_type high_of(uint128_t x) { return static_cast<value_type>(x >> 64); }
+    static value_type low_of(uint128_t x) { return static_cast<value_type>(x); }
+
+    static uint128_t add(uint128_t a, uint128_t b) {
+        return (a + b);
+    }
+
+    static uint128_t step(uint128_t state, uint128_t inc) {
+        return (state * make_uint128(kMultiplierHigh, kMultiplierLow) + inc);
+    }
+#else
+    static uint128_t make_uint128(value_type high, value_type low) {
+        uint128_t result;
+        result.low = low;
+        result.high = high;
+        return result;
+    }
+
+    static value_type high_of(const uint128_t & x) { return x.high; }
+    static value_type low_of(const uint128_t & x) { return x.low; }
+
+    static uint128_t add(const uint128_t & a, const uint128_t & b) {
+        uint128_t result;
+        result.low = a.low + b.low;
+        result.high = a.high + b.high + ((result.low < a.low) ? 1 : 0);
+        return result;
+    }
+
+    static value_type mul_high64(value_type a, value_type b) {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_AMD64))
+        value_type high;
+        (void)_umul128(a, b, &high);
+        return high;
+#else
+        value_type a_lo = a & 0xFFFFFFFFull, a_hi = a >> 32;
+        value_type b_lo = b & 0xFFFFFFFFull, b_hi = b >> 32;
+        value_type lo_lo = a_lo * b_lo;
+        value_type hi_lo = a_hi * b_lo;
+        value_type lo_hi = a_lo * b_hi;
+        value_type hi_hi = a_hi * b_hi;
+        value_type cross = (lo_lo >> 32) + (hi_lo & 0xFFFFFFFFull) + lo_hi;
+        return (hi_hi + (hi_lo >> 32) + (cross >> 32));
+#endif
+    }
+
+    static uint128_t step(const uint128_t & state, const uint128_t & inc) {
+        // state * multiplier (mod 2^128)
+        uint128_t product;
+        product.low = state.low * kMultiplierLow;
+        product.high = mul_high64(state.low, kMultiplierLow) +
+                       state.low * kMultiplierHigh + state.high * kMultiplierLow;
+        return add(product, inc);
+    }
+#endif // __SIZEOF_INT128__
+
+    // XSL-RR: xor the high and low halves, then rotate right by the top 6 bits.
+    static value_type output(const uint128_t & state) {
+        value_type value = high_of(state) ^ low_of(state);
+        unsigned int rot = static_cast<unsigned int>(high_of(state) >> 58);
+        return ((value >> rot) | (value << ((64 - rot) & 63)));
+    }
+
+    value_type next() {
+        this->state_ = step(this->state_, this->inc_);
+        return output(this->state_);
+    }
+
+public:
+    void srand(value_type initSeed = kDefaultSeed) {
+        this->srand(initSeed, kDefaultStream);
+    }
+
+    void srand(value_type initSeed, value_type initStream) {
+        if (initSeed == 0) {
+            time_t timer;
+            ::time(&timer);
+            initSeed = static_cast<value_type>(timer);
+        }
+        this->srand128(0, initSeed, 0, initStream);
+    }
+
+    //
+    // The same as pcg64_srandom_r(rng, initstate, initseq) of the reference.
+    //
+    void srand128(value_type seedHigh, value_type seedLow, value_type streamHigh, value_type streamLow) {
+        // inc = (initseq << 1) | 1
+        this->inc_ = make_uint128((streamHigh << 1) | (streamLow >> 63), (streamLow << 1) | 1ull);
+        this->state_ = make_uint128(0, 0);
+        this->state_ = step(this->state_, this->inc_);
+        this->state_ = add(this->state_, make_uint128(seedHigh, seedLow));
+        this->state_ = step(this->state_, this->inc_);
+    }
+
+    value_type rand() {
+        return this->next();
+    }
+
+    // The upper bits are the same good as the lower bits, use the upper bits like xoshiro.
+    std::int32_t nextInt32() {
+        return static_cast<std::int32_t>(this->next() >> 32);
+    }
+
+    std::uint32_t nextUInt32() {
+        return static_cast<std::uint32_t>(this->next() >> 32);
+    }
+
+    std::int64_t nextInt64() {
+        return static_cast<std::int64_t>(this->next());
+    }
+
+    std::uint64_t nextUInt64() {
+        return static_cast<std::uint64_t>(this->next());
+    }
+
+    std::intptr_t nextInt() {
+        if (sizeof(std::intptr_t) == 4)
+            return static_cast<std::intptr_t>(this->nextInt32());
+        else
+            return static_cast<std::intptr_t>(this->nextInt64());
+    }
+
+    std::size_t nextUInt() {
+        if (sizeof(std::size_t) == 4)
+            return static_cast<std::size_t>(this->nextUInt32());
+        else
+            return static_cast<std::size_t>(this->nextUInt64());
+    }
+
+    //
+    // The same values as n calls of nextUInt32() or nextUInt64().
+    //
+    void fill(std::uint32_t * out, size_type n) {
+        uint128_t state = this->state_;
+        for (size_type i = 0; i < n; i++) {
+            state = step(state, this->inc_);
+            out[i] = static_cast<std::uint32_t>(output(state) >> 32);
+        }
+        this->state_ = state;
+    }
+
+    void fill(std::uint64_t * out, size_type n) {
+        uint128_t state = this->state_;
+        for (size_type i = 0; i < n; i++) {
+            state = step(state, this->inc_);
+            out[i] = output(state);
+        }
+        this->state_ = state;
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_SYSTEM_PCG64_H
@@ -59,6 +59,9 @@
 #include "jstd/system/LibcRandom.h"
 #include "jstd/system/MT19937_32.h"
 #include "jstd/system/MT19937_64.h"
+#include "jstd/system/SFMT19937.h"
+#include "jstd/system/Xoshiro256pp.h"
+#include "jstd/system/PCG64.h"
 
 namespace jstd {
 
@@ -118,6 +121,15 @@ public:
         return this_type::getInstance().nextUInt();
     }
 
+    // The same values as n calls of nextUInt32() / nextUInt64(), but faster.
+    static void fill(std::uint32_t * out, size_type n) {
+        this_type::getInstance().fill(out, n);
+    }
+
+    static void fill(std::uint64_t * out, size_type n) {
+        this_type::getInstance().fill(out, n);
+    }
+
     static std::int32_t nextInt32(std::int32_t minValue, std::int32_t maxValue) {
         std::int32_t result = this_type::nextInteger<std::int32_t, std::uint32_t>(minValue, maxValue);
         return result;
@@ -261,6 +273,9 @@ private:
 typedef BasicRandomGenerator<LibcRandom>    RandomGen;
 typedef BasicRandomGenerator<MT19937_32>    MtRandomGen32;
 typedef BasicRandomGenerator<MT19937_64>    MtRandomGen64;
+typedef BasicRandomGenerator<SFMT19937>     SfmtRandomGen;
+typedef BasicRandomGenerator<Xoshiro256pp>  XoshiroRandomGen;
+typedef BasicRandomGenerator<PCG64>         PcgRandomGen;
 
 #if defined(_M_X64) || defined(_M_AMD64) || defined(_M_IA64) || defined(__amd64__) || defined(__x86_64__) \
  || defined(__aarch64__) || defined(_M_ARM64) || defined(__ARM64__) || defined(__arm64__)
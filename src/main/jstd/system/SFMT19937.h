@@ -0,0 +1,290 @@
+
+#ifndef JSTD_SYSTEM_SFMT19937_H
+#define JSTD_SYSTEM_SFMT19937_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+#include "jstd/basic/stdsize.h"
+
+#include <string.h>
+#include <time.h>
+
+#include <cstdint>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#include <emmintrin.h>
+#define JSTD_SFMT_USE_SSE2  1
+#endif
+
+//
+// SFMT19937, the SIMD-oriented Fast Mersenne Twister, the period is 2^19937 - 1.
+//
+// The recursion works on the 128-bit words, so it's 4 lanes of MT at once on SSE2
+// (and the portable version is auto-vectorized), it's not the same sequence as MT19937.
+//
+//   Mutsuo Saito and Makoto Matsumoto, "SIMD-oriented Fast Mersenne Twister:
+//   a 128-bit Pseudorandom Number Generator", Monte Carlo and Quasi-Monte Carlo
+//   Methods 2006. http://www.math.sci.hiroshima-u.ac.jp/m-mat/MT/SFMT/
+//
+// The seeding is the same as init_gen_rand() of the reference (version 1.5).
+//
+namespace jstd {
+
+class SFMT19937
+{
+public:
+    typedef std::uint32_t value_type;
+    typedef std::size_t   size_type;
+
+    static const value_type kDefaultSeed = 19650218ul;
+    static const value_type kRandMax = 0xFFFFFFFFul;
+
+    static const size_type N = 156;             // The 128-bit words
+    static const size_type N32 = N * 4;
+    static const size_type POS1 = 122;
+    static const int SL1 = 18;
+    static const int SL2 = 1;                   // In bytes
+    static const int SR1 = 11;
+    static const int SR2 = 1;                   // In bytes
+
+    static const value_type MSK1 = 0xDFFFFFEFul;
+    static const value_type MSK2 = 0xDDFECB7Ful;
+    static const value_type MSK3 = 0xBFFAFFFFul;
+    static const value_type MSK4 = 0xBFFFFFF6ul;
+
+    static const value_type PARITY1 = 0x00000001ul;
+    static const value_type PARITY2 = 0x00000000ul;
+    static const value_type PARITY3 = 0x00000000ul;
+    static const value_type PARITY4 = 0x13C9E684ul;
+
+private:
+    alignas(16) value_type state[N32];
+    size_type index;
+
+public:
+    explicit SFMT19937(value_type initSeed = kDefaultSeed) : index(N32) {
+        this->srand(initSeed);
+    }
+
+    ~SFMT19937() {}
+
+    value_type rand_max() const {
+        return static_cast<value_type>(kRandMax);
+    }
+
+private:
+    void period_certification() {
+        static const value_type kParity[4] = { PARITY1, PARITY2, PARITY3, PARITY4 };
+        value_type inner = 0;
+        for (size_type i = 0; i < 4; i++) {
+            inner ^= this->state[i] & kParity[i];
+        }
+        for (int i = 16; i > 0; i >>= 1) {
+            inner ^= inner >> i;
+        }
+        if ((inner & 1) == 1)
+            return;
+
+        // Fix the first bit of the parity.
+        for (size_type i = 0; i < 4; i++) {
+            value_type work = 1;
+            for (int j = 0; j < 32; j++) {
+                if ((work & kParity[i]) != 0) {
+                    this->state[i] ^= work;
+                    return;
+                }
+                work <<= 1;
+            }
+        }
+    }
+
+#if defined(JSTD_SFMT_USE_SSE2)
+    static inline __m128i recursion(__m128i a, __m128i b, __m128i c, __m128i d, __m128i mask) {
+        __m128i x = _mm_slli_si128(a, SL2);
+        __m128i y = _mm_srli_epi32(b, SR1);
+        __m128i z = _mm_srli_si128(c, SR2);
+        __m128i v = _mm_slli_epi32(d, SL1);
+        z = _mm_xor_si128(z, a);
+        z = _mm_xor_si128(z, v);
+        x = _mm_xor_si128(x, _mm_and_si128(y, mask));
+        return _mm_xor_si128(z, x);
+    }
+
+    void next_state() {
+        __m128i * s = reinterpret_cast<__m128i *>(&this->state[0]);
+        const __m128i mask = _mm_set_epi32(static_cast<int>(MSK4), static_cast<int>(MSK3),
+                                           static_cast<int>(MSK2), static_cast<int>(MSK1));
+        __m128i r1 = _mm_load_si128(&s[N - 2]);
+        __m128i r2 = _mm_load_si128(&s[N - 1]);
+        size_type i;
+        for (i = 0; i < N - POS1; i++) {
+            __m128i r = recursion(_mm_load_si128(&s[i]), _mm_load_si128(&s[i + POS1]), r1, r2, mask);
+            _mm_store_si128(&s[i], r);
+            r1 = r2;
+            r2 = r;
+        }
+        for (; i < N; i++) {
+            __m128i r = recursion(_mm_load_si128(&s[i]), _mm_load_si128(&s[i + POS1 - N]), r1, r2, mask);
+            _mm_store_si128(&s[i], r);
+            r1 = r2;
+            r2 = r;
+        }
+        this->index = 0;
+    }
+#else
+    // The 128-bit shifts by bytes, on the little endian 32-bit words.
+    static inline void lshift128(value_type * out, const value_type * in, int shift) {
+        std::uint64_t th = (static_cast<std::uint64_t>(in[3]) << 32) | in[2];
+        std::uint64_t tl = (static_cast<std::uint64_t>(in[1]) << 32) | in[0];
+        std::uint64_t oh = (th << (shift * 8)) | (tl >> (64 - shift * 8));
+        std::uint64_t ol = tl << (shift * 8);
+        out[0] = static_cast<value_type>(ol);
+        out[1] = static_cast<value_type>(ol >> 32);
+        out[2] = static_cast<value_type>(oh);
+        out[3] = static_cast<value_type>(oh >> 32);
+    }
+
+    static inline void rshift128(value_type * out, const value_type * in, int shift) {
+        std::uint64_t th = (static_cast<std::uint64_t>(in[3]) << 32) | in[2];
+        std::uint64_t tl = (static_cast<std::uint64_t>(in[1]) << 32) | in[0];
+        std::uint64_t oh = th >> (shift * 8);
+        std::uint64_t ol = (tl >> (shift * 8)) | (th << (64 - shift * 8));
+        out[0] = static_cast<value_type>(ol);
+        out[1] = static_cast<value_type>(ol >> 32);
+        out[2] = static_cast<value_type>(oh);
+        out[3] = static_cast<value_type>(oh >> 32);
+    }
+
+    static inline void recursion(value_type * r, const value_type * a, const value_type * b,
+                                 const value_type * c, const value_type * d) {
+        value_type x[4], y[4];
+        lshift128(x, a, SL2);
+        rshift128(y, c, SR2);
+        r[0] = a[0] ^ x[0] ^ ((b[0] >> SR1) & MSK1) ^ y[0] ^ (d[0] << SL1);
+        r[1] = a[1] ^ x[1] ^ ((b[1] >> SR1) & MSK2) ^ y[1] ^ (d[1] << SL1);
+        r[2] = a[2] ^ x[2] ^ ((b[2] >> SR1) & MSK3) ^ y[2] ^ (d[2] << SL1);
+        r[3] = a[3] ^ x[3] ^ ((b[3] >> SR1) & MSK4) ^ y[3] ^ (d[3] << SL1);
+    }
+
+    void next_state() {
+        value_type * s = &this->state[0];
+        const value_type * r1 = &s[(N - 2) * 4];
+        const value_type * r2 = &s[(N - 1) * 4];
+        size_type i;
+        for (i = 0; i < N - POS1; i++) {
+            recursion(&s[i * 4], &s[i * 4], &s[(i + POS1) * 4], r1, r2);
+            r1 = r2;
+            r2 = &s[i * 4];
+        }
+        for (; i < N; i++) {
+            recursion(&s[i * 4], &s[i * 4], &s[(i + POS1 - N) * 4], r1, r2);
+            r1 = r2;
+            r2 = &s[i * 4];
+        }
+        this->index = 0;
+    }
+#endif // JSTD_SFMT_USE_SSE2
+
+public:
+    void srand(value_type initSeed = kDefaultSeed) {
+        if (initSeed == 0) {
+            time_t timer;
+            ::time(&timer);
+            initSeed = static_cast<value_type>(timer);
+        }
+        this->state[0] = initSeed;
+        for (size_type i = 1; i < N32; i++) {
+            this->state[i] = 1812433253ul * (this->state[i - 1] ^ (this->state[i - 1] >> 30))
+                           + static_cast<value_type>(i);
+        }
+        this->index = N32;
+        this->period_certification();
+    }
+
+    value_type rand() {
+        if (this->index >= N32)
+            this->next_state();
+        return this->state[this->index++];
+    }
+
+    std::int32_t nextInt32() {
+        return static_cast<std::int32_t>(this->rand());
+    }
+
+    std::uint32_t nextUInt32() {
+        return static_cast<std::uint32_t>(this->rand());
+    }
+
+    std::int64_t nextInt64() {
+        return static_cast<std::int64_t>(this->nextUInt64());
+    }
+
+    // The low word is the first, like gen_rand64() of the reference if the index is even.
+    std::uint64_t nextUInt64() {
+        std::uint64_t low = this->rand();
+        std::uint64_t high = this->rand();
+        return ((high << 32) | low);
+    }
+
+    std::intptr_t nextInt() {
+        if (sizeof(std::intptr_t) == 4)
+            return static_cast<std::intptr_t>(this->nextInt32());
+        else
+            return static_cast<std::intptr_t>(this->nextInt64());
+    }
+
+    std::size_t nextUInt() {
+        if (sizeof(std::size_t) == 4)
+            return static_cast<std::size_t>(this->nextUInt32());
+        else
+            return static_cast<std::size_t>(this->nextUInt64());
+    }
+
+    //
+    // The same values as n calls of nextUInt32() or nextUInt64(),
+    // the whole blocks are copied.
+    //
+    void fill(std::uint32_t * out, size_type n) {
+        while (n > 0) {
+            if (this->index >= N32)
+                this->next_state();
+            size_type count = N32 - this->index;
+            if (count > n)
+                count = n;
+            ::memcpy(out, &this->state[this->index], count * sizeof(value_type));
+            this->index += count;
+            out += count;
+            n -= count;
+        }
+    }
+
+    void fill(std::uint64_t * out, size_type n) {
+        size_type i = 0;
+        while (i < n) {
+            if (this->index >= N32)
+                this->next_state();
+            if ((this->index & 1) != 0 || (this->index + 1) >= N32) {
+                out[i++] = this->nextUInt64();
+                continue;
+            }
+            size_type count = (N32 - this->index) / 2;
+            if (count > (n - i))
+                count = n - i;
+            const value_type * p = &this->state[this->index];
+            for (size_type k = 0; k < count; k++) {
+                out[i + k] = (static_cast<std::uint64_t>(p[k * 2 + 1]) << 32) | p[k * 2];
+            }
+            this->index += count * 2;
+            i += count;
+        }
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_SYSTEM_SFMT19937_H
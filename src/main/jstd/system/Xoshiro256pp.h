@@ -0,0 +1,199 @@
+
+#ifndef JSTD_SYSTEM_XOSHIRO256PP_H
+#define JSTD_SYSTEM_XOSHIRO256PP_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+#include "jstd/basic/stdsize.h"
+
+#include <time.h>
+
+#include <cstdint>
+#include <cstddef>
+
+//
+// xoshiro256++ 1.0, a 64-bit all-purpose generator with 256-bit state,
+// the period is 2^256 - 1.
+//
+//   David Blackman and Sebastiano Vigna, "Scrambled Linear Pseudorandom Number Generators",
+//   ACM Transactions on Mathematical Software, 2021. https://prng.di.unimi.it/
+//
+// The state is seeded by SplitMix64 from the 64-bit seed, as the authors suggest.
+//
+namespace jstd {
+
+class Xoshiro256pp
+{
+public:
+    typedef std::uint64_t value_type;
+    typedef std::size_t   size_type;
+
+    static const value_type kDefaultSeed = 20200831ull;
+    static const value_type kRandMax = 0xFFFFFFFFFFFFFFFFull;
+
+private:
+    value_type state[4];
+
+public:
+    explicit Xoshiro256pp(value_type initSeed = kDefaultSeed) {
+        this->srand(initSeed);
+    }
+
+    ~Xoshiro256pp() {}
+
+    value_type rand_max() const {
+        return static_cast<value_type>(kRandMax);
+    }
+
+    static value_type splitmix64(value_type & x) {
+        value_type z = (x += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return (z ^ (z >> 31));
+    }
+
+private:
+    static inline value_type rotl(value_type x, int k) {
+        return ((x << k) | (x >> (64 - k)));
+    }
+
+    value_type next() {
+        value_type result = rotl(this->state[0] + this->state[3], 23) + this->state[0];
+        value_type t = this->state[1] << 17;
+
+        this->state[2] ^= this->state[0];
+        this->state[3] ^= this->state[1];
+        this->state[1] ^= this->state[2];
+        this->state[0] ^= this->state[3];
+
+        this->state[2] ^= t;
+        this->state[3] = rotl(this->state[3], 45);
+        return result;
+    }
+
+public:
+    void srand(value_type initSeed = kDefaultSeed) {
+        if (initSeed == 0) {
+            time_t timer;
+            ::time(&timer);
+            initSeed = static_cast<value_type>(timer);
+        }
+        value_type x = initSeed;
+        for (size_type i = 0; i < 4; i++) {
+            this->state[i] = splitmix64(x);
+        }
+    }
+
+    // The state must not be all zero.
+    void set_state(value_type s0, value_type s1, value_type s2, value_type s3) {
+        this->state[0] = s0;
+        this->state[1] = s1;
+        this->state[2] = s2;
+        this->state[3] = s3;
+    }
+
+    //
+    // It's equivalent to 2^128 calls of rand(), it can be used to
+    // generate 2^128 non-overlapping subsequences (for the threads).
+    //
+    void jump() {
+        static const value_type kJump[4] = {
+            0x180EC6D33CFD0ABAull, 0xD5A61266F0C9392Cull,
+            0xA9582618E03FC9AAull, 0x39ABDC4529B1661Cull
+        };
+        value_type s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        for (size_type i = 0; i < 4; i++) {
+            for (int b = 0; b < 64; b++) {
+                if ((kJump[i] & (1ull << b)) != 0) {
+                    s0 ^= this->state[0];
+                    s1 ^= this->state[1];
+                    s2 ^= this->state[2];
+                    s3 ^= this->state[3];
+                }
+                this->next();
+            }
+        }
+        this->set_state(s0, s1, s2, s3);
+    }
+
+    value_type rand() {
+        return this->next();
+    }
+
+    // The upper bits are better than the lower bits.
+    std::int32_t nextInt32() {
+        return static_cast<std::int32_t>(this->next() >> 32);
+    }
+
+    std::uint32_t nextUInt32() {
+        return static_cast<std::uint32_t>(this->next() >> 32);
+    }
+
+    std::int64_t nextInt64() {
+        return static_cast<std::int64_t>(this->next());
+    }
+
+    std::uint64_t nextUInt64() {
+        return static_cast<std::uint64_t>(this->next());
+    }
+
+    std::intptr_t nextInt() {
+        if (sizeof(std::intptr_t) == 4)
+            return static_cast<std::intptr_t>(this->nextInt32());
+        else
+            return static_cast<std::intptr_t>(this->nextInt64());
+    }
+
+    std::size_t nextUInt() {
+        if (sizeof(std::size_t) == 4)
+            return static_cast<std::size_t>(this->nextUInt32());
+        else
+            return static_cast<std::size_t>(this->nextUInt64());
+    }
+
+    //
+    // The same values as n calls of nextUInt32() or nextUInt64(),
+    // the state is kept in the registers in the loop.
+    //
+    void fill(std::uint32_t * out, size_type n) {
+        value_type s0 = this->state[0], s1 = this->state[1];
+        value_type s2 = this->state[2], s3 = this->state[3];
+        for (size_type i = 0; i < n; i++) {
+            value_type result = rotl(s0 + s3, 23) + s0;
+            value_type t = s1 << 17;
+            s2 ^= s0;
+            s3 ^= s1;
+            s1 ^= s2;
+            s0 ^= s3;
+            s2 ^= t;
+            s3 = rotl(s3, 45);
+            out[i] = static_cast<std::uint32_t>(result >> 32);
+        }
+        this->set_state(s0, s1, s2, s3);
+    }
+
+    void fill(std::uint64_t * out, size_type n) {
+        value_type s0 = this->state[0], s1 = this->state[1];
+        value_type s2 = this->state[2], s3 = this->state[3];
+        for (size_type i = 0; i < n; i++) {
+            value_type result = rotl(s0 + s3, 23) + s0;
+            value_type t = s1 << 17;
+            s2 ^= s0;
+            s3 ^= s1;
+            s1 ^= s2;
+            s0 ^= s3;
+            s2 ^= t;
+            s3 = rotl(s3, 45);
+            out[i] = result;
+        }
+        this->set_state(s0, s1, s2, s3);
+    }
+};
+
+} // namespace jstd
+
+#endif // JSTD_SYSTEM_XOSHIRO256PP_H
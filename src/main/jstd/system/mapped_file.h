@@ -0,0 +1,206 @@
+
+#ifndef JSTD_SYSTEM_MAPPED_FILE_H
+#define JSTD_SYSTEM_MAPPED_FILE_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#if defined(_WIN32) || defined(__cygwin__)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>   // For mmap(), munmap()
+#include <fcntl.h>
+#include <unistd.h>
+#endif // _WIN32
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+
+#include <stdio.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>      // For std::size_t
+#include <vector>
+#include <utility>      // For std::swap()
+
+namespace jstd {
+
+//
+// A read-only memory mapped file, the whole file is mapped at open().
+//
+// The empty file is opened successfully, but data() is nullptr.
+//
+class mapped_file {
+public:
+    typedef std::size_t size_type;
+
+private:
+    const char *    data_;
+    size_type       size_;
+    bool            is_open_;
+
+public:
+    mapped_file() : data_(nullptr), size_(0), is_open_(false) {}
+
+    explicit mapped_file(const char * filename)
+        : data_(nullptr), size_(0), is_open_(false) {
+        this->open(filename);
+    }
+
+    mapped_file(const mapped_file & src) = delete;
+    mapped_file & operator = (const mapped_file & rhs) = delete;
+
+    mapped_file(mapped_file && src)
+        : data_(src.data_), size_(src.size_), is_open_(src.is_open_) {
+        src.data_ = nullptr;
+        src.size_ = 0;
+        src.is_open_ = false;
+    }
+
+    mapped_file & operator = (mapped_file && rhs) {
+        this->swap(rhs);
+        return *this;
+    }
+
+    ~mapped_file() {
+        this->close();
+    }
+
+    const char * data() const { return this->data_; }
+    size_type size() const    { return this->size_; }
+    bool is_open() const      { return this->is_open_; }
+
+    bool open(const char * filename) {
+        this->close();
+        assert(filename != nullptr);
+#if defined(_WIN32) || defined(__cygwin__)
+        HANDLE hFile = ::CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL,
+                                     OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER file_size;
+        if (!::GetFileSizeEx(hFile, &file_size)) {
+            ::CloseHandle(hFile);
+            return false;
+        }
+
+        if (file_size.QuadPart != 0) {
+            HANDLE hMapping = ::CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (hMapping == NULL) {
+                ::CloseHandle(hFile);
+                return false;
+            }
+            void * view = ::MapViewOfFile(hMapping, FILE_MAP_READ, 0, 0, 0);
+            // The view holds the references of the mapping and the file.
+            ::CloseHandle(hMapping);
+            if (view == NULL) {
+                ::CloseHandle(hFile);
+                return false;
+            }
+            this->data_ = static_cast<const char *>(view);
+            this->size_ = static_cast<size_type>(file_size.QuadPart);
+        }
+        ::CloseHandle(hFile);
+#else
+        int fd = ::open(filename, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        struct stat file_stat;
+        if (::fstat(fd, &file_stat) != 0) {
+            ::close(fd);
+            return false;
+        }
+
+        if (file_stat.st_size != 0) {
+            size_type file_size = static_cast<size_type>(file_stat.st_size);
+            void * view = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (view == MAP_FAILED) {
+                ::close(fd);
+                return false;
+            }
+#if defined(MADV_SEQUENTIAL)
+            ::madvise(view, file_size, MADV_SEQUENTIAL);
+#endif
+            this->data_ = static_cast<const char *>(view);
+            this->size_ = file_size;
+        }
+        // The mapping is still valid after the file be closed.
+        ::close(fd);
+#endif // _WIN32
+        this->is_open_ = true;
+        return true;
+    }
+
+    void close() {
+        if (this->data_ != nullptr) {
+#if defined(_WIN32) || defined(__cygwin__)
+            ::UnmapViewOfFile(this->data_);
+#else
+            ::munmap(const_cast<char *>(this->data_), this->size_);
+#endif
+            this->data_ = nullptr;
+            this->size_ = 0;
+        }
+        this->is_open_ = false;
+    }
+
+    void swap(mapped_file & other) {
+        if (&other != this) {
+            std::swap(this->data_,    other.data_);
+            std::swap(this->size_,    other.size_);
+            std::swap(this->is_open_, other.is_open_);
+        }
+    }
+};
+
+//
+// Read the whole file into the buffer by one fread().
+//
+static inline
+bool read_file(const char * filename, std::vector<char> & buffer)
+{
+    assert(filename != nullptr);
+    buffer.clear();
+
+    FILE * fp = ::fopen(filename, "rb");
+    if (fp == nullptr)
+        return false;
+
+    // The 64 bits file size, long is 32 bits on Windows.
+    bool is_ok = false;
+#if defined(_MSC_VER) || defined(__MINGW32__)
+    if (::_fseeki64(fp, 0, SEEK_END) == 0) {
+        int64_t file_size = ::_ftelli64(fp);
+        if ((file_size >= 0) && (::_fseeki64(fp, 0, SEEK_SET) == 0) &&
+            (static_cast<uint64_t>(file_size) <= static_cast<uint64_t>(SIZE_MAX))) {
+#else
+    if (::fseeko(fp, 0, SEEK_END) == 0) {
+        off_t file_size = ::ftello(fp);
+        if ((file_size >= 0) && (::fseeko(fp, 0, SEEK_SET) == 0) &&
+            (static_cast<uint64_t>(file_size) <= static_cast<uint64_t>(SIZE_MAX))) {
+#endif
+            buffer.resize(static_cast<std::size_t>(file_size));
+            std::size_t read_bytes = 0;
+            if (file_size != 0)
+                read_bytes = ::fread(&buffer[0], 1, buffer.size(), fp);
+            is_ok = (read_bytes == buffer.size());
+            if (!is_ok)
+                buffer.clear();
+        }
+    }
+    ::fclose(fp);
+    return is_ok;
+}
+
+} // namespace jstd
+
+#endif // JSTD_SYSTEM_MAPPED_FILE_H
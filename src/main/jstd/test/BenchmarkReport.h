@@ -0,0 +1,1220 @@
+
+#ifndef JSTD_TEST_BENCHMARK_REPORT_H
+#define JSTD_TEST_BENCHMARK_REPORT_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+#include "jstd/basic/inttypes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include <cstdint>
+#include <cstddef>      // For std::size_t
+#include <string>
+#include <vector>
+#include <deque>
+#include <algorithm>    // For std::fill()
+#include <utility>
+
+#include "jstd/system/mapped_file.h"
+#include "jstd/test/BenchmarkRunner.h"
+
+//
+// The compile flags of the build, it's defined by CMakeLists.txt,
+// the other build systems may define it in the same way.
+//
+#ifndef JSTD_BUILD_FLAGS
+#define JSTD_BUILD_FLAGS    ""
+#endif
+
+namespace jtest {
+
+namespace detail {
+
+static inline
+std::string trim_string(const std::string & str) {
+    std::size_t first = 0;
+    std::size_t last = str.size();
+    while (first < last && (str[first] == ' ' || str[first] == '\t'))
+        first++;
+    while (last > first && (str[last - 1] == ' ' || str[last - 1] == '\t' ||
+                            str[last - 1] == '\r' || str[last - 1] == '\n'))
+        last--;
+    return str.substr(first, last - first);
+}
+
+static inline
+std::string format_double(double value) {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.10g", value);
+    return std::string(buf);
+}
+
+//
+// A minimal JSON reader, it's only used to read back the reports written
+// by BenchmarkReport::save_json(), the numbers are returned as the tokens.
+//
+class JsonReader {
+private:
+    const char * cur_;
+    const char * end_;
+    bool         has_error_;
+
+public:
+    JsonReader(const char * data, std::size_t size)
+        : cur_(data), end_(data + size), has_error_(false) {
+    }
+    ~JsonReader() {}
+
+    bool has_error() const { return this->has_error_; }
+
+    char peek() {
+        this->skip_spaces();
+        return (this->cur_ < this->end_) ? *this->cur_ : '\0';
+    }
+
+    bool expect(char ch) {
+        if (this->peek() == ch) {
+            this->cur_++;
+            return true;
+        }
+        this->has_error_ = true;
+        return false;
+    }
+
+    bool accept(char ch) {
+        if (this->peek() == ch) {
+            this->cur_++;
+            return true;
+        }
+        return false;
+    }
+
+    //
+    // Iterate the members of an object or the elements of an array:
+    //
+    //   bool is_first = true;
+    //   if (reader.expect('{')) {
+    //       while (reader.next_item('}', is_first)) { ... }
+    //   }
+    //
+    bool next_item(char close, bool & is_first) {
+        if (this->has_error_)
+            return false;
+        if (this->accept(close))
+            return false;
+        if (!is_first) {
+            if (!this->expect(','))
+                return false;
+        }
+        is_first = false;
+        return true;
+    }
+
+    bool read_string(std::string & str) {
+        str.clear();
+        if (!this->expect('"'))
+            return false;
+        while (this->cur_ < this->end_) {
+            char ch = *this->cur_++;
+            if (ch == '"')
+                return true;
+            if (ch != '\\') {
+                str.push_back(ch);
+                continue;
+            }
+            if (this->cur_ >= this->end_)
+                break;
+            ch = *this->cur_++;
+            switch (ch) {
+            case 'b': str.push_back('\b'); break;
+            case 'f': str.push_back('\f'); break;
+            case 'n': str.push_back('\n'); break;
+            case 'r': str.push_back('\r'); break;
+            case 't': str.push_back('\t'); break;
+            case 'u': {
+                unsigned int code_point;
+                if (!this->read_hex4(code_point))
+                    return false;
+                if (code_point >= 0xD800 && code_point < 0xDC00 &&
+                    (this->end_ - this->cur_) >= 6 && this->cur_[0] == '\\' && this->cur_[1] == 'u') {
+                    this->cur_ += 2;
+                    unsigned int low;
+                    if (!this->read_hex4(low))
+                        return false;
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                }
+                append_utf8(str, code_point);
+                break;
+            }
+            default:
+                str.push_back(ch);
+                break;
+            }
+        }
+        this->has_error_ = true;
+        return false;
+    }
+
+    // The number, true, false and null are returned as the token text.
+    bool read_scalar(std::string & token) {
+        token.clear();
+        char ch = this->peek();
+        if (ch == '"')
+            return this->read_string(token);
+        if (ch == '{' || ch == '[') {
+            this->has_error_ = true;
+            return false;
+        }
+        while (this->cur_ < this->end_) {
+            ch = *this->cur_;
+            if (ch == ',' || ch == '}' || ch == ']' || ch == ' ' ||
+                ch == '\t' || ch == '\r' || ch == '\n')
+                break;
+            token.push_back(ch);
+            this->cur_++;
+        }
+        if (token.empty()) {
+            this->has_error_ = true;
+            return false;
+        }
+        return true;
+    }
+
+    double read_double() {
+        std::string token;
+        if (!this->read_scalar(token))
+            return 0.0;
+        return ::atof(token.c_str());
+    }
+
+    std::size_t read_size() {
+        std::string token;
+        if (!this->read_scalar(token))
+            return 0;
+        return static_cast<std::size_t>(::strtoull(token.c_str(), nullptr, 10));
+    }
+
+    bool read_bool() {
+        std::string token;
+        if (!this->read_scalar(token))
+            return false;
+        return (token == "true");
+    }
+
+    bool skip_value() {
+        char ch = this->peek();
+        if (ch == '{' || ch == '[') {
+            char close = (ch == '{') ? '}' : ']';
+            this->cur_++;
+            bool is_first = true;
+            while (this->next_item(close, is_first)) {
+                if (ch == '{') {
+                    std::string key;
+                    if (!this->read_string(key) || !this->expect(':'))
+                        return false;
+                }
+                if (!this->skip_value())
+                    return false;
+            }
+            return !this->has_error_;
+        }
+        else {
+            std::string token;
+            return this->read_scalar(token);
+        }
+    }
+
+private:
+    void skip_spaces() {
+        while (this->cur_ < this->end_ &&
+               (*this->cur_ == ' ' || *this->cur_ == '\t' ||
+                *this->cur_ == '\r' || *this->cur_ == '\n'))
+            this->cur_++;
+    }
+
+    bool read_hex4(unsigned int & value) {
+        value = 0;
+        if ((this->end_ - this->cur_) < 4) {
+            this->has_error_ = true;
+            return false;
+        }
+        for (int i = 0; i < 4; i++) {
+            char ch = *this->cur_++;
+            value <<= 4;
+            if (ch >= '0' && ch <= '9')
+                value |= (unsigned int)(ch - '0');
+            else if (ch >= 'a' && ch <= 'f')
+                value |= (unsigned int)(ch - 'a' + 10);
+            else if (ch >= 'A' && ch <= 'F')
+                value |= (unsigned int)(ch - 'A' + 10);
+            else {
+                this->has_error_ = true;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void append_utf8(std::string & str, unsigned int code_point) {
+        if (code_point < 0x80) {
+            str.push_back((char)code_point);
+        }
+        else if (code_point < 0x800) {
+            str.push_back((char)(0xC0 | (code_point >> 6)));
+            str.push_back((char)(0x80 | (code_point & 0x3F)));
+        }
+        else if (code_point < 0x10000) {
+            str.push_back((char)(0xE0 | (code_point >> 12)));
+            str.push_back((char)(0x80 | ((code_point >> 6) & 0x3F)));
+            str.push_back((char)(0x80 | (code_point & 0x3F)));
+        }
+        else {
+            str.push_back((char)(0xF0 | (code_point >> 18)));
+            str.push_back((char)(0x80 | ((code_point >> 12) & 0x3F)));
+            str.push_back((char)(0x80 | ((code_point >> 6) & 0x3F)));
+            str.push_back((char)(0x80 | (code_point & 0x3F)));
+        }
+    }
+};
+
+static inline
+void append_json_string(std::string & out, const std::string & str) {
+    out.push_back('"');
+    for (std::size_t i = 0; i < str.size(); i++) {
+        unsigned char ch = (unsigned char)str[i];
+        switch (ch) {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n";  break;
+        case '\r': out += "\\r";  break;
+        case '\t': out += "\\t";  break;
+        default:
+            if (ch < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04X", (unsigned int)ch);
+                out += buf;
+            }
+            else {
+                out.push_back((char)ch);
+            }
+            break;
+        }
+    }
+    out.push_back('"');
+}
+
+static inline
+void append_json_number(std::string & out, double value) {
+    // NaN and infinity are not the valid JSON numbers.
+    if (value == value && value - value == 0.0)
+        out += format_double(value);
+    else
+        out += "null";
+}
+
+//
+// RFC 4180: the field contains the comma, the quote or the line break
+// is quoted, and the quote in it is doubled.
+//
+static inline
+void append_csv_field(std::string & out, const std::string & field) {
+    if (field.find_first_of(",\"\r\n") == std::string::npos) {
+        out += field;
+        return;
+    }
+    out.push_back('"');
+    for (std::size_t i = 0; i < field.size(); i++) {
+        if (field[i] == '"')
+            out.push_back('"');
+        out.push_back(field[i]);
+    }
+    out.push_back('"');
+}
+
+//
+// Split a CSV record, the quoted fields may contain the line breaks,
+// return the position of the next record.
+//
+static inline
+std::size_t split_csv_record(const std::string & data, std::size_t pos,
+                             std::vector<std::string> & fields) {
+    fields.clear();
+    std::string field;
+    bool in_quotes = false;
+    while (pos < data.size()) {
+        char ch = data[pos++];
+        if (in_quotes) {
+            if (ch == '"') {
+                if (pos < data.size() && data[pos] == '"') {
+                    field.push_back('"');
+                    pos++;
+                }
+                else {
+                    in_quotes = false;
+                }
+            }
+            else {
+                field.push_back(ch);
+            }
+        }
+        else if (ch == '"') {
+            in_quotes = true;
+        }
+        else if (ch == ',') {
+            fields.push_back(field);
+            field.clear();
+        }
+        else if (ch == '\n') {
+            break;
+        }
+        else if (ch != '\r') {
+            field.push_back(ch);
+        }
+    }
+    fields.push_back(field);
+    return pos;
+}
+
+} // namespace detail
+
+//
+// The brand string of the CPU, such as "Intel(R) Xeon(R) Platinum 8375C CPU @ 2.90GHz".
+//
+static inline
+std::string get_cpu_model() {
+#if defined(JTEST_HAVE_CPUID)
+    unsigned int regs[4];
+    detail::cpuid(0x80000000U, regs);
+    if (regs[0] >= 0x80000004U) {
+        char brand[3 * 16 + 1];
+        for (unsigned int i = 0; i < 3; i++) {
+            detail::cpuid(0x80000002U + i, regs);
+            ::memcpy(&brand[i * 16], regs, sizeof(regs));
+        }
+        brand[3 * 16] = '\0';
+        std::string model = detail::trim_string(brand);
+        if (!model.empty())
+            return model;
+    }
+#endif
+#if defined(__linux__)
+    FILE * fp = ::fopen("/proc/cpuinfo", "r");
+    if (fp != nullptr) {
+        char line[512];
+        std::string model;
+        while (::fgets(line, sizeof(line), fp) != nullptr) {
+            if (::strncmp(line, "model name", 10) == 0 || ::strncmp(line, "Model", 5) == 0) {
+                const char * colon = ::strchr(line, ':');
+                if (colon != nullptr) {
+                    model = detail::trim_string(colon + 1);
+                    break;
+                }
+            }
+        }
+        ::fclose(fp);
+        if (!model.empty())
+            return model;
+    }
+#endif
+    return std::string("unknown");
+}
+
+static inline
+std::string get_compiler_name() {
+    char name[256];
+#if defined(__clang__)
+    snprintf(name, sizeof(name), "clang %s", __clang_version__);
+#elif defined(__INTEL_COMPILER)
+    snprintf(name, sizeof(name), "icc %d.%d", __INTEL_COMPILER / 100, __INTEL_COMPILER % 100);
+#elif defined(__GNUC__)
+    snprintf(name, sizeof(name), "gcc %s", __VERSION__);
+#elif defined(_MSC_VER)
+    snprintf(name, sizeof(name), "msvc %d", (int)_MSC_FULL_VER);
+#else
+    snprintf(name, sizeof(name), "unknown");
+#endif
+    return detail::trim_string(name);
+}
+
+//
+// The instruction sets enabled at compile time, the build flags may be
+// unavailable (not built by CMake), but it's always known.
+//
+static inline
+std::string get_isa_flags() {
+    std::string isa;
+#if defined(__x86_64__) || defined(_M_X64)
+    isa += "x86_64";
+#elif defined(__i386__) || defined(_M_IX86)
+    isa += "x86";
+#elif defined(__aarch64__) || defined(_M_ARM64)
+    isa += "aarch64";
+#else
+    isa += "unknown";
+#endif
+#if defined(__SSE4_2__)
+    isa += " sse4.2";
+#endif
+#if defined(__AVX__)
+    isa += " avx";
+#endif
+#if defined(__AVX2__)
+    isa += " avx2";
+#endif
+#if defined(__AVX512F__)
+    isa += " avx512f";
+#endif
+#if defined(__AVX512BW__)
+    isa += " avx512bw";
+#endif
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    isa += " neon";
+#endif
+    return isa;
+}
+
+static inline
+std::string get_build_flags() {
+    std::string flags(JSTD_BUILD_FLAGS);
+#if defined(NDEBUG)
+    if (flags.empty())
+        flags = "-DNDEBUG";
+#endif
+    return detail::trim_string(flags);
+}
+
+//
+// The clock of jtest::StopWatch, it's the timer of the benchmark runner.
+//
+static inline
+std::string get_timer_name() {
+#if JTEST_USE_RDTSC_STOPWATCH
+    char name[128];
+    snprintf(name, sizeof(name), "rdtsc (%0.3f GHz, %s TSC, overhead %" PRIu64 " ticks)",
+             TscClock::frequency() / 1000000000.0,
+             TscClock::is_invariant() ? "invariant" : "variant",
+             static_cast<std::uint64_t>(TscClock::overhead()));
+    return std::string(name);
+#elif HAVE_STD_CHRONO_H
+    return std::string("std::chrono::high_resolution_clock");
+#else
+    return std::string("gettimeofday()");
+#endif
+}
+
+// In UTC, ISO 8601 format.
+static inline
+std::string get_timestamp() {
+    char buf[64];
+    time_t now = ::time(nullptr);
+    struct tm utc_time;
+#if defined(_MSC_VER)
+    ::gmtime_s(&utc_time, &now);
+#else
+    ::gmtime_r(&now, &utc_time);
+#endif
+    ::strftime(buf, sizeof(buf), "%Y-%m-%dT%H:%M:%SZ", &utc_time);
+    return std::string(buf);
+}
+
+//
+// The results of a benchmark program and the metadata of the run,
+// it's saved as (and loaded from) a JSON or a CSV file:
+//
+//   JSON: {
+//           "context": { "program": "benchmark", "compiler": "gcc 11.4.0", ... },
+//           "benchmarks": [
+//             { "name": "...", "labels": { "key_type": "std::string", ... },
+//               "time_unit": "ns", "median": 12.5, ...,
+//               "counters": { "cycles": 30.2, ... }, "latency": { "p50": 20.5, ... },
+//               "samples": [ ... ] },
+//             ...
+//           ]
+//         }
+//
+//   CSV:  # program,benchmark
+//         # compiler,gcc 11.4.0
+//         name,repetitions,...,ci_upper_ns,cycles_per_op,...,latency_p50_ns,...,key_type,...
+//         ...
+//
+// The CSV file has one row per case and no samples, the metadata are the
+// comment lines, and the labels are the columns after the fixed columns.
+// The hardware counters (per operation) and the latency percentiles are saved
+// only if they're counted.
+//
+class BenchmarkReport {
+public:
+    typedef std::size_t size_type;
+
+private:
+    BenchmarkLabels             metadata_;
+    std::vector<BenchmarkStats> cases_;
+
+    static const char * const * csv_columns() {
+        static const char * const kColumns[] = {
+            "name", "repetitions", "iterations", "items_per_iteration", "warmup_runs", "checksum",
+            "median_ns", "mad_ns", "mean_ns", "stddev_ns", "min_ns", "max_ns", "ci_lower_ns", "ci_upper_ns",
+            nullptr
+        };
+        return kColumns;
+    }
+
+    // The optional columns, only if the frequency is sampled.
+    static const char * const * frequency_columns() {
+        static const char * const kColumns[] = {
+            "frequency_min_mhz", "frequency_max_mhz", "reruns", "throttled", nullptr
+        };
+        return kColumns;
+    }
+
+    static const char * const * latency_names() {
+        static const char * const kNames[] = {
+            "count", "p50", "p90", "p99", "p999", "max", nullptr
+        };
+        return kNames;
+    }
+
+    static double * get_latency_value(LatencySummary & latency, std::size_t index) {
+        double * const values[] = {
+            nullptr, &latency.p50, &latency.p90, &latency.p99, &latency.p999, &latency.max
+        };
+        return values[index];
+    }
+
+    static std::string get_latency_column(std::size_t index) {
+        if (index == 0)
+            return "latency_samples";
+        else
+            return std::string("latency_") + latency_names()[index] + "_ns";
+    }
+
+    static std::string get_counter_column(std::size_t event) {
+        return std::string(get_perf_event_name(event)) + "_per_op";
+    }
+
+    static bool find_latency_column(const std::string & column, std::size_t & index) {
+        for (std::size_t i = 1; latency_names()[i] != nullptr; i++) {
+            if (column == get_latency_column(i)) {
+                index = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool find_perf_event(const std::string & name, std::size_t & event) {
+        for (std::size_t i = 0; i < kPerfEventCount; i++) {
+            if (name == get_perf_event_name(i)) {
+                event = i;
+                return true;
+            }
+        }
+        return false;
+    }
+
+public:
+    BenchmarkReport() {}
+    explicit BenchmarkReport(const BenchmarkRunner & runner) {
+        this->assign(runner);
+    }
+    ~BenchmarkReport() {}
+
+    BenchmarkLabels & metadata() { return this->metadata_; }
+    const BenchmarkLabels & metadata() const { return this->metadata_; }
+
+    std::vector<BenchmarkStats> & cases() { return this->cases_; }
+    const std::vector<BenchmarkStats> & cases() const { return this->cases_; }
+
+    size_type size() const { return this->cases_.size(); }
+
+    void clear() {
+        this->metadata_.clear();
+        this->cases_.clear();
+    }
+
+    const BenchmarkStats * find(const std::string & name) const {
+        for (std::size_t i = 0; i < this->cases_.size(); i++) {
+            if (this->cases_[i].name == name)
+                return &this->cases_[i];
+        }
+        return nullptr;
+    }
+
+    //
+    // The system metadata first, then the metadata set by the program
+    // (HashFunc, key type, data size, ...), they can override the former.
+    //
+    void assign(const BenchmarkRunner & runner) {
+        this->clear();
+
+        this->metadata_.set("timestamp", get_timestamp());
+        this->metadata_.set("compiler", get_compiler_name());
+        this->metadata_.set("build_flags", get_build_flags());
+        this->metadata_.set("isa", get_isa_flags());
+        this->metadata_.set("cpu_model", get_cpu_model());
+        this->metadata_.set("timer", get_timer_name());
+        this->metadata_.set("repetitions", runner.options().repetitions);
+        this->metadata_.set("min_time_ms", detail::format_double(runner.options().min_time));
+
+        for (BenchmarkLabels::const_iterator iter = runner.metadata().begin();
+             iter != runner.metadata().end(); ++iter) {
+            this->metadata_.set(iter->first, iter->second);
+        }
+
+        const std::deque<BenchmarkStats> & results = runner.results();
+        this->cases_.assign(results.begin(), results.end());
+    }
+
+    std::string to_json() const {
+        std::string out;
+        out += "{\n  \"context\": {";
+        for (std::size_t i = 0; i < this->metadata_.size(); i++) {
+            out += (i == 0) ? "\n    " : ",\n    ";
+            detail::append_json_string(out, this->metadata_[i].first);
+            out += ": ";
+            detail::append_json_string(out, this->metadata_[i].second);
+        }
+        out += "\n  },\n  \"benchmarks\": [";
+
+        for (std::size_t n = 0; n < this->cases_.size(); n++) {
+            const BenchmarkStats & stats = this->cases_[n];
+            out += (n == 0) ? "\n    {\n" : ",\n    {\n";
+            out += "      \"name\": ";
+            detail::append_json_string(out, stats.name);
+            out += ",\n      \"labels\": {";
+            for (std::size_t i = 0; i < stats.labels.size(); i++) {
+                if (i != 0)
+                    out += ", ";
+                detail::append_json_string(out, stats.labels[i].first);
+                out += ": ";
+                detail::append_json_string(out, stats.labels[i].second);
+            }
+            out += "},\n";
+            out += "      \"repetitions\": " + std::to_string(stats.repetitions()) + ",\n";
+            out += "      \"iterations\": " + std::to_string(stats.iterations) + ",\n";
+            out += "      \"items_per_iteration\": " + std::to_string(stats.items_per_iteration) + ",\n";
+            out += "      \"warmup_runs\": " + std::to_string(stats.warmup_runs) + ",\n";
+            out += "      \"checksum\": " + std::to_string(stats.checksum) + ",\n";
+            out += "      \"time_unit\": \"ns\",\n";
+
+            const double values[] = {
+                stats.median, stats.mad, stats.mean, stats.stddev,
+                stats.min, stats.max, stats.ci_lower, stats.ci_upper
+            };
+            const char * const names[] = {
+                "median", "mad", "mean", "stddev", "min", "max", "ci_lower", "ci_upper"
+            };
+            for (std::size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+                out += "      \"";
+                out += names[i];
+                out += "\": ";
+                detail::append_json_number(out, values[i]);
+                out += ",\n";
+            }
+
+            if (stats.counters.has_any()) {
+                out += "      \"counters\": {";
+                bool is_first = true;
+                for (std::size_t i = 0; i < kPerfEventCount; i++) {
+                    if (stats.counters.valid[i]) {
+                        if (!is_first)
+                            out += ", ";
+                        detail::append_json_string(out, get_perf_event_name(i));
+                        out += ": ";
+                        detail::append_json_number(out, stats.counters.values[i]);
+                        is_first = false;
+                    }
+                }
+                out += "},\n";
+            }
+
+            if (stats.frequency_max > 0.0) {
+                out += "      \"frequency_min_mhz\": ";
+                detail::append_json_number(out, stats.frequency_min);
+                out += ",\n      \"frequency_max_mhz\": ";
+                detail::append_json_number(out, stats.frequency_max);
+                out += ",\n      \"reruns\": " + std::to_string(stats.reruns) + ",\n";
+                out += "      \"throttled\": ";
+                out += stats.throttled ? "true" : "false";
+                out += ",\n";
+            }
+
+            if (stats.latency.has_value()) {
+                LatencySummary latency(stats.latency);
+                out += "      \"latency\": { \"count\": " + std::to_string(latency.count);
+                for (std::size_t i = 1; latency_names()[i] != nullptr; i++) {
+                    out += ", \"";
+                    out += latency_names()[i];
+                    out += "\": ";
+                    detail::append_json_number(out, *get_latency_value(latency, i));
+                }
+                out += " },\n";
+            }
+
+            out += "      \"samples\": [";
+            for (std::size_t i = 0; i < stats.samples.size(); i++) {
+                if (i != 0)
+                    out += ", ";
+                detail::append_json_number(out, stats.samples[i]);
+            }
+            out += "]\n    }";
+        }
+        out += "\n  ]\n}\n";
+        return out;
+    }
+
+    std::string to_csv() const {
+        // The union of the label keys, in the order of first appearance.
+        BenchmarkLabels label_keys;
+        bool has_counters = false;
+        bool has_latency = false;
+        bool has_frequency = false;
+        for (std::size_t n = 0; n < this->cases_.size(); n++) {
+            const BenchmarkLabels & labels = this->cases_[n].labels;
+            for (std::size_t i = 0; i < labels.size(); i++) {
+                label_keys.set(labels[i].first, std::string());
+            }
+            if (this->cases_[n].counters.has_any())
+                has_counters = true;
+            if (this->cases_[n].latency.has_value())
+                has_latency = true;
+            if (this->cases_[n].frequency_max > 0.0)
+                has_frequency = true;
+        }
+
+        std::string out;
+        for (std::size_t i = 0; i < this->metadata_.size(); i++) {
+            out += "# ";
+            detail::append_csv_field(out, this->metadata_[i].first);
+            out += ",";
+            detail::append_csv_field(out, this->metadata_[i].second);
+            out += "\n";
+        }
+
+        const char * const * columns = csv_columns();
+        for (std::size_t i = 0; columns[i] != nullptr; i++) {
+            if (i != 0)
+                out += ",";
+            out += columns[i];
+        }
+        if (has_counters) {
+            for (std::size_t i = 0; i < kPerfEventCount; i++) {
+                out += ",";
+                detail::append_csv_field(out, get_counter_column(i));
+            }
+        }
+        if (has_latency) {
+            for (std::size_t i = 0; latency_names()[i] != nullptr; i++) {
+                out += ",";
+                detail::append_csv_field(out, get_latency_column(i));
+            }
+        }
+        if (has_frequency) {
+            for (std::size_t i = 0; frequency_columns()[i] != nullptr; i++) {
+                out += ",";
+                out += frequency_columns()[i];
+            }
+        }
+        for (std::size_t i = 0; i < label_keys.size(); i++) {
+            out += ",";
+            detail::append_csv_field(out, label_keys[i].first);
+        }
+        out += "\n";
+
+        for (std::size_t n = 0; n < this->cases_.size(); n++) {
+            const BenchmarkStats & stats = this->cases_[n];
+            detail::append_csv_field(out, stats.name);
+            out += "," + std::to_string(stats.repetitions());
+            out += "," + std::to_string(stats.iterations);
+            out += "," + std::to_string(stats.items_per_iteration);
+            out += "," + std::to_string(stats.warmup_runs);
+            out += "," + std::to_string(stats.checksum);
+
+            const double values[] = {
+                stats.median, stats.mad, stats.mean, stats.stddev,
+                stats.min, stats.max, stats.ci_lower, stats.ci_upper
+            };
+            for (std::size_t i = 0; i < sizeof(values) / sizeof(values[0]); i++) {
+                out += "," + detail::format_double(values[i]);
+            }
+
+            if (has_counters) {
+                for (std::size_t i = 0; i < kPerfEventCount; i++) {
+                    out += ",";
+                    if (stats.counters.valid[i])
+                        out += detail::format_double(stats.counters.values[i]);
+                }
+            }
+
+            if (has_latency) {
+                LatencySummary latency(stats.latency);
+                out += ",";
+                if (latency.has_value())
+                    out += std::to_string(latency.count);
+                for (std::size_t i = 1; latency_names()[i] != nullptr; i++) {
+                    out += ",";
+                    if (latency.has_value())
+                        out += detail::format_double(*get_latency_value(latency, i));
+                }
+            }
+
+            if (has_frequency) {
+                out += "," + detail::format_double(stats.frequency_min);
+                out += "," + detail::format_double(stats.frequency_max);
+                out += "," + std::to_string(stats.reruns);
+                out += stats.throttled ? ",1" : ",0";
+            }
+
+            for (std::size_t i = 0; i < label_keys.size(); i++) {
+                out += ",";
+                const std::string * value = stats.labels.get(label_keys[i].first);
+                if (value != nullptr)
+                    detail::append_csv_field(out, *value);
+            }
+            out += "\n";
+        }
+        return out;
+    }
+
+    bool save_json(const std::string & filename) const {
+        return save_file(filename, this->to_json());
+    }
+
+    bool save_csv(const std::string & filename) const {
+        return save_file(filename, this->to_csv());
+    }
+
+    //
+    // The format is detected by the content: a JSON report begins with '{'.
+    //
+    bool load(const std::string & filename) {
+        this->clear();
+
+        std::vector<char> buffer;
+        if (!jstd::read_file(filename.c_str(), buffer))
+            return false;
+
+        std::size_t pos = 0;
+        while (pos < buffer.size() && (buffer[pos] == ' ' || buffer[pos] == '\t' ||
+                                       buffer[pos] == '\r' || buffer[pos] == '\n'))
+            pos++;
+        if (pos < buffer.size() && buffer[pos] == '{')
+            return this->parse_json(buffer.data(), buffer.size());
+        else
+            return this->parse_csv(std::string(buffer.begin(), buffer.end()));
+    }
+
+    bool parse_json(const char * data, std::size_t size) {
+        this->clear();
+
+        detail::JsonReader reader(data, size);
+        if (!reader.expect('{'))
+            return false;
+
+        bool is_first = true;
+        while (reader.next_item('}', is_first)) {
+            std::string key;
+            if (!reader.read_string(key) || !reader.expect(':'))
+                return false;
+            if (key == "context") {
+                if (!parse_json_labels(reader, this->metadata_))
+                    return false;
+            }
+            else if (key == "benchmarks") {
+                if (!reader.expect('['))
+                    return false;
+                bool is_first_case = true;
+                while (reader.next_item(']', is_first_case)) {
+                    BenchmarkStats stats;
+                    if (!parse_json_stats(reader, stats))
+                        return false;
+                    this->cases_.push_back(std::move(stats));
+                }
+            }
+            else {
+                reader.skip_value();
+            }
+        }
+        return !reader.has_error();
+    }
+
+    bool parse_csv(const std::string & data) {
+        this->clear();
+
+        std::vector<std::string> fields;
+        std::vector<std::string> header;
+        std::size_t pos = 0;
+        while (pos < data.size()) {
+            std::size_t next = detail::split_csv_record(data, pos, fields);
+            bool is_comment = (data[pos] == '#');
+            pos = next;
+
+            if (is_comment) {
+                // "# key,value"
+                if (fields.size() >= 2) {
+                    std::string key = detail::trim_string(fields[0].substr(1));
+                    this->metadata_.set(key, fields[1]);
+                }
+                continue;
+            }
+            if (fields.size() == 1 && fields[0].empty())
+                continue;
+
+            if (header.empty()) {
+                header = fields;
+                const char * const * columns = csv_columns();
+                std::size_t num_columns = 0;
+                while (columns[num_columns] != nullptr)
+                    num_columns++;
+                if (header.size() < num_columns || header[0] != "name")
+                    return false;
+                continue;
+            }
+
+            BenchmarkStats stats;
+            double ci_lower = 0.0, ci_upper = 0.0;
+            for (std::size_t i = 0; i < fields.size() && i < header.size(); i++) {
+                const std::string & column = header[i];
+                const std::string & value = fields[i];
+                if (column == "name")
+                    stats.name = value;
+                else if (column == "repetitions")
+                    stats.samples.resize(static_cast<std::size_t>(::strtoull(value.c_str(), nullptr, 10)));
+                else if (column == "iterations")
+                    stats.iterations = static_cast<size_type>(::strtoull(value.c_str(), nullptr, 10));
+                else if (column == "items_per_iteration")
+                    stats.items_per_iteration = static_cast<size_type>(::strtoull(value.c_str(), nullptr, 10));
+                else if (column == "warmup_runs")
+                    stats.warmup_runs = static_cast<size_type>(::strtoull(value.c_str(), nullptr, 10));
+                else if (column == "checksum")
+                    stats.checksum = static_cast<size_type>(::strtoull(value.c_str(), nullptr, 10));
+                else if (column == "median_ns")
+                    stats.median = ::atof(value.c_str());
+                else if (column == "mad_ns")
+                    stats.mad = ::atof(value.c_str());
+                else if (column == "mean_ns")
+                    stats.mean = ::atof(value.c_str());
+                else if (column == "stddev_ns")
+                    stats.stddev = ::atof(value.c_str());
+                else if (column == "min_ns")
+                    stats.min = ::atof(value.c_str());
+                else if (column == "max_ns")
+                    stats.max = ::atof(value.c_str());
+                else if (column == "ci_lower_ns")
+                    ci_lower = ::atof(value.c_str());
+                else if (column == "ci_upper_ns")
+                    ci_upper = ::atof(value.c_str());
+                else if (column == "frequency_min_mhz")
+                    stats.frequency_min = ::atof(value.c_str());
+                else if (column == "frequency_max_mhz")
+                    stats.frequency_max = ::atof(value.c_str());
+                else if (column == "reruns")
+                    stats.reruns = static_cast<size_type>(::strtoull(value.c_str(), nullptr, 10));
+                else if (column == "throttled")
+                    stats.throttled = (value == "1");
+                else if (!value.empty()) {
+                    std::size_t event, index;
+                    if (column == get_latency_column(0)) {
+                        stats.latency.count = ::strtoull(value.c_str(), nullptr, 10);
+                    }
+                    else if (find_latency_column(column, index)) {
+                        *get_latency_value(stats.latency, index) = ::atof(value.c_str());
+                    }
+                    else if (column.size() > 7 && column.compare(column.size() - 7, 7, "_per_op") == 0 &&
+                        find_perf_event(column.substr(0, column.size() - 7), event)) {
+                        stats.counters.values[event] = ::atof(value.c_str());
+                        stats.counters.valid[event] = true;
+                    }
+                    else {
+                        stats.labels.set(column, value);
+                    }
+                }
+            }
+            // The samples are not saved in CSV, only the count of them (the repetitions).
+            std::fill(stats.samples.begin(), stats.samples.end(), stats.median);
+            stats.ci_lower = ci_lower;
+            stats.ci_upper = ci_upper;
+            this->cases_.push_back(std::move(stats));
+        }
+        return !header.empty();
+    }
+
+private:
+    static bool save_file(const std::string & filename, const std::string & content) {
+        FILE * fp = ::fopen(filename.c_str(), "wb");
+        if (fp == nullptr)
+            return false;
+        std::size_t written = ::fwrite(content.data(), 1, content.size(), fp);
+        bool is_ok = (written == content.size());
+        if (::fclose(fp) != 0)
+            is_ok = false;
+        return is_ok;
+    }
+
+    static bool parse_json_labels(detail::JsonReader & reader, BenchmarkLabels & labels) {
+        if (!reader.expect('{'))
+            return false;
+        bool is_first = true;
+        while (reader.next_item('}', is_first)) {
+            std::string key, value;
+            if (!reader.read_string(key) || !reader.expect(':') || !reader.read_scalar(value))
+                return false;
+            labels.set(key, value);
+        }
+        return !reader.has_error();
+    }
+
+    static bool parse_json_counters(detail::JsonReader & reader, PerfCounterValues & counters) {
+        if (!reader.expect('{'))
+            return false;
+        bool is_first = true;
+        while (reader.next_item('}', is_first)) {
+            std::string key;
+            if (!reader.read_string(key) || !reader.expect(':'))
+                return false;
+            std::size_t event;
+            if (find_perf_event(key, event)) {
+                counters.values[event] = reader.read_double();
+                counters.valid[event] = true;
+            }
+            else {
+                reader.skip_value();
+            }
+        }
+        return !reader.has_error();
+    }
+
+    static bool parse_json_latency(detail::JsonReader & reader, LatencySummary & latency) {
+        if (!reader.expect('{'))
+            return false;
+        bool is_first = true;
+        while (reader.next_item('}', is_first)) {
+            std::string key;
+            if (!reader.read_string(key) || !reader.expect(':'))
+                return false;
+            std::size_t index = 0;
+            for (std::size_t i = 1; latency_names()[i] != nullptr; i++) {
+                if (key == latency_names()[i]) {
+                    index = i;
+                    break;
+                }
+            }
+            if (key == "count")
+                latency.count = reader.read_size();
+            else if (index != 0)
+                *get_latency_value(latency, index) = reader.read_double();
+            else
+                reader.skip_value();
+        }
+        return !reader.has_error();
+    }
+
+    static bool parse_json_stats(detail::JsonReader & reader, BenchmarkStats & stats) {
+        if (!reader.expect('{'))
+            return false;
+
+        std::vector<double> samples;
+        std::size_t repetitions = 0;
+        bool is_first = true;
+        while (reader.next_item('}', is_first)) {
+            std::string key;
+            if (!reader.read_string(key) || !reader.expect(':'))
+                return false;
+            if (key == "name") {
+                if (!reader.read_string(stats.name))
+                    return false;
+            }
+            else if (key == "labels") {
+                if (!parse_json_labels(reader, stats.labels))
+                    return false;
+            }
+            else if (key == "counters") {
+                if (!parse_json_counters(reader, stats.counters))
+                    return false;
+            }
+            else if (key == "latency") {
+                if (!parse_json_latency(reader, stats.latency))
+                    return false;
+            }
+            else if (key == "samples") {
+                if (!reader.expect('['))
+                    return false;
+                bool is_first_sample = true;
+                while (reader.next_item(']', is_first_sample)) {
+                    samples.push_back(reader.read_double());
+                }
+            }
+            else if (key == "repetitions")          repetitions = reader.read_size();
+            else if (key == "iterations")           stats.iterations = reader.read_size();
+            else if (key == "items_per_iteration")  stats.items_per_iteration = reader.read_size();
+            else if (key == "warmup_runs")          stats.warmup_runs = reader.read_size();
+            else if (key == "checksum")             stats.checksum = reader.read_size();
+            else if (key == "median")               stats.median = reader.read_double();
+            else if (key == "mad")                  stats.mad = reader.read_double();
+            else if (key == "mean")                 stats.mean = reader.read_double();
+            else if (key == "stddev")               stats.stddev = reader.read_double();
+            else if (key == "min")                  stats.min = reader.read_double();
+            else if (key == "max")                  stats.max = reader.read_double();
+            else if (key == "ci_lower")             stats.ci_lower = reader.read_double();
+            else if (key == "ci_upper")             stats.ci_upper = reader.read_double();
+            else if (key == "frequency_min_mhz")    stats.frequency_min = reader.read_double();
+            else if (key == "frequency_max_mhz")    stats.frequency_max = reader.read_double();
+            else if (key == "reruns")               stats.reruns = reader.read_size();
+            else if (key == "throttled")            stats.throttled = reader.read_bool();
+            else
+                reader.skip_value();
+        }
+
+        if (samples.empty() && repetitions != 0)
+            samples.resize(repetitions, stats.median);
+        stats.samples.swap(samples);
+        return !reader.has_error();
+    }
+};
+
+//
+// Write the reports specified by --json=<file> and --csv=<file>,
+// return false if any of them can't be written.
+//
+static inline
+bool write_reports(const BenchmarkRunner & runner) {
+    const BenchmarkOptions & options = runner.options();
+    if (options.list_only || (options.json_file.empty() && options.csv_file.empty()))
+        return true;
+
+    BenchmarkReport report(runner);
+    bool is_ok = true;
+    if (!options.json_file.empty()) {
+        if (report.save_json(options.json_file)) {
+            printf("The JSON report is written to: %s\n", options.json_file.c_str());
+        }
+        else {
+            printf("Error: can't write the JSON report: %s\n", options.json_file.c_str());
+            is_ok = false;
+        }
+    }
+    if (!options.csv_file.empty()) {
+        if (report.save_csv(options.csv_file)) {
+            printf("The CSV report is written to: %s\n", options.csv_file.c_str());
+        }
+        else {
+            printf("Error: can't write the CSV report: %s\n", options.csv_file.c_str());
+            is_ok = false;
+        }
+    }
+    printf("\n");
+    return is_ok;
+}
+
+} // namespace jtest
+
+#endif // JSTD_TEST_BENCHMARK_REPORT_H
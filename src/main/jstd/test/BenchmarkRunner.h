@@ -0,0 +1,999 @@
+
+#ifndef JSTD_TEST_BENCHMARK_RUNNER_H
+#define JSTD_TEST_BENCHMARK_RUNNER_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+#include "jstd/basic/inttypes.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>      // For std::size_t
+#include <string>
+#include <vector>
+#include <deque>        // The stats in std::deque are never moved by push_back()
+#include <functional>   // For std::function<T>
+#include <algorithm>    // For std::sort(), std::min(), std::max()
+#include <atomic>       // For std::atomic_signal_fence()
+#include <type_traits>
+#include <utility>
+
+#include "jstd/test/StopWatch.h"
+#include "jstd/test/CPUWarmUp.h"
+#include "jstd/test/PerfCounters.h"
+#include "jstd/test/LatencyHistogram.h"
+
+namespace jtest {
+
+//
+// Optimization barriers:
+//
+//   DoNotOptimize(value): the value is considered read (and written) by an
+//                         unknown observer, so the computation of it can't be
+//                         eliminated, and it's not hoisted out of the loop.
+//
+//   ClobberMemory():      all the pending memory writes must be flushed,
+//                         it's a pure compiler barrier (no fence instruction).
+//
+// From: https://github.com/google/benchmark (the same semantics)
+//
+#if defined(__GNUC__) || defined(__clang__)
+
+template <typename T>
+static inline
+void DoNotOptimize(const T & value) {
+    __asm__ __volatile__ ("" : : "r,m"(value) : "memory");
+}
+
+template <typename T>
+static inline
+typename std::enable_if<std::is_scalar<T>::value>::type
+DoNotOptimize(T & value) {
+#if defined(__clang__)
+    __asm__ __volatile__ ("" : "+r,m"(value) : : "memory");
+#else
+    __asm__ __volatile__ ("" : "+m,r"(value) : : "memory");
+#endif
+}
+
+template <typename T>
+static inline
+typename std::enable_if<!std::is_scalar<T>::value>::type
+DoNotOptimize(T & value) {
+    __asm__ __volatile__ ("" : "+m"(value) : : "memory");
+}
+
+static inline
+void ClobberMemory() {
+    __asm__ __volatile__ ("" : : : "memory");
+}
+
+#else
+
+namespace detail {
+
+static inline
+void use_char_pointer(const volatile char * ptr) {
+    static const volatile char * volatile s_sink = nullptr;
+    s_sink = ptr;
+}
+
+} // namespace detail
+
+template <typename T>
+static inline
+void DoNotOptimize(const T & value) {
+    detail::use_char_pointer(&reinterpret_cast<const volatile char &>(value));
+    std::atomic_signal_fence(std::memory_order_acq_rel);
+}
+
+static inline
+void ClobberMemory() {
+    std::atomic_signal_fence(std::memory_order_acq_rel);
+}
+
+#endif // __GNUC__ || __clang__
+
+//
+// The running state of one run of a benchmark case.
+//
+// The case function does the setup first, it's not timed, the timing begins
+// at the first call of keep_running():
+//
+//   void bench_find(jtest::BenchmarkState & state) {
+//       Container container;   // setup, not timed
+//       ...
+//       while (state.keep_running()) {
+//           for (std::size_t i = 0; i < keys.size(); i++)
+//               jtest::DoNotOptimize(container.find(keys[i]));
+//       }
+//       state.set_items_per_iteration(keys.size());
+//   }
+//
+// The per-iteration setup or teardown can be excluded by pause_timing(),
+// the next keep_running() resumes the timing automatically.
+//
+// The hardware counters (if set) count the same segments as the timing,
+// they're started before and stopped after the stopwatch.
+//
+// The per-operation latencies can be sampled into latency(), only the samples
+// of the measured runs are reported:
+//
+//   jtest::LatencySampler sampler(state.latency(), state.latency_sample_rate());
+//   while (state.keep_running()) {
+//       for (std::size_t i = 0; i < keys.size(); i++) {
+//           sampler.start();
+//           container.insert(keys[i]);
+//           sampler.stop();
+//       }
+//   }
+//
+class BenchmarkState {
+public:
+    typedef std::size_t size_type;
+
+private:
+    size_type           iterations_;
+    size_type           remaining_;
+    size_type           items_per_iteration_;
+    size_type           checksum_;
+    double              elapsed_time_;      // In millisecond
+    bool                is_started_;
+    bool                is_running_;
+    bool                is_finished_;
+    jtest::StopWatch    sw_;
+    PerfCounterGroup *  counters_;
+    LatencyHistogram *  latency_;
+    size_type           latency_sample_rate_;
+
+public:
+    explicit BenchmarkState(size_type iterations)
+        : iterations_(iterations), remaining_(iterations),
+          items_per_iteration_(1), checksum_(0), elapsed_time_(0.0),
+          is_started_(false), is_running_(false), is_finished_(false),
+          counters_(nullptr), latency_(nullptr), latency_sample_rate_(1) {
+    }
+    ~BenchmarkState() {}
+
+    void reset(size_type iterations) {
+        this->iterations_ = iterations;
+        this->remaining_ = iterations;
+        this->items_per_iteration_ = 1;
+        this->checksum_ = 0;
+        this->elapsed_time_ = 0.0;
+        this->is_started_ = false;
+        this->is_running_ = false;
+        this->is_finished_ = false;
+    }
+
+    size_type iterations() const { return this->iterations_; }
+    size_type items_per_iteration() const { return this->items_per_iteration_; }
+    size_type checksum() const { return this->checksum_; }
+
+    double elapsed_millisec() const { return this->elapsed_time_; }
+
+    bool is_started() const { return this->is_started_; }
+    bool is_finished() const { return this->is_finished_; }
+
+    PerfCounterGroup * perf_counters() const { return this->counters_; }
+
+    void set_perf_counters(PerfCounterGroup * counters) {
+        this->counters_ = counters;
+    }
+
+    // It's owned by the BenchmarkRunner.
+    LatencyHistogram & latency() {
+        assert(this->latency_ != nullptr);
+        return *this->latency_;
+    }
+
+    size_type latency_sample_rate() const { return this->latency_sample_rate_; }
+
+    void set_latency(LatencyHistogram * latency, size_type sample_rate) {
+        this->latency_ = latency;
+        this->latency_sample_rate_ = sample_rate;
+    }
+
+    bool keep_running() {
+        if (unlikely(!this->is_running_)) {
+            this->resume_timing();
+        }
+        if (likely(this->remaining_ != 0)) {
+            this->remaining_--;
+            return true;
+        }
+        this->pause_timing();
+        this->is_finished_ = true;
+        return false;
+    }
+
+    void pause_timing() {
+        if (this->is_running_) {
+            this->sw_.stop();
+            if (this->counters_ != nullptr)
+                this->counters_->stop();
+            this->elapsed_time_ += this->sw_.getElapsedMillisec();
+            this->is_running_ = false;
+        }
+    }
+
+    void resume_timing() {
+        if (!this->is_running_) {
+            this->is_started_ = true;
+            this->is_running_ = true;
+            if (this->counters_ != nullptr)
+                this->counters_->start();
+            this->sw_.start();
+        }
+    }
+
+    //
+    // The reported time is divided by (iterations * items_per_iteration),
+    // so it's the time of one operation, not the time of one pass.
+    //
+    void set_items_per_iteration(size_type items) {
+        this->items_per_iteration_ = (items != 0) ? items : 1;
+    }
+
+    void set_checksum(size_type checksum) {
+        this->checksum_ = checksum;
+    }
+};
+
+//
+// The ordered key-value pairs, they are the run metadata of the reports
+// and the labels (key type, data size, ...) of the benchmark cases.
+//
+class BenchmarkLabels {
+public:
+    typedef std::size_t                                 size_type;
+    typedef std::pair<std::string, std::string>         value_type;
+    typedef std::vector<value_type>::const_iterator     const_iterator;
+
+private:
+    std::vector<value_type> items_;
+
+public:
+    BenchmarkLabels() {}
+    ~BenchmarkLabels() {}
+
+    size_type size() const { return this->items_.size(); }
+    bool empty() const { return this->items_.empty(); }
+
+    const_iterator begin() const { return this->items_.begin(); }
+    const_iterator end() const { return this->items_.end(); }
+
+    const value_type & operator [] (size_type index) const {
+        return this->items_[index];
+    }
+
+    void clear() {
+        this->items_.clear();
+    }
+
+    // Replace the value if the key already exists, the order is kept.
+    void set(const std::string & key, const std::string & value) {
+        for (std::size_t i = 0; i < this->items_.size(); i++) {
+            if (this->items_[i].first == key) {
+                this->items_[i].second = value;
+                return;
+            }
+        }
+        this->items_.push_back(std::make_pair(key, value));
+    }
+
+    void set(const std::string & key, std::size_t value) {
+        this->set(key, std::to_string(value));
+    }
+
+    const std::string * get(const std::string & key) const {
+        for (std::size_t i = 0; i < this->items_.size(); i++) {
+            if (this->items_[i].first == key)
+                return &this->items_[i].second;
+        }
+        return nullptr;
+    }
+
+    void erase(const std::string & key) {
+        for (std::size_t i = 0; i < this->items_.size(); i++) {
+            if (this->items_[i].first == key) {
+                this->items_.erase(this->items_.begin() + i);
+                return;
+            }
+        }
+    }
+};
+
+//
+// The statistics of all the measured runs of a benchmark case,
+// the samples are the time of one operation (in nanosecond).
+//
+struct BenchmarkStats {
+    typedef std::size_t size_type;
+
+    std::string         name;
+    BenchmarkLabels     labels;
+    PerfCounterValues   counters;       // Per operation, of all the measured runs
+    LatencySummary      latency;        // The sampled latencies of all the measured runs
+    size_type           iterations;
+    size_type           items_per_iteration;
+    size_type           warmup_runs;
+    size_type           checksum;
+    std::vector<double> samples;
+
+    // The effective frequency (in MHz) sampled around the measured runs,
+    // a case measured while the frequency is drifting is rerun or flagged.
+    double              frequency_min;
+    double              frequency_max;
+    size_type           reruns;
+    bool                throttled;
+
+    double  median;
+    double  mad;            // The median absolute deviation
+    double  mean;
+    double  stddev;
+    double  min;
+    double  max;
+    double  ci_lower;       // The 95% confidence interval of the mean
+    double  ci_upper;
+
+    BenchmarkStats()
+        : iterations(0), items_per_iteration(1), warmup_runs(0), checksum(0),
+          frequency_min(0.0), frequency_max(0.0), reruns(0), throttled(false),
+          median(0.0), mad(0.0), mean(0.0), stddev(0.0), min(0.0), max(0.0),
+          ci_lower(0.0), ci_upper(0.0) {
+    }
+
+    size_type repetitions() const { return this->samples.size(); }
+
+    // In percent of the maximum frequency.
+    double frequency_drift() const {
+        return (this->frequency_max > 0.0) ?
+               ((this->frequency_max - this->frequency_min) * 100.0 / this->frequency_max) : 0.0;
+    }
+
+    // In percent of the median.
+    double mad_percent() const {
+        return (this->median != 0.0) ? (this->mad * 100.0 / this->median) : 0.0;
+    }
+
+    // The half width of the confidence interval, in percent of the mean.
+    double ci_percent() const {
+        return (this->mean != 0.0) ? ((this->ci_upper - this->ci_lower) * 50.0 / this->mean) : 0.0;
+    }
+
+    static double median_of(std::vector<double> & values) {
+        std::size_t n = values.size();
+        if (n == 0)
+            return 0.0;
+        std::sort(values.begin(), values.end());
+        if ((n & 1) != 0)
+            return values[n / 2];
+        else
+            return (values[n / 2 - 1] + values[n / 2]) * 0.5;
+    }
+
+    //
+    // The two-sided 95% quantile of the Student's t-distribution.
+    //
+    static double t_quantile_95(std::size_t degrees) {
+        static const double kTable[30] = {
+            12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+             2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+             2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+        };
+        if (degrees == 0)
+            return 0.0;
+        else if (degrees <= 30)
+            return kTable[degrees - 1];
+        else
+            return 1.960;
+    }
+
+    void compute() {
+        std::size_t n = this->samples.size();
+        if (n == 0)
+            return;
+
+        std::vector<double> sorted(this->samples);
+        this->median = median_of(sorted);
+        this->min = sorted.front();
+        this->max = sorted.back();
+
+        std::vector<double> deviations(n);
+        double sum = 0.0;
+        for (std::size_t i = 0; i < n; i++) {
+            deviations[i] = ::fabs(this->samples[i] - this->median);
+            sum += this->samples[i];
+        }
+        this->mad = median_of(deviations);
+        this->mean = sum / n;
+
+        double variance = 0.0;
+        if (n > 1) {
+            for (std::size_t i = 0; i < n; i++) {
+                double diff = this->samples[i] - this->mean;
+                variance += diff * diff;
+            }
+            variance /= (n - 1);
+        }
+        this->stddev = ::sqrt(variance);
+
+        double half_width = t_quantile_95(n - 1) * this->stddev / ::sqrt((double)n);
+        this->ci_lower = this->mean - half_width;
+        this->ci_upper = this->mean + half_width;
+    }
+};
+
+struct BenchmarkOptions {
+    typedef std::size_t size_type;
+
+    size_type   repetitions;        // The measured runs of each case
+    size_type   warmup;             // The discarded runs before measuring
+    double      min_time;           // The minimum time of one run (in millisecond)
+    size_type   max_iterations;
+    bool        list_only;
+    bool        perf_counters;      // Count the hardware events (perf_event_open)
+    size_type   latency_sample;     // Sample one of every n operations (a power of 2)
+    double      max_drift;          // The frequency drift (in percent) to rerun a case, 0 is disabled
+    size_type   max_reruns;
+
+    std::vector<std::string> filters;
+
+    std::string json_file;          // The reports written by write_reports()
+    std::string csv_file;
+
+    BenchmarkOptions()
+        : repetitions(5), warmup(1), min_time(100.0),
+          max_iterations(1000000000), list_only(false), perf_counters(false),
+          latency_sample(16), max_drift(5.0), max_reruns(2) {
+    }
+};
+
+class BenchmarkCase {
+public:
+    typedef std::size_t                                 size_type;
+    typedef std::function<void (BenchmarkState &)>      function_type;
+
+private:
+    std::string     name_;
+    function_type   function_;
+    size_type       iterations_;        // 0 means auto-scaled
+    size_type       repetitions_;       // 0 means BenchmarkOptions::repetitions
+
+public:
+    BenchmarkCase(const std::string & name, const function_type & function)
+        : name_(name), function_(function), iterations_(0), repetitions_(0) {
+    }
+    ~BenchmarkCase() {}
+
+    const std::string & name() const { return this->name_; }
+    const function_type & function() const { return this->function_; }
+
+    size_type iterations() const { return this->iterations_; }
+    size_type repetitions() const { return this->repetitions_; }
+
+    //
+    // Use a fixed iteration count, it's used for the cases that a pass
+    // is already long enough, or can't be repeated cheaply.
+    //
+    BenchmarkCase & iterations(size_type iterations) {
+        this->iterations_ = iterations;
+        return *this;
+    }
+
+    BenchmarkCase & repetitions(size_type repetitions) {
+        this->repetitions_ = repetitions;
+        return *this;
+    }
+};
+
+//
+// The benchmark runner, usage:
+//
+//   jtest::BenchmarkRunner runner;
+//   if (!runner.parse_args(argc, argv))
+//       return 0;
+//
+//   runner.add("hash_map/find", bench_find);     // run by run_all()
+//   runner.run_all();
+//
+//   const jtest::BenchmarkStats * stats = runner.run("hash_map/insert", bench_insert);
+//   if (stats != nullptr) { ... }                // nullptr if it's filtered out
+//
+// Command line options:
+//
+//   --filter=<pattern>[,<pattern>]   Run the cases whose name contains any of the patterns,
+//                                    "-<pattern>" excludes the matched cases.
+//   --repetitions=<n>                The measured runs of each case.
+//   --warmup=<n>                     The discarded runs before measuring.
+//   --min_time=<ms>                  The minimum time of one run, the iterations are
+//                                    doubled or predicted until a run reaches it.
+//   --max_iterations=<n>             The limit of the auto-scaled iterations.
+//   --list                           List the selected case names, not run.
+//   --perf_counters                  Count the hardware events per operation (Linux only),
+//                                    --no_perf_counters disables it.
+//   --latency_sample=<n>             The latency cases time one of every n operations.
+//   --max_drift=<percent>            The effective CPU frequency is sampled around the
+//                                    measured runs, if it drifts more than this (default 5),
+//                                    the case is rerun, 0 disables the sampling.
+//   --max_reruns=<n>                 The reruns of a drifting case (default 2), then it's
+//                                    flagged as throttled.
+//   --json=<file>                    Write the results and the metadata to a JSON file.
+//   --csv=<file>                     Write the results and the metadata to a CSV file.
+//
+// The other arguments are kept in args() for the program itself.
+//
+// The reports are written by jtest::write_reports() (see BenchmarkReport.h),
+// the labels set by set_label() are attached to the cases run after it.
+//
+class BenchmarkRunner {
+public:
+    typedef std::size_t                         size_type;
+    typedef BenchmarkCase::function_type        function_type;
+
+private:
+    BenchmarkOptions            options_;
+    std::vector<std::string>    args_;
+    std::vector<BenchmarkCase>  cases_;
+    std::deque<BenchmarkStats>  results_;
+    BenchmarkLabels             metadata_;
+    BenchmarkLabels             labels_;
+    PerfCounterGroup            perf_group_;
+    bool                        perf_reported_;
+    LatencyHistogram            latency_;
+
+public:
+    BenchmarkRunner() : perf_reported_(false) {}
+    ~BenchmarkRunner() {}
+
+    BenchmarkOptions & options() { return this->options_; }
+    const BenchmarkOptions & options() const { return this->options_; }
+
+    const std::vector<std::string> & args() const { return this->args_; }
+    const std::deque<BenchmarkStats> & results() const { return this->results_; }
+
+    BenchmarkLabels & metadata() { return this->metadata_; }
+    const BenchmarkLabels & metadata() const { return this->metadata_; }
+
+    const BenchmarkLabels & labels() const { return this->labels_; }
+
+    void set_label(const std::string & key, const std::string & value) {
+        this->labels_.set(key, value);
+    }
+
+    void set_label(const std::string & key, std::size_t value) {
+        this->labels_.set(key, value);
+    }
+
+    void erase_label(const std::string & key) {
+        this->labels_.erase(key);
+    }
+
+    void clear_labels() {
+        this->labels_.clear();
+    }
+
+    //
+    // Warm up the CPU until the frequency is stable (or maxMillisecs),
+    // the result is written to the metadata of the reports.
+    //
+    CPU::WarmUpResult warm_up(double maxMillisecs = 2000.0) {
+        CPU::WarmUpResult result = CPU::warm_up_adaptive(1.0, 50.0, maxMillisecs);
+
+        char buf[128];
+        snprintf(buf, sizeof(buf), "%0.0f", result.frequency);
+        this->metadata_.set("cpu_frequency_mhz", buf);
+        snprintf(buf, sizeof(buf), "%s after %0.0f ms, drift %0.2f%%",
+                 result.is_stable ? "stable" : "not stable",
+                 result.elapsed_time, result.drift);
+        this->metadata_.set("warm_up", buf);
+        return result;
+    }
+
+    static void print_usage(const char * program) {
+        printf("Usage: %s [options] [args]\n\n", (program != nullptr) ? program : "benchmark");
+        printf("  --filter=<pattern>[,<pattern>]  Run the cases whose name contains the pattern,\n"
+               "                                  \"-<pattern>\" excludes the matched cases.\n"
+               "  --repetitions=<n>               The measured runs of each case.\n"
+               "  --warmup=<n>                    The discarded runs before measuring.\n"
+               "  --min_time=<ms>                 The minimum time of one run.\n"
+               "  --max_iterations=<n>            The limit of the auto-scaled iterations.\n"
+               "  --list                          List the selected case names, not run.\n"
+               "  --perf_counters                 Count the hardware events per operation.\n"
+               "  --no_perf_counters              Don't count the hardware events.\n"
+               "  --latency_sample=<n>            The latency cases time one of every n operations.\n"
+               "  --max_drift=<percent>           Rerun a case if the CPU frequency drifts more than it.\n"
+               "  --max_reruns=<n>                The reruns of a drifting case, then it's flagged.\n"
+               "  --json=<file>                   Write the results to a JSON file.\n"
+               "  --csv=<file>                    Write the results to a CSV file.\n"
+               "  --help                          Show this message.\n\n");
+    }
+
+    //
+    // Return false if the program should exit (--help).
+    //
+    bool parse_args(int argc, char * argv[]) {
+        if (argc > 0 && argv[0] != nullptr)
+            this->metadata_.set("program", get_program_name(argv[0]));
+        for (int i = 1; i < argc; i++) {
+            const char * arg = argv[i];
+            const char * value;
+            if (::strncmp(arg, "--", 2) != 0) {
+                this->args_.push_back(std::string(arg));
+            }
+            else if ((value = match_option(arg, "--filter=")) != nullptr) {
+                add_filters(value);
+            }
+            else if ((value = match_option(arg, "--repetitions=")) != nullptr) {
+                this->options_.repetitions = parse_size(value, this->options_.repetitions);
+                if (this->options_.repetitions == 0)
+                    this->options_.repetitions = 1;
+            }
+            else if ((value = match_option(arg, "--warmup=")) != nullptr) {
+                this->options_.warmup = parse_size(value, this->options_.warmup);
+            }
+            else if ((value = match_option(arg, "--min_time=")) != nullptr) {
+                double min_time = ::atof(value);
+                if (min_time > 0.0)
+                    this->options_.min_time = min_time;
+            }
+            else if ((value = match_option(arg, "--max_iterations=")) != nullptr) {
+                this->options_.max_iterations = parse_size(value, this->options_.max_iterations);
+                if (this->options_.max_iterations == 0)
+                    this->options_.max_iterations = 1;
+            }
+            else if ((value = match_option(arg, "--latency_sample=")) != nullptr) {
+                this->options_.latency_sample = parse_size(value, this->options_.latency_sample);
+                if (this->options_.latency_sample == 0)
+                    this->options_.latency_sample = 1;
+            }
+            else if ((value = match_option(arg, "--max_drift=")) != nullptr) {
+                double max_drift = ::atof(value);
+                if (max_drift >= 0.0)
+                    this->options_.max_drift = max_drift;
+            }
+            else if ((value = match_option(arg, "--max_reruns=")) != nullptr) {
+                this->options_.max_reruns = parse_size(value, this->options_.max_reruns);
+            }
+            else if ((value = match_option(arg, "--json=")) != nullptr) {
+                this->options_.json_file = value;
+            }
+            else if ((value = match_option(arg, "--csv=")) != nullptr) {
+                this->options_.csv_file = value;
+            }
+            else if (::strcmp(arg, "--perf_counters") == 0) {
+                this->options_.perf_counters = true;
+            }
+            else if (::strcmp(arg, "--no_perf_counters") == 0) {
+                this->options_.perf_counters = false;
+            }
+            else if (::strcmp(arg, "--list") == 0) {
+                this->options_.list_only = true;
+            }
+            else if (::strcmp(arg, "--help") == 0) {
+                print_usage(argv[0]);
+                return false;
+            }
+            else {
+                printf("Unknown option: %s\n\n", arg);
+            }
+        }
+        return true;
+    }
+
+    bool is_selected(const std::string & name) const {
+        bool has_include = false;
+        bool is_included = false;
+        for (std::size_t i = 0; i < this->options_.filters.size(); i++) {
+            const std::string & filter = this->options_.filters[i];
+            if (filter[0] == '-') {
+                if (name.find(filter.c_str() + 1) != std::string::npos)
+                    return false;
+            }
+            else {
+                has_include = true;
+                if (name.find(filter) != std::string::npos)
+                    is_included = true;
+            }
+        }
+        return (!has_include || is_included);
+    }
+
+    BenchmarkCase & add(const std::string & name, const function_type & function) {
+        this->cases_.push_back(BenchmarkCase(name, function));
+        return this->cases_.back();
+    }
+
+    size_type run_all() {
+        size_type count = 0;
+        for (std::size_t i = 0; i < this->cases_.size(); i++) {
+            if (this->run(this->cases_[i]) != nullptr)
+                count++;
+        }
+        return count;
+    }
+
+    const BenchmarkStats * run(const std::string & name, const function_type & function,
+                               size_type iterations = 0) {
+        BenchmarkCase bench_case(name, function);
+        bench_case.iterations(iterations);
+        return this->run(bench_case);
+    }
+
+    const BenchmarkStats * run(const BenchmarkCase & bench_case) {
+        if (!this->is_selected(bench_case.name()))
+            return nullptr;
+
+        if (this->options_.list_only) {
+            printf(" %s\n", bench_case.name().c_str());
+            return nullptr;
+        }
+
+        BenchmarkStats stats;
+        stats.name = bench_case.name();
+        stats.labels = this->labels_;
+
+        //
+        // The calibration runs are the warm-up runs too, the iterations are
+        // predicted from the last run until a run reaches the min_time.
+        //
+        size_type iterations = bench_case.iterations();
+        size_type warmup_runs = 0;
+        BenchmarkState state(1);
+        state.set_latency(&this->latency_, this->options_.latency_sample);
+        if (iterations == 0) {
+            iterations = 1;
+            for (;;) {
+                if (!run_once(bench_case, iterations, state))
+                    return nullptr;
+                warmup_runs++;
+
+                double elapsed_time = state.elapsed_millisec();
+                if (elapsed_time >= this->options_.min_time ||
+                    iterations >= this->options_.max_iterations)
+                    break;
+
+                double multiplier = 10.0;
+                if (elapsed_time > this->options_.min_time * 0.01)
+                    multiplier = (this->options_.min_time * 1.4) / elapsed_time;
+                if (multiplier < 2.0)
+                    multiplier = 2.0;
+                else if (multiplier > 10.0)
+                    multiplier = 10.0;
+
+                double next_iterations = (double)iterations * multiplier;
+                if (next_iterations > (double)this->options_.max_iterations)
+                    iterations = this->options_.max_iterations;
+                else
+                    iterations = static_cast<size_type>(next_iterations);
+            }
+        }
+
+        for (; warmup_runs < this->options_.warmup; warmup_runs++) {
+            if (!run_once(bench_case, iterations, state))
+                return nullptr;
+        }
+
+        size_type repetitions = (bench_case.repetitions() != 0) ?
+                                 bench_case.repetitions() : this->options_.repetitions;
+        bool sample_frequency = (this->options_.max_drift > 0.0);
+        PerfCounterGroup * perf_group = this->open_perf_counters();
+        CPU::FrequencyRange frequency;
+        double total_operations;
+
+        //
+        // The frequency is sampled before and after each measured run (not timed),
+        // if it drifts more than max_drift, all the measured runs are discarded.
+        //
+        for (size_type reruns = 0; ; reruns++) {
+            // Only the measured runs are counted.
+            this->latency_.reset();
+            if (perf_group != nullptr)
+                perf_group->reset();
+            state.set_perf_counters(perf_group);
+
+            stats.samples.clear();
+            frequency.reset();
+            if (sample_frequency)
+                frequency.add(CPU::FrequencyProbe::measure());
+
+            total_operations = 0.0;
+            for (size_type n = 0; n < repetitions; n++) {
+                if (!run_once(bench_case, iterations, state))
+                    return nullptr;
+                double operations = (double)state.iterations() * (double)state.items_per_iteration();
+                stats.samples.push_back(state.elapsed_millisec() * 1000000.0 / operations);
+                total_operations += operations;
+                if (sample_frequency)
+                    frequency.add(CPU::FrequencyProbe::measure());
+            }
+
+            stats.reruns = reruns;
+            if (!sample_frequency || frequency.drift() <= this->options_.max_drift)
+                break;
+            if (reruns >= this->options_.max_reruns) {
+                stats.throttled = true;
+                break;
+            }
+        }
+        stats.frequency_min = frequency.min;
+        stats.frequency_max = frequency.max;
+
+        if (perf_group != nullptr) {
+            stats.counters = perf_group->totals().per_operation(total_operations);
+            if (!stats.counters.has_any())
+                this->report_perf_error();
+        }
+        if (this->latency_.count() != 0)
+            stats.latency = this->latency_.summary(LatencySampler::ns_per_tick());
+
+        stats.iterations = iterations;
+        stats.items_per_iteration = state.items_per_iteration();
+        stats.warmup_runs = warmup_runs;
+        stats.checksum = state.checksum();
+        stats.compute();
+
+        this->results_.push_back(stats);
+        print_stats(this->results_.back());
+        return &this->results_.back();
+    }
+
+    //
+    // Add a result measured by another harness (e.g. ThreadBench), it's printed
+    // and written to the reports like the other cases.
+    //
+    const BenchmarkStats * add_result(const BenchmarkStats & stats) {
+        this->results_.push_back(stats);
+        print_stats(this->results_.back());
+        return &this->results_.back();
+    }
+
+    static std::string format_time(double nanosecs) {
+        char time_buf[64];
+
+        if (nanosecs >= 1000000000.0 * 10.0)
+            snprintf(time_buf, sizeof(time_buf), "%8.2f s ", nanosecs / 1000000000.0);
+        else if (nanosecs >= 1000000.0 * 10.0)
+            snprintf(time_buf, sizeof(time_buf), "%8.2f ms", nanosecs / 1000000.0);
+        else if (nanosecs >= 1000.0 * 10.0)
+            snprintf(time_buf, sizeof(time_buf), "%8.2f us", nanosecs / 1000.0);
+        else
+            snprintf(time_buf, sizeof(time_buf), "%8.2f ns", nanosecs);
+
+        return std::string(time_buf);
+    }
+
+    static void print_stats(const BenchmarkStats & stats) {
+        printf(" %-60s %s/op  MAD %5.2f%%  CI95 +/-%5.2f%%  (%" PRIuPTR " runs x %" PRIuPTR " iters)",
+               stats.name.c_str(), format_time(stats.median).c_str(),
+               stats.mad_percent(), stats.ci_percent(),
+               stats.repetitions(), stats.iterations);
+        if (stats.checksum != 0)
+            printf("  sum = %" PRIuPTR, stats.checksum);
+        printf("\n");
+        if (stats.counters.has_any())
+            print_counters(stats.counters);
+        if (stats.latency.has_value())
+            print_latency(stats.latency);
+        if (stats.throttled || stats.reruns != 0)
+            print_frequency(stats);
+        ::fflush(stdout);
+    }
+
+    static void print_frequency(const BenchmarkStats & stats) {
+        printf(" %-60s %s: frequency %0.0f - %0.0f MHz, drift %0.2f%%, %" PRIuPTR " reruns\n",
+               "", stats.throttled ? "THROTTLED" : "rerun",
+               stats.frequency_min, stats.frequency_max, stats.frequency_drift(), stats.reruns);
+    }
+
+    static void print_latency(const LatencySummary & latency) {
+        printf(" %-60s latency: p50 %s  p90 %s  p99 %s  p999 %s  max %s  (%" PRIu64 " samples)\n",
+               "", format_time(latency.p50).c_str(), format_time(latency.p90).c_str(),
+               format_time(latency.p99).c_str(), format_time(latency.p999).c_str(),
+               format_time(latency.max).c_str(), latency.count);
+    }
+
+    //
+    //   cycles/op, instructions/op, IPC, L1D-misses/op, LLC-misses/op, dTLB-misses/op, branch-misses/op
+    //
+    static void print_counters(const PerfCounterValues & counters) {
+        printf(" %-60s", "");
+        for (std::size_t i = 0; i < kPerfEventCount; i++) {
+            if (counters.valid[i])
+                printf(" %s/op %0.2f ", get_perf_event_name(i), counters.values[i]);
+            else
+                printf(" %s/op  n/a ", get_perf_event_name(i));
+            if (i == kPerfInstructions && counters.ipc() != 0.0)
+                printf(" IPC %0.2f ", counters.ipc());
+        }
+        printf("\n");
+    }
+
+private:
+    static const char * match_option(const char * arg, const char * option) {
+        std::size_t length = ::strlen(option);
+        if (::strncmp(arg, option, length) == 0)
+            return (arg + length);
+        else
+            return nullptr;
+    }
+
+    static std::string get_program_name(const char * path) {
+        const char * name = path;
+        for (const char * p = path; *p != '\0'; p++) {
+            if (*p == '/' || *p == '\\')
+                name = p + 1;
+        }
+        return std::string(name);
+    }
+
+    static size_type parse_size(const char * value, size_type default_value) {
+        char * end = nullptr;
+        unsigned long long number = ::strtoull(value, &end, 10);
+        if (end == value)
+            return default_value;
+        return static_cast<size_type>(number);
+    }
+
+    void add_filters(const char * value) {
+        std::string filters(value);
+        std::size_t first = 0;
+        while (first <= filters.size()) {
+            std::size_t last = filters.find(',', first);
+            if (last == std::string::npos)
+                last = filters.size();
+            if (last > first)
+                this->options_.filters.push_back(filters.substr(first, last - first));
+            first = last + 1;
+        }
+    }
+
+    //
+    // Open the counter group at the first time, return nullptr if it's disabled
+    // or unavailable, the reason is printed only once.
+    //
+    PerfCounterGroup * open_perf_counters() {
+        if (!this->options_.perf_counters)
+            return nullptr;
+        if (this->perf_group_.is_open() || this->perf_group_.open())
+            return &this->perf_group_;
+        this->report_perf_error();
+        return nullptr;
+    }
+
+    void report_perf_error() {
+        if (!this->perf_reported_) {
+            printf(" (The hardware counters are unavailable: %s)\n",
+                   this->perf_group_.error().empty() ? "no event is counted"
+                                                     : this->perf_group_.error().c_str());
+            this->perf_reported_ = true;
+        }
+    }
+
+    bool run_once(const BenchmarkCase & bench_case, size_type iterations, BenchmarkState & state) {
+        state.reset(iterations);
+
+        bench_case.function()(state);
+
+        if (!state.is_finished()) {
+            printf(" %-60s error: the case didn't call keep_running() until it returns false.\n",
+                   bench_case.name().c_str());
+            return false;
+        }
+        return true;
+    }
+};
+
+} // namespace jtest
+
+#endif // JSTD_TEST_BENCHMARK_RUNNER_H
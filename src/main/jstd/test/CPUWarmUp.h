@@ -21,8 +21,22 @@
 #include <chrono>
 #endif
 
+#include <cstdint>
+#include <cstddef>      // For std::size_t
 #include <atomic>
 
+#include "jstd/test/StopWatch.h"
+
+//
+// Keep the value in a register, so the dependent chain of additions
+// can't be folded or vectorized by the compiler.
+//
+#if defined(__GNUC__) || defined(__clang__)
+#define JTEST_KEEP_IN_REGISTER(x)   __asm__ __volatile__ ("" : "+r" (x))
+#else
+#define JTEST_KEEP_IN_REGISTER(x)   ((void)0)
+#endif
+
 namespace jtest {
 namespace CPU {
 
@@ -91,6 +105,168 @@ void warm_up(DWORD delayMillsecs)
 
 #endif // _MSC_VER
 
+//
+// The effective frequency of the current core (in MHz), it's estimated by
+// a fixed-work loop, a dependent chain of additions (1 cycle each on the
+// most CPUs), timed by the TSC. The absolute value is an estimate, but the
+// changes of it (turbo, power saving, thermal throttling) are real.
+//
+// The best of the tries is used, the interrupts only make it lower.
+//
+struct FrequencyProbe {
+    static const std::uint32_t kAddsPerLoop = 8;
+    static const std::uint32_t kDefaultLoops = 32 * 1024;
+
+    static double measure(std::uint32_t loops = kDefaultLoops, int tries = 3) {
+        double best = 0.0;
+        for (int i = 0; i < tries; i++) {
+            TscClock::tick_t start = TscClock::now();
+            std::uint64_t sum = run_chain(loops);
+            TscClock::tick_t stop = TscClock::now();
+            double seconds = TscClock::to_seconds(TscClock::interval(stop, start));
+            if (seconds > 0.0 && sum != 0) {
+                double mhz = (double)loops * kAddsPerLoop / seconds / 1000000.0;
+                if (mhz > best)
+                    best = mhz;
+            }
+        }
+        return best;
+    }
+
+private:
+    static std::uint64_t run_chain(std::uint32_t loops) {
+        // The step is a register operand, some cores fold the chains of immediate additions.
+#if defined(__GNUC__) || defined(__clang__)
+        std::uint64_t step = 1;
+        JTEST_KEEP_IN_REGISTER(step);
+#else
+        volatile std::uint64_t step = 1;
+#endif
+        std::uint64_t sum = loops;
+        for (std::uint32_t i = 0; i < loops; i++) {
+            sum += step; JTEST_KEEP_IN_REGISTER(sum);
+            sum += step; JTEST_KEEP_IN_REGISTER(sum);
+            sum += step; JTEST_KEEP_IN_REGISTER(sum);
+            sum += step; JTEST_KEEP_IN_REGISTER(sum);
+            sum += step; JTEST_KEEP_IN_REGISTER(sum);
+            sum += step; JTEST_KEEP_IN_REGISTER(sum);
+            sum += step; JTEST_KEEP_IN_REGISTER(sum);
+            sum += step; JTEST_KEEP_IN_REGISTER(sum);
+        }
+        return sum;
+    }
+};
+
+//
+// The range of the sampled frequencies, the drift is (max - min) / max.
+//
+struct FrequencyRange {
+    double      min;
+    double      max;
+    double      last;
+    std::size_t samples;
+
+    FrequencyRange() : min(0.0), max(0.0), last(0.0), samples(0) {}
+
+    void reset() {
+        this->min = 0.0;
+        this->max = 0.0;
+        this->last = 0.0;
+        this->samples = 0;
+    }
+
+    void add(double mhz) {
+        if (this->samples == 0 || mhz < this->min)
+            this->min = mhz;
+        if (this->samples == 0 || mhz > this->max)
+            this->max = mhz;
+        this->last = mhz;
+        this->samples++;
+    }
+
+    // In percent.
+    double drift() const {
+        return (this->max > 0.0) ? ((this->max - this->min) * 100.0 / this->max) : 0.0;
+    }
+};
+
+struct WarmUpResult {
+    double          elapsed_time;   // In millisecond
+    double          frequency;      // The last sample, in MHz
+    double          drift;          // Of the last window, in percent
+    std::size_t     samples;
+    bool            is_stable;
+
+    WarmUpResult() : elapsed_time(0.0), frequency(0.0), drift(0.0),
+                     samples(0), is_stable(false) {}
+};
+
+//
+// Load the core until the effective frequency is stable: the last kWindow
+// samples (about 10 ms apart) are within the tolerance (in percent).
+// It stops at maxMillisecs even if the frequency is still changing,
+// so it's shorter than warm_up() on an idle host, and longer when
+// the turbo or the power saving is settling.
+//
+static inline
+WarmUpResult warm_up_adaptive(double tolerance = 1.0, double minMillisecs = 50.0,
+                              double maxMillisecs = 2000.0)
+{
+    static const std::size_t kWindow = 5;
+    static const std::uint64_t kRoundNanosecs = 10 * 1000000ULL;
+
+    WarmUpResult result;
+    double window[kWindow];
+    volatile int sum = 0;
+
+    printf("------------------------------------------\n\n");
+    printf("CPU warm-up begin ...\n");
+
+    std::uint64_t start_ns = TscClock::monotonic_raw_ns();
+    std::uint64_t now_ns = start_ns;
+    for (;;) {
+        std::uint64_t round_start = now_ns;
+        do {
+            for (int i = 0; i < 500; ++i) {
+                sum += i;
+                for (int j = 5000; j >= 0; --j) {
+                    sum -= j;
+                }
+            }
+            now_ns = TscClock::monotonic_raw_ns();
+        } while ((now_ns - round_start) < kRoundNanosecs);
+
+        double mhz = FrequencyProbe::measure();
+        window[result.samples % kWindow] = mhz;
+        result.samples++;
+        result.frequency = mhz;
+        now_ns = TscClock::monotonic_raw_ns();
+        result.elapsed_time = (double)(now_ns - start_ns) / 1000000.0;
+
+        if (result.samples >= kWindow) {
+            FrequencyRange range;
+            for (std::size_t i = 0; i < kWindow; i++) {
+                range.add(window[i]);
+            }
+            result.drift = range.drift();
+            if (result.drift <= tolerance && result.elapsed_time >= minMillisecs) {
+                result.is_stable = true;
+                break;
+            }
+        }
+        if (result.elapsed_time >= maxMillisecs)
+            break;
+    }
+
+    printf("sum = %d, frequency: %0.0f MHz, drift: %0.2f%%, %s after %0.3f ms (%u samples)\n",
+           sum, result.frequency, result.drift,
+           result.is_stable ? "stable" : "NOT stable",
+           result.elapsed_time, (unsigned int)result.samples);
+    printf("CPU warm-up end   ... \n\n");
+    printf("------------------------------------------\n\n");
+    return result;
+}
+
 struct WarmUp {
     WarmUp(unsigned int delayMillsecs = 1000) {
         //
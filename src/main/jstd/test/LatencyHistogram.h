@@ -0,0 +1,231 @@
+
+#ifndef JSTD_TEST_LATENCY_HISTOGRAM_H
+#define JSTD_TEST_LATENCY_HISTOGRAM_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <string.h>
+
+#include <cstdint>
+#include <cstddef>      // For std::size_t
+#include <vector>
+
+#include "jstd/support/BitUtils.h"
+#include "jstd/test/StopWatch.h"
+
+namespace jtest {
+
+//
+// The percentiles of a latency histogram, in nanosecond.
+//
+struct LatencySummary {
+    std::uint64_t   count;      // The number of the samples
+    double          p50;
+    double          p90;
+    double          p99;
+    double          p999;
+    double          max;
+
+    LatencySummary() : count(0), p50(0.0), p90(0.0), p99(0.0), p999(0.0), max(0.0) {}
+
+    bool has_value() const { return (this->count != 0); }
+};
+
+//
+// A HDR-style (High Dynamic Range) histogram of the latencies:
+//
+// The values less than kSubBuckets are counted exactly, the larger values are
+// grouped by the power of 2, and each power of 2 is divided into kSubBuckets
+// linear sub-buckets, so the relative error of a value is less than 1/128
+// (about 0.8%) from 1 to 2^64. record() is a bit scan, a shift and an add,
+// it never allocates.
+//
+// The values are in any unit (e.g. the TSC ticks), summary() scales them.
+//
+class LatencyHistogram {
+public:
+    typedef std::size_t     size_type;
+    typedef std::uint64_t   value_type;
+
+    static const size_type kSubBucketBits = 7;
+    static const size_type kSubBuckets = size_type(1) << kSubBucketBits;
+    static const size_type kBucketCount = kSubBuckets + (64 - kSubBucketBits) * kSubBuckets;
+
+private:
+    std::vector<value_type> counts_;
+    value_type              total_count_;
+    value_type              min_;
+    value_type              max_;
+    double                  sum_;
+
+public:
+    LatencyHistogram() : counts_(kBucketCount, 0), total_count_(0),
+                         min_(~value_type(0)), max_(0), sum_(0.0) {
+    }
+    ~LatencyHistogram() {}
+
+    value_type count() const { return this->total_count_; }
+    value_type min() const { return (this->total_count_ != 0) ? this->min_ : 0; }
+    value_type max() const { return this->max_; }
+
+    double mean() const {
+        return (this->total_count_ != 0) ? (this->sum_ / static_cast<double>(this->total_count_)) : 0.0;
+    }
+
+    void reset() {
+        ::memset(&this->counts_[0], 0, this->counts_.size() * sizeof(value_type));
+        this->total_count_ = 0;
+        this->min_ = ~value_type(0);
+        this->max_ = 0;
+        this->sum_ = 0.0;
+    }
+
+    void record(value_type value) {
+        this->counts_[get_index(value)]++;
+        this->total_count_++;
+        if (value < this->min_)
+            this->min_ = value;
+        if (value > this->max_)
+            this->max_ = value;
+        this->sum_ += static_cast<double>(value);
+    }
+
+    void merge(const LatencyHistogram & other) {
+        for (size_type i = 0; i < kBucketCount; i++) {
+            this->counts_[i] += other.counts_[i];
+        }
+        this->total_count_ += other.total_count_;
+        if (other.total_count_ != 0) {
+            if (other.min_ < this->min_)
+                this->min_ = other.min_;
+            if (other.max_ > this->max_)
+                this->max_ = other.max_;
+        }
+        this->sum_ += other.sum_;
+    }
+
+    //
+    // The value at the percentile (0.0 ~ 100.0): the highest value of the bucket
+    // that the rank falls in, it's never larger than max().
+    //
+    value_type percentile(double percent) const {
+        if (this->total_count_ == 0)
+            return 0;
+        if (percent >= 100.0)
+            return this->max_;
+
+        value_type rank = static_cast<value_type>(percent * static_cast<double>(this->total_count_) / 100.0 + 0.5);
+        if (rank == 0)
+            rank = 1;
+        value_type accumulated = 0;
+        for (size_type i = 0; i < kBucketCount; i++) {
+            accumulated += this->counts_[i];
+            if (accumulated >= rank) {
+                value_type value = get_highest_value(i);
+                return (value < this->max_) ? value : this->max_;
+            }
+        }
+        return this->max_;
+    }
+
+    //
+    // The percentiles in nanosecond, scale is the nanoseconds per unit.
+    //
+    LatencySummary summary(double scale = 1.0) const {
+        LatencySummary result;
+        result.count = this->total_count_;
+        result.p50   = static_cast<double>(this->percentile(50.0)) * scale;
+        result.p90   = static_cast<double>(this->percentile(90.0)) * scale;
+        result.p99   = static_cast<double>(this->percentile(99.0)) * scale;
+        result.p999  = static_cast<double>(this->percentile(99.9)) * scale;
+        result.max   = static_cast<double>(this->max_) * scale;
+        return result;
+    }
+
+    static size_type get_index(value_type value) {
+        if (value < kSubBuckets)
+            return static_cast<size_type>(value);
+        size_type exponent = static_cast<size_type>(jstd::BitUtils::bsr64(value));
+        size_type shift = exponent - kSubBucketBits;
+        size_type sub_index = static_cast<size_type>(value >> shift) - kSubBuckets;
+        return (kSubBuckets + shift * kSubBuckets + sub_index);
+    }
+
+    static value_type get_lowest_value(size_type index) {
+        if (index < kSubBuckets)
+            return static_cast<value_type>(index);
+        size_type shift = (index - kSubBuckets) / kSubBuckets;
+        size_type sub_index = (index - kSubBuckets) % kSubBuckets;
+        return (static_cast<value_type>(kSubBuckets + sub_index) << shift);
+    }
+
+    static value_type get_highest_value(size_type index) {
+        if (index < kSubBuckets)
+            return static_cast<value_type>(index);
+        size_type shift = (index - kSubBuckets) / kSubBuckets;
+        return (get_lowest_value(index) + ((value_type(1) << shift) - 1));
+    }
+};
+
+//
+// Time every N-th operation (N is a power of 2) by the TSC, and record the
+// ticks into a LatencyHistogram, the reading overhead is subtracted:
+//
+//   jtest::LatencySampler sampler(histogram, 16);
+//   for (std::size_t i = 0; i < keys.size(); i++) {
+//       sampler.start();
+//       dict.insert(keys[i], values[i]);
+//       sampler.stop();
+//   }
+//   jtest::LatencySummary latency = histogram.summary(jtest::LatencySampler::ns_per_tick());
+//
+// The TSC readings are serializing, so the sampled operations don't overlap
+// with the neighbours, it's the latency rather than the throughput.
+//
+class LatencySampler {
+public:
+    typedef std::size_t         size_type;
+    typedef TscClock::tick_t    tick_t;
+
+private:
+    LatencyHistogram &  histogram_;
+    size_type           mask_;
+    size_type           count_;
+    tick_t              start_tick_;
+    bool                is_sampled_;
+
+public:
+    explicit LatencySampler(LatencyHistogram & histogram, size_type sample_rate = 1)
+        : histogram_(histogram),
+          mask_((sample_rate > 1) ? ((size_type(1) << jstd::BitUtils::log2_int(sample_rate)) - 1) : 0),
+          count_(0), start_tick_(0), is_sampled_(false) {
+    }
+    ~LatencySampler() {}
+
+    size_type sample_rate() const { return (this->mask_ + 1); }
+
+    void start() {
+        if ((this->count_++ & this->mask_) == 0) {
+            this->is_sampled_ = true;
+            this->start_tick_ = TscClock::now();
+        }
+    }
+
+    void stop() {
+        if (this->is_sampled_) {
+            tick_t stop_tick = TscClock::now();
+            this->histogram_.record(TscClock::interval(stop_tick, this->start_tick_));
+            this->is_sampled_ = false;
+        }
+    }
+
+    static double ns_per_tick() {
+        return (1000000000.0 / TscClock::frequency());
+    }
+};
+
+} // namespace jtest
+
+#endif // JSTD_TEST_LATENCY_HISTOGRAM_H
@@ -0,0 +1,92 @@
+
+#ifndef JSTD_TEST_MEMORY_TRACKER_H
+#define JSTD_TEST_MEMORY_TRACKER_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include "jstd/basic/stddef.h"
+#include "jstd/basic/stdint.h"
+#include "jstd/basic/inttypes.h"
+
+#include <stdio.h>
+
+#include <cstddef>
+#include <unordered_map>
+
+#include "jstd/hash/dictionary.h"
+#include "jstd/hash/string_dictionary.h"
+#include "jstd/hash/small_dictionary.h"
+#include "jstd/memory/tracking_allocator.h"
+
+namespace jtest {
+
+//
+// TrackedContainer<Container>::type
+//
+// The same container, but use the jstd::tracking_allocator<T> as it's allocator,
+// create it in a jstd::allocation_tracking_scope to get the exact heap bytes.
+//
+template <typename Container>
+struct TrackedContainer {
+    typedef Container type;
+    static const bool is_tracked = false;
+};
+
+template <typename Key, typename Value, typename Hasher, typename KeyEqual, typename Allocator>
+struct TrackedContainer<std::unordered_map<Key, Value, Hasher, KeyEqual, Allocator>> {
+    typedef std::unordered_map<Key, Value, Hasher, KeyEqual,
+                               jstd::tracking_allocator<typename Allocator::value_type, Allocator>> type;
+    static const bool is_tracked = true;
+};
+
+template <typename Key, typename Value, std::size_t HashFunc, std::size_t Alignment,
+          typename Hasher, typename KeyEqual, typename Allocator>
+struct TrackedContainer<jstd::BasicDictionary<Key, Value, HashFunc, Alignment, Hasher, KeyEqual, Allocator>> {
+    typedef jstd::BasicDictionary<Key, Value, HashFunc, Alignment, Hasher, KeyEqual,
+                                  jstd::tracking_allocator<typename Allocator::value_type, Allocator>> type;
+    static const bool is_tracked = true;
+};
+
+template <typename Value, std::size_t HashFunc, typename ArenaAllocator, typename Allocator>
+struct TrackedContainer<jstd::BasicStringDictionary<Value, HashFunc,
+                                                    jstd::basic_string_key_arena<ArenaAllocator>, Allocator>> {
+    typedef jstd::BasicStringDictionary<Value, HashFunc,
+                jstd::basic_string_key_arena<jstd::tracking_allocator<char, ArenaAllocator>>,
+                jstd::tracking_allocator<typename Allocator::value_type, Allocator>> type;
+    static const bool is_tracked = true;
+};
+
+template <typename Key, typename Value, std::size_t N, std::size_t HashFunc, std::size_t Alignment,
+          typename Hasher, typename KeyEqual, typename Allocator>
+struct TrackedContainer<jstd::BasicSmallDictionary<Key, Value, N, HashFunc, Alignment, Hasher, KeyEqual, Allocator>> {
+    typedef jstd::BasicSmallDictionary<Key, Value, N, HashFunc, Alignment, Hasher, KeyEqual,
+                                       jstd::tracking_allocator<typename Allocator::value_type, Allocator>> type;
+    static const bool is_tracked = true;
+};
+
+static inline
+void print_allocation_stats(const char * name, const jstd::allocation_stats & stats,
+                            std::size_t entries)
+{
+    printf("%-40s live: %9" PRIuPTR " bytes, peak: %9" PRIuPTR " bytes, "
+           "%8.2f bytes/entry, allocs: %" PRIuPTR ", frees: %" PRIuPTR "\n",
+           name, stats.live_bytes.load(), stats.peak_bytes.load(), stats.bytes_per_entry(entries),
+           stats.alloc_count.load(), stats.dealloc_count.load());
+}
+
+static inline
+void print_allocation_histogram(const jstd::allocation_stats & stats)
+{
+    for (std::size_t i = 0; i < jstd::allocation_stats::kHistogramSize; i++) {
+        if (stats.histogram[i] != 0) {
+            printf("    [%12" PRIuPTR ", %12" PRIuPTR ") bytes: %" PRIuPTR "\n",
+                   (std::size_t(1) << i), (std::size_t(2) << i), stats.histogram[i].load());
+        }
+    }
+}
+
+} // namespace jtest
+
+#endif // JSTD_TEST_MEMORY_TRACKER_H
@@ -0,0 +1,344 @@
+
+#ifndef JSTD_TEST_PERF_COUNTERS_H
+#define JSTD_TEST_PERF_COUNTERS_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>        // For __NR_perf_event_open
+#include <linux/perf_event.h>
+#define JTEST_HAVE_PERF_EVENT   1
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+
+#include <cstdint>
+#include <cstddef>      // For std::size_t
+#include <string>
+
+namespace jtest {
+
+//
+// The hardware events of PerfCounterGroup.
+//
+enum PerfEvent {
+    kPerfCycles,
+    kPerfInstructions,
+    kPerfL1DMisses,
+    kPerfLLCMisses,
+    kPerfDTLBMisses,
+    kPerfBranchMisses,
+    kPerfEventCount
+};
+
+static inline
+const char * get_perf_event_name(std::size_t event) {
+    static const char * const kNames[kPerfEventCount] = {
+        "cycles", "instructions", "L1D-misses", "LLC-misses", "dTLB-misses", "branch-misses"
+    };
+    return (event < kPerfEventCount) ? kNames[event] : "unknown";
+}
+
+//
+// The values of the events, valid[i] is false if the event is unavailable,
+// or it's not counted (the PMU is multiplexed and the group never ran).
+//
+struct PerfCounterValues {
+    double  values[kPerfEventCount];
+    bool    valid[kPerfEventCount];
+
+    PerfCounterValues() {
+        this->clear();
+    }
+
+    void clear() {
+        for (std::size_t i = 0; i < kPerfEventCount; i++) {
+            this->values[i] = 0.0;
+            this->valid[i] = false;
+        }
+    }
+
+    bool has_any() const {
+        for (std::size_t i = 0; i < kPerfEventCount; i++) {
+            if (this->valid[i])
+                return true;
+        }
+        return false;
+    }
+
+    // Instructions per cycle.
+    double ipc() const {
+        if (this->valid[kPerfCycles] && this->valid[kPerfInstructions] &&
+            this->values[kPerfCycles] != 0.0)
+            return (this->values[kPerfInstructions] / this->values[kPerfCycles]);
+        else
+            return 0.0;
+    }
+
+    PerfCounterValues & operator += (const PerfCounterValues & rhs) {
+        for (std::size_t i = 0; i < kPerfEventCount; i++) {
+            if (rhs.valid[i]) {
+                this->values[i] += rhs.values[i];
+                this->valid[i] = true;
+            }
+        }
+        return *this;
+    }
+
+    PerfCounterValues per_operation(double operations) const {
+        PerfCounterValues result(*this);
+        if (operations > 0.0) {
+            for (std::size_t i = 0; i < kPerfEventCount; i++) {
+                result.values[i] /= operations;
+            }
+        }
+        return result;
+    }
+};
+
+//
+// A perf_event_open() counter group of the hardware events, the events are
+// counted for the calling thread in the user mode.
+//
+// It degrades gracefully: if the PMU is not accessible (not Linux, in a VM or
+// a container without the PMU, or perf_event_paranoid is too high), open()
+// returns false, error() tells the reason, and start() / stop() do nothing.
+// The events that can't be opened alone are marked invalid.
+//
+class PerfCounterGroup {
+public:
+    typedef std::size_t size_type;
+
+private:
+    int                 fds_[kPerfEventCount];
+    int                 leader_fd_;
+    size_type           num_opened_;
+    bool                is_running_;
+    std::uint64_t       time_enabled_;      // The times are not reset by PERF_EVENT_IOC_RESET
+    std::uint64_t       time_running_;
+    std::string         error_;
+    PerfCounterValues   totals_;
+
+public:
+    PerfCounterGroup() : leader_fd_(-1), num_opened_(0), is_running_(false),
+                         time_enabled_(0), time_running_(0) {
+        for (std::size_t i = 0; i < kPerfEventCount; i++) {
+            this->fds_[i] = -1;
+        }
+    }
+
+    PerfCounterGroup(const PerfCounterGroup & src) = delete;
+    PerfCounterGroup & operator = (const PerfCounterGroup & rhs) = delete;
+
+    ~PerfCounterGroup() {
+        this->close();
+    }
+
+    bool is_open() const { return (this->leader_fd_ >= 0); }
+    bool is_running() const { return this->is_running_; }
+    size_type num_opened() const { return this->num_opened_; }
+    const std::string & error() const { return this->error_; }
+
+    bool is_event_open(std::size_t event) const {
+        return (event < kPerfEventCount) && (this->fds_[event] >= 0);
+    }
+
+    // The sum of all the counted segments since the last reset().
+    const PerfCounterValues & totals() const { return this->totals_; }
+
+    void reset() {
+        this->totals_.clear();
+    }
+
+    bool open() {
+        if (this->is_open())
+            return true;
+#if defined(JTEST_HAVE_PERF_EVENT)
+        int first_errno = 0;
+        for (std::size_t i = 0; i < kPerfEventCount; i++) {
+            struct perf_event_attr attr;
+            ::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            std::uint32_t type;
+            std::uint64_t config;
+            get_event_config(i, type, config);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = (this->leader_fd_ < 0) ? 1 : 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+                               PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            int fd = static_cast<int>(::syscall(__NR_perf_event_open, &attr, 0, -1,
+                                                this->leader_fd_, 0));
+            if (fd >= 0) {
+                this->fds_[i] = fd;
+                if (this->leader_fd_ < 0)
+                    this->leader_fd_ = fd;
+                this->num_opened_++;
+            }
+            else if (first_errno == 0) {
+                first_errno = errno;
+            }
+        }
+        if (this->leader_fd_ < 0) {
+            this->error_ = std::string("perf_event_open() failed: ") + ::strerror(first_errno);
+            if (first_errno == EACCES || first_errno == EPERM)
+                this->error_ += " (see /proc/sys/kernel/perf_event_paranoid)";
+            return false;
+        }
+        this->error_.clear();
+        return true;
+#else
+        this->error_ = "perf_event_open() is only supported on Linux";
+        return false;
+#endif
+    }
+
+    void close() {
+#if defined(JTEST_HAVE_PERF_EVENT)
+        // Close the followers first, then the leader.
+        for (std::size_t i = kPerfEventCount; i > 0; i--) {
+            int fd = this->fds_[i - 1];
+            if (fd >= 0 && fd != this->leader_fd_)
+                ::close(fd);
+            this->fds_[i - 1] = -1;
+        }
+        if (this->leader_fd_ >= 0)
+            ::close(this->leader_fd_);
+#endif
+        this->leader_fd_ = -1;
+        this->num_opened_ = 0;
+        this->is_running_ = false;
+        this->time_enabled_ = 0;
+        this->time_running_ = 0;
+    }
+
+    void start() {
+#if defined(JTEST_HAVE_PERF_EVENT)
+        if (this->leader_fd_ >= 0 && !this->is_running_) {
+            ::ioctl(this->leader_fd_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ::ioctl(this->leader_fd_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+            this->is_running_ = true;
+        }
+#endif
+    }
+
+    //
+    // Stop the counting, the counts of this segment are added to totals().
+    //
+    void stop() {
+#if defined(JTEST_HAVE_PERF_EVENT)
+        if (this->is_running_) {
+            ::ioctl(this->leader_fd_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+            this->is_running_ = false;
+
+            // { nr, time_enabled, time_running, values[nr] }
+            std::uint64_t buffer[3 + kPerfEventCount];
+            ssize_t bytes = ::read(this->leader_fd_, buffer, sizeof(buffer));
+            if (bytes < (ssize_t)(3 * sizeof(std::uint64_t)))
+                return;
+
+            std::uint64_t nr = buffer[0];
+            std::uint64_t time_enabled = buffer[1] - this->time_enabled_;
+            std::uint64_t time_running = buffer[2] - this->time_running_;
+            this->time_enabled_ = buffer[1];
+            this->time_running_ = buffer[2];
+            if (nr > this->num_opened_)
+                return;
+            if (time_running == 0) {
+                // All the events of a group are scheduled together or not at all.
+                if (time_enabled != 0)
+                    this->error_ = "the counter group can't be scheduled on the PMU";
+                return;
+            }
+
+            // The PMU is multiplexed, scale the counts to the enabled time.
+            double scale = static_cast<double>(time_enabled) / static_cast<double>(time_running);
+            std::size_t index = 0;
+            for (std::size_t i = 0; i < kPerfEventCount; i++) {
+                if (this->fds_[i] >= 0 && index < nr) {
+                    this->totals_.values[i] += static_cast<double>(buffer[3 + index]) * scale;
+                    this->totals_.valid[i] = true;
+                    index++;
+                }
+            }
+        }
+#endif
+    }
+
+private:
+#if defined(JTEST_HAVE_PERF_EVENT)
+    static void get_event_config(std::size_t event, std::uint32_t & type, std::uint64_t & config) {
+        static const std::uint64_t kCacheReadMiss = (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                    (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        switch (event) {
+        case kPerfCycles:
+            type = PERF_TYPE_HARDWARE;
+            config = PERF_COUNT_HW_CPU_CYCLES;
+            break;
+        case kPerfInstructions:
+            type = PERF_TYPE_HARDWARE;
+            config = PERF_COUNT_HW_INSTRUCTIONS;
+            break;
+        case kPerfL1DMisses:
+            type = PERF_TYPE_HW_CACHE;
+            config = PERF_COUNT_HW_CACHE_L1D | kCacheReadMiss;
+            break;
+        case kPerfLLCMisses:
+            type = PERF_TYPE_HARDWARE;
+            config = PERF_COUNT_HW_CACHE_MISSES;
+            break;
+        case kPerfDTLBMisses:
+            type = PERF_TYPE_HW_CACHE;
+            config = PERF_COUNT_HW_CACHE_DTLB | kCacheReadMiss;
+            break;
+        case kPerfBranchMisses:
+        default:
+            type = PERF_TYPE_HARDWARE;
+            config = PERF_COUNT_HW_BRANCH_MISSES;
+            break;
+        }
+    }
+#endif // JTEST_HAVE_PERF_EVENT
+};
+
+//
+// Count the events of a scope, like jtest::StopWatch:
+//
+//   jtest::PerfCounterGroup counters;
+//   counters.open();
+//   {
+//       jtest::PerfCounterScope scope(counters);
+//       for (std::size_t i = 0; i < keys.size(); i++)
+//           dict.find(keys[i]);
+//   }
+//   double misses = counters.totals().values[jtest::kPerfLLCMisses];
+//
+class PerfCounterScope {
+private:
+    PerfCounterGroup & group_;
+
+public:
+    explicit PerfCounterScope(PerfCounterGroup & group) : group_(group) {
+        this->group_.start();
+    }
+
+    PerfCounterScope(const PerfCounterScope & src) = delete;
+    PerfCounterScope & operator = (const PerfCounterScope & rhs) = delete;
+
+    ~PerfCounterScope() {
+        this->group_.stop();
+    }
+};
+
+} // namespace jtest
+
+#endif // JSTD_TEST_PERF_COUNTERS_H
@@ -6,7 +6,11 @@
 #pragma once
 #endif
 
-#include <time.h>       // For ::clock()
+#include <time.h>       // For ::clock(), ::clock_gettime()
+
+#if defined(_MSC_VER)
+#include <intrin.h>     // For __cpuid(), __rdtsc(), __rdtscp(), _mm_lfence()
+#endif
 
 #if defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
 #ifndef WIN32_LEAN_AND_MEAN
@@ -30,6 +34,22 @@
 #include <chrono>
 #endif
 
+#include <cstdint>
+#include <algorithm>    // For std::sort()
+
+//
+// Use the calibrated TSC stopwatch (rdtscStopWatchImpl) as jtest::StopWatch,
+// it's the stopwatch of jtest::BenchmarkRunner.
+//
+#ifndef JTEST_USE_RDTSC_STOPWATCH
+#define JTEST_USE_RDTSC_STOPWATCH   0
+#endif
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define JTEST_HAVE_CPUID            1
+#define JTEST_HAVE_RDTSC            1
+#endif
+
 #ifndef __COMPILER_BARRIER
 #if defined(_MSC_VER) || defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
 #include <intrin.h>
@@ -105,6 +125,271 @@ public:
 
 } // namespace detail
 
+namespace detail {
+
+#if defined(JTEST_HAVE_CPUID)
+
+//
+// The same as the cpuid() of tools/cpuid/cpuid_x86.c
+//
+static inline
+void cpuid(unsigned int op, unsigned int regs[4]) {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int cpu_info[4] = { -1 };
+    __cpuid(cpu_info, (int)op);
+    regs[0] = (unsigned int)cpu_info[0];
+    regs[1] = (unsigned int)cpu_info[1];
+    regs[2] = (unsigned int)cpu_info[2];
+    regs[3] = (unsigned int)cpu_info[3];
+#elif defined(__i386__) && defined(__PIC__)
+    __asm__ __volatile__
+    ("mov %%ebx, %%edi;"
+     "cpuid;"
+     "xchgl %%ebx, %%edi;"
+     : "=a" (regs[0]), "=D" (regs[1]), "=c" (regs[2]), "=d" (regs[3]) : "a" (op), "c" (0) : "cc");
+#else
+    __asm__ __volatile__
+    ("cpuid" : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3]) : "a" (op), "c" (0) : "cc");
+#endif
+}
+
+#endif // JTEST_HAVE_CPUID
+
+//
+// The TSC (Time Stamp Counter) clock.
+//
+// The reading is serialized: "RDTSCP; LFENCE" waits for all the previous
+// instructions to finish, and the later instructions can't begin before it.
+// It's used for both the start and the stop of a measurement, if RDTSCP is
+// not supported, "LFENCE; RDTSC; LFENCE" is used instead.
+//
+// The frequency of TSC is calibrated against CLOCK_MONOTONIC_RAW (the raw
+// hardware clock, not adjusted by NTP) when it's first used, and the overhead
+// of a back-to-back reading is subtracted from the measured durations.
+//
+// On the other architectures, the ticks are the nanoseconds of the monotonic clock.
+//
+template <typename T = void>
+class basic_tsc_clock {
+public:
+    typedef std::uint64_t   tick_t;
+
+    struct calibration_t {
+        double  frequency;      // The ticks per second
+        tick_t  overhead;       // The ticks of a back-to-back reading
+        bool    is_invariant;   // Runs at a constant rate in all the P-, C- and T-states
+
+        calibration_t() : frequency(1000000000.0), overhead(0), is_invariant(false) {}
+    };
+
+private:
+    static bool s_has_rdtscp;
+
+    static calibration_t & get_calibration() {
+        static calibration_t s_calibration = calibrate_impl(50.0);
+        return s_calibration;
+    }
+
+public:
+    static bool has_rdtscp() { return s_has_rdtscp; }
+
+    static bool is_invariant() { return get_calibration().is_invariant; }
+    static double frequency() { return get_calibration().frequency; }
+    static tick_t overhead() { return get_calibration().overhead; }
+
+    static const calibration_t & calibration() {
+        return get_calibration();
+    }
+
+    //
+    // Calibrate it again, the total time is about millisecs.
+    //
+    static const calibration_t & calibrate(double millisecs = 50.0) {
+        calibration_t & calibration = get_calibration();
+        calibration = calibrate_impl(millisecs);
+        return calibration;
+    }
+
+    static tick_t now() {
+#if defined(JTEST_HAVE_RDTSC)
+  #if defined(_MSC_VER) && !defined(__clang__)
+        if (s_has_rdtscp) {
+            unsigned int aux;
+            tick_t tick = __rdtscp(&aux);
+            _mm_lfence();
+            return tick;
+        }
+        else {
+            _mm_lfence();
+            tick_t tick = __rdtsc();
+            _mm_lfence();
+            return tick;
+        }
+  #else
+        unsigned int lo, hi, aux;
+        if (s_has_rdtscp) {
+            __asm__ __volatile__ ("rdtscp\n\t"
+                                  "lfence"
+                                  : "=a" (lo), "=d" (hi), "=c" (aux) : : "memory");
+        }
+        else {
+            __asm__ __volatile__ ("lfence\n\t"
+                                  "rdtsc\n\t"
+                                  "lfence"
+                                  : "=a" (lo), "=d" (hi) : : "memory");
+        }
+        return ((static_cast<tick_t>(hi) << 32) | lo);
+  #endif
+#else
+        return monotonic_raw_ns();
+#endif // JTEST_HAVE_RDTSC
+    }
+
+    //
+    // The ticks between two readings, the reading overhead is subtracted.
+    //
+    static tick_t interval(tick_t now_tick, tick_t old_tick) {
+        tick_t ticks = (now_tick > old_tick) ? (now_tick - old_tick) : 0;
+        tick_t overhead = get_calibration().overhead;
+        return (ticks > overhead) ? (ticks - overhead) : 0;
+    }
+
+    static double to_seconds(tick_t ticks) {
+        return (static_cast<double>(ticks) / get_calibration().frequency);
+    }
+
+    static std::uint64_t monotonic_raw_ns() {
+#if defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
+        LARGE_INTEGER counter, frequency;
+        ::QueryPerformanceCounter(&counter);
+        ::QueryPerformanceFrequency(&frequency);
+        return static_cast<std::uint64_t>(static_cast<double>(counter.QuadPart) * 1000000000.0 /
+                                          static_cast<double>(frequency.QuadPart));
+#elif defined(CLOCK_MONOTONIC_RAW) || defined(CLOCK_MONOTONIC)
+        struct timespec ts;
+  #if defined(CLOCK_MONOTONIC_RAW)
+        ::clock_gettime(CLOCK_MONOTONIC_RAW, &ts);
+  #else
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+  #endif
+        return (static_cast<std::uint64_t>(ts.tv_sec) * 1000000000ULL +
+                static_cast<std::uint64_t>(ts.tv_nsec));
+#else
+        timeval tv;
+        ::gettimeofday(&tv, nullptr);
+        return (static_cast<std::uint64_t>(tv.tv_sec) * 1000000000ULL +
+                static_cast<std::uint64_t>(tv.tv_usec) * 1000ULL);
+#endif
+    }
+
+private:
+    static bool detect_rdtscp() {
+#if defined(JTEST_HAVE_CPUID)
+        unsigned int regs[4];
+        cpuid(0x80000000U, regs);
+        if (regs[0] >= 0x80000001U) {
+            cpuid(0x80000001U, regs);
+            // CPUID.80000001H:EDX[27]
+            return ((regs[3] & (1U << 27)) != 0);
+        }
+#endif
+        return false;
+    }
+
+    static bool detect_invariant_tsc() {
+#if defined(JTEST_HAVE_CPUID)
+        unsigned int regs[4];
+        cpuid(0x80000000U, regs);
+        if (regs[0] >= 0x80000007U) {
+            cpuid(0x80000007U, regs);
+            // CPUID.80000007H:EDX[8]
+            return ((regs[3] & (1U << 8)) != 0);
+        }
+#endif
+        return false;
+    }
+
+    //
+    // Read the TSC and the reference clock at the same time,
+    // the TSC is the midpoint of the two readings around the reference clock,
+    // the pair with the smallest gap of 5 tries is used.
+    //
+    static void sample_pair(tick_t & tick, std::uint64_t & ref_ns) {
+        tick_t min_gap = tick_t(-1);
+        for (int i = 0; i < 5; i++) {
+            tick_t tick1 = now();
+            std::uint64_t ns = monotonic_raw_ns();
+            tick_t tick2 = now();
+            tick_t gap = tick2 - tick1;
+            if (gap < min_gap) {
+                min_gap = gap;
+                tick = tick1 + gap / 2;
+                ref_ns = ns;
+            }
+        }
+    }
+
+    static calibration_t calibrate_impl(double millisecs) {
+        static const int kRounds = 5;
+        static const int kOverheadRounds = 9;
+        static const int kOverheadLoops = 200;
+
+        calibration_t calibration;
+        s_has_rdtscp = detect_rdtscp();
+        calibration.is_invariant = detect_invariant_tsc();
+
+        // The minimum of a round is the overhead, the others are interrupted or
+        // delayed. A single minimum jitters by a few ticks from run to run, so the
+        // median of the minimums of the rounds is used.
+        tick_t overheads[kOverheadRounds];
+        for (int round = 0; round < kOverheadRounds; round++) {
+            tick_t overhead = tick_t(-1);
+            for (int i = 0; i < kOverheadLoops; i++) {
+                tick_t tick1 = now();
+                tick_t tick2 = now();
+                if ((tick2 - tick1) < overhead)
+                    overhead = tick2 - tick1;
+            }
+            overheads[round] = overhead;
+        }
+        std::sort(&overheads[0], &overheads[kOverheadRounds]);
+        calibration.overhead = overheads[kOverheadRounds / 2];
+
+#if defined(JTEST_HAVE_RDTSC)
+        std::uint64_t round_ns = static_cast<std::uint64_t>(millisecs * 1000000.0 / kRounds);
+        if (round_ns < 1000000)
+            round_ns = 1000000;
+
+        double frequencies[kRounds];
+        for (int round = 0; round < kRounds; round++) {
+            tick_t tick1, tick2;
+            std::uint64_t ns1, ns2;
+            sample_pair(tick1, ns1);
+            do {
+                sample_pair(tick2, ns2);
+            } while ((ns2 - ns1) < round_ns);
+            frequencies[round] = static_cast<double>(tick2 - tick1) * 1000000000.0 /
+                                 static_cast<double>(ns2 - ns1);
+        }
+        // The median of the rounds.
+        std::sort(&frequencies[0], &frequencies[kRounds]);
+        calibration.frequency = frequencies[kRounds / 2];
+#else
+        (void)millisecs;
+        calibration.frequency = 1000000000.0;
+        calibration.is_invariant = true;
+#endif
+        return calibration;
+    }
+};
+
+template <typename T>
+bool basic_tsc_clock<T>::s_has_rdtscp = basic_tsc_clock<T>::detect_rdtscp();
+
+} // namespace detail
+
+typedef detail::basic_tsc_clock<void>   TscClock;
+
 template <typename T>
 class StopWatchBase {
 public:
@@ -356,8 +641,8 @@ public:
     }
 
     time_float_t getDurationTime() const {
-        detail::duration_time<time_float_t> _duration_time = impl_type::duration_time(stop_time_, start_time_);
-        return _duration_time;
+        detail::duration_time<time_float_t> _duration_time(impl_type::duration_time(stop_time_, start_time_));
+        return _duration_time.seconds();
     }
 
     time_float_t getDurationMicrosec() {
@@ -528,6 +813,48 @@ public:
     }
 };
 
+//
+// The stopwatch of the serialized TSC readings, it can time a short operation
+// (tens of nanoseconds), see TscClock. The time stamp is in nanosecond.
+//
+template <typename TimeFloatTy>
+class rdtscStopWatchImpl {
+public:
+    typedef TimeFloatTy                                     time_float_t;
+    typedef std::uint64_t                                   time_stamp_t;
+    typedef TscClock::tick_t                                time_point_t;
+    typedef time_float_t                                    duration_type;
+    typedef rdtscStopWatchImpl<TimeFloatTy>                 this_type;
+
+private:
+    // Calibrate the TSC at startup, not at the first measurement.
+    static const bool s_is_calibrated;
+
+public:
+    rdtscStopWatchImpl() {}
+    ~rdtscStopWatchImpl() {}
+
+    static time_point_t now() {
+        return TscClock::now();
+    }
+
+    static time_float_t duration_time(time_point_t now_time, time_point_t old_time) {
+        (void)s_is_calibrated;
+        return static_cast<time_float_t>(TscClock::to_seconds(TscClock::interval(now_time, old_time)));
+    }
+
+    static time_stamp_t timestamp(time_point_t now_time, time_point_t base_time) {
+        return static_cast<time_stamp_t>(this_type::duration_time(now_time, base_time) *
+                                         TimeRatio<time_float_t>::nanosecs);
+    }
+};
+
+template <typename TimeFloatTy>
+const bool rdtscStopWatchImpl<TimeFloatTy>::s_is_calibrated = (TscClock::frequency() > 0.0);
+
+typedef StopWatchBase< rdtscStopWatchImpl<double> >         rdtscStopWatch;
+typedef StopWatchExBase< rdtscStopWatchImpl<double> >       rdtscStopWatchEx;
+
 #if HAVE_STD_CHRONO_H
 
 template <typename TimeFloatTy>
@@ -563,8 +890,13 @@ public:
     }
 };
 
+#if JTEST_USE_RDTSC_STOPWATCH
+typedef StopWatchBase< rdtscStopWatchImpl<double> >         StopWatch;
+typedef StopWatchExBase< rdtscStopWatchImpl<double> >       StopWatchEx;
+#else
 typedef StopWatchBase< StdStopWatchImpl<double> >           StopWatch;
 typedef StopWatchExBase< StdStopWatchImpl<double> >         StopWatchEx;
+#endif
 
 typedef StopWatchBase< StdStopWatchImpl<double> >           defaultStopWatch;
 typedef StopWatchExBase< StdStopWatchImpl<double> >         defaultStopWatchEx;
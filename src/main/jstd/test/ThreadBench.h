@@ -0,0 +1,748 @@
+
+#ifndef JSTD_TEST_THREAD_BENCH_H
+#define JSTD_TEST_THREAD_BENCH_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#if defined(__linux__)
+#include <sched.h>      // For sched_setaffinity(), sched_getaffinity()
+#if !defined(NO_AFFINITY)
+#define JTEST_HAVE_THREAD_AFFINITY  1
+#endif
+#elif defined(_WIN32) || defined(WIN32) || defined(OS_WINDOWS) || defined(_WINDOWS_)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#if !defined(NO_AFFINITY)
+#define JTEST_HAVE_THREAD_AFFINITY  1
+#endif
+#endif // __linux__
+
+#if defined(_M_X64) || defined(_M_AMD64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#include <emmintrin.h>  // For _mm_pause()
+#define JTEST_CPU_PAUSE()   _mm_pause()
+#else
+#define JTEST_CPU_PAUSE()   (void)0
+#endif
+
+#include <stdio.h>
+
+#include <cstdint>
+#include <cstddef>      // For std::size_t
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>       // For std::unique_ptr<T>
+#include <atomic>
+#include <thread>
+#include <chrono>       // For std::chrono::steady_clock
+#include <algorithm>    // For std::sort()
+
+#include "jstd/test/LatencyHistogram.h"
+#include "jstd/test/BenchmarkRunner.h"
+
+namespace jtest {
+
+//
+// A logical CPU and its place in the topology.
+//
+struct CpuInfo {
+    int     cpu;            // The logical CPU id
+    int     core_id;        // The physical core id in the package
+    int     package_id;
+    int     smt_index;      // The index of the SMT siblings of the core, 0 is the first thread
+
+    CpuInfo() : cpu(0), core_id(0), package_id(0), smt_index(0) {}
+};
+
+//
+// How to place the worker threads on the logical CPUs.
+//
+enum ThreadPlacement {
+    kPlaceNone,             // Not pinned, the scheduler decides
+    kPlaceSpread,           // One thread per physical core first, then the SMT siblings
+    kPlaceCompact,          // Fill the SMT siblings of a core first
+    kPlacementCount
+};
+
+static inline
+const char * get_placement_name(std::size_t placement) {
+    static const char * const kNames[kPlacementCount] = {
+        "none", "spread", "compact"
+    };
+    return (placement < kPlacementCount) ? kNames[placement] : "unknown";
+}
+
+//
+// The logical CPUs that the process is allowed to run on, and their cores:
+// two logical CPUs on the same (package, core) are the SMT siblings, they
+// share the execution units and the L1/L2 caches, so the threads on them
+// don't scale like the threads on the different cores.
+//
+// The topology is read from /sys/devices/system/cpu/cpu<n>/topology on Linux,
+// otherwise every logical CPU is a core.
+//
+class CpuTopology {
+public:
+    typedef std::size_t size_type;
+
+private:
+    std::vector<CpuInfo>    cpus_;      // Sorted by the cpu id
+    size_type               cores_;
+    bool                    is_detected_;
+
+public:
+    CpuTopology() : cores_(0), is_detected_(false) {
+        this->detect();
+    }
+    ~CpuTopology() {}
+
+    static const CpuTopology & get() {
+        static CpuTopology s_topology;
+        return s_topology;
+    }
+
+    const std::vector<CpuInfo> & cpus() const { return this->cpus_; }
+
+    size_type logical_cpus() const { return this->cpus_.size(); }
+    size_type physical_cores() const { return this->cores_; }
+
+    bool has_smt() const { return (this->cpus_.size() > this->cores_); }
+
+    // The SMT topology is read from the system, not guessed.
+    bool is_detected() const { return this->is_detected_; }
+
+    const CpuInfo * find(int cpu) const {
+        for (std::size_t i = 0; i < this->cpus_.size(); i++) {
+            if (this->cpus_[i].cpu == cpu)
+                return &this->cpus_[i];
+        }
+        return nullptr;
+    }
+
+    bool are_siblings(int cpu1, int cpu2) const {
+        const CpuInfo * info1 = this->find(cpu1);
+        const CpuInfo * info2 = this->find(cpu2);
+        if (info1 == nullptr || info2 == nullptr || cpu1 == cpu2)
+            return false;
+        return (info1->package_id == info2->package_id && info1->core_id == info2->core_id);
+    }
+
+    //
+    // The logical CPUs of the threads, -1 means not pinned. If there are more
+    // threads than the logical CPUs, the CPUs are reused round-robin.
+    //
+    std::vector<int> placement(size_type threads, ThreadPlacement placement) const {
+        std::vector<int> result(threads, -1);
+        if (placement == kPlaceNone || this->cpus_.empty())
+            return result;
+
+        std::vector<CpuInfo> order(this->cpus_);
+        if (placement == kPlaceSpread)
+            std::sort(order.begin(), order.end(), less_spread);
+        else
+            std::sort(order.begin(), order.end(), less_compact);
+
+        for (size_type i = 0; i < threads; i++) {
+            result[i] = order[i % order.size()].cpu;
+        }
+        return result;
+    }
+
+    // The threads that share a physical core with a thread before them.
+    size_type shared_cores(const std::vector<int> & cpus) const {
+        size_type shared = 0;
+        for (std::size_t i = 0; i < cpus.size(); i++) {
+            if (cpus[i] < 0)
+                continue;
+            for (std::size_t j = 0; j < i; j++) {
+                if (cpus[j] == cpus[i] || this->are_siblings(cpus[j], cpus[i])) {
+                    shared++;
+                    break;
+                }
+            }
+        }
+        return shared;
+    }
+
+    void print() const {
+        printf(" CPU topology: %" PRIuPTR " logical CPUs, %" PRIuPTR " physical cores, SMT = %s%s\n",
+               this->logical_cpus(), this->physical_cores(),
+               this->has_smt() ? "yes" : "no",
+               this->is_detected_ ? "" : " (not detected)");
+    }
+
+private:
+    static bool less_spread(const CpuInfo & a, const CpuInfo & b) {
+        if (a.smt_index != b.smt_index)
+            return (a.smt_index < b.smt_index);
+        return (a.cpu < b.cpu);
+    }
+
+    static bool less_compact(const CpuInfo & a, const CpuInfo & b) {
+        if (a.package_id != b.package_id)
+            return (a.package_id < b.package_id);
+        if (a.core_id != b.core_id)
+            return (a.core_id < b.core_id);
+        return (a.smt_index < b.smt_index);
+    }
+
+    static bool read_int(const char * path, int & value) {
+        FILE * fp = ::fopen(path, "r");
+        if (fp == nullptr)
+            return false;
+        bool is_ok = (::fscanf(fp, "%d", &value) == 1);
+        ::fclose(fp);
+        return is_ok;
+    }
+
+    void detect() {
+        std::vector<int> allowed;
+#if defined(__linux__)
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        if (::sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &cpu_set))
+                    allowed.push_back(cpu);
+            }
+        }
+#endif
+        if (allowed.empty()) {
+            unsigned int count = std::thread::hardware_concurrency();
+            if (count == 0)
+                count = 1;
+            for (unsigned int cpu = 0; cpu < count; cpu++) {
+                allowed.push_back(static_cast<int>(cpu));
+            }
+        }
+
+        this->is_detected_ = true;
+        this->cpus_.clear();
+        for (std::size_t i = 0; i < allowed.size(); i++) {
+            CpuInfo info;
+            info.cpu = allowed[i];
+            info.core_id = allowed[i];
+            info.package_id = 0;
+#if defined(__linux__)
+            char path[128];
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/core_id", info.cpu);
+            bool has_core = read_int(path, info.core_id);
+            snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/topology/physical_package_id", info.cpu);
+            bool has_package = read_int(path, info.package_id);
+            if (!has_core || !has_package) {
+                info.core_id = info.cpu;
+                info.package_id = 0;
+                this->is_detected_ = false;
+            }
+#else
+            this->is_detected_ = false;
+#endif
+            this->cpus_.push_back(info);
+        }
+
+        this->cores_ = 0;
+        for (std::size_t i = 0; i < this->cpus_.size(); i++) {
+            int smt_index = 0;
+            for (std::size_t j = 0; j < i; j++) {
+                if (this->cpus_[j].package_id == this->cpus_[i].package_id &&
+                    this->cpus_[j].core_id == this->cpus_[i].core_id)
+                    smt_index++;
+            }
+            this->cpus_[i].smt_index = smt_index;
+            if (smt_index == 0)
+                this->cores_++;
+        }
+    }
+};
+
+//
+// Pin the calling thread to a logical CPU. It's unsupported if the platform
+// has no affinity API, or NO_AFFINITY is defined.
+//
+struct ThreadAffinity {
+    static bool is_supported() {
+#if defined(JTEST_HAVE_THREAD_AFFINITY)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static bool pin_current_thread(int cpu) {
+        if (cpu < 0)
+            return false;
+#if defined(JTEST_HAVE_THREAD_AFFINITY)
+#if defined(__linux__)
+        if (cpu >= CPU_SETSIZE)
+            return false;
+        cpu_set_t cpu_set;
+        CPU_ZERO(&cpu_set);
+        CPU_SET(cpu, &cpu_set);
+        return (::sched_setaffinity(0, sizeof(cpu_set), &cpu_set) == 0);
+#else
+        if (cpu >= static_cast<int>(sizeof(DWORD_PTR) * 8))
+            return false;
+        return (::SetThreadAffinityMask(::GetCurrentThread(), DWORD_PTR(1) << cpu) != 0);
+#endif
+#else
+        return false;
+#endif // JTEST_HAVE_THREAD_AFFINITY
+    }
+};
+
+//
+// A reusable sense-reversing barrier, the waiting threads spin on a cache line
+// instead of sleeping, so they are released within a few hundred cycles.
+// It yields after a while, in case the threads are more than the CPUs.
+//
+class SpinBarrier {
+public:
+    typedef std::size_t size_type;
+
+    static const size_type kSpinsBeforeYield = 4096;
+
+private:
+    std::atomic<size_type>  count_;
+    std::atomic<size_type>  generation_;
+    size_type               threads_;
+
+public:
+    explicit SpinBarrier(size_type threads)
+        : count_(threads), generation_(0), threads_(threads) {
+    }
+    ~SpinBarrier() {}
+
+    SpinBarrier(const SpinBarrier &) = delete;
+    SpinBarrier & operator = (const SpinBarrier &) = delete;
+
+    size_type threads() const { return this->threads_; }
+
+    // Return true on the last arrived thread.
+    bool wait() {
+        size_type generation = this->generation_.load(std::memory_order_acquire);
+        if (this->count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            this->count_.store(this->threads_, std::memory_order_relaxed);
+            this->generation_.fetch_add(1, std::memory_order_release);
+            return true;
+        }
+
+        size_type spins = 0;
+        while (this->generation_.load(std::memory_order_acquire) == generation) {
+            if (spins < kSpinsBeforeYield) {
+                JTEST_CPU_PAUSE();
+                spins++;
+            }
+            else {
+                std::this_thread::yield();
+            }
+        }
+        return false;
+    }
+};
+
+class ThreadBench;
+
+//
+// The context of a worker thread, the worker reports the operations it did
+// by add_operations(), and times the sampled operations by sampler().
+//
+class ThreadContext {
+public:
+    typedef std::size_t                             size_type;
+    typedef std::chrono::steady_clock               clock_type;
+    typedef std::chrono::steady_clock::time_point   time_point;
+
+private:
+    size_type           thread_id_;
+    size_type           thread_count_;
+    int                 cpu_;
+    bool                is_pinned_;
+    std::uint64_t       operations_;
+    double              elapsed_time_;      // In millisecond
+    time_point          start_time_;
+    time_point          stop_time_;
+    LatencyHistogram    histogram_;
+    LatencySampler      sampler_;
+
+    friend class ThreadBench;
+
+public:
+    ThreadContext(size_type thread_id, size_type thread_count, int cpu, size_type sample_rate)
+        : thread_id_(thread_id), thread_count_(thread_count), cpu_(cpu), is_pinned_(false),
+          operations_(0), elapsed_time_(0.0), start_time_(), stop_time_(),
+          histogram_(), sampler_(histogram_, sample_rate) {
+    }
+    ~ThreadContext() {}
+
+    size_type thread_id() const { return this->thread_id_; }
+    size_type thread_count() const { return this->thread_count_; }
+
+    int cpu() const { return this->cpu_; }
+    bool is_pinned() const { return this->is_pinned_; }
+
+    std::uint64_t operations() const { return this->operations_; }
+    double elapsed_millisec() const { return this->elapsed_time_; }
+
+    void add_operations(std::uint64_t operations) {
+        this->operations_ += operations;
+    }
+
+    LatencySampler & sampler() { return this->sampler_; }
+    const LatencyHistogram & histogram() const { return this->histogram_; }
+};
+
+//
+// The result of a threaded case, the per-thread values are of the median run.
+//
+struct ThreadBenchResult {
+    typedef std::size_t size_type;
+
+    BenchmarkStats              stats;              // ns/op of the aggregate throughput
+    size_type                   threads;
+    ThreadPlacement             placement;
+    size_type                   pinned_threads;
+    size_type                   shared_cores;       // The threads share a core with another
+    std::vector<int>            thread_cpus;
+    std::vector<std::uint64_t>  thread_operations;
+    std::vector<double>         thread_millisecs;
+    double                      throughput;         // Operations per second
+    double                      efficiency;         // The throughput / (threads x baseline per thread)
+    double                      imbalance;          // (max - min) / mean of the per-thread operations/s
+
+    ThreadBenchResult()
+        : threads(0), placement(kPlaceNone), pinned_threads(0), shared_cores(0),
+          throughput(0.0), efficiency(0.0), imbalance(0.0) {
+    }
+
+    // The throughput of a thread, operations per second.
+    double thread_throughput(size_type index) const {
+        return (this->thread_millisecs[index] > 0.0) ?
+               (static_cast<double>(this->thread_operations[index]) * 1000.0 / this->thread_millisecs[index]) : 0.0;
+    }
+};
+
+//
+// The multithreaded benchmark harness, usage:
+//
+//   jtest::ThreadBench bench(&s_runner);
+//   bench.scaling("hash_map/find", jtest::ThreadBench::thread_counts(),
+//       [&](jtest::ThreadContext & context) {
+//           std::size_t found = 0;
+//           for (std::size_t i = context.thread_id(); i < keys.size(); i++) {
+//               context.sampler().start();
+//               found += (hashmap.find(keys[i]) != hashmap.end());
+//               context.sampler().stop();
+//           }
+//           jtest::DoNotOptimize(found);
+//           context.add_operations(keys.size() - context.thread_id());
+//       });
+//
+// Every run spawns N worker threads, each one pins itself to its CPU (see
+// ThreadPlacement), then the workers meet at a SpinBarrier, so they start
+// together. The run is timed by the workers themselves, from the first start
+// to the last stop (a steady clock, it's comparable across the CPUs), so it
+// doesn't depend on when the main thread is scheduled. The function is called by the workers at the same time, it must
+// be thread-safe, and it should report its operations by add_operations().
+//
+// The aggregate time per operation is added to the BenchmarkRunner (if any),
+// so it follows the filters and is written to the reports, with the labels
+// "threads", "placement", "throughput" (Mops/s) and "efficiency".
+//
+class ThreadBench {
+public:
+    typedef std::size_t                         size_type;
+    typedef std::unique_ptr<ThreadContext>      context_ptr;
+
+private:
+    BenchmarkRunner *               runner_;
+    ThreadPlacement                 placement_;
+    size_type                       repetitions_;
+    size_type                       warmup_;
+    size_type                       latency_sample_;
+    std::deque<ThreadBenchResult>   results_;
+
+public:
+    explicit ThreadBench(BenchmarkRunner * runner = nullptr, ThreadPlacement placement = kPlaceSpread)
+        : runner_(runner), placement_(placement), repetitions_(5), warmup_(1), latency_sample_(16) {
+        if (runner != nullptr) {
+            this->repetitions_ = runner->options().repetitions;
+            this->warmup_ = runner->options().warmup;
+            this->latency_sample_ = runner->options().latency_sample;
+        }
+        if (!ThreadAffinity::is_supported())
+            this->placement_ = kPlaceNone;
+    }
+    ~ThreadBench() {}
+
+    ThreadPlacement placement() const { return this->placement_; }
+    size_type repetitions() const { return this->repetitions_; }
+    size_type warmup() const { return this->warmup_; }
+
+    const std::deque<ThreadBenchResult> & results() const { return this->results_; }
+
+    void set_placement(ThreadPlacement placement) {
+        this->placement_ = ThreadAffinity::is_supported() ? placement : kPlaceNone;
+    }
+
+    void set_repetitions(size_type repetitions) {
+        this->repetitions_ = (repetitions != 0) ? repetitions : 1;
+    }
+
+    void set_warmup(size_type warmup) {
+        this->warmup_ = warmup;
+    }
+
+    //
+    // 1, 2, 4, ... up to max_threads (the logical CPUs if it's 0),
+    // max_threads is always the last one.
+    //
+    static std::vector<size_type> thread_counts(size_type max_threads = 0) {
+        if (max_threads == 0)
+            max_threads = CpuTopology::get().logical_cpus();
+        if (max_threads == 0)
+            max_threads = 1;
+        std::vector<size_type> counts;
+        for (size_type n = 1; n < max_threads; n *= 2) {
+            counts.push_back(n);
+        }
+        counts.push_back(max_threads);
+        return counts;
+    }
+
+    //
+    // Run the function on the threads, the efficiency is computed against
+    // the baseline (normally the one thread result) if it's not null.
+    //
+    template <typename Func>
+    const ThreadBenchResult * run(const std::string & name, size_type threads, const Func & func,
+                                  const ThreadBenchResult * baseline = nullptr) {
+        if (this->runner_ != nullptr) {
+            if (!this->runner_->is_selected(name))
+                return nullptr;
+            if (this->runner_->options().list_only) {
+                printf(" %s\n", name.c_str());
+                return nullptr;
+            }
+        }
+        if (threads == 0)
+            threads = 1;
+
+        const CpuTopology & topology = CpuTopology::get();
+
+        ThreadBenchResult result;
+        result.threads = threads;
+        result.placement = this->placement_;
+        result.thread_cpus = topology.placement(threads, this->placement_);
+        result.shared_cores = topology.shared_cores(result.thread_cpus);
+
+        std::vector<context_ptr> contexts(threads);
+        for (size_type i = 0; i < threads; i++) {
+            contexts[i].reset(new ThreadContext(i, threads, result.thread_cpus[i], this->latency_sample_));
+        }
+
+        for (size_type n = 0; n < this->warmup_; n++) {
+            this->run_once(contexts, func);
+        }
+        for (size_type i = 0; i < threads; i++) {
+            contexts[i]->histogram_.reset();
+        }
+
+        std::vector<std::vector<std::uint64_t>> run_operations;
+        std::vector<std::vector<double>> run_millisecs;
+        for (size_type n = 0; n < this->repetitions_; n++) {
+            double elapsed_time = this->run_once(contexts, func);
+            std::uint64_t operations = 0;
+            std::vector<std::uint64_t> thread_operations(threads);
+            std::vector<double> thread_millisecs(threads);
+            for (size_type i = 0; i < threads; i++) {
+                thread_operations[i] = contexts[i]->operations_;
+                thread_millisecs[i] = contexts[i]->elapsed_time_;
+                operations += contexts[i]->operations_;
+            }
+            if (operations == 0)
+                operations = 1;
+            result.stats.samples.push_back(elapsed_time * 1000000.0 / static_cast<double>(operations));
+            run_operations.push_back(thread_operations);
+            run_millisecs.push_back(thread_millisecs);
+        }
+
+        result.pinned_threads = 0;
+        for (size_type i = 0; i < threads; i++) {
+            if (contexts[i]->is_pinned_)
+                result.pinned_threads++;
+        }
+
+        // The per-thread values of the median run.
+        size_type median_run = 0;
+        {
+            std::vector<double> sorted(result.stats.samples);
+            std::sort(sorted.begin(), sorted.end());
+            double median = sorted[(sorted.size() - 1) / 2];
+            for (size_type n = 0; n < result.stats.samples.size(); n++) {
+                if (result.stats.samples[n] == median) {
+                    median_run = n;
+                    break;
+                }
+            }
+        }
+        result.thread_operations = run_operations[median_run];
+        result.thread_millisecs = run_millisecs[median_run];
+
+        LatencyHistogram histogram;
+        for (size_type i = 0; i < threads; i++) {
+            histogram.merge(contexts[i]->histogram_);
+        }
+        if (histogram.count() != 0)
+            result.stats.latency = histogram.summary(LatencySampler::ns_per_tick());
+
+        result.stats.name = name;
+        result.stats.iterations = 1;
+        result.stats.items_per_iteration = 1;
+        result.stats.warmup_runs = this->warmup_;
+        result.stats.compute();
+
+        result.throughput = (result.stats.median > 0.0) ? (1000000000.0 / result.stats.median) : 0.0;
+        if (baseline != nullptr && baseline->throughput > 0.0 && baseline->threads != 0) {
+            double expected = baseline->throughput * static_cast<double>(threads) /
+                              static_cast<double>(baseline->threads);
+            result.efficiency = result.throughput / expected;
+        }
+        else if (threads == 1) {
+            result.efficiency = 1.0;
+        }
+        result.imbalance = get_imbalance(result);
+
+        if (this->runner_ != nullptr)
+            result.stats.labels = this->runner_->labels();
+        set_labels(result);
+
+        this->results_.push_back(result);
+        const ThreadBenchResult & last = this->results_.back();
+        if (this->runner_ != nullptr)
+            this->runner_->add_result(last.stats);
+        else
+            BenchmarkRunner::print_stats(last.stats);
+        print_result(last);
+        return &last;
+    }
+
+    //
+    // Run the function on each thread count, the cases are named
+    // "<name>/threads=<n>", the efficiency is against the first count.
+    //
+    template <typename Func>
+    size_type scaling(const std::string & name, const std::vector<size_type> & thread_counts,
+                      const Func & func) {
+        const ThreadBenchResult * baseline = nullptr;
+        size_type count = 0;
+        for (std::size_t i = 0; i < thread_counts.size(); i++) {
+            const ThreadBenchResult * result =
+                this->run(name + "/threads=" + std::to_string(thread_counts[i]),
+                          thread_counts[i], func, baseline);
+            if (result != nullptr) {
+                if (baseline == nullptr)
+                    baseline = result;
+                count++;
+            }
+        }
+        return count;
+    }
+
+    static void print_result(const ThreadBenchResult & result) {
+        printf(" %-60s threads: %" PRIuPTR " (%s, pinned %" PRIuPTR ", shared cores %" PRIuPTR "), "
+               "throughput: %0.3f Mops/s",
+               "", result.threads, get_placement_name(result.placement),
+               result.pinned_threads, result.shared_cores, result.throughput / 1000000.0);
+        if (result.efficiency != 0.0)
+            printf(", efficiency: %0.1f%%", result.efficiency * 100.0);
+        if (result.threads > 1)
+            printf(", imbalance: %0.1f%%", result.imbalance * 100.0);
+        printf("\n");
+        ::fflush(stdout);
+    }
+
+private:
+    template <typename Func>
+    double run_once(std::vector<context_ptr> & contexts, const Func & func) {
+        typedef ThreadContext::clock_type clock_type;
+        typedef std::chrono::duration<double, std::milli> millisecs;
+
+        size_type threads = contexts.size();
+        SpinBarrier barrier(threads);
+
+        for (size_type i = 0; i < threads; i++) {
+            contexts[i]->operations_ = 0;
+            contexts[i]->elapsed_time_ = 0.0;
+        }
+
+        std::vector<std::thread> workers;
+        workers.reserve(threads);
+        for (size_type i = 0; i < threads; i++) {
+            ThreadContext * context = contexts[i].get();
+            workers.push_back(std::thread([context, &barrier, &func]() {
+                if (context->cpu_ >= 0)
+                    context->is_pinned_ = ThreadAffinity::pin_current_thread(context->cpu_);
+                barrier.wait();
+
+                context->start_time_ = clock_type::now();
+                func(*context);
+                context->stop_time_ = clock_type::now();
+                context->elapsed_time_ = std::chrono::duration_cast<millisecs>(
+                                             context->stop_time_ - context->start_time_).count();
+            }));
+        }
+
+        for (size_type i = 0; i < threads; i++) {
+            workers[i].join();
+        }
+
+        ThreadContext::time_point start_time = contexts[0]->start_time_;
+        ThreadContext::time_point stop_time = contexts[0]->stop_time_;
+        for (size_type i = 1; i < threads; i++) {
+            if (contexts[i]->start_time_ < start_time)
+                start_time = contexts[i]->start_time_;
+            if (contexts[i]->stop_time_ > stop_time)
+                stop_time = contexts[i]->stop_time_;
+        }
+        return std::chrono::duration_cast<millisecs>(stop_time - start_time).count();
+    }
+
+    static double get_imbalance(const ThreadBenchResult & result) {
+        size_type threads = result.thread_operations.size();
+        if (threads < 2)
+            return 0.0;
+        double min_value = result.thread_throughput(0);
+        double max_value = min_value;
+        double sum = 0.0;
+        for (size_type i = 0; i < threads; i++) {
+            double value = result.thread_throughput(i);
+            if (value < min_value)
+                min_value = value;
+            if (value > max_value)
+                max_value = value;
+            sum += value;
+        }
+        double mean = sum / static_cast<double>(threads);
+        return (mean > 0.0) ? ((max_value - min_value) / mean) : 0.0;
+    }
+
+    static void set_labels(ThreadBenchResult & result) {
+        char buf[64];
+        result.stats.labels.set("threads", result.threads);
+        result.stats.labels.set("placement", get_placement_name(result.placement));
+        snprintf(buf, sizeof(buf), "%0.3f", result.throughput / 1000000.0);
+        result.stats.labels.set("throughput", buf);
+        if (result.efficiency != 0.0) {
+            snprintf(buf, sizeof(buf), "%0.3f", result.efficiency);
+            result.stats.labels.set("efficiency", buf);
+        }
+    }
+};
+
+} // namespace jtest
+
+#endif // JSTD_TEST_THREAD_BENCH_H
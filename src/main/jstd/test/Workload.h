@@ -0,0 +1,436 @@
+
+#ifndef JSTD_TEST_WORKLOAD_H
+#define JSTD_TEST_WORKLOAD_H
+
+#if defined(_MSC_VER) && (_MSC_VER >= 1020)
+#pragma once
+#endif
+
+#include <math.h>
+#include <assert.h>
+
+#include <cstdint>
+#include <cstddef>      // For std::size_t
+#include <string>
+#include <vector>
+
+#include "jstd/system/RandomGen.h"
+
+//
+// The YCSB (Yahoo! Cloud Serving Benchmark) style workloads:
+//
+//   Brian F. Cooper, Adam Silberstein, Erwin Tam, Raghu Ramakrishnan, Russell Sears,
+//   "Benchmarking Cloud Serving Systems with YCSB", SoCC 2010.
+//
+// The Zipfian generator is from:
+//
+//   Jim Gray, Prakash Sundaresan, Susanne Englert, Ken Baclawski, Peter J. Weinberger,
+//   "Quickly Generating Billion-Record Synthetic Databases", SIGMOD 1994.
+//
+
+namespace jtest {
+
+enum KeyDistribution {
+    kDistUniform,
+    kDistZipfian,       // The popular keys are scattered over the key space
+    kDistLatest,        // The recently inserted keys are the most popular
+    kDistHotspot,       // hot_op_fraction of the operations access hot_set_fraction of the keys
+    kDistCount
+};
+
+static inline
+const char * get_distribution_name(KeyDistribution distribution) {
+    static const char * const kNames[kDistCount] = {
+        "uniform", "zipfian", "latest", "hotspot"
+    };
+    return (distribution < kDistCount) ? kNames[distribution] : "unknown";
+}
+
+enum WorkloadOp {
+    kOpRead,
+    kOpUpdate,
+    kOpInsert,
+    kOpScan,            // Read scan_length consecutive keys
+    kOpReadModifyWrite,
+    kOpErase,
+    kOpCount
+};
+
+static inline
+const char * get_workload_op_name(std::size_t op) {
+    static const char * const kNames[kOpCount] = {
+        "read", "update", "insert", "scan", "read-modify-write", "erase"
+    };
+    return (op < kOpCount) ? kNames[op] : "unknown";
+}
+
+//
+// The Zipfian distribution over [0, items), 0 is the most popular item,
+// theta is the skew (0 < theta < 1), YCSB uses 0.99.
+//
+// The zeta(n) is O(n) at the first time, and it's incremental when the items grow.
+//
+template <typename RandomGen = jstd::MtRandomGen>
+class BasicZipfianGenerator {
+public:
+    typedef std::uint64_t value_type;
+
+private:
+    value_type  items_;
+    double      theta_;
+    double      alpha_;
+    double      zeta2_;
+    double      zetan_;
+    double      eta_;
+    value_type  zeta_items_;        // The items of zetan_
+
+public:
+    explicit BasicZipfianGenerator(value_type items = 1, double theta = 0.99)
+        : items_(0), theta_(theta), alpha_(0.0), zeta2_(0.0), zetan_(0.0), eta_(0.0),
+          zeta_items_(0) {
+        assert(theta > 0.0 && theta < 1.0);
+        this->alpha_ = 1.0 / (1.0 - theta);
+        this->zeta2_ = zeta(0, 2, theta, 0.0);
+        this->set_items(items);
+    }
+    ~BasicZipfianGenerator() {}
+
+    value_type items() const { return this->items_; }
+    double theta() const { return this->theta_; }
+
+    void set_items(value_type items) {
+        if (items == 0)
+            items = 1;
+        if (items != this->items_) {
+            if (items > this->zeta_items_)
+                this->zetan_ = zeta(this->zeta_items_, items, this->theta_, this->zetan_);
+            else
+                this->zetan_ = zeta(0, items, this->theta_, 0.0);
+            this->zeta_items_ = items;
+            this->items_ = items;
+            this->eta_ = (1.0 - ::pow(2.0 / static_cast<double>(items), 1.0 - this->theta_)) /
+                         (1.0 - this->zeta2_ / this->zetan_);
+        }
+    }
+
+    value_type next() {
+        double u = RandomGen::nextDouble53();
+        double uz = u * this->zetan_;
+        if (uz < 1.0)
+            return 0;
+        if (uz < 1.0 + ::pow(0.5, this->theta_))
+            return (this->items_ > 1) ? 1 : 0;
+        value_type item = static_cast<value_type>(static_cast<double>(this->items_) *
+                                                  ::pow(this->eta_ * u - this->eta_ + 1.0, this->alpha_));
+        return (item < this->items_) ? item : (this->items_ - 1);
+    }
+
+    // The sum of 1 / i^theta, i = [first + 1, last].
+    static double zeta(value_type first, value_type last, double theta, double initial) {
+        double sum = initial;
+        for (value_type i = first; i < last; i++) {
+            sum += 1.0 / ::pow(static_cast<double>(i + 1), theta);
+        }
+        return sum;
+    }
+};
+
+//
+// Choose the key indexes of a distribution, the keys are [0, items).
+//
+template <typename RandomGen = jstd::MtRandomGen>
+class BasicKeyChooser {
+public:
+    typedef std::uint64_t                       value_type;
+    typedef BasicZipfianGenerator<RandomGen>    zipfian_type;
+
+private:
+    KeyDistribution distribution_;
+    value_type      items_;
+    double          hot_set_fraction_;
+    double          hot_op_fraction_;
+    zipfian_type    zipfian_;
+
+public:
+    BasicKeyChooser(KeyDistribution distribution, value_type items, double theta = 0.99,
+                    double hot_set_fraction = 0.2, double hot_op_fraction = 0.8)
+        : distribution_(distribution), items_((items != 0) ? items : 1),
+          hot_set_fraction_(hot_set_fraction), hot_op_fraction_(hot_op_fraction),
+          zipfian_((distribution == kDistZipfian || distribution == kDistLatest) ? items : 1, theta) {
+    }
+    ~BasicKeyChooser() {}
+
+    KeyDistribution distribution() const { return this->distribution_; }
+    value_type items() const { return this->items_; }
+
+    //
+    // The new keys are inserted, only the latest distribution follows them,
+    // the Zipfian keys stay in the loaded keys, like YCSB.
+    //
+    void set_items(value_type items) {
+        if (items == 0)
+            items = 1;
+        if (this->distribution_ == kDistLatest)
+            this->zipfian_.set_items(items);
+        if (this->distribution_ != kDistZipfian)
+            this->items_ = items;
+    }
+
+    value_type next() {
+        switch (this->distribution_) {
+        case kDistZipfian:
+            // Scatter the popular items, they are not the neighbours.
+            return (scramble(this->zipfian_.next()) % this->items_);
+        case kDistLatest:
+            return (this->items_ - 1 - this->zipfian_.next());
+        case kDistHotspot:
+            {
+                value_type hot_items = static_cast<value_type>(static_cast<double>(this->items_) *
+                                                               this->hot_set_fraction_);
+                if (hot_items == 0)
+                    hot_items = 1;
+                if (RandomGen::nextDouble53() < this->hot_op_fraction_ || hot_items >= this->items_)
+                    return (RandomGen::nextUInt64() % hot_items);
+                else
+                    return (hot_items + RandomGen::nextUInt64() % (this->items_ - hot_items));
+            }
+        case kDistUniform:
+        default:
+            return (RandomGen::nextUInt64() % this->items_);
+        }
+    }
+
+    // The 64-bit FNV-1a hash of the 8 bytes, like the scrambled Zipfian of YCSB.
+    static value_type scramble(value_type value) {
+        value_type hash = 14695981039346656037ULL;
+        for (std::size_t i = 0; i < sizeof(value_type); i++) {
+            hash ^= (value & 0xFFU);
+            hash *= 1099511628211ULL;
+            value >>= 8;
+        }
+        return hash;
+    }
+};
+
+//
+// The proportions of the operations (the sum is 1.0) and the key distribution.
+//
+struct WorkloadSpec {
+    std::string         name;
+    double              proportions[kOpCount];
+    KeyDistribution     distribution;
+    double              theta;              // The skew of the Zipfian and the latest
+    double              hot_set_fraction;
+    double              hot_op_fraction;
+    std::size_t         max_scan_length;    // The scan length is uniform in [1, max_scan_length]
+
+    WorkloadSpec() : distribution(kDistZipfian), theta(0.99),
+                     hot_set_fraction(0.2), hot_op_fraction(0.8), max_scan_length(100) {
+        for (std::size_t i = 0; i < kOpCount; i++) {
+            this->proportions[i] = 0.0;
+        }
+    }
+
+    WorkloadSpec(const std::string & _name, double read, double update, double insert,
+                 double scan, double read_modify_write, double erase,
+                 KeyDistribution _distribution = kDistZipfian)
+        : name(_name), distribution(_distribution), theta(0.99),
+          hot_set_fraction(0.2), hot_op_fraction(0.8), max_scan_length(100) {
+        this->proportions[kOpRead]            = read;
+        this->proportions[kOpUpdate]          = update;
+        this->proportions[kOpInsert]          = insert;
+        this->proportions[kOpScan]            = scan;
+        this->proportions[kOpReadModifyWrite] = read_modify_write;
+        this->proportions[kOpErase]           = erase;
+    }
+
+    //
+    // The core workloads of YCSB:
+    //
+    //   A: update heavy,   read 50%, update 50%, zipfian
+    //   B: read mostly,    read 95%, update 5%, zipfian
+    //   C: read only,      read 100%, zipfian
+    //   D: read latest,    read 95%, insert 5%, latest
+    //   E: short ranges,   scan 95%, insert 5%, zipfian
+    //   F: read-modify-write, read 50%, read-modify-write 50%, zipfian
+    //
+    // The hash maps have no range scan, a scan reads the consecutive keys.
+    //
+    static WorkloadSpec ycsb(char workload) {
+        switch (workload) {
+        case 'A': case 'a':
+            return WorkloadSpec("ycsb_a", 0.50, 0.50, 0.00, 0.00, 0.00, 0.00);
+        case 'B': case 'b':
+            return WorkloadSpec("ycsb_b", 0.95, 0.05, 0.00, 0.00, 0.00, 0.00);
+        case 'C': case 'c':
+            return WorkloadSpec("ycsb_c", 1.00, 0.00, 0.00, 0.00, 0.00, 0.00);
+        case 'D': case 'd':
+            return WorkloadSpec("ycsb_d", 0.95, 0.00, 0.05, 0.00, 0.00, 0.00, kDistLatest);
+        case 'E': case 'e':
+            return WorkloadSpec("ycsb_e", 0.00, 0.00, 0.05, 0.95, 0.00, 0.00);
+        case 'F': case 'f':
+        default:
+            return WorkloadSpec("ycsb_f", 0.50, 0.00, 0.00, 0.00, 0.50, 0.00);
+        }
+    }
+};
+
+struct WorkloadOperation {
+    std::uint64_t   key;        // The key index
+    std::uint32_t   op;         // WorkloadOp
+    std::uint32_t   length;     // The scan length
+};
+
+//
+// Generate the operation sequence of a workload, the keys [0, records) are loaded
+// before running, and the inserted keys are [records, records + inserts).
+//
+// The operations are generated before running, so the random generator is not timed,
+// and every container runs the same sequence with the same seed.
+//
+template <typename RandomGen = jstd::MtRandomGen>
+class BasicWorkload {
+public:
+    typedef std::size_t                         size_type;
+    typedef std::uint64_t                       key_type;
+    typedef BasicKeyChooser<RandomGen>          key_chooser_type;
+
+private:
+    WorkloadSpec                    spec_;
+    size_type                       records_;
+    size_type                       inserts_;
+    size_type                       op_counts_[kOpCount];
+    std::vector<WorkloadOperation>  operations_;
+
+public:
+    explicit BasicWorkload(const WorkloadSpec & spec) : spec_(spec), records_(0), inserts_(0) {
+        for (size_type i = 0; i < kOpCount; i++) {
+            this->op_counts_[i] = 0;
+        }
+    }
+    ~BasicWorkload() {}
+
+    const WorkloadSpec & spec() const { return this->spec_; }
+    const std::string & name() const { return this->spec_.name; }
+
+    size_type records() const { return this->records_; }
+    size_type inserts() const { return this->inserts_; }
+    size_type size() const { return this->operations_.size(); }
+
+    size_type op_count(size_type op) const {
+        return (op < kOpCount) ? this->op_counts_[op] : 0;
+    }
+
+    const std::vector<WorkloadOperation> & operations() const { return this->operations_; }
+
+    const WorkloadOperation & operator [] (size_type index) const {
+        return this->operations_[index];
+    }
+
+    void generate(size_type records, size_type operations, typename RandomGen::value_type seed) {
+        RandomGen::srand(seed);
+
+        this->records_ = records;
+        this->inserts_ = 0;
+        for (size_type i = 0; i < kOpCount; i++) {
+            this->op_counts_[i] = 0;
+        }
+        this->operations_.clear();
+        this->operations_.reserve(operations);
+
+        double thresholds[kOpCount];
+        double sum = 0.0;
+        for (size_type i = 0; i < kOpCount; i++) {
+            sum += this->spec_.proportions[i];
+            thresholds[i] = sum;
+        }
+
+        key_chooser_type chooser(this->spec_.distribution, records, this->spec_.theta,
+                                 this->spec_.hot_set_fraction, this->spec_.hot_op_fraction);
+        for (size_type n = 0; n < operations; n++) {
+            double u = RandomGen::nextDouble53() * sum;
+            size_type op = kOpRead;
+            while (op < kOpCount - 1 && u >= thresholds[op])
+                op++;
+
+            WorkloadOperation operation;
+            operation.op = static_cast<std::uint32_t>(op);
+            operation.length = 1;
+            if (op == kOpInsert) {
+                operation.key = static_cast<key_type>(records + this->inserts_);
+                this->inserts_++;
+                chooser.set_items(static_cast<key_type>(records + this->inserts_));
+            }
+            else {
+                operation.key = chooser.next();
+                if (op == kOpScan && this->spec_.max_scan_length > 1) {
+                    operation.length = static_cast<std::uint32_t>(
+                        1 + RandomGen::nextUInt64() % this->spec_.max_scan_length);
+                }
+            }
+            this->operations_.push_back(operation);
+            this->op_counts_[op]++;
+        }
+    }
+
+    //
+    // Run the operations on a std::unordered_map<K, V> like container,
+    // return the count of the found keys. The key indexes are cast to Key.
+    //
+    template <typename Container, typename Key = typename Container::key_type>
+    size_type run(Container & container) const {
+        typedef Key                             ckey_type;
+        typedef typename Container::mapped_type cmapped_type;
+
+        size_type found = 0;
+        for (size_type n = 0; n < this->operations_.size(); n++) {
+            const WorkloadOperation & operation = this->operations_[n];
+            switch (operation.op) {
+            case kOpRead:
+                found += (container.find(static_cast<ckey_type>(operation.key)) != container.end());
+                break;
+            case kOpUpdate:
+                {
+                    auto iter = container.find(static_cast<ckey_type>(operation.key));
+                    if (iter != container.end()) {
+                        iter->second = static_cast<cmapped_type>(n);
+                        found++;
+                    }
+                }
+                break;
+            case kOpInsert:
+                container.emplace(static_cast<ckey_type>(operation.key),
+                                  static_cast<cmapped_type>(operation.key));
+                break;
+            case kOpScan:
+                for (std::uint32_t i = 0; i < operation.length; i++) {
+                    found += (container.find(static_cast<ckey_type>(operation.key + i)) != container.end());
+                }
+                break;
+            case kOpReadModifyWrite:
+                {
+                    auto iter = container.find(static_cast<ckey_type>(operation.key));
+                    if (iter != container.end()) {
+                        iter->second = iter->second + static_cast<cmapped_type>(1);
+                        found++;
+                    }
+                }
+                break;
+            case kOpErase:
+                container.erase(static_cast<ckey_type>(operation.key));
+                break;
+            default:
+                break;
+            }
+        }
+        return found;
+    }
+};
+
+typedef BasicZipfianGenerator<jstd::MtRandomGen>    ZipfianGenerator;
+typedef BasicKeyChooser<jstd::MtRandomGen>          KeyChooser;
+typedef BasicWorkload<jstd::MtRandomGen>            Workload;
+
+} // namespace jtest
+
+#endif // JSTD_TEST_WORKLOAD_H
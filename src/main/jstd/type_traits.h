@@ -81,6 +81,10 @@ constexpr T cmin(const T & a, const T & b) {
 struct void_wrapper {
     void_wrapper() {}
 
+    // Used as the ReturnType of the *_no_return() methods, ignore the return values.
+    template <typename ... Args>
+    void_wrapper(Args && ... args) {}
+
     template <typename ... Args>
     void operator () (Args && ... args) const {
         return void();
@@ -0,0 +1,319 @@
+// Your can edit 'JSTD_ENABLE_VLD' marco in <jstd/basic/vld_def.h> file
+// to switch Visual Leak Detector(vld).
+#ifdef _MSC_VER
+#include <jstd/basic/vld.h>
+#endif
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include <jstd/basic/stddef.h>
+#include <jstd/basic/inttypes.h>
+#include <jstd/test/BenchmarkRunner.h>
+#include <jstd/test/BenchmarkReport.h>
+
+//
+// Compare two benchmark reports (written by --json=<file> or --csv=<file>),
+//
+//   bench_compare [options] <baseline> <contender>
+//
+// A case is a regression (or an improvement) only if the change of the median
+// exceeds both the threshold and the noise of the two runs, the noise is the sum
+// of the half widths of the 95% confidence intervals (or of the MADs if larger).
+// The cases measured while the CPU was throttled (see --max_drift) are marked.
+//
+// The exit code is 0 if no regression, 1 if there are regressions, 2 if error.
+//
+
+struct CompareOptions {
+    double                      threshold;      // In percent
+    bool                        fail_on_missing;
+    bool                        show_all;
+    std::vector<std::string>    filters;
+
+    CompareOptions() : threshold(5.0), fail_on_missing(false), show_all(true) {}
+};
+
+enum CompareStatus {
+    kStatusSame,
+    kStatusNoise,
+    kStatusImproved,
+    kStatusRegressed
+};
+
+static const char * const kStatusNames[] = {
+    "same", "noise", "IMPROVED", "REGRESSED"
+};
+
+static void print_usage(const char * program)
+{
+    printf("Usage: %s [options] <baseline> <contender>\n\n", program);
+    printf("  The reports are the JSON or CSV files written by --json=<file> or --csv=<file>.\n\n");
+    printf("  --threshold=<percent>           The minimum change to be significant, default is 5.\n"
+           "  --filter=<pattern>[,<pattern>]  Compare the cases whose name contains the pattern.\n"
+           "  --changes_only                  Only print the significant changes.\n"
+           "  --fail_on_missing               The missing cases are the regressions too.\n"
+           "  --help                          Show this message.\n\n");
+    printf("  Exit code: 0 = no regression, 1 = regressions, 2 = error.\n\n");
+}
+
+static bool is_selected(const CompareOptions & options, const std::string & name)
+{
+    if (options.filters.empty())
+        return true;
+    for (std::size_t i = 0; i < options.filters.size(); i++) {
+        if (name.find(options.filters[i]) != std::string::npos)
+            return true;
+    }
+    return false;
+}
+
+static void add_filters(CompareOptions & options, const char * value)
+{
+    std::string filters(value);
+    std::size_t first = 0;
+    while (first <= filters.size()) {
+        std::size_t last = filters.find(',', first);
+        if (last == std::string::npos)
+            last = filters.size();
+        if (last > first)
+            options.filters.push_back(filters.substr(first, last - first));
+        first = last + 1;
+    }
+}
+
+//
+// The noise of a case in nanosecond: the half width of the confidence interval,
+// or the MAD if it's larger (the confidence interval is 0 if only one run).
+//
+static double get_noise(const jtest::BenchmarkStats & stats)
+{
+    double half_width = (stats.ci_upper - stats.ci_lower) * 0.5;
+    if (half_width < 0.0)
+        half_width = 0.0;
+    return (half_width > stats.mad) ? half_width : stats.mad;
+}
+
+static const char * get_metadata(const jtest::BenchmarkReport & report, const char * key)
+{
+    const std::string * value = report.metadata().get(key);
+    return (value != nullptr) ? value->c_str() : "unknown";
+}
+
+static void print_report_info(const char * title, const char * filename,
+                              const jtest::BenchmarkReport & report)
+{
+    printf(" %-10s %s\n", title, filename);
+    printf("            program: %s, timestamp: %s, %" PRIuPTR " cases\n",
+           get_metadata(report, "program"), get_metadata(report, "timestamp"), report.size());
+}
+
+//
+// The run metadata should be the same, otherwise the results may be not comparable.
+//
+static void check_metadata(const jtest::BenchmarkReport & baseline,
+                           const jtest::BenchmarkReport & contender)
+{
+    static const char * const kKeys[] = {
+        "program", "compiler", "build_flags", "isa", "cpu_model", "hash_func"
+    };
+
+    bool has_warning = false;
+    for (std::size_t i = 0; i < sizeof(kKeys) / sizeof(kKeys[0]); i++) {
+        const std::string * value1 = baseline.metadata().get(kKeys[i]);
+        const std::string * value2 = contender.metadata().get(kKeys[i]);
+        if (value1 != nullptr && value2 != nullptr && *value1 != *value2) {
+            if (!has_warning)
+                printf("\n");
+            printf(" Warning: the %s is different:\n"
+                   "            baseline : %s\n"
+                   "            contender: %s\n",
+                   kKeys[i], value1->c_str(), value2->c_str());
+            has_warning = true;
+        }
+    }
+}
+
+//
+// The cases with the same name are paired in order.
+//
+static const jtest::BenchmarkStats *
+find_case(const jtest::BenchmarkReport & report, const std::string & name,
+          std::size_t occurrence)
+{
+    for (std::size_t i = 0; i < report.cases().size(); i++) {
+        const jtest::BenchmarkStats & stats = report.cases()[i];
+        if (stats.name == name) {
+            if (occurrence == 0)
+                return &stats;
+            occurrence--;
+        }
+    }
+    return nullptr;
+}
+
+static std::size_t count_before(const jtest::BenchmarkReport & report, std::size_t index)
+{
+    std::size_t count = 0;
+    const std::string & name = report.cases()[index].name;
+    for (std::size_t i = 0; i < index; i++) {
+        if (report.cases()[i].name == name)
+            count++;
+    }
+    return count;
+}
+
+int main(int argc, char * argv[])
+{
+    CompareOptions options;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        const char * arg = argv[i];
+        if (::strncmp(arg, "--threshold=", 12) == 0) {
+            double threshold = ::atof(arg + 12);
+            if (threshold >= 0.0)
+                options.threshold = threshold;
+        }
+        else if (::strncmp(arg, "--filter=", 9) == 0) {
+            add_filters(options, arg + 9);
+        }
+        else if (::strcmp(arg, "--changes_only") == 0) {
+            options.show_all = false;
+        }
+        else if (::strcmp(arg, "--fail_on_missing") == 0) {
+            options.fail_on_missing = true;
+        }
+        else if (::strcmp(arg, "--help") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        }
+        else if (::strncmp(arg, "--", 2) == 0) {
+            printf("Unknown option: %s\n\n", arg);
+            print_usage(argv[0]);
+            return 2;
+        }
+        else {
+            files.push_back(std::string(arg));
+        }
+    }
+
+    if (files.size() != 2) {
+        print_usage(argv[0]);
+        return 2;
+    }
+
+    jtest::BenchmarkReport baseline, contender;
+    if (!baseline.load(files[0])) {
+        printf("Error: can't read the report: %s\n\n", files[0].c_str());
+        return 2;
+    }
+    if (!contender.load(files[1])) {
+        printf("Error: can't read the report: %s\n\n", files[1].c_str());
+        return 2;
+    }
+
+    printf("\n");
+    print_report_info("Baseline :", files[0].c_str(), baseline);
+    print_report_info("Contender:", files[1].c_str(), contender);
+    check_metadata(baseline, contender);
+    printf("\n");
+
+    printf(" %-60s %14s %14s  %8s  %9s  %s\n",
+           "Benchmark", "Baseline", "Contender", "Change", "Noise", "Result");
+    printf("----------------------------------------------------------------------------------------------------------------------\n");
+
+    std::size_t counts[4] = { 0, 0, 0, 0 };
+    std::size_t missing = 0, added = 0, checksum_changed = 0, throttled = 0;
+
+    for (std::size_t i = 0; i < baseline.cases().size(); i++) {
+        const jtest::BenchmarkStats & base = baseline.cases()[i];
+        if (!is_selected(options, base.name))
+            continue;
+
+        const jtest::BenchmarkStats * cont = find_case(contender, base.name, count_before(baseline, i));
+        if (cont == nullptr) {
+            printf(" %-60s %s/op %14s  %8s  %9s  %s\n",
+                   base.name.c_str(), jtest::BenchmarkRunner::format_time(base.median).c_str(),
+                   "-", "", "", "missing");
+            missing++;
+            continue;
+        }
+
+        double change = 0.0, noise = 0.0;
+        if (base.median > 0.0) {
+            change = (cont->median - base.median) * 100.0 / base.median;
+            noise = (get_noise(base) + get_noise(*cont)) * 100.0 / base.median;
+        }
+
+        CompareStatus status;
+        if (::fabs(change) <= options.threshold)
+            status = kStatusSame;
+        else if (::fabs(change) <= noise)
+            status = kStatusNoise;
+        else if (change > 0.0)
+            status = kStatusRegressed;
+        else
+            status = kStatusImproved;
+        counts[status]++;
+
+        bool is_checksum_changed = (base.checksum != cont->checksum);
+        if (is_checksum_changed)
+            checksum_changed++;
+
+        // Measured while the CPU frequency was drifting, the change may be not real.
+        bool is_throttled = (base.throttled || cont->throttled);
+        if (is_throttled)
+            throttled++;
+
+        if (options.show_all || status == kStatusRegressed ||
+            status == kStatusImproved || is_checksum_changed) {
+            printf(" %-60s %s/op %s/op  %+7.2f%%  +/-%5.2f%%  %s%s%s\n",
+                   base.name.c_str(),
+                   jtest::BenchmarkRunner::format_time(base.median).c_str(),
+                   jtest::BenchmarkRunner::format_time(cont->median).c_str(),
+                   change, noise, kStatusNames[status],
+                   is_checksum_changed ? " (checksum changed)" : "",
+                   is_throttled ? " (throttled)" : "");
+        }
+    }
+
+    for (std::size_t i = 0; i < contender.cases().size(); i++) {
+        const jtest::BenchmarkStats & cont = contender.cases()[i];
+        if (!is_selected(options, cont.name))
+            continue;
+        if (find_case(baseline, cont.name, count_before(contender, i)) == nullptr) {
+            if (options.show_all) {
+                printf(" %-60s %14s %s/op  %8s  %9s  %s\n",
+                       cont.name.c_str(), "-",
+                       jtest::BenchmarkRunner::format_time(cont.median).c_str(), "", "", "new");
+            }
+            added++;
+        }
+    }
+
+    printf("----------------------------------------------------------------------------------------------------------------------\n");
+    printf("\n");
+    printf(" threshold: %0.2f%%, regressed: %" PRIuPTR ", improved: %" PRIuPTR ", noise: %" PRIuPTR
+           ", same: %" PRIuPTR ", missing: %" PRIuPTR ", new: %" PRIuPTR,
+           options.threshold, counts[kStatusRegressed], counts[kStatusImproved],
+           counts[kStatusNoise], counts[kStatusSame], missing, added);
+    if (checksum_changed != 0)
+        printf(", checksum changed: %" PRIuPTR, checksum_changed);
+    if (throttled != 0)
+        printf(", throttled: %" PRIuPTR, throttled);
+    printf("\n\n");
+
+    if (counts[kStatusRegressed] != 0 || (options.fail_on_missing && missing != 0))
+        return 1;
+    else
+        return 0;
+}
@@ -249,7 +249,8 @@ public:
     void printResult(const std::string & filename, double totalElapsedTime = 0.0) {
         for (size_type catId = 0; catId < category_size(); catId++) {
             BenchmarkCategory * category = getCategory(catId);
-            if (category != nullptr) {
+            // All the tests of the category may be filtered out.
+            if (category != nullptr && category->size() != 0) {
                 printf(" Test                                    %23s   %23s      Ratio\n",
                        this->name1_.c_str(), this->name2_.c_str());
                 printf("--------------------------------------------------------------------------------------------------------\n");
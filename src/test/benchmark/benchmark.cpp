@@ -65,14 +65,22 @@
 
 #include <unordered_map>
 #include <jstd/hash/dictionary.h>
+#include <jstd/hash/string_dictionary.h>
+#include <jstd/hash/small_dictionary.h>
 #include <jstd/hash/hashmap_analyzer.h>
 #include <jstd/string/string_view.h>
 #include <jstd/string/string_view_array.h>
+#include <jstd/string/line_splitter.h>
 #include <jstd/system/Console.h>
+#include <jstd/system/mapped_file.h>
 #include <jstd/system/RandomGen.h>
 #include <jstd/test/StopWatch.h>
 #include <jstd/test/CPUWarmUp.h>
 #include <jstd/test/ProcessMemInfo.h>
+#include <jstd/test/MemoryTracker.h>
+#include <jstd/test/BenchmarkRunner.h>
+#include <jstd/test/BenchmarkReport.h>
+#include <jstd/test/ThreadBench.h>
 
 #include "BenchmarkResult.h"
 
@@ -83,11 +91,7 @@ static bool dict_words_is_ready = false;
 
 static const std::size_t kInitCapacity = 16;
 
-#ifndef _DEBUG
-static const std::size_t kIterations = 3000000;
-#else
-static const std::size_t kIterations = 1000;
-#endif
+static jtest::BenchmarkRunner s_runner;
 
 //
 // See: https://blog.csdn.net/janekeyzheng/article/details/42419407
@@ -232,17 +236,6 @@ void print_error(std::size_t index, const jstd::string_view & key, const jstd::s
            index + 1, skey.c_str(), svalue.c_str());
 }
 
-template <typename Container>
-void print_test_time(std::size_t checksum, double elapsedTime)
-{
-    // printf("---------------------------------------------------------------------------\n");
-    if (jstd::has_static_name<Container>::value)
-        printf(" %-36s  ", jstd::call_static_name<Container>::name().c_str());
-    else
-        printf(" %-36s  ", "std::unordered_map<K, V>");
-    printf("sum = %-10" PRIuPTR "  time: %8.3f ms\n", checksum, elapsedTime);
-}
-
 template <typename Vector>
 void copy_and_shuffle_vector(Vector & dest_list, const Vector & src_list) {
     // copy
@@ -326,17 +319,11 @@ void copy_vector_and_reverse_item(Vector & dest_list, const Vector & src_list) {
 }
 
 template <typename Container, typename Vector>
-void test_hashmap_find_sequential(const Vector & test_data,
-                                  double & elapsedTime, std::size_t & check_sum)
+void test_hashmap_find_sequential(jtest::BenchmarkState & state, const Vector & test_data)
 {
     typedef typename Container::const_iterator const_iterator;
 
     std::size_t data_length = test_data.size();
-    std::size_t repeat_times;
-    if (data_length != 0)
-        repeat_times = (kIterations / data_length) + 1;
-    else
-        repeat_times = 0;
 
     Container container(kInitCapacity);
     for (std::size_t i = 0; i < data_length; i++) {
@@ -344,10 +331,7 @@ void test_hashmap_find_sequential(const Vector & test_data,
     }
 
     std::size_t checksum = 0;
-    jtest::StopWatch sw;
-
-    sw.start();
-    for (std::size_t n = 0; n < repeat_times; n++) {
+    while (state.keep_running()) {
         for (std::size_t i = 0; i < data_length; i++) {
             const_iterator iter = container.find(test_data[i].first);
             if (iter != container.end()) {
@@ -364,26 +348,18 @@ void test_hashmap_find_sequential(const Vector & test_data,
 #endif
         }
     }
-    sw.stop();
-
-    elapsedTime = sw.getElapsedMillisec();
-    check_sum = checksum;
 
-    print_test_time<Container>(check_sum, elapsedTime);
+    state.set_items_per_iteration(data_length);
+    state.set_checksum(checksum / state.iterations());
 }
 
 template <typename Container, typename Vector>
-void test_hashmap_find_random(const Vector & test_data, const Vector & rand_data,
-                              double & elapsedTime, std::size_t & check_sum)
+void test_hashmap_find_random(jtest::BenchmarkState & state,
+                              const Vector & test_data, const Vector & rand_data)
 {
     typedef typename Container::const_iterator const_iterator;
 
     std::size_t data_length = test_data.size();
-    std::size_t repeat_times;
-    if (data_length != 0)
-        repeat_times = (kIterations / data_length) + 1;
-    else
-        repeat_times = 0;
 
     Container container(kInitCapacity);
     for (std::size_t i = 0; i < data_length; i++) {
@@ -391,10 +367,7 @@ void test_hashmap_find_random(const Vector & test_data, const Vector & rand_data
     }
 
     std::size_t checksum = 0;
-    jtest::StopWatch sw;
-
-    sw.start();
-    for (std::size_t n = 0; n < repeat_times; n++) {
+    while (state.keep_running()) {
         for (std::size_t i = 0; i < data_length; i++) {
             const_iterator iter = container.find(rand_data[i].first);
             if (iter != container.end()) {
@@ -402,26 +375,18 @@ void test_hashmap_find_random(const Vector & test_data, const Vector & rand_data
             }
         }
     }
-    sw.stop();
 
-    elapsedTime = sw.getElapsedMillisec();
-    check_sum = checksum;
-
-    print_test_time<Container>(check_sum, elapsedTime);
+    state.set_items_per_iteration(data_length);
+    state.set_checksum(checksum / state.iterations());
 }
 
 template <typename Container, typename Vector>
-void test_hashmap_find_failed(const Vector & test_data, const Vector & reverse_data,
-                              double & elapsedTime, std::size_t & check_sum)
+void test_hashmap_find_failed(jtest::BenchmarkState & state,
+                              const Vector & test_data, const Vector & reverse_data)
 {
     typedef typename Container::const_iterator const_iterator;
 
     std::size_t data_length = test_data.size();
-    std::size_t repeat_times;
-    if (data_length != 0)
-        repeat_times = (kIterations / data_length) + 1;
-    else
-        repeat_times = 0;
 
     Container container(kInitCapacity);
     for (std::size_t i = 0; i < data_length; i++) {
@@ -429,10 +394,7 @@ void test_hashmap_find_failed(const Vector & test_data, const Vector & reverse_d
     }
 
     std::size_t checksum = 0;
-    jtest::StopWatch sw;
-
-    sw.start();
-    for (std::size_t n = 0; n < repeat_times; n++) {
+    while (state.keep_running()) {
         for (std::size_t i = 0; i < data_length; i++) {
             const_iterator iter = container.find(reverse_data[i].first);
             if (iter != container.end()) {
@@ -440,34 +402,22 @@ void test_hashmap_find_failed(const Vector & test_data, const Vector & reverse_d
             }
         }
     }
-    sw.stop();
 
-    elapsedTime = sw.getElapsedMillisec();
-    check_sum = checksum;
-
-    print_test_time<Container>(check_sum, elapsedTime);
+    state.set_items_per_iteration(data_length);
+    state.set_checksum(checksum / state.iterations());
 }
 
 template <typename Container, typename Vector>
-void test_hashmap_find_empty(const Vector & test_data,
-                             double & elapsedTime, std::size_t & check_sum)
+void test_hashmap_find_empty(jtest::BenchmarkState & state, const Vector & test_data)
 {
     typedef typename Container::const_iterator const_iterator;
 
     std::size_t data_length = test_data.size();
-    std::size_t repeat_times;
-    if (data_length != 0)
-        repeat_times = (kIterations / data_length) + 1;
-    else
-        repeat_times = 0;
 
     Container container(kInitCapacity);
 
     std::size_t checksum = 0;
-    jtest::StopWatch sw;
-
-    sw.start();
-    for (std::size_t n = 0; n < repeat_times; n++) {
+    while (state.keep_running()) {
         for (std::size_t i = 0; i < data_length; i++) {
             const_iterator iter = container.find(test_data[i].first);
             if (iter != container.end()) {
@@ -475,254 +425,185 @@ void test_hashmap_find_empty(const Vector & test_data,
             }
         }
     }
-    sw.stop();
-
-    elapsedTime = sw.getElapsedMillisec();
-    check_sum = checksum;
 
-    print_test_time<Container>(check_sum, elapsedTime);
+    jtest::DoNotOptimize(checksum);
+    state.set_items_per_iteration(data_length);
+    state.set_checksum(checksum / state.iterations());
 }
 
+//
+// For the insert, emplace and erase tests, the construction (and the prefilling)
+// and the destruction of the container in each iteration are not timed.
+//
+
 template <typename Container, typename Vector>
-void test_hashmap_insert(const Vector & test_data,
-                         double & elapsedTime, std::size_t & check_sum)
+void test_hashmap_insert(jtest::BenchmarkState & state, const Vector & test_data)
 {
     std::size_t data_length = test_data.size();
-    std::size_t repeat_times;
-    if (data_length != 0)
-        repeat_times = (kIterations / data_length) + 1;
-    else
-        repeat_times = 0;
 
     std::size_t checksum = 0;
-    double totalTime = 0.0;
-    jtest::StopWatch sw;
-
-    for (std::size_t n = 0; n < repeat_times; n++) {
+    while (state.keep_running()) {
+        state.pause_timing();
         Container container(kInitCapacity);
-        sw.start();
+        state.resume_timing();
+
         for (std::size_t i = 0; i < data_length; i++) {
             container.insert(std::make_pair(test_data[i].first, test_data[i].second));
         }
-        sw.stop();
 
         checksum += container.size();
-        totalTime += sw.getElapsedMillisec();
+        state.pause_timing();
     }
 
-    elapsedTime = totalTime;
-    check_sum = checksum;
-
-    print_test_time<Container>(check_sum, elapsedTime);
+    state.set_items_per_iteration(data_length);
+    state.set_checksum(checksum / state.iterations());
 }
 
 template <typename Container, typename Vector>
-void test_hashmap_insert_predicted(const Vector & test_data,
-                                   double & elapsedTime, std::size_t & check_sum)
+void test_hashmap_insert_predicted(jtest::BenchmarkState & state, const Vector & test_data)
 {
     std::size_t data_length = test_data.size();
-    std::size_t repeat_times;
-    if (data_length != 0)
-        repeat_times = (kIterations / data_length) + 1;
-    else
-        repeat_times = 0;
 
     std::size_t checksum = 0;
-    double totalTime = 0.0;
-    jtest::StopWatch sw;
-
-    for (std::size_t n = 0; n < repeat_times; n++) {
+    while (state.keep_running()) {
+        state.pause_timing();
         Container container(kInitCapacity);
         container.reserve(data_length);
+        state.resume_timing();
 
-        sw.start();
         for (std::size_t i = 0; i < data_length; i++) {
             container.insert(std::make_pair(test_data[i].first, test_data[i].second));
         }
-        sw.stop();
 
         checksum += container.size();
-        totalTime += sw.getElapsedMillisec();
+        state.pause_timing();
     }
 
-    elapsedTime = totalTime;
-    check_sum = checksum;
-
-    print_test_time<Container>(check_sum, elapsedTime);
+    state.set_items_per_iteration(data_length);
+    state.set_checksum(checksum / state.iterations());
 }
 
 template <typename Container, typename Vector>
-void test_hashmap_insert_replace(const Vector & test_data,
-                                 double & elapsedTime, std::size_t & check_sum)
+void test_hashmap_insert_replace(jtest::BenchmarkState & state, const Vector & test_data)
 {
     std::size_t data_length = test_data.size();
-    std::size_t repeat_times;
-    if (data_length != 0)
-        repeat_times = (kIterations / data_length) + 1;
-    else
-        repeat_times = 0;
 
     std::size_t checksum = 0;
-    double totalTime = 0.0;
-    jtest::StopWatch sw;
-
-    for (std::size_t n = 0; n < repeat_times; n++) {
+    while (state.keep_running()) {
+        state.pause_timing();
         Container container(kInitCapacity);
         for (std::size_t i = 0; i < data_length; i++) {
             container.insert(std::make_pair(test_data[i].first, test_data[i].second));
         }
+        state.resume_timing();
 
-        sw.start();
         for (std::size_t i = 0; i < data_length; i++) {
             std::size_t reverse_idx = data_length - 1 - i;
             container.insert(std::make_pair(test_data[i].first, test_data[reverse_idx].second));
         }
-        sw.stop();
 
         checksum += container.size();
-        totalTime += sw.getElapsedMillisec();
+        state.pause_timing();
     }
 
-    elapsedTime = totalTime;
-    check_sum = checksum;
-
-    print_test_time<Container>(check_sum, elapsedTime);
+    state.set_items_per_iteration(data_length);
+    state.set_checksum(checksum / state.iterations());
 }
 
 template <typename Container, typename Vector>
-void test_hashmap_emplace(const Vector & test_data,
-                          double & elapsedTime, std::size_t & check_sum)
+void test_hashmap_emplace(jtest::BenchmarkState & state, const Vector & test_data)
 {
     std::size_t data_length = test_data.size();
-    std::size_t repeat_times;
-    if (data_length != 0)
-        repeat_times = (kIterations / data_length) + 1;
-    else
-        repeat_times = 0;
 
     std::size_t checksum = 0;
-    double totalTime = 0.0;
-    jtest::StopWatch sw;
-
-    for (std::size_t n = 0; n < repeat_times; n++) {
+    while (state.keep_running()) {
+        state.pause_timing();
         Container container(kInitCapacity);
-        sw.start();
+        state.resume_timing();
+
         for (std::size_t i = 0; i < data_length; i++) {
             container.emplace(test_data[i].first, test_data[i].second);
         }
-        sw.stop();
 
         checksum += container.size();
-        totalTime += sw.getElapsedMillisec();
+        state.pause_timing();
     }
 
-    elapsedTime = totalTime;
-    check_sum = checksum;
-
-    print_test_time<Container>(check_sum, elapsedTime);
+    state.set_items_per_iteration(data_length);
+    state.set_checksum(checksum / state.iterations());
 }
 
 template <typename Container, typename Vector>
-void test_hashmap_emplace_predicted(const Vector & test_data,
-                                    double & elapsedTime, std::size_t & check_sum)
+void test_hashmap_emplace_predicted(jtest::BenchmarkState & state, const Vector & test_data)
 {
     std::size_t data_length = test_data.size();
-    std::size_t repeat_times;
-    if (data_length != 0)
-        repeat_times = (kIterations / data_length) + 1;
-    else
-        repeat_times = 0;
 
     std::size_t checksum = 0;
-    double totalTime = 0.0;
-    jtest::StopWatch sw;
-
-    for (std::size_t n = 0; n < repeat_times; n++) {
+    while (state.keep_running()) {
+        state.pause_timing();
         Container container(kInitCapacity);
         container.reserve(data_length);
+        state.resume_timing();
 
-        sw.start();
         for (std::size_t i = 0; i < data_length; i++) {
             container.emplace(test_data[i].first, test_data[i].second);
         }
-        sw.stop();
 
         checksum += container.size();
-        totalTime += sw.getElapsedMillisec();
+        state.pause_timing();
     }
 
-    elapsedTime = totalTime;
-    check_sum = checksum;
-
-    print_test_time<Container>(check_sum, elapsedTime);
+    state.set_items_per_iteration(data_length);
+    state.set_checksum(checksum / state.iterations());
 }
 
 template <typename Container, typename Vector>
-void test_hashmap_emplace_replace(const Vector & test_data,
-                                  double & elapsedTime, std::size_t & check_sum)
+void test_hashmap_emplace_replace(jtest::BenchmarkState & state, const Vector & test_data)
 {
     std::size_t data_length = test_data.size();
-    std::size_t repeat_times;
-    if (data_length != 0)
-        repeat_times = (kIterations / data_length) + 1;
-    else
-        repeat_times = 0;
 
     std::size_t checksum = 0;
-    double totalTime = 0.0;
-    jtest::StopWatch sw;
-
-    for (std::size_t n = 0; n < repeat_times; n++) {
+    while (state.keep_running()) {
+        state.pause_timing();
         Container container(kInitCapacity);
         for (std::size_t i = 0; i < data_length; i++) {
             container.emplace(test_data[i].first, test_data[i].second);
         }
+        state.resume_timing();
 
-        sw.start();
         for (std::size_t i = 0; i < data_length; i++) {
             std::size_t reverse_idx = data_length - 1 - i;
             container.emplace(test_data[i].first, test_data[reverse_idx].second);
         }
-        sw.stop();
 
         checksum += container.size();
-        totalTime += sw.getElapsedMillisec();
+        state.pause_timing();
     }
 
-    elapsedTime = totalTime;
-    check_sum = checksum;
-
-    print_test_time<Container>(check_sum, elapsedTime);
+    state.set_items_per_iteration(data_length);
+    state.set_checksum(checksum / state.iterations());
 }
 
 template <typename Container, typename Vector>
-void test_hashmap_erase_sequential(const Vector & test_data,
-                                   double & elapsedTime, std::size_t & check_sum)
+void test_hashmap_erase_sequential(jtest::BenchmarkState & state, const Vector & test_data)
 {
     std::size_t data_length = test_data.size();
-    std::size_t repeat_times;
-    if (data_length != 0)
-        repeat_times = (kIterations / data_length) + 1;
-    else
-        repeat_times = 0;
 
     std::size_t checksum = 0;
-    double totalTime = 0.0;
-    jtest::StopWatch sw;
-
-    for (std::size_t n = 0; n < repeat_times; n++) {
+    while (state.keep_running()) {
+        state.pause_timing();
         Container container(kInitCapacity);
         for (std::size_t i = 0; i < data_length; i++) {
             container.emplace(test_data[i].first, test_data[i].second);
         }
         checksum += container.size();
+        state.resume_timing();
 
-        sw.start();
         for (std::size_t i = 0; i < data_length; i++) {
             container.erase(test_data[i].first);
         }
-        sw.stop();
 
+        state.pause_timing();
         assert(container.size() == 0);
 #ifdef _DEBUG
         if (container.size() != 0) {
@@ -734,102 +615,73 @@ void test_hashmap_erase_sequential(const Vector & test_data,
         }
 #endif
         checksum += container.size();
-        totalTime += sw.getElapsedMillisec();
     }
 
-    elapsedTime = totalTime;
-    check_sum = checksum;
-
-    print_test_time<Container>(check_sum, elapsedTime);
+    state.set_items_per_iteration(data_length);
+    state.set_checksum(checksum / state.iterations());
 }
 
 template <typename Container, typename Vector>
-void test_hashmap_erase_random(const Vector & test_data, const Vector & rand_data,
-                               double & elapsedTime, std::size_t & check_sum)
+void test_hashmap_erase_random(jtest::BenchmarkState & state,
+                               const Vector & test_data, const Vector & rand_data)
 {
     std::size_t data_length = test_data.size();
-    std::size_t repeat_times;
-    if (data_length != 0)
-        repeat_times = (kIterations / data_length) + 1;
-    else
-        repeat_times = 0;
 
     std::size_t checksum = 0;
-    double totalTime = 0.0;
-    jtest::StopWatch sw;
-
-    for (std::size_t n = 0; n < repeat_times; n++) {
+    while (state.keep_running()) {
+        state.pause_timing();
         Container container(kInitCapacity);
         for (std::size_t i = 0; i < data_length; i++) {
             container.emplace(test_data[i].first, test_data[i].second);
         }
         checksum += container.size();
+        state.resume_timing();
 
-        sw.start();
         for (std::size_t i = 0; i < data_length; i++) {
             container.erase(rand_data[i].first);
         }
-        sw.stop();
 
+        state.pause_timing();
         assert(container.size() == 0);
         checksum += container.size();
-        totalTime += sw.getElapsedMillisec();
     }
 
-    elapsedTime = totalTime;
-    check_sum = checksum;
-
-    print_test_time<Container>(check_sum, elapsedTime);
+    state.set_items_per_iteration(data_length);
+    state.set_checksum(checksum / state.iterations());
 }
 
 template <typename Container, typename Vector>
-void test_hashmap_erase_failed(const Vector & test_data, const Vector & reverse_data,
-                               double & elapsedTime, std::size_t & check_sum)
+void test_hashmap_erase_failed(jtest::BenchmarkState & state,
+                               const Vector & test_data, const Vector & reverse_data)
 {
     std::size_t data_length = test_data.size();
-    std::size_t repeat_times;
-    if (data_length != 0)
-        repeat_times = (kIterations / data_length) + 1;
-    else
-        repeat_times = 0;
 
     std::size_t checksum = 0;
-    double totalTime = 0.0;
-    jtest::StopWatch sw;
-
-    for (std::size_t n = 0; n < repeat_times; n++) {
+    while (state.keep_running()) {
+        state.pause_timing();
         Container container(kInitCapacity);
         for (std::size_t i = 0; i < data_length; i++) {
             container.emplace(test_data[i].first, test_data[i].second);
         }
         checksum += container.size();
+        state.resume_timing();
 
-        sw.start();
         for (std::size_t i = 0; i < data_length; i++) {
             container.erase(reverse_data[i].first);
         }
-        sw.stop();
 
+        state.pause_timing();
         checksum += container.size();
-        totalTime += sw.getElapsedMillisec();
     }
 
-    elapsedTime = totalTime;
-    check_sum = checksum;
-
-    print_test_time<Container>(check_sum, elapsedTime);
+    state.set_items_per_iteration(data_length);
+    state.set_checksum(checksum / state.iterations());
 }
 
 template <typename Container, typename Vector>
-void test_hashmap_rehash(const Vector & test_data,
-                         double & elapsedTime, std::size_t & check_sum)
+void test_hashmap_rehash(jtest::BenchmarkState & state, const Vector & test_data)
 {
     std::size_t data_length = test_data.size();
-    std::size_t repeat_times;
-    if (data_length != 0)
-        repeat_times = (kIterations / 2 / data_length) + 1;
-    else
-        repeat_times = 0;
 
     Container container(kInitCapacity);
     for (std::size_t i = 0; i < data_length; i++) {
@@ -837,12 +689,9 @@ void test_hashmap_rehash(const Vector & test_data,
     }
 
     std::size_t checksum = 0;
-    double totalTime = 0.0;
     std::size_t bucket_counts = 0;
-    jtest::StopWatch sw;
 
-    sw.start();
-    for (std::size_t n = 0; n < repeat_times; n++) {
+    while (state.keep_running()) {
         checksum += container.size();
         checksum += container.bucket_count();
 
@@ -877,34 +726,21 @@ void test_hashmap_rehash(const Vector & test_data,
 #endif
         }
     }
-    sw.stop();
-
-    totalTime = sw.getElapsedMillisec();
-
-    elapsedTime = totalTime;
-    check_sum = checksum;
 
-    print_test_time<Container>(check_sum, elapsedTime);
+    // The time of the rehash()s per entry.
+    state.set_items_per_iteration(data_length);
+    state.set_checksum(checksum / state.iterations());
 }
 
 template <typename Container, typename Vector>
-void test_hashmap_rehash2(const Vector & test_data,
-                          double & elapsedTime, std::size_t & check_sum)
+void test_hashmap_rehash2(jtest::BenchmarkState & state, const Vector & test_data)
 {
     std::size_t data_length = test_data.size();
-    std::size_t repeat_times;
-    if (data_length != 0)
-        repeat_times = (kIterations / 2 / data_length) + 1;
-    else
-        repeat_times = 0;
 
     std::size_t checksum = 0;
-    double totalTime = 0.0;
     std::size_t bucket_counts = 0;
-    jtest::StopWatch sw;
 
-    sw.start();
-    for (std::size_t n = 0; n < repeat_times; n++) {
+    while (state.keep_running()) {
         Container container(kInitCapacity);
         for (std::size_t i = 0; i < data_length; i++) {
             container.emplace(test_data[i].first, test_data[i].second);
@@ -943,14 +779,56 @@ void test_hashmap_rehash2(const Vector & test_data,
 #endif
         }
     }
-    sw.stop();
 
-    totalTime = sw.getElapsedMillisec();
+    // The time of the rehash()s per entry.
+    state.set_items_per_iteration(data_length);
+    state.set_checksum(checksum / state.iterations());
+}
 
-    elapsedTime = totalTime;
-    check_sum = checksum;
+template <typename Container, typename Vector>
+void test_hashmap_memory_usage(const char * name, const Vector & test_data)
+{
+    typedef typename jtest::TrackedContainer<Container>::type TrackedContainer;
 
-    print_test_time<Container>(check_sum, elapsedTime);
+    std::size_t data_length = test_data.size();
+    jstd::allocation_stats stats;
+    {
+        jstd::allocation_tracking_scope scope(stats);
+        TrackedContainer container(kInitCapacity);
+        for (std::size_t i = 0; i < data_length; i++) {
+            container.insert(std::make_pair(test_data[i].first, test_data[i].second));
+        }
+        jtest::print_allocation_stats(name, stats, container.size());
+    }
+}
+
+//
+// Run a test for the two containers, the case names are like
+// "jstd::Dictionary: hash_map<int, int>/find/random", the median time
+// of one operation is added to the result table.
+//
+void run_hashmap_test(jtest::BenchmarkResult & result, std::size_t cat_id,
+                      const std::string & test_name,
+                      const jtest::BenchmarkCase::function_type & test_func1,
+                      const jtest::BenchmarkCase::function_type & test_func2)
+{
+    jtest::BenchmarkCategory * category = result.getCategory(cat_id);
+    assert(category != nullptr);
+
+    std::size_t pos = test_name.find('/');
+    std::string test_path = category->name() +
+                            ((pos != std::string::npos) ? test_name.substr(pos) : test_name);
+
+    s_runner.set_label("container", result.getName1());
+    const jtest::BenchmarkStats * stats1 = s_runner.run(result.getName1() + ": " + test_path, test_func1);
+    s_runner.set_label("container", result.getName2());
+    const jtest::BenchmarkStats * stats2 = s_runner.run(result.getName2() + ": " + test_path, test_func2);
+
+    if (stats1 != nullptr && stats2 != nullptr) {
+        result.addResult(cat_id, test_name,
+                         stats1->median / 1000000.0, stats1->checksum,
+                         stats2->median / 1000000.0, stats2->checksum);
+    }
 }
 
 template <typename Container1, typename Container2, typename Vector>
@@ -961,8 +839,9 @@ void hashmap_benchmark_simple(const std::string & cat_name,
 {
     std::size_t cat_id = result.addCategory(cat_name);
 
-    double elapsedTime1, elapsedTime2;
-    std::size_t checksum1, checksum2;
+    s_runner.clear_labels();
+    s_runner.set_label("key_type", cat_name);
+    s_runner.set_label("data_size", test_data.size());
 
     Vector rand_data;
     copy_and_shuffle_vector(rand_data, test_data);
@@ -970,130 +849,185 @@ void hashmap_benchmark_simple(const std::string & cat_name,
     //
     // test hashmap<K, V>/find/sequential
     //
-    test_hashmap_find_sequential<Container1, Vector>(test_data, elapsedTime1, checksum1);
-    test_hashmap_find_sequential<Container2, Vector>(test_data, elapsedTime2, checksum2);
-
-    result.addResult(cat_id, "hash_map<K, V>/find/sequential", elapsedTime1, checksum1, elapsedTime2, checksum2);
+    run_hashmap_test(result, cat_id, "hash_map<K, V>/find/sequential",
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_find_sequential<Container1, Vector>(state, test_data);
+        },
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_find_sequential<Container2, Vector>(state, test_data);
+        });
 
     //
     // test hashmap<K, V>/find/random
     //
-    test_hashmap_find_random<Container1, Vector>(test_data, rand_data, elapsedTime1, checksum1);
-    test_hashmap_find_random<Container2, Vector>(test_data, rand_data, elapsedTime2, checksum2);
-
-    result.addResult(cat_id, "hash_map<K, V>/find/random", elapsedTime1, checksum1, elapsedTime2, checksum2);
+    run_hashmap_test(result, cat_id, "hash_map<K, V>/find/random",
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_find_random<Container1, Vector>(state, test_data, rand_data);
+        },
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_find_random<Container2, Vector>(state, test_data, rand_data);
+        });
 
     //
     // test hashmap<K, V>/find/failed
     //
-    test_hashmap_find_failed<Container1, Vector>(test_data, reverse_data, elapsedTime1, checksum1);
-    test_hashmap_find_failed<Container2, Vector>(test_data, reverse_data, elapsedTime2, checksum2);
-
-    result.addResult(cat_id, "hash_map<K, V>/find/failed", elapsedTime1, checksum1, elapsedTime2, checksum2);
+    run_hashmap_test(result, cat_id, "hash_map<K, V>/find/failed",
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_find_failed<Container1, Vector>(state, test_data, reverse_data);
+        },
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_find_failed<Container2, Vector>(state, test_data, reverse_data);
+        });
 
     //
     // test hashmap<K, V>/find/empty
     //
-    test_hashmap_find_empty<Container1, Vector>(test_data, elapsedTime1, checksum1);
-    test_hashmap_find_empty<Container2, Vector>(test_data, elapsedTime2, checksum2);
-
-    result.addResult(cat_id, "hash_map<K, V>/find/empty", elapsedTime1, checksum1, elapsedTime2, checksum2);
+    run_hashmap_test(result, cat_id, "hash_map<K, V>/find/empty",
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_find_empty<Container1, Vector>(state, test_data);
+        },
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_find_empty<Container2, Vector>(state, test_data);
+        });
 
     result.addBlankLine(cat_id);
 
     //
     // test hashmap<K, V>/insert
     //
-    test_hashmap_insert<Container1, Vector>(test_data, elapsedTime1, checksum1);
-    test_hashmap_insert<Container2, Vector>(test_data, elapsedTime2, checksum2);
-
-    result.addResult(cat_id, "hash_map<K, V>/insert", elapsedTime1, checksum1, elapsedTime2, checksum2);
+    run_hashmap_test(result, cat_id, "hash_map<K, V>/insert",
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_insert<Container1, Vector>(state, test_data);
+        },
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_insert<Container2, Vector>(state, test_data);
+        });
 
     //
     // test hashmap<K, V>/insert/predicted
     //
-    test_hashmap_insert_predicted<Container1, Vector>(test_data, elapsedTime1, checksum1);
-    test_hashmap_insert_predicted<Container2, Vector>(test_data, elapsedTime2, checksum2);
-
-    result.addResult(cat_id, "hash_map<K, V>/insert/predicted", elapsedTime1, checksum1, elapsedTime2, checksum2);
+    run_hashmap_test(result, cat_id, "hash_map<K, V>/insert/predicted",
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_insert_predicted<Container1, Vector>(state, test_data);
+        },
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_insert_predicted<Container2, Vector>(state, test_data);
+        });
 
     //
     // test hashmap<K, V>/insert/replace
     //
-    test_hashmap_insert_replace<Container1, Vector>(test_data, elapsedTime1, checksum1);
-    test_hashmap_insert_replace<Container2, Vector>(test_data, elapsedTime2, checksum2);
-
-    result.addResult(cat_id, "hash_map<K, V>/insert/replace", elapsedTime1, checksum1, elapsedTime2, checksum2);
+    run_hashmap_test(result, cat_id, "hash_map<K, V>/insert/replace",
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_insert_replace<Container1, Vector>(state, test_data);
+        },
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_insert_replace<Container2, Vector>(state, test_data);
+        });
 
     result.addBlankLine(cat_id);
 
     //
     // test hashmap<K, V>/emplace
     //
-    test_hashmap_emplace<Container1, Vector>(test_data, elapsedTime1, checksum1);
-    test_hashmap_emplace<Container2, Vector>(test_data, elapsedTime2, checksum2);
-
-    result.addResult(cat_id, "hash_map<K, V>/emplace", elapsedTime1, checksum1, elapsedTime2, checksum2);
+    run_hashmap_test(result, cat_id, "hash_map<K, V>/emplace",
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_emplace<Container1, Vector>(state, test_data);
+        },
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_emplace<Container2, Vector>(state, test_data);
+        });
 
     //
     // test hashmap<K, V>/emplace/predicted
     //
-    test_hashmap_emplace_predicted<Container1, Vector>(test_data, elapsedTime1, checksum1);
-    test_hashmap_emplace_predicted<Container2, Vector>(test_data, elapsedTime2, checksum2);
-
-    result.addResult(cat_id, "hash_map<K, V>/emplace/predicted", elapsedTime1, checksum1, elapsedTime2, checksum2);
+    run_hashmap_test(result, cat_id, "hash_map<K, V>/emplace/predicted",
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_emplace_predicted<Container1, Vector>(state, test_data);
+        },
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_emplace_predicted<Container2, Vector>(state, test_data);
+        });
 
     //
     // test hashmap<K, V>/emplace/replace
     //
-    test_hashmap_emplace_replace<Container1, Vector>(test_data, elapsedTime1, checksum1);
-    test_hashmap_emplace_replace<Container2, Vector>(test_data, elapsedTime2, checksum2);
-
-    result.addResult(cat_id, "hash_map<K, V>/emplace/replace", elapsedTime1, checksum1, elapsedTime2, checksum2);
+    run_hashmap_test(result, cat_id, "hash_map<K, V>/emplace/replace",
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_emplace_replace<Container1, Vector>(state, test_data);
+        },
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_emplace_replace<Container2, Vector>(state, test_data);
+        });
 
     result.addBlankLine(cat_id);
 
     //
     // test hashmap<K, V>/erase/sequential
     //
-    test_hashmap_erase_sequential<Container1, Vector>(test_data, elapsedTime1, checksum1);
-    test_hashmap_erase_sequential<Container2, Vector>(test_data, elapsedTime2, checksum2);
-
-    result.addResult(cat_id, "hash_map<K, V>/erase/sequential", elapsedTime1, checksum1, elapsedTime2, checksum2);
+    run_hashmap_test(result, cat_id, "hash_map<K, V>/erase/sequential",
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_erase_sequential<Container1, Vector>(state, test_data);
+        },
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_erase_sequential<Container2, Vector>(state, test_data);
+        });
 
     //
     // test hashmap<K, V>/erase/random
     //
-    test_hashmap_erase_random<Container1, Vector>(test_data, rand_data, elapsedTime1, checksum1);
-    test_hashmap_erase_random<Container2, Vector>(test_data, rand_data, elapsedTime2, checksum2);
-
-    result.addResult(cat_id, "hash_map<K, V>/erase/random", elapsedTime1, checksum1, elapsedTime2, checksum2);
+    run_hashmap_test(result, cat_id, "hash_map<K, V>/erase/random",
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_erase_random<Container1, Vector>(state, test_data, rand_data);
+        },
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_erase_random<Container2, Vector>(state, test_data, rand_data);
+        });
 
     //
     // test hashmap<K, V>/erase/failed
     //
-    test_hashmap_erase_failed<Container1, Vector>(test_data, reverse_data, elapsedTime1, checksum1);
-    test_hashmap_erase_failed<Container2, Vector>(test_data, reverse_data, elapsedTime2, checksum2);
-
-    result.addResult(cat_id, "hash_map<K, V>/erase/failed", elapsedTime1, checksum1, elapsedTime2, checksum2);
+    run_hashmap_test(result, cat_id, "hash_map<K, V>/erase/failed",
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_erase_failed<Container1, Vector>(state, test_data, reverse_data);
+        },
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_erase_failed<Container2, Vector>(state, test_data, reverse_data);
+        });
 
     result.addBlankLine(cat_id);
 
     //
     // test hashmap<K, V>/rehash
     //
-    test_hashmap_rehash<Container1, Vector>(test_data, elapsedTime1, checksum1);
-    test_hashmap_rehash<Container2, Vector>(test_data, elapsedTime2, checksum2);
-
-    result.addResult(cat_id, "hash_map<K, V>/rehash", elapsedTime1, checksum1, elapsedTime2, checksum2);
+    run_hashmap_test(result, cat_id, "hash_map<K, V>/rehash",
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_rehash<Container1, Vector>(state, test_data);
+        },
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_rehash<Container2, Vector>(state, test_data);
+        });
 
     //
     // test hashmap<K, V>/rehash2
     //
-    test_hashmap_rehash2<Container1, Vector>(test_data, elapsedTime1, checksum1);
-    test_hashmap_rehash2<Container2, Vector>(test_data, elapsedTime2, checksum2);
+    run_hashmap_test(result, cat_id, "hash_map<K, V>/rehash2",
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_rehash2<Container1, Vector>(state, test_data);
+        },
+        [&](jtest::BenchmarkState & state) {
+            test_hashmap_rehash2<Container2, Vector>(state, test_data);
+        });
 
-    result.addResult(cat_id, "hash_map<K, V>/rehash2", elapsedTime1, checksum1, elapsedTime2, checksum2);
+    //
+    // The exact heap bytes of the containers (not include the heap memory of the key and value).
+    //
+    jtest::BenchmarkCategory * category = result.getCategory(cat_id);
+    if (category != nullptr && category->size() != 0) {
+        printf("\n");
+        test_hashmap_memory_usage<Container1, Vector>(result.getName1().c_str(), test_data);
+        test_hashmap_memory_usage<Container2, Vector>(result.getName2().c_str(), test_data);
+    }
 }
 
 void hashmap_benchmark_all()
@@ -1195,17 +1129,18 @@ void hashmap_benchmark_all()
             //
             // std::unordered_map<jstd::string_view, jstd::string_view>
             //
-            typedef jstd::string_view_array<jstd::string_view, jstd::string_view> string_view_array_t;
+            typedef jstd::flat_string_view_array<jstd::string_view, jstd::string_view>
+                                                                                  string_view_array_t;
             typedef typename string_view_array_t::element_type                    element_type;
 
             string_view_array_t test_data_svsv;
             string_view_array_t reverse_data_svsv;
 
             for (std::size_t i = 0; i < test_data_ss.size(); i++) {
-                test_data_svsv.push_back(new element_type(test_data_ss[i].first, test_data_ss[i].second));
+                test_data_svsv.push_back(element_type(test_data_ss[i].first, test_data_ss[i].second));
             }
             for (std::size_t i = 0; i < reverse_data_ss.size(); i++) {
-                reverse_data_svsv.push_back(new element_type(reverse_data_ss[i].first, reverse_data_ss[i].second));
+                reverse_data_svsv.push_back(element_type(reverse_data_ss[i].first, reverse_data_ss[i].second));
             }
 
             std::unordered_map<jstd::string_view, jstd::string_view> std_map_svsv;
@@ -1329,17 +1264,18 @@ void hashmap_benchmark_same_hash_all()
             //
             // std::unordered_map<jstd::string_view, jstd::string_view>
             //
-            typedef jstd::string_view_array<jstd::string_view, jstd::string_view> string_view_array_t;
+            typedef jstd::flat_string_view_array<jstd::string_view, jstd::string_view>
+                                                                                  string_view_array_t;
             typedef typename string_view_array_t::element_type                    element_type;
 
             string_view_array_t test_data_svsv;
             string_view_array_t reverse_data_svsv;
 
             for (std::size_t i = 0; i < test_data_ss.size(); i++) {
-                test_data_svsv.push_back(new element_type(test_data_ss[i].first, test_data_ss[i].second));
+                test_data_svsv.push_back(element_type(test_data_ss[i].first, test_data_ss[i].second));
             }
             for (std::size_t i = 0; i < reverse_data_ss.size(); i++) {
-                reverse_data_svsv.push_back(new element_type(reverse_data_ss[i].first, reverse_data_ss[i].second));
+                reverse_data_svsv.push_back(element_type(reverse_data_ss[i].first, reverse_data_ss[i].second));
             }
 
             std::unordered_map<jstd::string_view, jstd::string_view, std::hash<jstd::string_view>> std_map_svsv;
@@ -1362,23 +1298,318 @@ void hashmap_benchmark_same_hash_all()
     test_result.printResult(dict_filename, sw.getElapsedMillisec());
 }
 
+template <typename Container>
+void string_dictionary_benchmark_impl(const char * name,
+                                      const std::vector<std::pair<std::string, std::string>> & test_data)
+{
+    typedef typename jtest::TrackedContainer<Container>::type TrackedContainer;
+
+    std::size_t data_length = test_data.size();
+    std::string case_name(name);
+
+    s_runner.clear_labels();
+    s_runner.set_label("container", case_name);
+    s_runner.set_label("data_size", data_length);
+
+    s_runner.run(case_name + "/emplace", [&](jtest::BenchmarkState & state) {
+        std::size_t checksum = 0;
+        while (state.keep_running()) {
+            state.pause_timing();
+            Container container(kInitCapacity);
+            state.resume_timing();
+
+            for (std::size_t i = 0; i < data_length; i++) {
+                container.emplace(test_data[i].first, test_data[i].second);
+            }
+
+            checksum += container.size();
+            state.pause_timing();
+        }
+        state.set_items_per_iteration(data_length);
+        state.set_checksum(checksum / state.iterations());
+    });
+
+    if (s_runner.options().list_only) {
+        s_runner.run(case_name + "/find", [](jtest::BenchmarkState &) {});
+        return;
+    }
+
+    jstd::allocation_stats stats;
+    {
+        jstd::allocation_tracking_scope scope(stats);
+        TrackedContainer container(kInitCapacity);
+
+        for (std::size_t i = 0; i < data_length; i++) {
+            container.emplace(test_data[i].first, test_data[i].second);
+        }
+
+        s_runner.run(case_name + "/find", [&](jtest::BenchmarkState & state) {
+            std::size_t checksum = 0;
+            while (state.keep_running()) {
+                for (std::size_t i = 0; i < data_length; i++) {
+                    if (container.find(test_data[i].first) != container.end()) {
+                        checksum++;
+                    }
+                }
+            }
+            state.set_items_per_iteration(data_length);
+            state.set_checksum(checksum / state.iterations());
+        });
+
+        printf(" %-60s memory: %" PRIuPTR " bytes, %0.2f bytes/entry\n",
+               name, stats.live_bytes.load(), stats.bytes_per_entry(container.size()));
+    }
+}
+
+void string_dictionary_benchmark()
+{
+    std::vector<std::pair<std::string, std::string>> test_data;
+
+    if (!dict_words_is_ready) {
+        for (std::size_t i = 0; i < kHeaderFieldSize; i++) {
+            test_data.push_back(std::make_pair(std::string(header_fields[i]), std::to_string(i)));
+        }
+    }
+    else {
+        for (std::size_t i = 0; i < dict_words.size(); i++) {
+            test_data.push_back(std::make_pair(dict_words[i], std::to_string(i)));
+        }
+    }
+
+    printf("-------------------------------------------------------------------------------------------------\n");
+    printf(" string_dictionary_benchmark(), keys = %" PRIuPTR "\n\n", test_data.size());
+
+    string_dictionary_benchmark_impl<jstd::Dictionary<std::string, std::string>>(
+        "jstd::Dictionary<std::string, std::string>", test_data);
+    string_dictionary_benchmark_impl<jstd::StringDictionary<std::string>>(
+        "jstd::StringDictionary<std::string>", test_data);
+
+    {
+        jstd::StringDictionary<std::string> dict(kInitCapacity);
+        for (std::size_t i = 0; i < test_data.size(); i++) {
+            dict.emplace(test_data[i].first, test_data[i].second);
+        }
+        printf("\n");
+        printf(" StringDictionary: sizeof(key) = %u, arena used = %" PRIuPTR " bytes, "
+               "arena allocated = %" PRIuPTR " bytes\n",
+               (uint32_t)sizeof(jstd::interned_key),
+               dict.arena().used_bytes(), dict.arena().allocated_bytes());
+    }
+
+    printf("-------------------------------------------------------------------------------------------------\n");
+    printf("\n");
+}
+
+template <typename Container>
+const jtest::BenchmarkStats *
+dictionary_create_destroy_loop(const std::string & name, std::size_t entries)
+{
+    return s_runner.run(name, [&](jtest::BenchmarkState & state) {
+        std::size_t checksum = 0;
+        std::size_t n = 0;
+        while (state.keep_running()) {
+            Container container(kInitCapacity);
+            for (std::size_t i = 0; i < entries; i++) {
+                container.emplace(i, n + i);
+            }
+            checksum += container.size();
+            n++;
+        }
+        state.set_items_per_iteration(entries);
+        state.set_checksum(checksum / state.iterations());
+    });
+}
+
+void dictionary_chunk_recycler_benchmark()
+{
+    typedef jstd::Dictionary<std::size_t, std::size_t> Container;
+    typedef typename Container::chunk_recycler_type    chunk_recycler_type;
+
+#ifndef _DEBUG
+    static const std::size_t kEntries = 200000;
+#else
+    static const std::size_t kEntries = 10000;
+#endif
+
+    chunk_recycler_type & recycler = Container::chunk_recycler();
+
+    printf("-------------------------------------------------------------------------------------------------\n");
+    printf(" dictionary_chunk_recycler_benchmark(), entries = %" PRIuPTR "\n\n", kEntries);
+
+    s_runner.clear_labels();
+    s_runner.set_label("container", "jstd::Dictionary<std::size_t, std::size_t>");
+    s_runner.set_label("data_size", kEntries);
+
+    recycler.set_max_bytes(0);
+    dictionary_create_destroy_loop<Container>(
+        "dictionary_chunk_recycler/create_fill_destroy/disabled", kEntries);
+
+    recycler.set_max_bytes(64 * 1024 * 1024);
+    recycler.reset_counters();
+    const jtest::BenchmarkStats * stats = dictionary_create_destroy_loop<Container>(
+        "dictionary_chunk_recycler/create_fill_destroy/enabled", kEntries);
+
+    if (stats != nullptr) {
+        printf("\n");
+        printf(" recycler: hits = %" PRIuPTR ", misses = %" PRIuPTR ", recycled = %" PRIuPTR
+               ", dropped = %" PRIuPTR ", cached = %" PRIuPTR " bytes\n",
+               recycler.hits(), recycler.misses(), recycler.recycled(),
+               recycler.dropped(), recycler.cached_bytes());
+    }
+
+    recycler.set_max_bytes(0);
+
+    printf("-------------------------------------------------------------------------------------------------\n");
+    printf("\n");
+}
+
+template <typename Container>
+void small_dictionary_benchmark_impl(const std::string & name,
+                                     const std::vector<std::string> & keys, std::size_t entries,
+                                     double & build_time, double & find_time,
+                                     std::size_t & checksum, std::size_t & memory_bytes)
+{
+    typedef typename jtest::TrackedContainer<Container>::type TrackedContainer;
+
+    build_time = 0.0;
+    find_time = 0.0;
+    checksum = 0;
+    memory_bytes = 0;
+
+    s_runner.clear_labels();
+    s_runner.set_label("key_type", "std::string");
+    s_runner.set_label("data_size", entries);
+
+    const jtest::BenchmarkStats * build_stats =
+        s_runner.run(name + "/build", [&](jtest::BenchmarkState & state) {
+            std::size_t build_checksum = 0;
+            while (state.keep_running()) {
+                Container container;
+                for (std::size_t i = 0; i < entries; i++) {
+                    container.emplace(keys[i], i);
+                }
+                build_checksum += container.size();
+            }
+            state.set_items_per_iteration(entries);
+            state.set_checksum(build_checksum / state.iterations());
+        });
+
+    Container container;
+    for (std::size_t i = 0; i < entries; i++) {
+        container.emplace(keys[i], i);
+    }
+
+    const jtest::BenchmarkStats * find_stats =
+        s_runner.run(name + "/find", [&](jtest::BenchmarkState & state) {
+            std::size_t find_checksum = 0;
+            while (state.keep_running()) {
+                for (std::size_t i = 0; i < entries; i++) {
+                    if (container.find(keys[i]) != container.end()) {
+                        find_checksum++;
+                    }
+                }
+            }
+            state.set_items_per_iteration(entries);
+            state.set_checksum(find_checksum / state.iterations());
+        });
+
+    if (build_stats != nullptr) {
+        build_time = build_stats->median;
+        checksum += build_stats->checksum;
+    }
+    if (find_stats != nullptr) {
+        find_time = find_stats->median;
+        checksum += find_stats->checksum;
+    }
+
+    jstd::allocation_stats stats;
+    {
+        jstd::allocation_tracking_scope scope(stats);
+        TrackedContainer tracked;
+        for (std::size_t i = 0; i < entries; i++) {
+            tracked.emplace(keys[i], i);
+        }
+        memory_bytes = sizeof(TrackedContainer) + stats.live_bytes;
+    }
+}
+
+void small_dictionary_benchmark()
+{
+    typedef jstd::Dictionary<std::string, std::size_t>      Container1;
+    typedef jstd::SmallDictionary<std::string, std::size_t> Container2;
+
+    static const std::size_t kMaxEntries = 32;
+    static const std::size_t entry_sizes[] = { 1, 2, 4, 8, 12, 16, 24, 32 };
+    static const std::size_t kEntrySizes = sizeof(entry_sizes) / sizeof(entry_sizes[0]);
+
+    std::vector<std::string> keys;
+    for (std::size_t i = 0; i < kMaxEntries; i++) {
+        if (i < kHeaderFieldSize)
+            keys.push_back(std::string(header_fields[i]));
+        else
+            keys.push_back(std::string("X-Field-") + std::to_string(i));
+    }
+
+    printf("-------------------------------------------------------------------------------------------------\n");
+    printf(" small_dictionary_benchmark(), %s vs %s\n\n", Container1::name(), Container2::name());
+
+    double build_time1[kEntrySizes], build_time2[kEntrySizes];
+    double find_time1[kEntrySizes], find_time2[kEntrySizes];
+    std::size_t checksum1[kEntrySizes], checksum2[kEntrySizes];
+    std::size_t memory1[kEntrySizes], memory2[kEntrySizes];
+
+    for (std::size_t n = 0; n < kEntrySizes; n++) {
+        std::size_t entries = entry_sizes[n];
+        std::string suffix = "/entries=" + std::to_string(entries);
+
+        small_dictionary_benchmark_impl<Container1>(Container1::name() + suffix, keys, entries,
+                                                    build_time1[n], find_time1[n],
+                                                    checksum1[n], memory1[n]);
+        small_dictionary_benchmark_impl<Container2>(Container2::name() + suffix, keys, entries,
+                                                    build_time2[n], find_time2[n],
+                                                    checksum2[n], memory2[n]);
+    }
+
+    if (!s_runner.options().list_only) {
+        printf("\n");
+        printf(" entries |   build (ns/op)     |   find (ns/op)      |   bytes\n");
+        printf("         |   dict     small    |   dict     small    |   dict     small\n");
+        printf(" --------+---------------------+---------------------+------------------\n");
+
+        for (std::size_t n = 0; n < kEntrySizes; n++) {
+            printf(" %7" PRIuPTR " | %8.3f %8.3f   | %8.3f %8.3f   | %7" PRIuPTR " %7" PRIuPTR "%s\n",
+                   entry_sizes[n], build_time1[n], build_time2[n], find_time1[n], find_time2[n],
+                   memory1[n], memory2[n], (checksum1[n] == checksum2[n]) ? "" : "  (checksum failed)");
+        }
+    }
+
+    printf("-------------------------------------------------------------------------------------------------\n");
+    printf("\n");
+}
+
 bool read_dict_words(const std::string & filename)
 {
     bool is_ok = false;
     try {
-        std::ifstream dict(filename.c_str());
-
-        if (dict.is_open()) {
-            std::string word;
-            while (!dict.eof()) {
-                char buf[256];
-                dict.getline(buf, sizeof(buf));
-                word = buf;
-                dict_words.push_back(word);
+        jtest::StopWatch sw;
+        sw.start();
+
+        jstd::mapped_file dict;
+        if (dict.open(filename.c_str())) {
+            dict_words.reserve(jstd::line_splitter::count_lines(dict.data(), dict.size()));
+            jstd::line_splitter splitter(dict.data(), dict.size());
+            jstd::string_view line;
+            while (splitter.next_line(line)) {
+                if (!line.empty())
+                    dict_words.push_back(std::string(line.data(), line.size()));
             }
+            sw.stop();
 
+            double elapsed_time = sw.getElapsedMillisec();
+            printf("read_dict_words(): %" PRIuPTR " words, %" PRIuPTR " bytes, %0.3f ms, %0.1f MB/s\n\n",
+                   dict_words.size(), dict.size(), elapsed_time,
+                   (elapsed_time > 0.0) ? ((double)dict.size() / (1024.0 * 1024.0) / (elapsed_time / 1000.0)) : 0.0);
             is_ok = true;
-            dict.close();
         }
     }
     catch (const std::exception & ex) {
@@ -1409,21 +1640,227 @@ void RandomGenerator_test()
     printf("\n");
 }
 
+//
+// The concurrent finds on a shared read-only container, every thread finds
+// all the keys, starting at a different place.
+//
+template <typename Container>
+void thread_find_benchmark_impl(const std::string & name, const std::vector<std::size_t> & keys,
+                                const std::vector<std::size_t> & thread_counts)
+{
+    Container container(kInitCapacity);
+    if (!s_runner.options().list_only) {
+        for (std::size_t i = 0; i < keys.size(); i++) {
+            container.emplace(keys[i], i);
+        }
+    }
+    const Container & const_container = container;
+
+    s_runner.set_label("container", name);
+
+    jtest::ThreadBench bench(&s_runner);
+    bench.scaling(name + "/find", thread_counts, [&](jtest::ThreadContext & context) {
+        std::size_t count = keys.size();
+        std::size_t start = context.thread_id() * count / context.thread_count();
+        std::size_t found = 0;
+        for (std::size_t n = 0; n < count; n++) {
+            std::size_t index = start + n;
+            if (index >= count)
+                index -= count;
+            context.sampler().start();
+            found += (const_container.find(keys[index]) != const_container.end()) ? 1 : 0;
+            context.sampler().stop();
+        }
+        jtest::DoNotOptimize(found);
+        context.add_operations(count);
+    });
+}
+
+//
+// Every thread creates, fills and destroys its own dictionaries, so it's
+// the allocator (and the shared chunk recycler) that limits the scaling.
+//
+template <typename Container>
+void thread_create_destroy_benchmark_impl(const std::string & name, std::size_t entries,
+                                          const std::vector<std::size_t> & thread_counts)
+{
+    s_runner.set_label("container", name);
+
+    jtest::ThreadBench bench(&s_runner);
+    bench.scaling(name, thread_counts, [&](jtest::ThreadContext & context) {
+        static const std::size_t kLoops = 8;
+        std::size_t checksum = 0;
+        for (std::size_t n = 0; n < kLoops; n++) {
+            Container container(kInitCapacity);
+            for (std::size_t i = 0; i < entries; i++) {
+                container.emplace(i, n + i);
+            }
+            checksum += container.size();
+        }
+        jtest::DoNotOptimize(checksum);
+        context.add_operations(kLoops * entries);
+    });
+}
+
+void thread_scaling_benchmark()
+{
+    typedef jstd::Dictionary<std::size_t, std::size_t> Container;
+    typedef typename Container::chunk_recycler_type    chunk_recycler_type;
+
+#ifndef _DEBUG
+    static const std::size_t kKeys = 200000;
+    static const std::size_t kEntries = 20000;
+#else
+    static const std::size_t kKeys = 10000;
+    static const std::size_t kEntries = 1000;
+#endif
+
+    const jtest::CpuTopology & topology = jtest::CpuTopology::get();
+    std::vector<std::size_t> thread_counts = jtest::ThreadBench::thread_counts();
+
+    printf("-------------------------------------------------------------------------------------------------\n");
+    printf(" thread_scaling_benchmark(), keys = %" PRIuPTR ", threads = 1 ~ %" PRIuPTR "\n\n",
+           kKeys, thread_counts.back());
+    topology.print();
+    printf("\n");
+
+    std::vector<std::size_t> keys(kKeys);
+    jstd::MtRandomGen::srand(20200831);
+    for (std::size_t i = 0; i < kKeys; i++) {
+        keys[i] = jstd::MtRandomGen::nextUInt();
+    }
+
+    s_runner.clear_labels();
+    s_runner.set_label("data_size", kKeys);
+
+    thread_find_benchmark_impl<Container>(
+        "jstd::Dictionary<std::size_t, std::size_t>", keys, thread_counts);
+    thread_find_benchmark_impl<std::unordered_map<std::size_t, std::size_t>>(
+        "std::unordered_map<std::size_t, std::size_t>", keys, thread_counts);
+    printf("\n");
+
+    chunk_recycler_type & recycler = Container::chunk_recycler();
+
+    s_runner.set_label("data_size", kEntries);
+
+    recycler.set_max_bytes(0);
+    thread_create_destroy_benchmark_impl<Container>(
+        "thread_create_destroy/recycler=disabled", kEntries, thread_counts);
+
+    recycler.set_max_bytes(64 * 1024 * 1024);
+    thread_create_destroy_benchmark_impl<Container>(
+        "thread_create_destroy/recycler=enabled", kEntries, thread_counts);
+    recycler.set_max_bytes(0);
+
+    s_runner.clear_labels();
+
+    printf("-------------------------------------------------------------------------------------------------\n");
+    printf("\n");
+}
+
+template <typename RandomEngine, typename T>
+void random_engine_benchmark_impl(const std::string & name, std::vector<T> & buffer)
+{
+    std::size_t count = buffer.size();
+
+    s_runner.set_label("engine", name);
+    s_runner.set_label("bits", sizeof(T) * 8);
+
+    s_runner.run(name + "/next" + std::to_string(sizeof(T) * 8), [&](jtest::BenchmarkState & state) {
+        RandomEngine engine(20200831);
+        std::size_t checksum = 0;
+        while (state.keep_running()) {
+            T sum = 0;
+            for (std::size_t i = 0; i < count; i++) {
+                if (sizeof(T) == 4)
+                    sum += static_cast<T>(engine.nextUInt32());
+                else
+                    sum += static_cast<T>(engine.nextUInt64());
+            }
+            checksum += static_cast<std::size_t>(sum);
+        }
+        state.set_items_per_iteration(count);
+        state.set_checksum(checksum);
+    });
+
+    s_runner.run(name + "/fill" + std::to_string(sizeof(T) * 8), [&](jtest::BenchmarkState & state) {
+        RandomEngine engine(20200831);
+        std::size_t checksum = 0;
+        while (state.keep_running()) {
+            engine.fill(&buffer[0], count);
+            checksum += static_cast<std::size_t>(buffer[count - 1]);
+        }
+        state.set_items_per_iteration(count);
+        state.set_checksum(checksum);
+    });
+}
+
+template <typename RandomEngine>
+void random_engine_benchmark_one(const char * name)
+{
+    static const std::size_t kCount = 16384;
+
+    std::vector<std::uint32_t> buffer32(kCount);
+    std::vector<std::uint64_t> buffer64(kCount);
+    random_engine_benchmark_impl<RandomEngine>(name, buffer32);
+    random_engine_benchmark_impl<RandomEngine>(name, buffer64);
+}
+
+void random_engine_benchmark()
+{
+    printf("-------------------------------------------------------------------------------------------------\n");
+    printf(" random_engine_benchmark(), nextUIntXX() vs fill()\n\n");
+
+    s_runner.clear_labels();
+
+    random_engine_benchmark_one<jstd::MT19937_32>("jstd::MT19937_32");
+    random_engine_benchmark_one<jstd::MT19937_64>("jstd::MT19937_64");
+    random_engine_benchmark_one<jstd::SFMT19937>("jstd::SFMT19937");
+    random_engine_benchmark_one<jstd::Xoshiro256pp>("jstd::Xoshiro256pp");
+    random_engine_benchmark_one<jstd::PCG64>("jstd::PCG64");
+
+    s_runner.clear_labels();
+
+    printf("-------------------------------------------------------------------------------------------------\n");
+    printf("\n");
+}
+
 int main(int argc, char * argv[])
 {
     jstd::MtRandomGen mtRandomGen(20200831);
 
-    if (argc == 2) {
-        std::string filename = argv[1];
+    // The data set is small, a shorter run is enough to be stable.
+    s_runner.options().min_time = 20.0;
+    // Count the hardware events per operation if the PMU is accessible.
+    s_runner.options().perf_counters = true;
+    if (!s_runner.parse_args(argc, argv)) {
+        return 0;
+    }
+
+    if (s_runner.args().size() == 1) {
+        std::string filename = s_runner.args()[0];
         bool read_ok = read_dict_words(filename);
         dict_words_is_ready = read_ok;
         dict_filename = filename;
     }
 
-    jtest::CPU::warm_up(1000);
+    s_runner.metadata().set("hash_func", "jstd::HashFunc_CRC32C");
+    s_runner.metadata().set("dict_file", dict_filename.empty() ? "header_fields[]" : dict_filename);
+    s_runner.metadata().set("dict_keys", dict_words_is_ready ? dict_words.size() : kHeaderFieldSize);
+
+    s_runner.warm_up();
 
+    if (1) random_engine_benchmark();
+    if (1) string_dictionary_benchmark();
+    if (1) dictionary_chunk_recycler_benchmark();
+    if (1) small_dictionary_benchmark();
     if (1) hashmap_benchmark_all();
     if (1) hashmap_benchmark_same_hash_all();
+    if (1) thread_scaling_benchmark();
+
+    if (!jtest::write_reports(s_runner)) {
+        return 1;
+    }
 
     //jstd::Console::ReadKey();
     return 0;
@@ -78,6 +78,8 @@
 #include <vector>
 #include <unordered_map>
 #include <algorithm>
+#include <thread>         // For std::thread::hardware_concurrency()
+#include <type_traits>    // For std::conditional
 #include <cassert>
 
 #define USE_JSTD_HASH_TABLE     0
@@ -118,6 +120,7 @@
 #include <jstd/basic/inttypes.h>
 
 #include <jstd/hash/dictionary.h>
+#include <jstd/hash/hash_aggregator.h>
 #include <jstd/hash/hashmap_analyzer.h>
 #include <jstd/hasher/hash_helper.h>
 #include <jstd/string/string_view.h>
@@ -126,7 +129,9 @@
 #include <jstd/system/RandomGen.h>
 #include <jstd/test/StopWatch.h>
 #include <jstd/test/CPUWarmUp.h>
-#include <jstd/test/ProcessMemInfo.h>
+#include <jstd/test/MemoryTracker.h>
+#include <jstd/test/BenchmarkRunner.h>
+#include <jstd/test/BenchmarkReport.h>
 
 //
 // HashTable performance benchmark (CK/phmap/ska)
@@ -172,12 +177,6 @@ static const std::size_t kDefaultIters = 10000;
 
 static const std::size_t kInitCapacity = 8;
 
-static inline
-std::size_t CurrentMemoryUsage()
-{
-    return jtest::GetCurrentMemoryUsage();
-}
-
 namespace test {
 
 template <typename T>
@@ -275,6 +274,8 @@ private:
 
 LogBuffer s_log;
 
+static jtest::BenchmarkRunner s_runner;
+
 template <typename T>
 struct type_name {
     static const char * name() {
@@ -310,28 +311,6 @@ struct type_name<std::uint64_t> {
     }
 };
 
-std::string formatMsTime(double fMillisec) {
-    char time_buf[256];
-
-    if (fMillisec >= 1000.0 * 60.0 * 30.0) {
-        snprintf(time_buf, sizeof(time_buf), "%7.2f Min", fMillisec / (60.0 * 1000.0));
-    }
-    else if (fMillisec >= 1000.0 * 10.0) {
-        snprintf(time_buf, sizeof(time_buf), "%7.2f Sec", fMillisec / 1000.0);
-    }
-    else if (fMillisec >= 1.0 * 1.0) {
-        snprintf(time_buf, sizeof(time_buf), "%7.2f ms ", fMillisec);
-    }
-    else if (fMillisec >= 0.001 * 10.0) {
-        snprintf(time_buf, sizeof(time_buf), "%7.2f us ", fMillisec * 1000.0);
-    }
-    else {
-        snprintf(time_buf, sizeof(time_buf), "%7.2f ns ", fMillisec * 1000000.0);
-    }
-
-    return std::string(time_buf);
-}
-
 template <typename Key, typename Value>
 std::string get_hashmap_name(const char * fmt)
 {
@@ -344,12 +323,19 @@ std::string get_hashmap_name(const char * fmt)
 template <typename Key>
 std::vector<Key> generate_random_keys(std::size_t data_size, std::size_t key_range)
 {
+    // The same values as nextUInt(), but generated in bulk.
+    typedef typename std::conditional<(sizeof(std::size_t) == 8),
+                                      std::uint64_t, std::uint32_t>::type random_type;
     jstd::MtRandomGen mtRandomGen(20200831);
 
+    std::vector<random_type> randoms(data_size);
+    if (data_size > 0)
+        mtRandomGen.fill(&randoms[0], data_size);
+
     std::vector<Key> keys;
     keys.resize(data_size);
     for (std::size_t i = 0; i < data_size; i++) {
-        keys[i] = static_cast<Key>(mtRandomGen.nextUInt() % key_range);
+        keys[i] = static_cast<Key>(static_cast<std::size_t>(randoms[i]) % key_range);
     }
 
     return keys;
@@ -358,41 +344,142 @@ std::vector<Key> generate_random_keys(std::size_t data_size, std::size_t key_ran
 template <typename HashMap, typename Key = typename HashMap::key_type>
 void run_insert_random(const std::string & name, std::vector<Key> & keys, std::size_t cardinal)
 {
-    typedef typename HashMap::mapped_type mapped_type;
-
-    jtest::StopWatch sw;
-    HashMap hashmap;
-
-    {
-        sw.start();
-        for (std::size_t i = 0; i < keys.size(); i++) {
-            hashmap.insert(std::make_pair(keys[i], mapped_type(i)));
-        }
-        sw.stop();
+    typedef typename jtest::TrackedContainer<HashMap>::type TrackedHashMap;
+    typedef typename HashMap::mapped_type                   mapped_type;
+
+    std::string insert_name = name + "/insert/cardinal=" + std::to_string(cardinal);
+    std::string find_name   = name + "/find/cardinal=" + std::to_string(cardinal);
+
+    s_runner.set_label("container", name);
+    s_runner.set_label("cardinal", cardinal);
+
+    const jtest::BenchmarkStats * insert_stats =
+        s_runner.run(insert_name, [&](jtest::BenchmarkState & state) {
+            std::size_t hashmap_size = 0;
+            while (state.keep_running()) {
+                HashMap hashmap;
+                for (std::size_t i = 0; i < keys.size(); i++) {
+                    hashmap.insert(std::make_pair(keys[i], mapped_type(i)));
+                }
+                hashmap_size = hashmap.size();
+                // The destructor is not timed.
+                state.pause_timing();
+            }
+            state.set_items_per_iteration(keys.size());
+            state.set_checksum(hashmap_size);
+        });
+
+    if (s_runner.options().list_only) {
+        // Only print the name of the find case.
+        s_runner.run(find_name, [](jtest::BenchmarkState &) {});
+        return;
+    }
+    if (insert_stats == nullptr && !s_runner.is_selected(find_name))
+        return;
 
-        double elapsed_time = sw.getElapsedMillisec();
+    jstd::allocation_stats stats;
+    jstd::allocation_tracking_scope scope(stats);
+    TrackedHashMap hashmap;
 
-        printf("%s: %s\n", __func__, name.c_str());
-        printf("hashmap.size() = %u, cardinal = %u, load_factor = %0.3f, time: %0.2f ms\n",
-               (uint32_t)hashmap.size(), (uint32_t)cardinal,
-               hashmap.load_factor(), elapsed_time);
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        hashmap.insert(std::make_pair(keys[i], mapped_type(i)));
     }
 
-    {
+    s_runner.run(find_name, [&](jtest::BenchmarkState & state) {
         std::size_t check_sum = 0;
-        sw.start();
-        for (std::size_t i = 0; i < keys.size(); i++) {
-            auto iter = hashmap.find(keys[i]);
-            check_sum += iter->second;
+        while (state.keep_running()) {
+            for (std::size_t i = 0; i < keys.size(); i++) {
+                auto iter = hashmap.find(keys[i]);
+                check_sum += iter->second;
+            }
+        }
+        state.set_items_per_iteration(keys.size());
+        state.set_checksum(check_sum / state.iterations());
+    });
+
+    printf("hashmap.size() = %u, cardinal = %u, load_factor = %0.3f\n",
+           (uint32_t)hashmap.size(), (uint32_t)cardinal, hashmap.load_factor());
+    printf("memory: %" PRIuPTR " bytes, peak: %" PRIuPTR " bytes, %0.2f bytes/entry, allocs: %" PRIuPTR "\n\n",
+           stats.live_bytes.load(), stats.peak_bytes.load(), stats.bytes_per_entry(hashmap.size()),
+           stats.alloc_count.load());
+}
+
+template <typename Aggregator>
+void run_aggregate_table(const std::string & name, std::vector<typename Aggregator::key_type> & keys,
+                         std::size_t cardinal)
+{
+    std::string case_name = name + "/aggregate/" + Aggregator::aggregator_type::name() +
+                            "/cardinal=" + std::to_string(cardinal);
+
+    s_runner.set_label("container", name);
+    s_runner.set_label("cardinal", cardinal);
+
+    s_runner.run(case_name, [&](jtest::BenchmarkState & state) {
+        std::size_t groups = 0;
+        while (state.keep_running()) {
+            Aggregator aggregator;
+            aggregator.add(keys.data(), keys.data(), keys.size());
+            groups = aggregator.size();
+            // The destructor is not timed.
+            state.pause_timing();
         }
-        sw.stop();
+        state.set_items_per_iteration(keys.size());
+        state.set_checksum(groups);
+    });
+}
 
-        double elapsed_time = sw.getElapsedMillisec();
-        double average_time = elapsed_time / keys.size();
+template <typename Aggregator>
+void run_aggregate_partitioned(const std::string & name, std::vector<typename Aggregator::key_type> & keys,
+                               std::size_t cardinal, std::size_t threads)
+{
+    std::string case_name = name + "/aggregate/" + Aggregator::aggregator_type::name() +
+                            "/threads=" + std::to_string(threads) +
+                            "/cardinal=" + std::to_string(cardinal);
+
+    s_runner.set_label("container", name);
+    s_runner.set_label("cardinal", cardinal);
+
+    s_runner.run(case_name, [&](jtest::BenchmarkState & state) {
+        std::size_t groups = 0;
+        while (state.keep_running()) {
+            Aggregator aggregator(threads);
+            aggregator.aggregate(keys.data(), keys.data(), keys.size());
+            groups = aggregator.size();
+            // The destructor is not timed.
+            state.pause_timing();
+        }
+        state.set_items_per_iteration(keys.size());
+        state.set_checksum(groups);
+    });
+}
 
-        printf("hashmap.find(key), check_sum: %" PRIuPTR ", average: %s, time: %0.2f ms\n\n",
-               check_sum, formatMsTime(average_time).c_str(), elapsed_time);
-    }
+//
+// The group-by sum(key) of the same keys as the insert cases, one upsert per key,
+// the number of groups is the cardinality.
+//
+template <typename Key>
+void run_aggregate_random(std::vector<Key> & keys, std::size_t cardinal)
+{
+    typedef jstd::SumAggregator<Key, std::size_t>   Aggregator;
+
+    std::size_t threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+
+    std::string name0 = get_hashmap_name<Key, std::size_t>("std::unordered_map<%s, %s>");
+    std::string name1 = get_hashmap_name<Key, std::size_t>("jstd::Dictionary<%s, %s>");
+    std::string name2 = get_hashmap_name<Key, std::size_t>("jstd::PartitionedAggregator<%s, %s>");
+
+    s_runner.set_label("aggregator", Aggregator::name());
+
+    run_aggregate_table<jstd::HashAggregator<Key, Aggregator, std::unordered_map<Key, std::size_t>>>(
+        name0, keys, cardinal);
+    run_aggregate_table<jstd::HashAggregator<Key, Aggregator, jstd::Dictionary<Key, std::size_t>>>(
+        name1, keys, cardinal);
+    run_aggregate_partitioned<jstd::PartitionedAggregator<Key, Aggregator, jstd::Dictionary<Key, std::size_t>>>(
+        name2, keys, cardinal, threads);
+
+    s_runner.erase_label("aggregator");
 }
 
 template <typename Key, typename Value>
@@ -421,6 +508,11 @@ void benchmark_insert_random(std::size_t iters)
 
     printf("DataSize = %u\n\n", (uint32_t)DataSize);
 
+    s_runner.clear_labels();
+    s_runner.set_label("key_type", type_name<Key>::name());
+    s_runner.set_label("value_type", type_name<Value>::name());
+    s_runner.set_label("data_size", DataSize);
+
     std::string name0, name1;
     name0 = get_hashmap_name<Key, Value>("std::unordered_map<%s, %s>");
     name1 = get_hashmap_name<Key, Value>("jstd::Dictionary<%s, %s>");
@@ -430,32 +522,39 @@ void benchmark_insert_random(std::size_t iters)
     keys = generate_random_keys<Key>(DataSize, Cardinal0);
     run_insert_random<std::unordered_map<Key, Value>>(name0, keys, Cardinal0);
     run_insert_random<jstd::Dictionary<Key, Value>>  (name1, keys, Cardinal0);
+    run_aggregate_random<Key>(keys, Cardinal0);
 
     keys = generate_random_keys<Key>(DataSize, Cardinal1);
     run_insert_random<std::unordered_map<Key, Value>>(name0, keys, Cardinal1);
     run_insert_random<jstd::Dictionary<Key, Value>>  (name1, keys, Cardinal1);
+    run_aggregate_random<Key>(keys, Cardinal1);
 
     keys = generate_random_keys<Key>(DataSize, Cardinal2);
     run_insert_random<std::unordered_map<Key, Value>>(name0, keys, Cardinal2);
     run_insert_random<jstd::Dictionary<Key, Value>>  (name1, keys, Cardinal2);
+    run_aggregate_random<Key>(keys, Cardinal2);
 
     keys = generate_random_keys<Key>(DataSize, Cardinal3);
     run_insert_random<std::unordered_map<Key, Value>>(name0, keys, Cardinal3);
     run_insert_random<jstd::Dictionary<Key, Value>>  (name1, keys, Cardinal3);
+    run_aggregate_random<Key>(keys, Cardinal3);
 
     keys = generate_random_keys<Key>(DataSize, Cardinal4);
     run_insert_random<std::unordered_map<Key, Value>>(name0, keys, Cardinal4);
     run_insert_random<jstd::Dictionary<Key, Value>>  (name1, keys, Cardinal4);
+    run_aggregate_random<Key>(keys, Cardinal4);
 
 #if 0
     keys = generate_random_keys<Key>(DataSize, Cardinal5);
     run_insert_random<std::unordered_map<Key, Value>>(name0, keys, Cardinal5);
     run_insert_random<jstd::Dictionary<Key, Value>>  (name1, keys, Cardinal5);
+    run_aggregate_random<Key>(keys, Cardinal5);
 #endif
 
     keys = generate_random_keys<Key>(DataSize, Cardinal6);
     run_insert_random<std::unordered_map<Key, Value>>(name0, keys, Cardinal6);
     run_insert_random<jstd::Dictionary<Key, Value>>  (name1, keys, Cardinal6);
+    run_aggregate_random<Key>(keys, Cardinal6);
 }
 
 void benchmark_all_hashmaps(std::size_t iters)
@@ -511,13 +610,21 @@ int main(int argc, char * argv[])
     jstd::RandomGen   RandomGen(20200831);
     jstd::MtRandomGen mtRandomGen(20200831);
 
+    // The 16M keys of each case are long enough, 3 measured runs are enough.
+    s_runner.options().repetitions = 3;
+    if (!s_runner.parse_args(argc, argv)) {
+        return 0;
+    }
+
     std::size_t iters = kDefaultIters;
-    if (argc > 1) {
+    if (s_runner.args().size() > 0) {
         // first arg is # of iterations
-        iters = ::atoi(argv[1]);
+        iters = ::atoi(s_runner.args()[0].c_str());
     }
 
-    jtest::CPU::warm_up(1000);
+    s_runner.metadata().set("hash_func", PRINT_MACRO(HASH_MAP_FUNCTION));
+
+    s_runner.warm_up();
 
     if (1) { std_hash_test(); }
 
@@ -529,6 +636,10 @@ int main(int argc, char * argv[])
 
     printf("------------------------------------------------------------------------------------\n\n");
 
+    if (!jtest::write_reports(s_runner)) {
+        return 1;
+    }
+
     //jstd::Console::ReadKey();
     return 0;
 }
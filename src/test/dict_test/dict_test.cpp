@@ -16,17 +16,24 @@
 #include <string.h>
 #include <math.h>
 
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
 #include <iostream>
 #include <fstream>
 #include <iomanip>
 #include <sstream>
 #include <string>
 #include <atomic>
+#include <thread>
 #include <memory>
 #include <utility>
 #include <vector>
+#include <iterator>       // For std::back_inserter()
 #include <map>
 #include <unordered_map>
+#include <locale>         // For std::wstring_convert
+#include <codecvt>        // For std::codecvt_utf8<T>
 
 /* SIMD support features */
 #define JSTD_HAVE_MMX           1
@@ -55,8 +62,11 @@
 #define STRING_UTILS_U64        1
 #define STRING_UTILS_SSE42      2
 #define STRING_UTILS_LIBC       3
+#define STRING_UTILS_AVX2       4
+#define STRING_UTILS_AVX512     5
+#define STRING_UTILS_SIMD       6
 
-#define STRING_UTILS_MODE       STRING_UTILS_STL
+#define STRING_UTILS_MODE       STRING_UTILS_SIMD
 
 // Use in <jstd/support/Power2.h>
 #define JSTD_SUPPORT_X86_BITSCAN_INSTRUCTION    1
@@ -70,17 +80,28 @@
 
 #include <jstd/hash/hash_table.h>
 #include <jstd/hash/dictionary.h>
+#include <jstd/hash/hash_aggregator.h>
 #include <jstd/hash/hashmap_analyzer.h>
 #include <jstd/string/string_view.h>
+#include <jstd/string/string_view_array.h>
+#include <jstd/string/line_splitter.h>
+#include <jstd/string/utf_convert.h>
 #include <jstd/memory/shiftable_ptr.h>
 #include <jstd/system/Console.h>
+#include <jstd/system/mapped_file.h>
 #include <jstd/system/RandomGen.h>
 #include <jstd/test/StopWatch.h>
 #include <jstd/test/CPUWarmUp.h>
 #include <jstd/test/ProcessMemInfo.h>
+#include <jstd/test/LatencyHistogram.h>
+#include <jstd/test/Workload.h>
+#include <jstd/test/ThreadBench.h>
 
 #include <jstd/hasher/fnv1a.h>
 #include <jstd/string/formatter.h>
+#include <jstd/string/dtoa.h>
+#include <jstd/string/itoa_simd.h>
+#include <jstd/string/from_chars.h>
 #include <jstd/string/snprintf.hpp>
 
 #include <jstd/memory/c_aligned_malloc.h>
@@ -1599,6 +1620,176 @@ void hashtable_uinttest()
     //hashtable_iterator_uinttest<jstd::Dictionary<std::string, std::string>>();
 }
 
+void dictionary_node_handle_test()
+{
+    typedef jstd::Dictionary<std::string, std::vector<int>> dictionary_type;
+    typedef typename dictionary_type::node_handle node_handle;
+    typedef typename dictionary_type::node_insert_return_type node_insert_return_type;
+
+    static const std::size_t kKeyCount = 100000;
+    static const std::size_t kVectorSize = 64;
+
+    std::vector<std::string> keys;
+    keys.reserve(kKeyCount);
+    for (std::size_t i = 0; i < kKeyCount; i++) {
+        keys.push_back(std::string("shard_key_") + std::to_string(i));
+    }
+
+    printf("dictionary_node_handle_test()\n\n");
+
+    bool is_ok = true;
+    double copyTime, extractTime, mergeTime;
+    jtest::StopWatch sw;
+
+    {
+        dictionary_type source, target;
+        for (std::size_t i = 0; i < kKeyCount; i++) {
+            source.emplace(keys[i], std::vector<int>(kVectorSize, int(i)));
+        }
+
+        // Copy the value out, erase it, then insert it into the target.
+        sw.start();
+        for (std::size_t i = 0; i < kKeyCount; i++) {
+            typename dictionary_type::iterator iter = source.find(keys[i]);
+            if (iter != source.end()) {
+                std::vector<int> value = iter->second;
+                source.erase(keys[i]);
+                target.insert(keys[i], std::move(value));
+            }
+        }
+        sw.stop();
+        copyTime = sw.getElapsedMillisec();
+        is_ok = is_ok && (source.size() == 0) && (target.size() == kKeyCount);
+    }
+
+    {
+        dictionary_type source, target;
+        for (std::size_t i = 0; i < kKeyCount; i++) {
+            source.emplace(keys[i], std::vector<int>(kVectorSize, int(i)));
+        }
+
+        sw.start();
+        for (std::size_t i = 0; i < kKeyCount; i++) {
+            node_handle node = source.extract(keys[i]);
+            if (!node.empty()) {
+                node_insert_return_type result = target.insert(std::move(node));
+                is_ok = is_ok && result.inserted && result.node.empty();
+            }
+        }
+        sw.stop();
+        extractTime = sw.getElapsedMillisec();
+        is_ok = is_ok && (source.size() == 0) && (target.size() == kKeyCount);
+
+        for (std::size_t i = 0; i < kKeyCount; i += 97) {
+            typename dictionary_type::iterator iter = target.find(keys[i]);
+            is_ok = is_ok && (iter != target.end()) &&
+                    (iter->second.size() == kVectorSize) && (iter->second[0] == int(i));
+        }
+
+        // Extract a missing key and insert a duplicate key.
+        node_handle empty_node = source.extract(keys[0]);
+        is_ok = is_ok && empty_node.empty();
+
+        source.emplace(keys[1], std::vector<int>(1, -1));
+        node_handle dup_node = source.extract(keys[1]);
+        node_insert_return_type result = target.insert(std::move(dup_node));
+        is_ok = is_ok && !result.inserted && !result.node.empty() &&
+                (result.node.mapped()[0] == -1) && (result.position->second[0] == 1);
+    }
+
+    {
+        dictionary_type source, target;
+        for (std::size_t i = 0; i < kKeyCount; i++) {
+            source.emplace(keys[i], std::vector<int>(kVectorSize, int(i)));
+        }
+        // The overlapped keys stay in the source.
+        for (std::size_t i = 0; i < kKeyCount; i += 10) {
+            target.emplace(keys[i], std::vector<int>(1, -1));
+        }
+
+        sw.start();
+        target.merge(source);
+        sw.stop();
+        mergeTime = sw.getElapsedMillisec();
+
+        is_ok = is_ok && (target.size() == kKeyCount) && (source.size() == kKeyCount / 10);
+        for (std::size_t i = 0; i < kKeyCount; i++) {
+            typename dictionary_type::iterator iter = target.find(keys[i]);
+            bool found = (iter != target.end());
+            if ((i % 10) == 0)
+                is_ok = is_ok && found && (iter->second[0] == -1) && source.contains(keys[i]);
+            else
+                is_ok = is_ok && found && (iter->second[0] == int(i)) && !source.contains(keys[i]);
+        }
+    }
+
+    {
+        // The pinned nodes survive the reallocation and the destruction of the source.
+        std::vector<node_handle> nodes;
+        {
+            dictionary_type source;
+            for (std::size_t i = 0; i < 1000; i++) {
+                source.emplace(keys[i], std::vector<int>(kVectorSize, int(i)));
+            }
+            for (std::size_t i = 0; i < 100; i++) {
+                typename dictionary_type::const_iterator iter = source.find(keys[i]);
+                nodes.push_back(source.extract(iter));
+            }
+            is_ok = is_ok && (source.size() == 900) && !source.contains(keys[0]);
+
+            // Relink a pinned entry into the source.
+            node_insert_return_type result = source.insert(std::move(nodes.back()));
+            nodes.pop_back();
+            is_ok = is_ok && result.inserted && (result.position->second[0] == 99);
+
+            for (std::size_t i = 1000; i < 2000; i++) {
+                source.emplace(keys[i], std::vector<int>(1, int(i)));
+            }
+            source.shrink_to_fit();
+        }
+
+        dictionary_type target;
+        for (std::size_t i = 0; i < nodes.size(); i++) {
+            is_ok = is_ok && (nodes[i].key() == keys[i]) && (nodes[i].mapped()[0] == int(i));
+            target.insert(std::move(nodes[i]));
+        }
+        is_ok = is_ok && (target.size() == 99);
+    }
+
+    {
+        // Re-key the extracted nodes, they must be found by the new keys.
+        dictionary_type source, target;
+        for (std::size_t i = 0; i < 100; i++) {
+            source.emplace(keys[i], std::vector<int>(1, int(i)));
+        }
+
+        // Relink into the source.
+        node_handle node1 = source.extract(keys[0]);
+        node1.key() = keys[200];
+        node_insert_return_type result1 = source.insert(std::move(node1));
+        is_ok = is_ok && result1.inserted && !source.contains(keys[0]) &&
+                (source.find(keys[200]) != source.end()) &&
+                (source.find(keys[200])->second[0] == 0);
+
+        // Move into another dictionary.
+        node_handle node2 = source.extract(keys[1]);
+        node2.key() = keys[201];
+        node_insert_return_type result2 = target.insert(std::move(node2));
+        is_ok = is_ok && result2.inserted && !target.contains(keys[1]) &&
+                (target.find(keys[201]) != target.end()) &&
+                (target.find(keys[201])->second[0] == 1);
+
+        is_ok = is_ok && (source.erase(keys[200]) == 1) && (target.erase(keys[201]) == 1) &&
+                (source.size() == 98) && target.empty();
+    }
+
+    printf("  copy + erase + insert:  %8.3f ms\n", copyTime);
+    printf("  extract + insert(node): %8.3f ms\n", extractTime);
+    printf("  merge (90%% moved):      %8.3f ms\n", mergeTime);
+    printf("\n");
+    printf("  result: %s\n\n", is_ok ? "Passed" : "Failed");
+}
+
 void formatter_benchmark_sprintf_Integer_1()
 {
 #ifdef NDEBUG
@@ -1880,107 +2071,2451 @@ void formatter_benchmark_sprintf_Integer_1()
         printf("result = \n%s\n\n", str.c_str());
         printf("strlen       = %" PRIuPTR " bytes\n", str.size());
 
-        printf("elapsed time = %0.3f ms\n\n", time);
-        printf("fmt.sprintf_no_prepare() vs snprintf(): %0.3f x times.\n", time_base / time);
-        printf("\n");
+        printf("elapsed time = %0.3f ms\n\n", time);
+        printf("fmt.sprintf_no_prepare() vs snprintf(): %0.3f x times.\n", time_base / time);
+        printf("\n");
+    }
+
+    {
+        sw.restart();
+        for (i = 0; i < iters; ++i) {
+            std::string str;
+            fmt_len = format::snprintf(str,
+                                 "%d, %d, %d, %d, %d,\n"
+                                 "%d, %d, %d, %d, %d.",
+                                  12,  1234,  123456,  12345678,  123456789,
+                                 -12, -1234, -123456, -12345678, -123456789);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        fmt_len = format::snprintf(str1,
+                                "%d, %d, %d, %d, %d,\n"
+                                "%d, %d, %d, %d, %d.",
+                                12,  1234,  123456,  12345678,  123456789,
+                                -12, -1234, -123456, -12345678, -123456789);
+
+        printf("==========================================================================\n\n");
+        printf(">>> %-20s <<<\n\n", "format::snprintf() *");
+        printf("result = \n%s\n\n", str1.c_str());
+        printf("strlen       = %" PRIuPTR " bytes\n", str1.size());
+
+        printf("elapsed time = %0.3f ms\n\n", time);
+        printf("format::snprintf() * vs snprintf(): %0.3f x times.\n", time_base / time);
+        printf("\n");
+    }
+
+    {
+        std::string str;
+  
+        sw.restart();
+        for (i = 0; i < iters; ++i) {
+            str.clear();
+            fmt_len = format::snprintf(str,
+                                 "%d, %d, %d, %d, %d,\n"
+                                 "%d, %d, %d, %d, %d.",
+                                  12,  1234,  123456,  12345678,  123456789,
+                                 -12, -1234, -123456, -12345678, -123456789);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        printf("==========================================================================\n\n");
+        printf(">>> %-20s <<<\n\n", "format::snprintf()");
+        printf("result = \n%s\n\n", str.c_str());
+        printf("strlen       = %" PRIuPTR " bytes\n", str.size());
+
+        printf("elapsed time = %0.3f ms\n\n", time);
+        printf("format::snprintf() vs snprintf(): %0.3f x times.\n", time_base / time);
+        printf("\n");
+    }
+
+    static const jstd::precompiled_format s_precompiled_fmt(
+                                 "%d, %d, %d, %d, %d,\n"
+                                 "%d, %d, %d, %d, %d.");
+
+    {
+        sw.restart();
+        for (i = 0; i < iters; ++i) {
+            std::string str;
+            fmt_len = fmt.sprintf(str, s_precompiled_fmt,
+                                  12,  1234,  123456,  12345678,  123456789,
+                                 -12, -1234, -123456, -12345678, -123456789);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        str1.clear();
+        fmt_len = fmt.sprintf(str1, s_precompiled_fmt,
+                               12,  1234,  123456,  12345678,  123456789,
+                              -12, -1234, -123456, -12345678, -123456789);
+
+        printf("==========================================================================\n\n");
+        printf(">>> %-20s <<<\n\n", "fmt.sprintf(precompiled) *");
+        printf("result = \n%s\n\n", str1.c_str());
+        printf("strlen       = %" PRIuPTR " bytes\n", str1.size());
+
+        printf("elapsed time = %0.3f ms\n\n", time);
+        printf("fmt.sprintf(precompiled) * vs snprintf(): %0.3f x times.\n", time_base / time);
+        printf("\n");
+    }
+
+    {
+        std::string str;
+
+        sw.restart();
+        for (i = 0; i < iters; ++i) {
+            str.clear();
+            fmt_len = fmt.sprintf(str, s_precompiled_fmt,
+                                  12,  1234,  123456,  12345678,  123456789,
+                                 -12, -1234, -123456, -12345678, -123456789);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        printf("==========================================================================\n\n");
+        printf(">>> %-20s <<<\n\n", "fmt.sprintf(precompiled)");
+        printf("result = \n%s\n\n", str.c_str());
+        printf("strlen       = %" PRIuPTR " bytes\n", str.size());
+
+        printf("elapsed time = %0.3f ms\n\n", time);
+        printf("fmt.sprintf(precompiled) vs snprintf(): %0.3f x times.\n", time_base / time);
+        printf("\n");
+    }
+
+    {
+        // Format into a reused fixed buffer, there is no heap activity.
+        char fmtbuf3[512];
+        jstd::format_to_result<char *> result;
+
+        sw.restart();
+        for (i = 0; i < iters; ++i) {
+            result = fmt.format_to(fmtbuf3, sizeof(fmtbuf3),
+                                   "%d, %d, %d, %d, %d,\n"
+                                   "%d, %d, %d, %d, %d.",
+                                    12,  1234,  123456,  12345678,  123456789,
+                                   -12, -1234, -123456, -12345678, -123456789);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        fmt_len = result.size;
+        *result.out = '\0';
+
+        printf("==========================================================================\n\n");
+        printf(">>> %-20s <<<\n\n", "fmt.format_to(buf)");
+        printf("result = \n%s\n\n", fmtbuf3);
+        printf("strlen       = %" PRIuPTR " bytes, truncated = %s\n",
+               fmt_len, result.truncated ? "true" : "false");
+
+        printf("elapsed time = %0.3f ms\n\n", time);
+        printf("fmt.format_to(buf) vs snprintf(): %0.3f x times.\n", time_base / time);
+        printf("\n");
+    }
+
+    JSTD_UNUSED_VAR(fmt_len);
+    printf("==========================================================================\n");
+    printf("\n");
+}
+
+void formatter_benchmark_double()
+{
+#ifdef NDEBUG
+    static const std::size_t iters = 999999;
+#else
+    static const std::size_t iters = 9999;
+#endif
+    static const std::size_t kValues = 1024;
+
+    std::size_t i;
+    double time, time_base;
+    jtest::StopWatch sw;
+
+    jstd::MtRandomGen64 mtRandomGen64(20200831);
+    std::vector<double> values;
+    values.reserve(kValues);
+    for (i = 0; i < kValues; i++) {
+        double value = static_cast<double>(jstd::MtRandomGen64::nextInt64()) /
+                       static_cast<double>(jstd::MtRandomGen64::nextUInt64(1, 1000000));
+        values.push_back(value);
+    }
+
+    char buf[512];
+    std::size_t total_len;
+    jstd::formatter fmt;
+
+    printf("==========================================================================\n\n");
+    printf("  formatter_benchmark_double()\n\n");
+    printf("  iters = %" PRIuPTR ", random doubles = %" PRIuPTR "\n\n", iters, kValues);
+
+    {
+        total_len = 0;
+        sw.start();
+        for (i = 0; i < iters; ++i) {
+            int len = snprintf(buf, sizeof(buf), "%g", values[i % kValues]);
+            total_len += static_cast<std::size_t>(len);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+        time_base = time;
+
+        printf("%-28s total_len = %9" PRIuPTR ", time = %8.3f ms\n",
+               "snprintf(\"%g\")", total_len, time);
+    }
+
+    {
+        total_len = 0;
+        sw.start();
+        for (i = 0; i < iters; ++i) {
+            int len = snprintf(buf, sizeof(buf), "%.17g", values[i % kValues]);
+            total_len += static_cast<std::size_t>(len);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        printf("%-28s total_len = %9" PRIuPTR ", time = %8.3f ms, %0.3f x\n",
+               "snprintf(\"%.17g\")", total_len, time, time_base / time);
+    }
+
+    {
+        total_len = 0;
+        sw.start();
+        for (i = 0; i < iters; ++i) {
+            total_len += jstd::dtoa(values[i % kValues], buf);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        printf("%-28s total_len = %9" PRIuPTR ", time = %8.3f ms, %0.3f x\n",
+               "jstd::dtoa() (shortest)", total_len, time, time_base / time);
+    }
+
+    {
+        total_len = 0;
+        sw.start();
+        for (i = 0; i < iters; ++i) {
+            jstd::format_to_result<char *> result = fmt.format_to(buf, sizeof(buf), "%g", values[i % kValues]);
+            total_len += result.size;
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        printf("%-28s total_len = %9" PRIuPTR ", time = %8.3f ms, %0.3f x\n",
+               "fmt.format_to(\"%g\")", total_len, time, time_base / time);
+    }
+
+    {
+        total_len = 0;
+        sw.start();
+        for (i = 0; i < iters; ++i) {
+            int len = snprintf(buf, sizeof(buf), "%.3f", values[i % kValues]);
+            total_len += static_cast<std::size_t>(len);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+        time_base = time;
+
+        printf("%-28s total_len = %9" PRIuPTR ", time = %8.3f ms\n",
+               "snprintf(\"%.3f\")", total_len, time);
+    }
+
+    {
+        total_len = 0;
+        sw.start();
+        for (i = 0; i < iters; ++i) {
+            total_len += jstd::dtoa_fixed(values[i % kValues], 3, buf);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        printf("%-28s total_len = %9" PRIuPTR ", time = %8.3f ms, %0.3f x\n",
+               "jstd::dtoa_fixed(3)", total_len, time, time_base / time);
+    }
+
+    printf("\n");
+}
+
+void formatter_benchmark_itoa()
+{
+#ifdef NDEBUG
+    static const std::size_t iters = 9999999;
+#else
+    static const std::size_t iters = 99999;
+#endif
+    static const std::size_t kValues = 1024;
+
+    std::size_t i;
+    double time, time_base;
+    jtest::StopWatch sw;
+
+    // Random values with the random digits, so the branches are not predictable.
+    jstd::MtRandomGen64 mtRandomGen64(20200831);
+    std::vector<uint32_t> values32;
+    std::vector<uint64_t> values64;
+    values32.reserve(kValues);
+    values64.reserve(kValues);
+    for (i = 0; i < kValues; i++) {
+        uint64_t value = jstd::MtRandomGen64::nextUInt64();
+        values32.push_back(static_cast<uint32_t>(value >> (value % 32)));
+        values64.push_back(value >> (value % 64));
+    }
+
+    char buf[64];
+    std::size_t total_len;
+    std::string str;
+    str.reserve(64);
+
+    std::vector<char> batch_buf(jstd::itoa_batch_max_size<uint64_t>(kValues));
+
+    printf("==========================================================================\n\n");
+    printf("  formatter_benchmark_itoa()\n\n");
+    printf("  iters = %" PRIuPTR ", random values = %" PRIuPTR "\n\n", iters, kValues);
+
+    {
+        total_len = 0;
+        sw.start();
+        for (i = 0; i < iters; ++i) {
+            int len = snprintf(buf, sizeof(buf), "%u", values32[i % kValues]);
+            total_len += static_cast<std::size_t>(len);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+        time_base = time;
+
+        printf("%-28s total_len = %9" PRIuPTR ", time = %8.3f ms, %8.2f M digits/s\n",
+               "snprintf(\"%u\")", total_len, time, total_len / time / 1000.0);
+    }
+
+    {
+        total_len = 0;
+        sw.start();
+        for (i = 0; i < iters; ++i) {
+            str.clear();
+            total_len += jstd::itoa(str, values32[i % kValues]);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        printf("%-28s total_len = %9" PRIuPTR ", time = %8.3f ms, %8.2f M digits/s, %0.3f x\n",
+               "jstd::itoa(uint32_t)", total_len, time, total_len / time / 1000.0, time_base / time);
+    }
+
+    {
+        total_len = 0;
+        sw.start();
+        for (i = 0; i < iters; ++i) {
+            total_len += jstd::u32toa_simd(values32[i % kValues], buf);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        printf("%-28s total_len = %9" PRIuPTR ", time = %8.3f ms, %8.2f M digits/s, %0.3f x\n",
+               "jstd::u32toa_simd()", total_len, time, total_len / time / 1000.0, time_base / time);
+    }
+
+    {
+        total_len = 0;
+        sw.start();
+        for (i = 0; i < iters; i += kValues) {
+            // Exclude the delimiters.
+            total_len += jstd::itoa_batch(&values32[0], kValues, &batch_buf[0]) - (kValues - 1);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        printf("%-28s total_len = %9" PRIuPTR ", time = %8.3f ms, %8.2f M digits/s, %0.3f x\n",
+               "jstd::itoa_batch(uint32_t)", total_len, time, total_len / time / 1000.0, time_base / time);
+    }
+
+    printf("\n");
+
+    {
+        total_len = 0;
+        sw.start();
+        for (i = 0; i < iters; ++i) {
+            int len = snprintf(buf, sizeof(buf), "%llu",
+                               static_cast<unsigned long long>(values64[i % kValues]));
+            total_len += static_cast<std::size_t>(len);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+        time_base = time;
+
+        printf("%-28s total_len = %9" PRIuPTR ", time = %8.3f ms, %8.2f M digits/s\n",
+               "snprintf(\"%llu\")", total_len, time, total_len / time / 1000.0);
+    }
+
+    {
+        total_len = 0;
+        sw.start();
+        for (i = 0; i < iters; ++i) {
+            str.clear();
+            total_len += jstd::itoa(str, values64[i % kValues]);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        printf("%-28s total_len = %9" PRIuPTR ", time = %8.3f ms, %8.2f M digits/s, %0.3f x\n",
+               "jstd::itoa(uint64_t)", total_len, time, total_len / time / 1000.0, time_base / time);
+    }
+
+    {
+        total_len = 0;
+        sw.start();
+        for (i = 0; i < iters; ++i) {
+            total_len += jstd::u64toa_simd(values64[i % kValues], buf);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        printf("%-28s total_len = %9" PRIuPTR ", time = %8.3f ms, %8.2f M digits/s, %0.3f x\n",
+               "jstd::u64toa_simd()", total_len, time, total_len / time / 1000.0, time_base / time);
+    }
+
+    {
+        total_len = 0;
+        sw.start();
+        for (i = 0; i < iters; i += kValues) {
+            total_len += jstd::itoa_batch(&values64[0], kValues, &batch_buf[0]) - (kValues - 1);
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        printf("%-28s total_len = %9" PRIuPTR ", time = %8.3f ms, %8.2f M digits/s, %0.3f x\n",
+               "jstd::itoa_batch(uint64_t)", total_len, time, total_len / time / 1000.0, time_base / time);
+    }
+
+    printf("\n");
+}
+
+void formatter_benchmark()
+{
+    formatter_benchmark_sprintf_Integer_1();
+    formatter_benchmark_double();
+    formatter_benchmark_itoa();
+}
+
+void from_chars_benchmark()
+{
+#ifdef NDEBUG
+    static const std::size_t kNumbers = 2000000;
+#else
+    static const std::size_t kNumbers = 20000;
+#endif
+
+    std::size_t i;
+    double time, time_base;
+    jtest::StopWatch sw;
+
+    // The corpus: kNumbers random integers and doubles, one number per line.
+    jstd::MtRandomGen64 mtRandomGen64(20200831);
+    std::vector<uint64_t> integers;
+    integers.reserve(kNumbers);
+    for (i = 0; i < kNumbers; i++) {
+        uint64_t value = jstd::MtRandomGen64::nextUInt64();
+        integers.push_back(value >> (value % 64));
+    }
+
+    std::string int_text;
+    int_text.resize(jstd::itoa_batch_max_size<uint64_t>(kNumbers));
+    int_text.resize(jstd::itoa_batch(&integers[0], kNumbers, &int_text[0], '\n'));
+
+    std::string double_text;
+    char buf[jstd::kMaxDtoaSize + 1];
+    for (i = 0; i < kNumbers; i++) {
+        double value = static_cast<double>(jstd::MtRandomGen64::nextInt64()) /
+                       static_cast<double>(jstd::MtRandomGen64::nextUInt64(1, 1000000));
+        double_text.append(buf, jstd::dtoa(value, buf));
+        double_text.push_back('\n');
+    }
+
+    printf("==========================================================================\n\n");
+    printf("  from_chars_benchmark()\n\n");
+    printf("  numbers = %" PRIuPTR ", int text = %" PRIuPTR " bytes, double text = %" PRIuPTR " bytes\n\n",
+           kNumbers, int_text.size(), double_text.size());
+
+    {
+        uint64_t checksum = 0;
+        const char * p = int_text.c_str();
+        sw.start();
+        for (i = 0; i < kNumbers; i++) {
+            char * end;
+            checksum += ::strtoull(p, &end, 10);
+            p = end + 1;
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+        time_base = time;
+
+        printf("%-28s checksum = %20" PRIu64 ", time = %8.3f ms, %8.2f MB/s\n",
+               "strtoull()", checksum, time, int_text.size() / time / 1000.0);
+    }
+
+    {
+        uint64_t checksum = 0;
+        const char * p = int_text.c_str();
+        const char * last = int_text.c_str() + int_text.size();
+        sw.start();
+        for (i = 0; i < kNumbers; i++) {
+            uint64_t value = 0;
+            jstd::from_chars_result result = jstd::from_chars(p, last, value);
+            checksum += value;
+            p = result.ptr + 1;
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        printf("%-28s checksum = %20" PRIu64 ", time = %8.3f ms, %8.2f MB/s, %0.3f x\n",
+               "jstd::from_chars(uint64_t)", checksum, time, int_text.size() / time / 1000.0,
+               time_base / time);
+    }
+
+    printf("\n");
+
+    {
+        double checksum = 0.0;
+        const char * p = double_text.c_str();
+        sw.start();
+        for (i = 0; i < kNumbers; i++) {
+            char * end;
+            checksum += ::strtod(p, &end);
+            p = end + 1;
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+        time_base = time;
+
+        printf("%-28s checksum = %20g, time = %8.3f ms, %8.2f MB/s\n",
+               "strtod()", checksum, time, double_text.size() / time / 1000.0);
+    }
+
+    {
+        double checksum = 0.0;
+        const char * p = double_text.c_str();
+        const char * last = double_text.c_str() + double_text.size();
+        sw.start();
+        for (i = 0; i < kNumbers; i++) {
+            double value = 0.0;
+            jstd::from_chars_result result = jstd::from_chars(p, last, value);
+            checksum += value;
+            p = result.ptr + 1;
+        }
+        sw.stop();
+        time = sw.getElapsedMillisec();
+
+        printf("%-28s checksum = %20g, time = %8.3f ms, %8.2f MB/s, %0.3f x\n",
+               "jstd::from_chars(double)", checksum, time, double_text.size() / time / 1000.0,
+               time_base / time);
+    }
+
+    printf("\n");
+}
+
+void string_view_test()
+{
+    jstd::string_view sv1(header_fields[4]);
+    try {
+        //sv1[2] = 'a';  // Run-time error, readonly
+    } catch (...) {
+        std::cout << "jstd::string_view<CharT> operator [] read only" << std::endl;
+    }
+
+    std::string str1("12345676890");
+
+    printf("str1 = %s\n", str1.c_str());
+    std::cout << "sv1  = " << sv1 << "\n\n";
+
+    jstd::string_view sv2("abcdefg");
+    std::size_t n2 = sv2.copy((char *)str1.data(), 4, 0);
+
+    printf("str1 = %s\n", str1.c_str());
+    std::cout << "sv2  = " << sv2 << "\n\n";
+
+    jstd::string_view sv3(str1);
+    sv3[2] = 'q';
+
+    printf("str1 = %s\n", str1.c_str());
+    std::cout << "sv3  = " << sv3 << "\n\n";
+
+    using std::swap;
+    std::swap(sv2, sv3);
+    std::cout << "sv2  = " << sv2 << '\n';
+    std::cout << "sv3  = " << sv3 << "\n\n";
+
+    jstd::Console::ReadKey();
+}
+
+void string_view_find_test()
+{
+#ifdef NDEBUG
+    static const std::size_t kTestCount = 200000;
+#else
+    static const std::size_t kTestCount = 2000;
+#endif
+
+    jstd::MtRandomGen64 mtRandomGen64(20200831);
+
+    std::size_t errors = 0;
+
+    // Random haystacks and needles of the small alphabets, compare with std::string.
+    for (std::size_t i = 0; i < kTestCount; i++) {
+        uint32_t alphabet = jstd::MtRandomGen64::nextUInt32() % 6 + 1;
+        std::size_t n = jstd::MtRandomGen64::nextUInt32() % (((i % 10) == 0) ? 300 : 70);
+        std::size_t m = jstd::MtRandomGen64::nextUInt32() % (((i % 4) == 0) ? 40 : 6);
+        std::string haystack, needle;
+        for (std::size_t j = 0; j < n; j++)
+            haystack.push_back(static_cast<char>('a' + jstd::MtRandomGen64::nextUInt32() % alphabet));
+        for (std::size_t j = 0; j < m; j++)
+            needle.push_back(static_cast<char>('a' + jstd::MtRandomGen64::nextUInt32() % alphabet));
+        if ((i % 3) == 0 && n > m) {
+            std::size_t offset = jstd::MtRandomGen64::nextUInt32() % (n - m + 1);
+            haystack.replace(offset, m, needle);
+        }
+
+        // The exact size buffers, to catch the reads out of the range.
+        std::vector<char> haystack_buf(haystack.begin(), haystack.end());
+        std::vector<char> needle_buf(needle.begin(), needle.end());
+        jstd::string_view sv(haystack_buf.data(), haystack_buf.size());
+        jstd::string_view sv_needle(needle_buf.data(), needle_buf.size());
+
+        std::size_t pos = ((i % 4) == 0) ? std::string::npos : (jstd::MtRandomGen64::nextUInt32() % (n + 3));
+        char ch = static_cast<char>('a' + jstd::MtRandomGen64::nextUInt32() % alphabet);
+
+        bool is_ok = (sv.find(sv_needle, pos) == haystack.find(needle, pos)) &&
+                     (sv.rfind(sv_needle, pos) == haystack.rfind(needle, pos)) &&
+                     (sv.find_first_of(sv_needle, pos) == haystack.find_first_of(needle, pos)) &&
+                     (sv.find_last_of(sv_needle, pos) == haystack.find_last_of(needle, pos)) &&
+                     (sv.find_first_not_of(sv_needle, pos) == haystack.find_first_not_of(needle, pos)) &&
+                     (sv.find_last_not_of(sv_needle, pos) == haystack.find_last_not_of(needle, pos)) &&
+                     (sv.find(ch, pos) == haystack.find(ch, pos)) &&
+                     (sv.rfind(ch, pos) == haystack.rfind(ch, pos));
+        if (!is_ok) {
+            if (errors < 10) {
+                printf("string_view find error: haystack = \"%s\", needle = \"%s\", pos = %" PRIuPTR "\n",
+                       haystack.c_str(), needle.c_str(), pos);
+            }
+            errors++;
+        }
+    }
+
+    printf("\n");
+    printf("string_view_find_test(): count = %" PRIuPTR "\n\n", kTestCount);
+    printf("string_view find errors: %" PRIuPTR "\n", errors);
+    printf("\n");
+    printf("result: %s\n\n", (errors == 0) ? "Passed" : "Failed");
+}
+
+void string_view_find_benchmark()
+{
+#ifdef NDEBUG
+    static const std::size_t kTotalBytes = 256 * 1024 * 1024;
+#else
+    static const std::size_t kTotalBytes = 1024 * 1024;
+#endif
+    static const std::size_t kHaystackSizes[] = { 16, 64, 256, 1024, 4096, 65536 };
+    static const std::size_t kNeedleSizes[] = { 1, 4, 16, 32 };
+
+    jtest::StopWatch sw;
+
+    printf("==========================================================================\n\n");
+    printf("  string_view_find_benchmark()\n\n");
+    printf("  The needle is at the end of the haystack, total bytes = %" PRIuPTR " per test.\n",
+           kTotalBytes);
+
+    // The haystack is a text of the lowercase letters except 'z', the needle
+    // only matches at the end, its first char is rare ('z') or frequent ('a').
+    static const char kFirstChars[] = { 'z', 'a' };
+    for (std::size_t f = 0; f < sizeof(kFirstChars); f++) {
+        printf("\n  The first char of needle: '%c'\n\n", kFirstChars[f]);
+        printf("  %8s %6s   %16s %16s %9s\n", "haystack", "needle",
+               "std::string", "jstd::sv", "speedup");
+        printf("  ------------------------------------------------------------------\n");
+
+        for (std::size_t h = 0; h < sizeof(kHaystackSizes) / sizeof(kHaystackSizes[0]); h++) {
+            for (std::size_t k = 0; k < sizeof(kNeedleSizes) / sizeof(kNeedleSizes[0]); k++) {
+                std::size_t n = kHaystackSizes[h];
+                std::size_t m = kNeedleSizes[k];
+                // A frequent single char needle always matches at the beginning.
+                if (m > n || (m == 1 && f != 0))
+                    continue;
+
+                std::string haystack;
+                for (std::size_t i = 0; i < n; i++)
+                    haystack.push_back(static_cast<char>('a' + (i * 7) % 25));
+                std::string needle(m, 'z');
+                needle[0] = kFirstChars[f];
+                haystack.replace(n - m, m, needle);
+
+                jstd::string_view sv(haystack);
+                jstd::string_view sv_needle(needle);
+                std::size_t iters = kTotalBytes / n;
+                std::size_t checksum1 = 0, checksum2 = 0;
+
+                sw.start();
+                for (std::size_t i = 0; i < iters; i++) {
+                    checksum1 += haystack.find(needle);
+                }
+                sw.stop();
+                double time1 = sw.getElapsedMillisec();
+
+                sw.start();
+                for (std::size_t i = 0; i < iters; i++) {
+                    checksum2 += sv.find(sv_needle);
+                }
+                sw.stop();
+                double time2 = sw.getElapsedMillisec();
+
+                printf("  %8" PRIuPTR " %6" PRIuPTR "   %10.2f GB/s %10.2f GB/s %8.3f x%s\n",
+                       n, m, kTotalBytes / time1 / 1000000.0, kTotalBytes / time2 / 1000000.0,
+                       time1 / time2, (checksum1 == checksum2) ? "" : "  (checksum error)");
+            }
+        }
+    }
+    printf("\n");
+
+    // find_first_of() with a delimiters set.
+    printf("  %8s %6s   %16s %16s %9s\n", "haystack", "set",
+           "std::string", "jstd::sv", "speedup");
+    printf("  ------------------------------------------------------------------\n");
+    for (std::size_t h = 0; h < sizeof(kHaystackSizes) / sizeof(kHaystackSizes[0]); h++) {
+        std::size_t n = kHaystackSizes[h];
+        std::string haystack;
+        for (std::size_t i = 0; i < n; i++)
+            haystack.push_back(static_cast<char>('a' + (i * 7) % 25));
+        haystack[n - 1] = ';';
+        const char * delimiters = " \t\r\n,;:|";
+
+        jstd::string_view sv(haystack);
+        std::size_t iters = kTotalBytes / n;
+        std::size_t checksum1 = 0, checksum2 = 0;
+
+        sw.start();
+        for (std::size_t i = 0; i < iters; i++) {
+            checksum1 += haystack.find_first_of(delimiters);
+        }
+        sw.stop();
+        double time1 = sw.getElapsedMillisec();
+
+        sw.start();
+        for (std::size_t i = 0; i < iters; i++) {
+            checksum2 += sv.find_first_of(delimiters);
+        }
+        sw.stop();
+        double time2 = sw.getElapsedMillisec();
+
+        printf("  %8" PRIuPTR " %6" PRIuPTR "   %10.2f GB/s %10.2f GB/s %8.3f x%s\n",
+               n, std::strlen(delimiters), kTotalBytes / time1 / 1000000.0,
+               kTotalBytes / time2 / 1000000.0, time1 / time2,
+               (checksum1 == checksum2) ? "" : "  (checksum error)");
+    }
+    printf("\n");
+}
+
+template <typename CharTy>
+static inline
+int sign_of(CharTy value)
+{
+    return (value > 0) ? 1 : ((value < 0) ? -1 : 0);
+}
+
+void string_utils_compare_test()
+{
+#ifdef NDEBUG
+    static const std::size_t kTestCount = 200000;
+#else
+    static const std::size_t kTestCount = 2000;
+#endif
+
+    jstd::MtRandomGen64 mtRandomGen64(20200831);
+
+    std::size_t errors = 0;
+
+    // Random strings with zero or one different char, compare with memcmp().
+    for (std::size_t i = 0; i < kTestCount; i++) {
+        std::size_t n = jstd::MtRandomGen64::nextUInt32() % (((i % 4) == 0) ? 40 : 300);
+        std::vector<char> str1(n), str2(n);
+        for (std::size_t j = 0; j < n; j++) {
+            str1[j] = str2[j] = static_cast<char>(jstd::MtRandomGen64::nextUInt32() % 256);
+        }
+        if ((n != 0) && ((i % 2) == 0)) {
+            std::size_t index = jstd::MtRandomGen64::nextUInt32() % n;
+            str2[index] = static_cast<char>(jstd::MtRandomGen64::nextUInt32() % 256);
+        }
+
+        int expected = sign_of(std::memcmp(str1.data(), str2.data(), n));
+        bool is_ok = (jstd::str_utils::is_equal(str1.data(), str2.data(), n) == (expected == 0)) &&
+                     (sign_of(jstd::str_utils::compare(str1.data(), str2.data(), n)) == expected);
+#if defined(__AVX2__)
+        is_ok = is_ok &&
+            (jstd::str_utils::detail::is_equal_avx2(str1.data(), str2.data(), n) == (expected == 0)) &&
+            (sign_of(jstd::str_utils::detail::compare_avx2(str1.data(), str2.data(), n)) == expected);
+#endif
+#if defined(__AVX512BW__)
+        is_ok = is_ok &&
+            (jstd::str_utils::detail::is_equal_avx512(str1.data(), str2.data(), n) == (expected == 0)) &&
+            (sign_of(jstd::str_utils::detail::compare_avx512(str1.data(), str2.data(), n)) == expected);
+#endif
+        // The different lengths.
+        std::size_t len2 = jstd::MtRandomGen64::nextUInt32() % (n + 1);
+        std::string s1(str1.data(), n), s2(str2.data(), len2);
+        is_ok = is_ok &&
+            (sign_of(jstd::str_utils::compare(s1.c_str(), s1.size(), s2.c_str(), s2.size())) ==
+             sign_of(s1.compare(s2)));
+        if (!is_ok) {
+            if (errors < 10) {
+                printf("string_utils compare error: length = %" PRIuPTR "\n", n);
+            }
+            errors++;
+        }
+    }
+
+    printf("\n");
+    printf("string_utils_compare_test(): count = %" PRIuPTR ", STRING_UTILS_KERNEL = %d\n\n",
+           kTestCount, (int)STRING_UTILS_KERNEL);
+    printf("string_utils compare errors: %" PRIuPTR "\n", errors);
+    printf("\n");
+    printf("result: %s\n\n", (errors == 0) ? "Passed" : "Failed");
+}
+
+struct StrUtilsKernel_STL {
+    static const char * name() { return "STL"; }
+    static bool is_equal(const char * s1, const char * s2, std::size_t n) {
+        return jstd::stl::StrEqual(s1, s2, n);
+    }
+    static int compare(const char * s1, const char * s2, std::size_t n) {
+        return jstd::stl::StrCmp(s1, s2, n);
+    }
+};
+
+struct StrUtilsKernel_LIBC {
+    static const char * name() { return "LIBC"; }
+    static bool is_equal(const char * s1, const char * s2, std::size_t n) {
+        return jstd::libc::StrEqual(s1, s2, n);
+    }
+    static int compare(const char * s1, const char * s2, std::size_t n) {
+        return jstd::libc::StrCmp(s1, s2, n);
+    }
+};
+
+// There is no compare() of U64, it's the LIBC version.
+struct StrUtilsKernel_U64 {
+    static const char * name() { return "U64"; }
+    static bool is_equal(const char * s1, const char * s2, std::size_t n) {
+        return jstd::str_utils::detail::is_equal_u64(s1, s2, n);
+    }
+    static int compare(const char * s1, const char * s2, std::size_t n) {
+        return jstd::libc::StrCmp(s1, s2, n);
+    }
+};
+
+#if defined(__SSE4_2__)
+struct StrUtilsKernel_SSE42 {
+    static const char * name() { return "SSE42"; }
+    static bool is_equal(const char * s1, const char * s2, std::size_t n) {
+        return jstd::str_utils::detail::is_equal_sse42(s1, s2, n);
+    }
+    static int compare(const char * s1, const char * s2, std::size_t n) {
+        return jstd::str_utils::detail::compare_sse42(s1, s2, n);
+    }
+};
+#endif
+
+#if defined(__AVX2__)
+struct StrUtilsKernel_AVX2 {
+    static const char * name() { return "AVX2"; }
+    static bool is_equal(const char * s1, const char * s2, std::size_t n) {
+        return jstd::str_utils::detail::is_equal_avx2(s1, s2, n);
+    }
+    static int compare(const char * s1, const char * s2, std::size_t n) {
+        return jstd::str_utils::detail::compare_avx2(s1, s2, n);
+    }
+};
+#endif
+
+#if defined(__AVX512BW__)
+struct StrUtilsKernel_AVX512 {
+    static const char * name() { return "AVX512"; }
+    static bool is_equal(const char * s1, const char * s2, std::size_t n) {
+        return jstd::str_utils::detail::is_equal_avx512(s1, s2, n);
+    }
+    static int compare(const char * s1, const char * s2, std::size_t n) {
+        return jstd::str_utils::detail::compare_avx512(s1, s2, n);
+    }
+};
+#endif
+
+// Return the nanoseconds per call.
+template <typename Kernel, bool IsCompare>
+double string_utils_kernel_benchmark(const std::vector<std::string> & strings1,
+                                     const std::vector<std::string> & strings2,
+                                     std::size_t length, std::size_t iters,
+                                     std::size_t & checksum)
+{
+    jtest::StopWatch sw;
+    std::size_t mask = strings1.size() - 1;
+    std::size_t sum = 0;
+    assert((strings1.size() & mask) == 0);
+
+    sw.start();
+    for (std::size_t i = 0; i < iters; i++) {
+        const std::string & str1 = strings1[i & mask];
+        const std::string & str2 = strings2[i & mask];
+        if (IsCompare)
+            sum += static_cast<std::size_t>(Kernel::compare(str1.c_str(), str2.c_str(), length) < 0);
+        else
+            sum += static_cast<std::size_t>(Kernel::is_equal(str1.c_str(), str2.c_str(), length));
+    }
+    sw.stop();
+
+    checksum = sum;
+    return (sw.getElapsedMillisec() * 1000000.0 / iters);
+}
+
+template <typename Kernel, bool IsCompare>
+void string_utils_kernel_benchmark_column(const std::vector<std::string> & strings1,
+                                          const std::vector<std::string> & strings2,
+                                          std::size_t length, std::size_t iters,
+                                          std::size_t expected)
+{
+    std::size_t checksum = 0;
+    double ns = string_utils_kernel_benchmark<Kernel, IsCompare>(strings1, strings2,
+                                                                 length, iters, checksum);
+    printf(" %7.2f%s", ns, (checksum == expected) ? " " : "*");
+}
+
+template <bool IsCompare>
+void string_utils_compare_benchmark_impl()
+{
+#ifdef NDEBUG
+    static const std::size_t kTotalBytes = 256 * 1024 * 1024;
+#else
+    static const std::size_t kTotalBytes = 1024 * 1024;
+#endif
+    static const std::size_t kLengths[] = {
+        1, 4, 7, 8, 15, 16, 24, 31, 32, 48, 63, 64, 100, 128, 255, 256, 1000, 4096
+    };
+    // Some different strings (power of 2), they are out of the L1 cache when the length is big.
+    static const std::size_t kStrings = 64;
+    // The U64 and SSE42 kernels maybe read over the end of strings.
+    static const std::size_t kPadding = 64;
+
+    printf("  %-8s %8s %8s %8s %8s %8s %8s  (ns per call)\n",
+           "length", "STL", "LIBC", "U64", "SSE42", "AVX2", "AVX512");
+    printf("  ------------------------------------------------------------------------\n");
+
+    for (std::size_t k = 0; k < sizeof(kLengths) / sizeof(kLengths[0]); k++) {
+        std::size_t length = kLengths[k];
+        std::vector<std::string> strings1, strings2;
+        for (std::size_t i = 0; i < kStrings; i++) {
+            std::string str;
+            for (std::size_t j = 0; j < length; j++)
+                str.push_back(static_cast<char>('a' + jstd::MtRandomGen64::nextUInt32() % 26));
+            str.reserve(length + kPadding);
+            strings1.push_back(str);
+            // The equal strings for is_equal(), the last char is different for compare().
+            if (IsCompare)
+                str[length - 1] = 'z' + 1;
+            strings2.push_back(str);
+            strings2.back().reserve(length + kPadding);
+        }
+
+        std::size_t iters = kTotalBytes / (length + 16);
+        std::size_t expected = iters;
+
+        printf("  %-8" PRIuPTR, length);
+        string_utils_kernel_benchmark_column<StrUtilsKernel_STL,  IsCompare>(strings1, strings2, length, iters, expected);
+        string_utils_kernel_benchmark_column<StrUtilsKernel_LIBC, IsCompare>(strings1, strings2, length, iters, expected);
+        string_utils_kernel_benchmark_column<StrUtilsKernel_U64,  IsCompare>(strings1, strings2, length, iters, expected);
+#if defined(__SSE4_2__)
+        string_utils_kernel_benchmark_column<StrUtilsKernel_SSE42, IsCompare>(strings1, strings2, length, iters, expected);
+#else
+        printf(" %8s", "n/a");
+#endif
+#if defined(__AVX2__)
+        string_utils_kernel_benchmark_column<StrUtilsKernel_AVX2, IsCompare>(strings1, strings2, length, iters, expected);
+#else
+        printf(" %8s", "n/a");
+#endif
+#if defined(__AVX512BW__)
+        string_utils_kernel_benchmark_column<StrUtilsKernel_AVX512, IsCompare>(strings1, strings2, length, iters, expected);
+#else
+        printf(" %8s", "n/a");
+#endif
+        printf("\n");
+    }
+    printf("\n");
+}
+
+void string_utils_compare_benchmark()
+{
+    printf("==========================================================================\n\n");
+    printf("  string_utils_compare_benchmark()\n\n");
+    printf("  STRING_UTILS_MODE = %d, STRING_UTILS_KERNEL = %d, '*' is a checksum error.\n\n",
+           (int)STRING_UTILS_MODE, (int)STRING_UTILS_KERNEL);
+
+    printf("  str_utils::is_equal(s1, s2, length), the strings are equal.\n\n");
+    string_utils_compare_benchmark_impl<false>();
+
+    printf("  str_utils::compare(s1, s2, length), the last char is different.\n\n");
+    string_utils_compare_benchmark_impl<true>();
+}
+
+static const char * find_data_file(const char * filename, std::string & path)
+{
+    static const char * kPrefixes[] = { "", "../", "../../", "../../../" };
+    for (std::size_t i = 0; i < sizeof(kPrefixes) / sizeof(kPrefixes[0]); i++) {
+        path = std::string(kPrefixes[i]) + filename;
+        FILE * fp = fopen(path.c_str(), "rb");
+        if (fp != nullptr) {
+            fclose(fp);
+            return path.c_str();
+        }
+    }
+    return nullptr;
+}
+
+template <typename Array>
+std::size_t string_view_array_iterate(const Array & array)
+{
+    std::size_t checksum = 0;
+    for (std::size_t i = 0; i < array.size(); i++) {
+        const jstd::string_view & key = array[i].first;
+        checksum += key.size() + static_cast<unsigned char>(key[key.size() - 1]);
+    }
+    return checksum;
+}
+
+void string_view_array_benchmark()
+{
+    typedef jstd::string_view_array<jstd::string_view, jstd::string_view>       string_view_array_t;
+    typedef jstd::flat_string_view_array<jstd::string_view, jstd::string_view>  flat_string_view_array_t;
+    typedef string_view_array_t::element_type                                   element_type;
+
+#ifdef NDEBUG
+    static const std::size_t kLoadRepeat = 50;
+    static const std::size_t kIterateRepeat = 1000;
+#else
+    static const std::size_t kLoadRepeat = 2;
+    static const std::size_t kIterateRepeat = 10;
+#endif
+
+    printf("==========================================================================\n\n");
+    printf("  string_view_array_benchmark()\n\n");
+
+    std::string path;
+    const char * filename = find_data_file("data/Maven.keys.txt", path);
+    if (filename == nullptr) {
+        printf("  The file \"data/Maven.keys.txt\" is not found, skipped.\n\n");
+        return;
+    }
+
+    jtest::StopWatch sw;
+    std::size_t lines = 0, checksum;
+    double load_time[4], iterate_time[3];
+    std::size_t checksums[3];
+
+    // std::vector<std::string> by std::getline(), like read_dict_file().
+    sw.start();
+    for (std::size_t r = 0; r < kLoadRepeat; r++) {
+        std::vector<std::string> words;
+        std::ifstream file(filename);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty() && line[line.size() - 1] == '\r')
+                line.resize(line.size() - 1);
+            if (!line.empty())
+                words.push_back(line);
+        }
+        lines = words.size();
+    }
+    sw.stop();
+    load_time[0] = sw.getElapsedMillisec() / kLoadRepeat;
+
+    // string_view_array<F, S>, one heap pair for each line of the file buffer.
+    std::vector<char> file_buffer;
+    sw.start();
+    for (std::size_t r = 0; r < kLoadRepeat; r++) {
+        string_view_array_t array;
+        jstd::read_file(filename, file_buffer);
+        jstd::string_view text(file_buffer.data(), file_buffer.size());
+        std::size_t first = 0;
+        while (first < text.size()) {
+            std::size_t last = text.find('\n', first);
+            if (last == jstd::string_view::npos)
+                last = text.size();
+            std::size_t next = last + 1;
+            if ((last > first) && (text[last - 1] == '\r'))
+                last--;
+            if (last > first)
+                array.push_back(new element_type(text.substr(first, last - first), jstd::string_view()));
+            first = next;
+        }
+    }
+    sw.stop();
+    load_time[1] = sw.getElapsedMillisec() / kLoadRepeat;
+
+    for (std::size_t mode = 0; mode < 2; mode++) {
+        sw.start();
+        for (std::size_t r = 0; r < kLoadRepeat; r++) {
+            flat_string_view_array_t array;
+            array.load_file(filename, (mode != 0));
+        }
+        sw.stop();
+        load_time[2 + mode] = sw.getElapsedMillisec() / kLoadRepeat;
+    }
+
+    // Iterate all keys and touch the last char of them.
+    {
+        std::vector<std::string> words;
+        flat_string_view_array_t flat_array;
+        flat_array.load_file(filename, true);
+        for (std::size_t i = 0; i < flat_array.size(); i++) {
+            words.push_back(flat_array[i].first.to_string());
+        }
+
+        string_view_array_t array;
+        for (std::size_t i = 0; i < words.size(); i++) {
+            array.push_back(new element_type(jstd::string_view(words[i]), jstd::string_view()));
+        }
+
+        sw.start();
+        checksum = 0;
+        for (std::size_t r = 0; r < kIterateRepeat; r++) {
+            for (std::size_t i = 0; i < words.size(); i++) {
+                checksum += words[i].size() + static_cast<unsigned char>(words[i][words[i].size() - 1]);
+            }
+        }
+        sw.stop();
+        iterate_time[0] = sw.getElapsedMillisec();
+        checksums[0] = checksum;
+
+        sw.start();
+        checksum = 0;
+        for (std::size_t r = 0; r < kIterateRepeat; r++) {
+            checksum += string_view_array_iterate(array);
+        }
+        sw.stop();
+        iterate_time[1] = sw.getElapsedMillisec();
+        checksums[1] = checksum;
+
+        sw.start();
+        checksum = 0;
+        for (std::size_t r = 0; r < kIterateRepeat; r++) {
+            checksum += string_view_array_iterate(flat_array);
+        }
+        sw.stop();
+        iterate_time[2] = sw.getElapsedMillisec();
+        checksums[2] = checksum;
+    }
+
+    printf("  File: %s, lines: %" PRIuPTR "\n\n", filename, lines);
+    printf("  %-44s %10s\n", "Load (ms per load)", "time");
+    printf("  ---------------------------------------------------------\n");
+    printf("  %-44s %10.3f\n", "std::vector<std::string> (std::getline)", load_time[0]);
+    printf("  %-44s %10.3f\n", "string_view_array<F, S> (new pairs)", load_time[1]);
+    printf("  %-44s %10.3f\n", "flat_string_view_array<F, S> (read)", load_time[2]);
+    printf("  %-44s %10.3f\n", "flat_string_view_array<F, S> (mmap)", load_time[3]);
+    printf("\n");
+    printf("  %-44s %10s\n", "Iterate (ns per key)", "time");
+    printf("  ---------------------------------------------------------\n");
+    printf("  %-44s %10.3f\n", "std::vector<std::string>",
+           iterate_time[0] * 1000000.0 / (kIterateRepeat * lines));
+    printf("  %-44s %10.3f%s\n", "string_view_array<F, S>",
+           iterate_time[1] * 1000000.0 / (kIterateRepeat * lines),
+           (checksums[1] == checksums[0]) ? "" : "  (checksum error)");
+    printf("  %-44s %10.3f%s\n", "flat_string_view_array<F, S>",
+           iterate_time[2] * 1000000.0 / (kIterateRepeat * lines),
+           (checksums[2] == checksums[0]) ? "" : "  (checksum error)");
+    printf("\n");
+}
+
+static void split_lines_scalar(const char * data, std::size_t size,
+                               std::vector<std::string> & lines)
+{
+    std::size_t first = 0;
+    while (first < size) {
+        std::size_t last = first;
+        while ((last < size) && (data[last] != '\n'))
+            last++;
+        std::size_t next = last + 1;
+        if ((last > first) && (data[last - 1] == '\r'))
+            last--;
+        lines.push_back(std::string(data + first, last - first));
+        first = next;
+    }
+}
+
+void line_splitter_test()
+{
+#ifdef NDEBUG
+    static const std::size_t kTestCount = 50000;
+#else
+    static const std::size_t kTestCount = 2000;
+#endif
+    static const char kChars[] = "ab,\n\r";
+
+    jstd::MtRandomGen64 mtRandomGen64(20200831);
+
+    std::size_t errors = 0;
+
+    // Random texts in the exact size buffers, compare with a scalar split.
+    for (std::size_t i = 0; i < kTestCount; i++) {
+        std::size_t n = jstd::MtRandomGen64::nextUInt32() % (((i % 4) == 0) ? 70 : 400);
+        std::vector<char> text(n);
+        for (std::size_t j = 0; j < n; j++) {
+            text[j] = kChars[jstd::MtRandomGen64::nextUInt32() % 5];
+        }
+
+        std::vector<std::string> expected, lines;
+        split_lines_scalar(text.data(), n, expected);
+
+        jstd::line_splitter splitter(text.data(), n);
+        jstd::string_view line;
+        while (splitter.next_line(line)) {
+            lines.push_back(line.to_string());
+        }
+        bool is_ok = (lines == expected) &&
+                     (jstd::line_splitter::count_lines(text.data(), n) == expected.size());
+
+        // The fields of every line, split by ','.
+        std::vector<std::string> expected_fields, fields;
+        std::size_t line_ends = 0;
+        for (std::size_t k = 0; k < expected.size(); k++) {
+            std::size_t first = 0, last;
+            while ((last = expected[k].find(',', first)) != std::string::npos) {
+                expected_fields.push_back(expected[k].substr(first, last - first));
+                first = last + 1;
+            }
+            expected_fields.push_back(expected[k].substr(first));
+        }
+
+        jstd::line_splitter field_splitter(text.data(), n, ',');
+        jstd::string_view field;
+        bool is_line_end;
+        while (field_splitter.next_field(field, is_line_end)) {
+            fields.push_back(field.to_string());
+            if (is_line_end)
+                line_ends++;
+        }
+        is_ok = is_ok && (fields == expected_fields) && (line_ends == expected.size());
+
+        if (!is_ok) {
+            if (errors < 10) {
+                printf("line_splitter error: length = %" PRIuPTR "\n", n);
+            }
+            errors++;
+        }
+    }
+
+    // file_line_reader with a small buffer, compare with line_splitter over the whole file.
+    std::string path;
+    const char * filename = find_data_file("data/Maven.keys.txt", path);
+    if (filename != nullptr) {
+        std::vector<char> file_buffer;
+        jstd::read_file(filename, file_buffer);
+        std::vector<std::string> expected, lines;
+        split_lines_scalar(file_buffer.data(), file_buffer.size(), expected);
+
+        jstd::file_line_reader reader(filename, 100);
+        jstd::string_view line;
+        while (reader.next_line(line)) {
+            lines.push_back(line.to_string());
+        }
+        if ((lines != expected) || (reader.total_bytes() != file_buffer.size())) {
+            printf("file_line_reader error: lines = %" PRIuPTR ", expected = %" PRIuPTR "\n",
+                   lines.size(), expected.size());
+            errors++;
+        }
+    }
+
+    printf("\n");
+    printf("line_splitter_test(): count = %" PRIuPTR "\n\n", kTestCount);
+    printf("line_splitter errors: %" PRIuPTR "\n", errors);
+    printf("\n");
+    printf("result: %s\n\n", (errors == 0) ? "Passed" : "Failed");
+}
+
+typedef jstd::flat_string_view_array<jstd::string_view, jstd::string_view>  flat_sv_array_t;
+typedef std::vector<std::pair<std::string, std::string>>                    sv_pairs_t;
+
+static bool flat_string_view_array_equal(const flat_sv_array_t & array, const sv_pairs_t & expected)
+{
+    if (array.size() != expected.size())
+        return false;
+    for (std::size_t i = 0; i < array.size(); i++) {
+        if ((array[i].first.to_string() != expected[i].first) ||
+            (array[i].second.to_string() != expected[i].second))
+            return false;
+    }
+    return true;
+}
+
+void flat_string_view_array_test()
+{
+    static const char kFilename[] = "flat_string_view_array_test.txt";
+    static const char kText[] = "alpha\r\nbeta\n\n\r\ngamma,1\r\ndelta,2,3\nepsilon,\n\nzeta";
+
+    std::size_t errors = 0;
+
+    FILE * fp = fopen(kFilename, "wb");
+    if (fp == nullptr) {
+        printf("flat_string_view_array_test(): can't create \"%s\", skipped.\n\n", kFilename);
+        return;
+    }
+    fwrite(kText, 1, sizeof(kText) - 1, fp);
+    fclose(fp);
+
+    // The empty lines are skipped, "\r\n" is accepted, and the fields after
+    // the first separator are joined into the second.
+    sv_pairs_t expected_lines = {
+        { "alpha", "" }, { "beta", "" }, { "gamma,1", "" },
+        { "delta,2,3", "" }, { "epsilon,", "" }, { "zeta", "" }
+    };
+    sv_pairs_t expected_fields = {
+        { "alpha", "" }, { "beta", "" }, { "gamma", "1" },
+        { "delta", "2,3" }, { "epsilon", "" }, { "zeta", "" }
+    };
+
+    // The read path and the mmap path of the same file.
+    for (int separator = 0; separator < 2; separator++) {
+        const sv_pairs_t & expected = (separator == 0) ? expected_lines : expected_fields;
+        flat_sv_array_t read_array, mmap_array;
+        bool read_ok = read_array.load_file(kFilename, false, (separator == 0) ? '\0' : ',');
+        bool mmap_ok = mmap_array.load_file(kFilename, true, (separator == 0) ? '\0' : ',');
+        if (!read_ok || !mmap_ok ||
+            !flat_string_view_array_equal(read_array, expected) ||
+            !flat_string_view_array_equal(mmap_array, expected) ||
+            !read_array.owns_bytes() || !mmap_array.owns_bytes() ||
+            (read_array.storage_bytes() != sizeof(kText) - 1) ||
+            (mmap_array.storage_bytes() != sizeof(kText) - 1)) {
+            printf("flat_string_view_array::load_file() error: separator = %d\n", separator);
+            errors++;
+        }
+    }
+
+    // push_back_copy(): the array owns the copies of the bytes.
+    {
+        flat_sv_array_t array;
+        std::string key("key"), value("value");
+        array.push_back_copy(jstd::string_view(key), jstd::string_view(value));
+        key.assign("###");
+        value.assign("#####");
+        std::string empty;
+        array.push_back_copy(jstd::string_view(empty), jstd::string_view(empty));
+        sv_pairs_t expected = { { "key", "value" }, { "", "" } };
+        if (!flat_string_view_array_equal(array, expected) || !array.owns_bytes() ||
+            (array[0].first.data() == key.data())) {
+            printf("flat_string_view_array::push_back_copy() error\n");
+            errors++;
+        }
+    }
+
+    // The copy owns it's own bytes, the move keeps the bytes at the same address.
+    {
+        flat_sv_array_t * source = new flat_sv_array_t;
+        source->load_file(kFilename, true, ',');
+        const char * source_data = (*source)[0].first.data();
+
+        flat_sv_array_t copy_array(*source);
+        flat_sv_array_t copy_assigned;
+        copy_assigned = *source;
+        flat_sv_array_t move_array(std::move(*source));
+        bool is_ok = copy_array.owns_bytes() && copy_assigned.owns_bytes() && move_array.owns_bytes() &&
+                     (copy_array[0].first.data() != source_data) &&
+                     (copy_assigned[0].first.data() != source_data) &&
+                     (move_array[0].first.data() == source_data) &&
+                     source->empty() && !source->owns_bytes();
+        delete source;
+
+        flat_sv_array_t move_assigned;
+        move_assigned = std::move(move_array);
+        is_ok = is_ok && flat_string_view_array_equal(copy_array, expected_fields) &&
+                flat_string_view_array_equal(copy_assigned, expected_fields) &&
+                flat_string_view_array_equal(move_assigned, expected_fields) &&
+                (move_assigned[0].first.data() == source_data) && move_array.empty();
+
+        // A copy of the array which doesn't own the bytes is a shallow copy.
+        flat_sv_array_t views;
+        views.push_back(flat_sv_array_t::value_type(jstd::string_view(kText, 5), jstd::string_view()));
+        flat_sv_array_t views_copy(views);
+        is_ok = is_ok && !views_copy.owns_bytes() && (views_copy[0].first.data() == kText);
+        if (!is_ok) {
+            printf("flat_string_view_array copy/move error\n");
+            errors++;
+        }
+    }
+
+    // The empty file and the missing file.
+    {
+        fp = fopen(kFilename, "wb");
+        if (fp != nullptr)
+            fclose(fp);
+        flat_sv_array_t read_array, mmap_array, missing_array;
+        if (!read_array.load_file(kFilename, false) || !read_array.empty() ||
+            !mmap_array.load_file(kFilename, true) || !mmap_array.empty() ||
+            missing_array.load_file("flat_string_view_array_test.missing.txt", true)) {
+            printf("flat_string_view_array::load_file() error: empty or missing file\n");
+            errors++;
+        }
+    }
+    remove(kFilename);
+
+    printf("flat_string_view_array_test(): errors = %" PRIuPTR "\n\n", errors);
+    printf("result: %s\n\n", (errors == 0) ? "Passed" : "Failed");
+}
+
+void rdtsc_stopwatch_test()
+{
+    std::size_t errors = 0;
+
+    const jtest::TscClock::calibration_t & calibration = jtest::TscClock::calibrate();
+    printf("rdtsc_stopwatch_test(): frequency = %0.3f MHz, invariant TSC = %s, rdtscp = %s, overhead = %" PRIu64 " ticks\n\n",
+           calibration.frequency / 1000000.0,
+           calibration.is_invariant ? "yes" : "no",
+           jtest::TscClock::has_rdtscp() ? "yes" : "no",
+           static_cast<std::uint64_t>(calibration.overhead));
+
+    // An empty measurement is about zero after the overhead is subtracted,
+    // the minimum of the readings still jitters by a few ticks.
+    static const jtest::TscClock::tick_t kEmptyToleranceTicks = 16;
+    double max_empty_ns = jtest::TscClock::to_seconds(kEmptyToleranceTicks) * 1.0e9;
+    double min_empty_ns = 1.0e9;
+    for (std::size_t i = 0; i < 1000; i++) {
+        jtest::rdtscStopWatch sw;
+        sw.start();
+        sw.stop();
+        double elapsed_ns = sw.getElapsedNanosec();
+        if (elapsed_ns < min_empty_ns)
+            min_empty_ns = elapsed_ns;
+    }
+    if (min_empty_ns > max_empty_ns) {
+        printf("rdtscStopWatch error: the empty measurement = %0.2f ns, expected <= %0.2f ns\n",
+               min_empty_ns, max_empty_ns);
+        errors++;
+    }
+
+    // A busy loop of 20 ms, rdtscStopWatch and StopWatch must agree within 1%.
+    jtest::rdtscStopWatch sw_tsc;
+    jtest::StopWatch sw_std;
+    sw_std.start();
+    sw_tsc.start();
+    std::uint64_t start_ns = jtest::TscClock::monotonic_raw_ns();
+    while ((jtest::TscClock::monotonic_raw_ns() - start_ns) < 20000000ULL) {
+        // Wait
+    }
+    sw_tsc.stop();
+    sw_std.stop();
+    double tsc_ms = sw_tsc.getElapsedMillisec();
+    double std_ms = sw_std.getElapsedMillisec();
+    printf("busy loop: rdtscStopWatch = %0.3f ms, StopWatch = %0.3f ms\n\n", tsc_ms, std_ms);
+    if (std::fabs(tsc_ms - std_ms) > std_ms * 0.01) {
+        printf("rdtscStopWatch error: the busy loop = %0.3f ms, expected = %0.3f ms\n", tsc_ms, std_ms);
+        errors++;
+    }
+
+    // rdtscStopWatchEx accumulates the paused segments.
+    jtest::rdtscStopWatchEx sw_ex;
+    for (std::size_t i = 0; i < 4; i++) {
+        sw_ex.start();
+        start_ns = jtest::TscClock::monotonic_raw_ns();
+        while ((jtest::TscClock::monotonic_raw_ns() - start_ns) < 2000000ULL) {
+            // Wait
+        }
+        sw_ex.pause();
+    }
+    double total_ms = sw_ex.getTotalMillisec();
+    if (total_ms < 8.0 * 0.99 || total_ms > 8.0 * 1.10) {
+        printf("rdtscStopWatchEx error: total = %0.3f ms, expected = 8.000 ms\n", total_ms);
+        errors++;
+    }
+
+    printf("rdtsc_stopwatch errors: %" PRIuPTR "\n", errors);
+    printf("\n");
+    printf("result: %s\n\n", (errors == 0) ? "Passed" : "Failed");
+}
+
+void latency_histogram_test()
+{
+    std::size_t errors = 0;
+
+    printf("latency_histogram_test()\n\n");
+
+    // Every bucket contains the values that map to it, and the buckets are contiguous.
+    for (std::size_t index = 1; index < jtest::LatencyHistogram::kBucketCount; index++) {
+        std::uint64_t lowest  = jtest::LatencyHistogram::get_lowest_value(index);
+        std::uint64_t highest = jtest::LatencyHistogram::get_highest_value(index);
+        if (jtest::LatencyHistogram::get_index(lowest) != index ||
+            jtest::LatencyHistogram::get_index(highest) != index ||
+            jtest::LatencyHistogram::get_highest_value(index - 1) + 1 != lowest) {
+            printf("LatencyHistogram error: bucket %" PRIuPTR " = [%" PRIu64 ", %" PRIu64 "]\n",
+                   index, lowest, highest);
+            errors++;
+            break;
+        }
+    }
+
+    // 1 ~ 1000000, the percentiles are within the relative error of 1/128.
+    jtest::LatencyHistogram histogram1, histogram2;
+    for (std::uint64_t value = 1; value <= 1000000; value++) {
+        if ((value & 1) != 0)
+            histogram1.record(value);
+        else
+            histogram2.record(value);
+    }
+    histogram1.merge(histogram2);
+
+    static const double kPercents[] = { 50.0, 90.0, 99.0, 99.9 };
+    for (std::size_t i = 0; i < sizeof(kPercents) / sizeof(kPercents[0]); i++) {
+        double expected = kPercents[i] * 1000000.0 / 100.0;
+        double value = static_cast<double>(histogram1.percentile(kPercents[i]));
+        if (std::fabs(value - expected) > expected / 128.0) {
+            printf("LatencyHistogram error: p%g = %0.0f, expected = %0.0f\n",
+                   kPercents[i], value, expected);
+            errors++;
+        }
+    }
+    if (histogram1.count() != 1000000 || histogram1.min() != 1 || histogram1.max() != 1000000 ||
+        histogram1.percentile(100.0) != 1000000) {
+        printf("LatencyHistogram error: count = %" PRIu64 ", min = %" PRIu64 ", max = %" PRIu64 "\n",
+               histogram1.count(), histogram1.min(), histogram1.max());
+        errors++;
+    }
+
+    jtest::LatencySummary summary = histogram1.summary(0.5);
+    printf("p50 = %0.1f, p90 = %0.1f, p99 = %0.1f, p999 = %0.1f, max = %0.1f (scale = 0.5)\n\n",
+           summary.p50, summary.p90, summary.p99, summary.p999, summary.max);
+
+    // Sample one of every 16 operations.
+    jtest::LatencyHistogram histogram3;
+    jtest::LatencySampler sampler(histogram3, 10);
+    for (std::size_t i = 0; i < 1600; i++) {
+        sampler.start();
+        sampler.stop();
+    }
+    if (sampler.sample_rate() != 16 || histogram3.count() != 100) {
+        printf("LatencySampler error: sample_rate = %" PRIuPTR ", samples = %" PRIu64 "\n",
+               sampler.sample_rate(), histogram3.count());
+        errors++;
+    }
+
+    histogram1.reset();
+    if (histogram1.count() != 0 || histogram1.max() != 0 || histogram1.percentile(99.0) != 0) {
+        printf("LatencyHistogram error: reset() failed\n");
+        errors++;
+    }
+
+    printf("latency_histogram errors: %" PRIuPTR "\n", errors);
+    printf("\n");
+    printf("result: %s\n\n", (errors == 0) ? "Passed" : "Failed");
+}
+
+void workload_test()
+{
+    static const std::size_t kItems = 100000;
+    static const std::size_t kSamples = 1000000;
+
+    std::size_t errors = 0;
+
+    printf("workload_test()\n\n");
+
+    jstd::MtRandomGen::srand(20200831);
+
+    // The frequency of the rank k is 1 / (k^theta * zeta(n)), the Gray's method is
+    // exact for the first two ranks, the others are approximated.
+    jtest::ZipfianGenerator zipfian(kItems, 0.99);
+    std::vector<std::size_t> counts(kItems, 0);
+    for (std::size_t i = 0; i < kSamples; i++) {
+        std::uint64_t item = zipfian.next();
+        if (item >= kItems) {
+            printf("ZipfianGenerator error: item = %" PRIu64 "\n", item);
+            errors++;
+            break;
+        }
+        counts[item]++;
+    }
+    double zetan = jtest::ZipfianGenerator::zeta(0, kItems, 0.99, 0.0);
+    for (std::size_t k = 0; k < 2; k++) {
+        double expected = kSamples / (std::pow(double(k + 1), 0.99) * zetan);
+        if (std::fabs(counts[k] - expected) > expected * 0.05) {
+            printf("ZipfianGenerator error: count[%" PRIuPTR "] = %" PRIuPTR ", expected = %0.0f\n",
+                   k, counts[k], expected);
+            errors++;
+        }
+    }
+    if (!(counts[1] > counts[2] && counts[2] > counts[3] && counts[3] > counts[kItems / 2])) {
+        printf("ZipfianGenerator error: the counts are not decreasing\n");
+        errors++;
+    }
+    printf("zipfian(n = %" PRIuPTR ", theta = 0.99): top 4 = %" PRIuPTR ", %" PRIuPTR ", %" PRIuPTR ", %" PRIuPTR "\n",
+           kItems, counts[0], counts[1], counts[2], counts[3]);
+
+    // The hot set (20% of the keys) gets 80% of the operations.
+    jtest::KeyChooser hotspot(jtest::kDistHotspot, kItems);
+    std::size_t hot_count = 0;
+    for (std::size_t i = 0; i < kSamples; i++) {
+        if (hotspot.next() < kItems / 5)
+            hot_count++;
+    }
+    double hot_fraction = double(hot_count) / kSamples;
+    printf("hotspot: %0.2f%% of the operations access the hot set\n", hot_fraction * 100.0);
+    if (std::fabs(hot_fraction - 0.8) > 0.01) {
+        printf("KeyChooser error: hotspot fraction = %0.4f, expected = 0.8\n", hot_fraction);
+        errors++;
+    }
+
+    // YCSB D: the reads follow the inserted keys.
+    jtest::Workload workload(jtest::WorkloadSpec::ycsb('D'));
+    workload.generate(kItems, kSamples, 20200831);
+    std::size_t recent_reads = 0, reads = 0;
+    std::size_t inserted = 0;
+    for (std::size_t i = 0; i < workload.size(); i++) {
+        const jtest::WorkloadOperation & operation = workload[i];
+        if (operation.op == jtest::kOpInsert) {
+            if (operation.key != kItems + inserted) {
+                printf("Workload error: insert key = %" PRIu64 "\n", operation.key);
+                errors++;
+                break;
+            }
+            inserted++;
+        }
+        else {
+            if (operation.key >= kItems + inserted) {
+                printf("Workload error: read key = %" PRIu64 " is not inserted\n", operation.key);
+                errors++;
+                break;
+            }
+            if (operation.key + 1000 >= kItems + inserted)
+                recent_reads++;
+            reads++;
+        }
+    }
+    double insert_fraction = double(workload.op_count(jtest::kOpInsert)) / workload.size();
+    printf("ycsb_d: insert %0.2f%%, read %0.2f%%, the reads of the latest 1000 keys: %0.2f%%\n\n",
+           insert_fraction * 100.0, 100.0 - insert_fraction * 100.0,
+           (reads != 0) ? (recent_reads * 100.0 / reads) : 0.0);
+    if (std::fabs(insert_fraction - 0.05) > 0.005 || inserted != workload.inserts() ||
+        recent_reads < reads / 2) {
+        printf("Workload error: ycsb_d, insert = %0.4f, recent reads = %" PRIuPTR " / %" PRIuPTR "\n",
+               insert_fraction, recent_reads, reads);
+        errors++;
+    }
+
+    // Every container runs the same operations.
+    jtest::Workload workload_a(jtest::WorkloadSpec::ycsb('A'));
+    workload_a.generate(1000, 100000, 20200831);
+    std::unordered_map<std::uint64_t, std::uint64_t> map1;
+    jstd::Dictionary<std::uint64_t, std::uint64_t> map2;
+    for (std::uint64_t key = 0; key < 1000; key++) {
+        map1.emplace(key, key);
+        map2.emplace(key, key);
+    }
+    std::size_t found1 = workload_a.run(map1);
+    std::size_t found2 = workload_a.run(map2);
+    if (found1 != workload_a.size() || found2 != found1) {
+        printf("Workload error: ycsb_a, found = %" PRIuPTR " / %" PRIuPTR ", expected = %" PRIuPTR "\n",
+               found1, found2, workload_a.size());
+        errors++;
+    }
+
+    printf("workload errors: %" PRIuPTR "\n", errors);
+    printf("\n");
+    printf("result: %s\n\n", (errors == 0) ? "Passed" : "Failed");
+}
+
+template <typename RandomEngine, typename T>
+std::size_t random_engine_fill_test(const char * name, std::size_t seed)
+{
+    // Cross the state blocks (624 / 312 words) with the odd sized chunks.
+    static const std::size_t chunks[] = { 1, 3, 311, 312, 313, 623, 624, 625, 1000, 7 };
+    static const std::size_t kChunks = sizeof(chunks) / sizeof(chunks[0]);
+
+    RandomEngine engine1(static_cast<typename RandomEngine::value_type>(seed));
+    RandomEngine engine2(static_cast<typename RandomEngine::value_type>(seed));
+    std::size_t errors = 0;
+    std::size_t index = 0;
+    for (std::size_t n = 0; n < kChunks; n++) {
+        std::vector<T> values(chunks[n]);
+        engine2.fill(&values[0], values.size());
+        for (std::size_t i = 0; i < values.size(); i++) {
+            T expected = (sizeof(T) == 4) ? static_cast<T>(engine1.nextUInt32())
+                                          : static_cast<T>(engine1.nextUInt64());
+            if (values[i] != expected) {
+                if (errors == 0) {
+                    printf("%s::fill(uint%u_t) error: index = %" PRIuPTR ", value = %" PRIu64 ", expected = %" PRIu64 "\n",
+                           name, (uint32_t)(sizeof(T) * 8), index + i,
+                           (std::uint64_t)values[i], (std::uint64_t)expected);
+                }
+                errors++;
+            }
+        }
+        index += values.size();
+    }
+    return errors;
+}
+
+template <typename RandomEngine>
+std::size_t random_engine_fill_test(const char * name)
+{
+    std::size_t errors = 0;
+    errors += random_engine_fill_test<RandomEngine, std::uint32_t>(name, 20200831);
+    errors += random_engine_fill_test<RandomEngine, std::uint64_t>(name, 20200831);
+    return errors;
+}
+
+void random_engine_test()
+{
+    std::size_t errors = 0;
+
+    printf("random_engine_test()\n\n");
+
+    // The reference vectors of the authors' implementations.
+    {
+        static const std::uint64_t expected[] = {
+            0x86B1DA1D72062B68ull, 0x1304AA46C9853D39ull, 0xA3670E9E0DD50358ull,
+            0xF9090E529A7DAE00ull, 0xC85B9FD837996F2Cull, 0x606121F8E3919196ull
+        };
+        jstd::PCG64 pcg64(42, 54);
+        for (std::size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+            std::uint64_t value = pcg64.nextUInt64();
+            if (value != expected[i]) {
+                printf("PCG64 error: index = %" PRIuPTR ", value = 0x%016" PRIX64 ", expected = 0x%016" PRIX64 "\n",
+                       i, value, expected[i]);
+                errors++;
+            }
+        }
+    }
+    {
+        static const std::uint64_t expected[] = {
+            41943041ull, 58720359ull, 3588806011781223ull,
+            3591011842654386ull, 9228616714210784205ull, 9973669472204895162ull
+        };
+        jstd::Xoshiro256pp xoshiro;
+        xoshiro.set_state(1, 2, 3, 4);
+        for (std::size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+            std::uint64_t value = xoshiro.nextUInt64();
+            if (value != expected[i]) {
+                printf("Xoshiro256pp error: index = %" PRIuPTR ", value = %" PRIu64 ", expected = %" PRIu64 "\n",
+                       i, value, expected[i]);
+                errors++;
+            }
+        }
+    }
+    {
+        static const std::uint32_t expected[] = {
+            3440181298u, 1564997079u, 1510669302u, 2930277156u, 1452439940u, 3796268453u
+        };
+        jstd::SFMT19937 sfmt(1234);
+        for (std::size_t i = 0; i < sizeof(expected) / sizeof(expected[0]); i++) {
+            std::uint32_t value = sfmt.nextUInt32();
+            if (value != expected[i]) {
+                printf("SFMT19937 error: index = %" PRIuPTR ", value = %u, expected = %u\n",
+                       i, value, expected[i]);
+                errors++;
+            }
+        }
+    }
+    {
+        // The 10000th output of std::mt19937 with the default seed.
+        jstd::MT19937_32 mt32(5489);
+        std::uint32_t value = 0;
+        for (std::size_t i = 0; i < 10000; i++) {
+            value = mt32.nextUInt32();
+        }
+        if (value != 4123659995u) {
+            printf("MT19937_32 error: value = %u, expected = %u\n", value, 4123659995u);
+            errors++;
+        }
+    }
+
+    // fill() must be the same as the repeated nextUInt32() / nextUInt64(), bit by bit.
+    errors += random_engine_fill_test<jstd::MT19937_32>("MT19937_32");
+    errors += random_engine_fill_test<jstd::MT19937_64>("MT19937_64");
+    errors += random_engine_fill_test<jstd::SFMT19937>("SFMT19937");
+    errors += random_engine_fill_test<jstd::Xoshiro256pp>("Xoshiro256pp");
+    errors += random_engine_fill_test<jstd::PCG64>("PCG64");
+
+    printf("random engine errors: %" PRIuPTR "\n", errors);
+    printf("\n");
+    printf("result: %s\n\n", (errors == 0) ? "Passed" : "Failed");
+}
+
+void thread_bench_test()
+{
+    static const std::size_t kThreads = 4;
+    static const std::size_t kPhases = 1000;
+    static const std::size_t kOperations = 100000;
+
+    std::size_t errors = 0;
+
+    printf("thread_bench_test()\n\n");
+
+    const jtest::CpuTopology & topology = jtest::CpuTopology::get();
+    topology.print();
+    printf("\n");
+
+    if (topology.logical_cpus() == 0 || topology.physical_cores() == 0 ||
+        topology.physical_cores() > topology.logical_cpus()) {
+        printf("CpuTopology error: logical CPUs = %" PRIuPTR ", physical cores = %" PRIuPTR "\n",
+               topology.logical_cpus(), topology.physical_cores());
+        errors++;
+    }
+
+    // The spread placement uses all the physical cores before the SMT siblings.
+    std::vector<int> cpus = topology.placement(topology.physical_cores(), jtest::kPlaceSpread);
+    if (topology.shared_cores(cpus) != 0) {
+        printf("CpuTopology error: the spread placement shares %" PRIuPTR " cores\n",
+               topology.shared_cores(cpus));
+        errors++;
+    }
+    cpus = topology.placement(kThreads, jtest::kPlaceCompact);
+    for (std::size_t i = 0; i < cpus.size(); i++) {
+        if (topology.find(cpus[i]) == nullptr) {
+            printf("CpuTopology error: cpu %d is not allowed\n", cpus[i]);
+            errors++;
+        }
+    }
+
+    // No thread passes the barrier before all the threads arrive.
+    {
+        jtest::SpinBarrier barrier(kThreads);
+        std::atomic<std::size_t> arrived(0);
+        std::atomic<std::size_t> barrier_errors(0);
+        std::vector<std::thread> threads;
+        for (std::size_t t = 0; t < kThreads; t++) {
+            threads.push_back(std::thread([&]() {
+                for (std::size_t phase = 0; phase < kPhases; phase++) {
+                    arrived.fetch_add(1);
+                    barrier.wait();
+                    if (arrived.load() < (phase + 1) * kThreads)
+                        barrier_errors.fetch_add(1);
+                    barrier.wait();
+                }
+            }));
+        }
+        for (std::size_t t = 0; t < kThreads; t++) {
+            threads[t].join();
+        }
+        if (barrier_errors.load() != 0 || arrived.load() != kPhases * kThreads) {
+            printf("SpinBarrier error: errors = %" PRIuPTR ", arrived = %" PRIuPTR "\n",
+                   barrier_errors.load(), arrived.load());
+            errors++;
+        }
+    }
+
+    // The operations of the threads are aggregated.
+    {
+        jtest::ThreadBench bench;
+        bench.set_repetitions(3);
+        const jtest::ThreadBenchResult * result =
+            bench.run("thread_bench_test/sum", kThreads, [](jtest::ThreadContext & context) {
+                std::size_t sum = 0;
+                for (std::size_t i = 0; i < kOperations; i++) {
+                    context.sampler().start();
+                    sum += i ^ context.thread_id();
+                    context.sampler().stop();
+                }
+                jtest::DoNotOptimize(sum);
+                context.add_operations(kOperations);
+            });
+        if (result == nullptr || result->threads != kThreads ||
+            result->thread_operations.size() != kThreads) {
+            printf("ThreadBench error: no result of %" PRIuPTR " threads\n", kThreads);
+            errors++;
+        }
+        else {
+            for (std::size_t t = 0; t < kThreads; t++) {
+                if (result->thread_operations[t] != kOperations) {
+                    printf("ThreadBench error: thread %" PRIuPTR ", operations = %" PRIu64 "\n",
+                           t, result->thread_operations[t]);
+                    errors++;
+                }
+            }
+            if (result->throughput <= 0.0 || result->stats.latency.count == 0) {
+                printf("ThreadBench error: throughput = %0.3f, latency samples = %" PRIu64 "\n",
+                       result->throughput, result->stats.latency.count);
+                errors++;
+            }
+        }
+    }
+
+    printf("thread bench errors: %" PRIuPTR "\n", errors);
+    printf("\n");
+    printf("result: %s\n\n", (errors == 0) ? "Passed" : "Failed");
+}
+
+template <typename Aggregator>
+std::size_t hash_aggregator_check(const char * name, const std::vector<std::uint32_t> & keys,
+                                  const std::vector<std::uint32_t> & values)
+{
+    typedef typename Aggregator::result_type                    result_type;
+    typedef std::unordered_map<std::uint32_t, result_type>      reference_map;
+    typedef jstd::Dictionary<std::uint32_t, result_type>        dictionary_type;
+
+    std::size_t errors = 0;
+
+    reference_map expected;
+    for (std::size_t i = 0; i < keys.size(); i++) {
+        auto iter = expected.find(keys[i]);
+        if (iter != expected.end())
+            Aggregator::combine(iter->second, Aggregator::init(values[i]));
+        else
+            expected.emplace(keys[i], Aggregator::init(values[i]));
+    }
+
+    jstd::HashAggregator<std::uint32_t, Aggregator, dictionary_type> aggregator;
+    aggregator.add(keys.data(), values.data(), keys.size());
+    if (aggregator.size() != expected.size()) {
+        printf("HashAggregator<%s> error: groups = %" PRIuPTR ", expected = %" PRIuPTR "\n",
+               name, aggregator.size(), expected.size());
+        errors++;
+    }
+    for (auto iter = expected.begin(); iter != expected.end(); ++iter) {
+        auto found = aggregator.table().find(iter->first);
+        if (found == aggregator.table().end() || found->second != iter->second) {
+            printf("HashAggregator<%s> error: key = %u\n", name, iter->first);
+            errors++;
+            break;
+        }
+    }
+
+    // The rows are aggregated twice, and the partial tables are merged.
+    jstd::PartitionedAggregator<std::uint32_t, Aggregator, dictionary_type> partitioned(4);
+    partitioned.aggregate(keys.data(), values.data(), keys.size());
+    partitioned.aggregate(keys.data(), values.data(), keys.size());
+    if (partitioned.size() != expected.size()) {
+        printf("PartitionedAggregator<%s> error: groups = %" PRIuPTR ", expected = %" PRIuPTR "\n",
+               name, partitioned.size(), expected.size());
+        errors++;
+    }
+    for (auto iter = expected.begin(); iter != expected.end(); ++iter) {
+        result_type twice = iter->second;
+        Aggregator::combine(twice, iter->second);
+        result_type result = result_type();
+        if (!partitioned.find(iter->first, result) || result != twice) {
+            printf("PartitionedAggregator<%s> error: key = %u\n", name, iter->first);
+            errors++;
+            break;
+        }
+    }
+
+    printf("%-6s: groups = %" PRIuPTR ", partitions = %" PRIuPTR ", errors = %" PRIuPTR "\n",
+           name, aggregator.size(), partitioned.partitions(), errors);
+    return errors;
+}
+
+void hash_aggregator_test()
+{
+    static const std::size_t kRows = 200000;
+    static const std::uint32_t kCardinal = 5000;
+
+    std::size_t errors = 0;
+
+    printf("hash_aggregator_test()\n\n");
+
+    jstd::MtRandomGen mtRandomGen(20200831);
+    std::vector<std::uint32_t> keys(kRows), values(kRows);
+    for (std::size_t i = 0; i < kRows; i++) {
+        keys[i] = mtRandomGen.nextUInt32() % kCardinal;
+        values[i] = mtRandomGen.nextUInt32() % 1000000;
+    }
+
+    // upsert() inserts the init value once, then combines into it.
+    {
+        jstd::Dictionary<std::uint32_t, std::uint32_t> dict;
+        auto plus = [](std::uint32_t & value, const std::uint32_t & init) { value += init; };
+        bool inserted1 = dict.upsert(7, 5, plus).second;
+        bool inserted2 = dict.upsert(7, 6, plus).second;
+        if (!inserted1 || inserted2 || dict.size() != 1 || dict[7] != 11) {
+            printf("Dictionary::upsert() error: size = %" PRIuPTR ", value = %u\n",
+                   dict.size(), dict[7]);
+            errors++;
+        }
+    }
+
+    errors += hash_aggregator_check<jstd::CountAggregator<std::uint32_t>>("count", keys, values);
+    errors += hash_aggregator_check<jstd::SumAggregator<std::uint32_t, std::uint64_t>>("sum", keys, values);
+    errors += hash_aggregator_check<jstd::MinAggregator<std::uint32_t>>("min", keys, values);
+    errors += hash_aggregator_check<jstd::MaxAggregator<std::uint32_t>>("max", keys, values);
+
+    printf("\n");
+    printf("hash aggregator errors: %" PRIuPTR "\n", errors);
+    printf("\n");
+    printf("result: %s\n\n", (errors == 0) ? "Passed" : "Failed");
+}
+
+void cpu_frequency_test()
+{
+    std::size_t errors = 0;
+
+    printf("cpu_frequency_test()\n\n");
+
+    jtest::CPU::WarmUpResult warm_up = jtest::CPU::warm_up_adaptive(1.0, 20.0, 500.0);
+    if (warm_up.samples == 0 || warm_up.frequency <= 0.0 || warm_up.elapsed_time > 1000.0) {
+        printf("warm_up_adaptive() error: samples = %" PRIuPTR ", frequency = %0.0f MHz, time = %0.3f ms\n",
+               warm_up.samples, warm_up.frequency, warm_up.elapsed_time);
+        errors++;
+    }
+
+    jtest::CPU::FrequencyRange range;
+    range.add(3000.0);
+    range.add(2900.0);
+    range.add(2950.0);
+    if (range.samples != 3 || range.min != 2900.0 || range.max != 3000.0 ||
+        ::fabs(range.drift() - 100.0 / 30.0) > 1.0e-9) {
+        printf("FrequencyRange error: min = %0.0f, max = %0.0f, drift = %0.4f%%\n",
+               range.min, range.max, range.drift());
+        errors++;
+    }
+
+    // The frequency is sampled around the measured runs, a drifting case is rerun,
+    // and it's flagged as throttled after max_reruns.
+    jtest::BenchmarkRunner runner;
+    runner.options().repetitions = 3;
+    runner.options().min_time = 5.0;
+    runner.options().max_drift = 1.0e-6;
+    runner.options().max_reruns = 1;
+    const jtest::BenchmarkStats * stats =
+        runner.run("cpu_frequency_test/sum", [](jtest::BenchmarkState & state) {
+            std::size_t sum = 0;
+            while (state.keep_running()) {
+                for (std::size_t i = 0; i < 1000; i++) {
+                    sum += i;
+                    jtest::DoNotOptimize(sum);
+                }
+            }
+            state.set_items_per_iteration(1000);
+        });
+    if (stats == nullptr || stats->frequency_max <= 0.0 ||
+        stats->frequency_min > stats->frequency_max || stats->reruns > 1 ||
+        (stats->throttled && stats->reruns != 1) || stats->repetitions() != 3) {
+        printf("BenchmarkRunner error: the frequency drift of the case is not recorded\n");
+        errors++;
+    }
+
+    printf("cpu frequency errors: %" PRIuPTR "\n", errors);
+    printf("\n");
+    printf("result: %s\n\n", (errors == 0) ? "Passed" : "Failed");
+}
+
+void line_splitter_benchmark()
+{
+#ifdef NDEBUG
+    static const std::size_t kTextSize = 64 * 1024 * 1024;
+    static const std::size_t kRepeat = 5;
+#else
+    static const std::size_t kTextSize = 1024 * 1024;
+    static const std::size_t kRepeat = 1;
+#endif
+
+    printf("==========================================================================\n\n");
+    printf("  line_splitter_benchmark()\n\n");
+
+    // Repeat the key file to a big text, or the random keys if it's not found.
+    std::string path;
+    const char * filename = find_data_file("data/Maven.keys.txt", path);
+    std::vector<char> keys;
+    if ((filename == nullptr) || !jstd::read_file(filename, keys) || keys.empty()) {
+        jstd::MtRandomGen64 mtRandomGen64(20200831);
+        filename = "(random keys)";
+        keys.clear();
+        while (keys.size() < 1024 * 1024) {
+            std::size_t length = 8 + jstd::MtRandomGen64::nextUInt32() % 64;
+            for (std::size_t i = 0; i < length; i++) {
+                std::uint32_t r = jstd::MtRandomGen64::nextUInt32() % 16;
+                keys.push_back((r == 0) ? '/' : static_cast<char>('a' + r));
+            }
+            keys.push_back('\n');
+        }
+    }
+    std::string text;
+    text.reserve(kTextSize + keys.size());
+    while (text.size() < kTextSize) {
+        text.append(keys.data(), keys.size());
+    }
+
+    jtest::StopWatch sw;
+    static const std::size_t kNumTests = 7;
+    const char * names[kNumTests] = {
+        "lines: std::getline(std::istringstream)",
+        "lines: memchr()",
+        "lines: jstd::line_splitter",
+        "lines: jstd::line_splitter::count_lines()",
+        "fields '/': byte loop",
+        "fields '/': jstd::line_splitter",
+        "fields '/': jstd::line_splitter::next_record()"
+    };
+    double elapsed_time[kNumTests];
+    std::size_t checksums[kNumTests];
+
+    for (std::size_t test = 0; test < kNumTests; test++) {
+        std::size_t checksum = 0;
+        sw.start();
+        for (std::size_t r = 0; r < kRepeat; r++) {
+            const char * data = text.data();
+            std::size_t size = text.size();
+            switch (test) {
+            case 0: {
+                std::istringstream stream(text);
+                std::string line;
+                while (std::getline(stream, line)) {
+                    checksum += line.size();
+                }
+                break;
+            }
+            case 1: {
+                const char * end = data + size;
+                while (data < end) {
+                    const char * eol = static_cast<const char *>(std::memchr(data, '\n', std::size_t(end - data)));
+                    if (eol == nullptr)
+                        eol = end;
+                    checksum += std::size_t(eol - data);
+                    data = eol + 1;
+                }
+                break;
+            }
+            case 2: {
+                jstd::line_splitter splitter(data, size);
+                jstd::string_view line;
+                while (splitter.next_line(line)) {
+                    checksum += line.size();
+                }
+                break;
+            }
+            case 3: {
+                checksum += jstd::line_splitter::count_lines(data, size);
+                break;
+            }
+            case 4: {
+                std::size_t first = 0;
+                for (std::size_t i = 0; i < size; i++) {
+                    char ch = data[i];
+                    if ((ch == '/') || (ch == '\n')) {
+                        checksum += i - first + 1;
+                        first = i + 1;
+                    }
+                }
+                if (first < size)
+                    checksum += size - first + 1;
+                break;
+            }
+            case 5: {
+                jstd::line_splitter splitter(data, size, '/');
+                jstd::string_view field;
+                bool is_line_end;
+                while (splitter.next_field(field, is_line_end)) {
+                    checksum += field.size() + 1;
+                }
+                break;
+            }
+            case 6: {
+                jstd::line_splitter splitter(data, size, '/');
+                jstd::string_view fields[16];
+                std::size_t count;
+                while ((count = splitter.next_record(fields, 16)) != 0) {
+                    for (std::size_t i = 0; i < count; i++) {
+                        checksum += fields[i].size() + 1;
+                    }
+                }
+                break;
+            }
+            default:
+                break;
+            }
+        }
+        sw.stop();
+        elapsed_time[test] = sw.getElapsedMillisec();
+        checksums[test] = checksum;
+    }
+
+    double total_mb = (double)text.size() * kRepeat / (1024.0 * 1024.0);
+    printf("  Text: %s x %" PRIuPTR " = %" PRIuPTR " bytes\n\n",
+           filename, (text.size() / keys.size()), text.size());
+    printf("  %-48s %10s %10s\n", "Split", "time (ms)", "MB/s");
+    printf("  --------------------------------------------------------------------\n");
+    for (std::size_t test = 0; test < kNumTests; test++) {
+        bool is_ok = (test == 3) ||
+                     (checksums[test] == checksums[(test < 4) ? 0 : 4]);
+        printf("  %-48s %10.3f %10.1f%s\n", names[test], elapsed_time[test],
+               (elapsed_time[test] > 0.0) ? (total_mb / (elapsed_time[test] / 1000.0)) : 0.0,
+               is_ok ? "" : "  (checksum error)");
+    }
+    printf("\n");
+}
+
+//
+// The random text of the words, the code points are drawn from the scripts:
+// ASCII, Latin (ASCII with some accents), Cyrillic, CJK and the mixed with emoji.
+//
+enum UtfScript {
+    kScriptAscii,
+    kScriptLatin,
+    kScriptCyrillic,
+    kScriptCJK,
+    kScriptMixed,
+    kScriptLast
+};
+
+static const char * utf_script_name(int script)
+{
+    static const char * names[kScriptLast] = {
+        "ASCII", "Latin", "Cyrillic", "CJK", "Mixed + emoji"
+    };
+    return names[script];
+}
+
+static char32_t utf_random_char(int script)
+{
+    std::uint32_t r = jstd::MtRandomGen64::nextUInt32();
+    std::uint32_t percent = r % 100;
+    switch (script) {
+    case kScriptAscii:
+        return char32_t('a' + (r >> 8) % 26);
+    case kScriptLatin:
+        return (percent < 92) ? char32_t('a' + (r >> 8) % 26) : char32_t(0xC0 + (r >> 8) % 0x40);
+    case kScriptCyrillic:
+        return char32_t(0x0410 + (r >> 8) % 0x40);
+    case kScriptCJK:
+        return char32_t(0x4E00 + (r >> 8) % 0x5000);
+    default:
+        if (percent < 40)
+            return char32_t('a' + (r >> 8) % 26);
+        else if (percent < 60)
+            return char32_t(0x03B1 + (r >> 8) % 24);
+        else if (percent < 90)
+            return char32_t(0x3041 + (r >> 8) % 0x56);
+        else
+            return char32_t(0x1F600 + (r >> 8) % 0x50);
+    }
+}
+
+static void utf_random_text(int script, std::size_t count, std::u32string & text)
+{
+    text.clear();
+    for (std::size_t i = 0; i < count; i++) {
+        if ((script != kScriptCJK) && ((jstd::MtRandomGen64::nextUInt32() % 7) == 0))
+            text.push_back(U' ');
+        else
+            text.push_back(utf_random_char(script));
+    }
+}
+
+static void utf32_to_utf8_ref(const std::u32string & text, std::string & utf8)
+{
+    utf8.clear();
+    for (std::size_t i = 0; i < text.size(); i++) {
+        char buf[4];
+        char * end = jstd::utf::detail::encode_utf8_char(buf, text[i]);
+        utf8.append(buf, end);
     }
+}
 
-    {
-        sw.restart();
-        for (i = 0; i < iters; ++i) {
-            std::string str;
-            fmt_len = format::snprintf(str,
-                                 "%d, %d, %d, %d, %d,\n"
-                                 "%d, %d, %d, %d, %d.",
-                                  12,  1234,  123456,  12345678,  123456789,
-                                 -12, -1234, -123456, -12345678, -123456789);
+static void utf32_to_utf16_ref(const std::u32string & text, std::u16string & utf16)
+{
+    utf16.clear();
+    for (std::size_t i = 0; i < text.size(); i++) {
+        char32_t cp = text[i];
+        if (cp >= 0x10000) {
+            utf16.push_back(char16_t(0xD800 + ((cp - 0x10000) >> 10)));
+            utf16.push_back(char16_t(0xDC00 + ((cp - 0x10000) & 0x3FF)));
         }
-        sw.stop();
-        time = sw.getElapsedMillisec();
+        else {
+            utf16.push_back(char16_t(cp));
+        }
+    }
+}
 
-        fmt_len = format::snprintf(str1,
-                                "%d, %d, %d, %d, %d,\n"
-                                "%d, %d, %d, %d, %d.",
-                                12,  1234,  123456,  12345678,  123456789,
-                                -12, -1234, -123456, -12345678, -123456789);
+void utf_convert_test()
+{
+#ifdef NDEBUG
+    static const std::size_t kTestCount = 20000;
+#else
+    static const std::size_t kTestCount = 1000;
+#endif
 
-        printf("==========================================================================\n\n");
-        printf(">>> %-20s <<<\n\n", "format::snprintf() *");
-        printf("result = \n%s\n\n", str1.c_str());
-        printf("strlen       = %" PRIuPTR " bytes\n", str1.size());
+    jstd::MtRandomGen64 mtRandomGen64(20200831);
+
+    std::size_t errors = 0;
+
+    for (std::size_t i = 0; i < kTestCount; i++) {
+        std::size_t count = jstd::MtRandomGen64::nextUInt32() % (((i % 4) == 0) ? 24 : 300);
+        std::u32string text;
+        std::u16string utf16;
+        std::string utf8;
+        utf_random_text(static_cast<int>(i % kScriptLast), count, text);
+        utf32_to_utf8_ref(text, utf8);
+        utf32_to_utf16_ref(text, utf16);
+
+        // The round trips, the outputs are in the exact size strings.
+        std::u16string out16;
+        std::u32string out32;
+        std::string out8_16, out8_32;
+        bool is_ok = jstd::utf::validate_utf8(jstd::string_view(utf8)) &&
+                     jstd::utf::utf8_to_utf16(jstd::string_view(utf8), out16) && (out16 == utf16) &&
+                     jstd::utf::utf8_to_utf32(jstd::string_view(utf8), out32) && (out32 == text) &&
+                     jstd::utf::utf16_to_utf8(jstd::utf::u16string_view(utf16), out8_16) && (out8_16 == utf8) &&
+                     jstd::utf::utf32_to_utf8(jstd::utf::u32string_view(text), out8_32) && (out8_32 == utf8);
+
+        // The broken UTF-8, the error position is the same as the scalar validation.
+        if (!utf8.empty()) {
+            std::vector<char> broken(utf8.begin(), utf8.end());
+            std::size_t index = jstd::MtRandomGen64::nextUInt32() % broken.size();
+            broken[index] = static_cast<char>(0x80 | (jstd::MtRandomGen64::nextUInt32() % 0x80));
+            if ((i % 2) == 0) {
+                broken.resize(jstd::MtRandomGen64::nextUInt32() % broken.size());
+            }
 
-        printf("elapsed time = %0.3f ms\n\n", time);
-        printf("format::snprintf() * vs snprintf(): %0.3f x times.\n", time_base / time);
-        printf("\n");
-    }
+            jstd::utf::result expected = jstd::utf::detail::validate_utf8_scalar(
+                reinterpret_cast<const std::uint8_t *>(broken.data()), broken.size(), 0);
+            jstd::utf::result res = jstd::utf::validate_utf8_with_errors(broken.data(), broken.size());
+            is_ok = is_ok && (res.error == expected.error) && (res.count == expected.count);
 
-    {
-        std::string str;
-  
-        sw.restart();
-        for (i = 0; i < iters; ++i) {
-            str.clear();
-            fmt_len = format::snprintf(str,
-                                 "%d, %d, %d, %d, %d,\n"
-                                 "%d, %d, %d, %d, %d.",
-                                  12,  1234,  123456,  12345678,  123456789,
-                                 -12, -1234, -123456, -12345678, -123456789);
+            std::vector<char16_t> out(jstd::utf::utf16_length_from_utf8(broken.data(), broken.size()) + 1);
+            res = jstd::utf::convert_utf8_to_utf16(broken.data(), broken.size(), out.data());
+            is_ok = is_ok && (res.error == expected.error) &&
+                    ((expected.error == jstd::utf::error_code::ok) || (res.count == expected.count));
         }
-        sw.stop();
-        time = sw.getElapsedMillisec();
 
-        printf("==========================================================================\n\n");
-        printf(">>> %-20s <<<\n\n", "format::snprintf()");
-        printf("result = \n%s\n\n", str.c_str());
-        printf("strlen       = %" PRIuPTR " bytes\n", str.size());
+        if (!is_ok) {
+            if (errors < 10) {
+                printf("utf_convert error: script = %s, length = %" PRIuPTR "\n",
+                       utf_script_name(static_cast<int>(i % kScriptLast)), utf8.size());
+            }
+            errors++;
+        }
+    }
 
-        printf("elapsed time = %0.3f ms\n\n", time);
-        printf("format::snprintf() vs snprintf(): %0.3f x times.\n", time_base / time);
-        printf("\n");
+    std::wstring wstr;
+    std::string str;
+    const char * hello = "Hello, \xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82, "
+                         "\xE4\xBD\xA0\xE5\xA5\xBD \xF0\x9F\x98\x80";
+    if (!jstd::utf::utf8_to_wstring(jstd::string_view(hello), wstr) ||
+        !jstd::utf::wstring_to_utf8(jstd::wstring_view(wstr), str) || (str != hello)) {
+        printf("utf_convert error: utf8_to_wstring() / wstring_to_utf8()\n");
+        errors++;
     }
 
-    JSTD_UNUSED_VAR(fmt_len);
-    printf("==========================================================================\n");
     printf("\n");
+    printf("utf_convert_test(): count = %" PRIuPTR "\n\n", kTestCount);
+    printf("utf_convert errors: %" PRIuPTR "\n", errors);
+    printf("\n");
+    printf("result: %s\n\n", (errors == 0) ? "Passed" : "Failed");
 }
 
-void formatter_benchmark()
+void utf_convert_benchmark()
 {
-    formatter_benchmark_sprintf_Integer_1();
-}
+#ifdef NDEBUG
+    static const std::size_t kCodePoints = 4 * 1024 * 1024;
+    static const std::size_t kRepeat = 5;
+#else
+    static const std::size_t kCodePoints = 64 * 1024;
+    static const std::size_t kRepeat = 1;
+#endif
 
-void string_view_test()
-{
-    jstd::string_view sv1(header_fields[4]);
-    try {
-        //sv1[2] = 'a';  // Run-time error, readonly
-    } catch (...) {
-        std::cout << "jstd::string_view<CharT> operator [] read only" << std::endl;
-    }
+    printf("==========================================================================\n\n");
+    printf("  utf_convert_benchmark()\n\n");
 
-    std::string str1("12345676890");
+    jstd::MtRandomGen64 mtRandomGen64(20200831);
 
-    printf("str1 = %s\n", str1.c_str());
-    std::cout << "sv1  = " << sv1 << "\n\n";
+#if defined(_WIN32)
+    typedef std::codecvt_utf8_utf16<wchar_t>  wchar_codecvt;
+#else
+    typedef std::codecvt_utf8<wchar_t>        wchar_codecvt;
+#endif
 
-    jstd::string_view sv2("abcdefg");
-    std::size_t n2 = sv2.copy((char *)str1.data(), 4, 0);
+    static const std::size_t kNumTests = 8;
+    const char * names[kNumTests] = {
+        "validate: scalar",
+        "validate: jstd::utf",
+        "utf8 => utf16: scalar",
+        "utf8 => utf16: jstd::utf",
+        "utf16 => utf8: jstd::utf",
+        "utf8 => wchar_t: std::wstring_convert",
+        "utf8 => wchar_t: jstd::utf",
+        "wchar_t => utf8: std::wstring_convert"
+    };
+
+    printf("  MB/s of UTF-8 bytes\n\n");
+    printf("  %-40s", "");
+    for (int script = 0; script < kScriptLast; script++) {
+        printf(" %14s", utf_script_name(script));
+    }
+    printf("\n");
+    printf("  ------------------------------------------------------------------------------------------------------------\n");
 
-    printf("str1 = %s\n", str1.c_str());
-    std::cout << "sv2  = " << sv2 << "\n\n";
+    double mb_per_sec[kNumTests][kScriptLast];
+    std::size_t checksum = 0;
 
-    jstd::string_view sv3(str1);
-    sv3[2] = 'q';
+    for (int script = 0; script < kScriptLast; script++) {
+        std::u32string text;
+        std::u16string utf16;
+        std::string utf8;
+        utf_random_text(script, kCodePoints, text);
+        utf32_to_utf8_ref(text, utf8);
+        utf32_to_utf16_ref(text, utf16);
+        std::wstring wtext;
+        jstd::utf::utf8_to_wstring(jstd::string_view(utf8), wtext);
 
-    printf("str1 = %s\n", str1.c_str());
-    std::cout << "sv3  = " << sv3 << "\n\n";
+        std::vector<char16_t> out16(utf16.size());
+        std::vector<char> out8(utf8.size());
+        const std::uint8_t * bytes = reinterpret_cast<const std::uint8_t *>(utf8.data());
 
-    using std::swap;
-    std::swap(sv2, sv3);
-    std::cout << "sv2  = " << sv2 << '\n';
-    std::cout << "sv3  = " << sv3 << "\n\n";
+        jtest::StopWatch sw;
+        for (std::size_t test = 0; test < kNumTests; test++) {
+            sw.start();
+            for (std::size_t r = 0; r < kRepeat; r++) {
+                switch (test) {
+                case 0:
+                    checksum += jstd::utf::detail::validate_utf8_scalar(bytes, utf8.size(), 0).count;
+                    break;
+                case 1:
+                    checksum += jstd::utf::validate_utf8_with_errors(utf8.data(), utf8.size()).count;
+                    break;
+                case 2:
+                    checksum += jstd::utf::detail::convert_utf8_scalar(bytes, utf8.size(), 0,
+                                                                       out16.data(), out16.data()).count;
+                    break;
+                case 3:
+                    checksum += jstd::utf::convert_utf8_to_utf16(utf8.data(), utf8.size(), out16.data()).count;
+                    break;
+                case 4:
+                    checksum += jstd::utf::convert_utf16_to_utf8(utf16.data(), utf16.size(), out8.data()).count;
+                    break;
+                case 5: {
+                    std::wstring_convert<wchar_codecvt> converter;
+                    checksum += converter.from_bytes(utf8).size();
+                    break;
+                }
+                case 6: {
+                    std::wstring wstr;
+                    jstd::utf::utf8_to_wstring(jstd::string_view(utf8), wstr);
+                    checksum += wstr.size();
+                    break;
+                }
+                case 7: {
+                    std::wstring_convert<wchar_codecvt> converter;
+                    checksum += converter.to_bytes(wtext).size();
+                    break;
+                }
+                default:
+                    break;
+                }
+            }
+            sw.stop();
+            double elapsed_time = sw.getElapsedMillisec();
+            mb_per_sec[test][script] = (elapsed_time > 0.0) ?
+                ((double)utf8.size() * kRepeat / (1024.0 * 1024.0) / (elapsed_time / 1000.0)) : 0.0;
+        }
+    }
 
-    jstd::Console::ReadKey();
+    for (std::size_t test = 0; test < kNumTests; test++) {
+        printf("  %-40s", names[test]);
+        for (int script = 0; script < kScriptLast; script++) {
+            printf(" %14.1f", mb_per_sec[test][script]);
+        }
+        printf("\n");
+    }
+    printf("\n");
+    printf("  checksum = %" PRIuPTR "\n\n", checksum);
 }
 
 void shiftable_ptr_test()
@@ -2098,6 +4633,568 @@ void formatter_test()
     printf("\n");
 }
 
+template <typename ...Args>
+std::size_t format_to_check(const char * format, Args && ... args)
+{
+    static const std::size_t kBufSize = 256;
+    static const std::size_t kGuardSize = 16;
+
+    char ref[kBufSize];
+    int ref_len = snprintf(ref, sizeof(ref), format, args...);
+    std::size_t ref_size = static_cast<std::size_t>(ref_len);
+    std::size_t errors = 0;
+
+    jstd::formatter fmt;
+
+    std::size_t fmt_size = fmt.formatted_size(format, args...);
+    if (fmt_size != ref_size) {
+        printf("formatted_size() error: format = \"%s\", size = %" PRIuPTR ", expect: %d\n",
+               format, fmt_size, ref_len);
+        errors++;
+    }
+
+    // The output iterator, no limit.
+    std::string str;
+    jstd::format_to_result<std::back_insert_iterator<std::string>> str_result =
+        fmt.format_to(std::back_inserter(str), format, args...);
+    if ((str != std::string(ref, ref_size)) || (str_result.size != ref_size) || str_result.truncated) {
+        printf("format_to(back_inserter) error: \"%s\", expect: \"%s\"\n", str.c_str(), ref);
+        errors++;
+    }
+
+    // The output iterator with a limit.
+    std::size_t limit = ref_size / 2;
+    std::vector<char> vec;
+    jstd::format_to_result<std::back_insert_iterator<std::vector<char>>> vec_result =
+        fmt.format_to(std::back_inserter(vec), limit, format, args...);
+    if ((vec.size() != limit) || (std::memcmp(vec.data(), ref, limit) != 0) ||
+        (vec_result.size != ref_size) || (vec_result.truncated != (ref_size > limit))) {
+        printf("format_to(back_inserter, %" PRIuPTR ") error: \"%.*s\", expect: \"%.*s\"\n",
+               limit, int(vec.size()), vec.data(), int(limit), ref);
+        errors++;
+    }
+
+    // The fixed buffer, never write past the capacity.
+    for (std::size_t capacity = 0; capacity <= ref_size + 1; capacity++) {
+        char buf[kBufSize + kGuardSize];
+        std::memset(buf, '#', sizeof(buf));
+        jstd::format_to_result<char *> result = fmt.format_to(buf, capacity, format, args...);
+        std::size_t written = (capacity < ref_size) ? capacity : ref_size;
+        bool guard_ok = true;
+        for (std::size_t i = capacity; i < sizeof(buf); i++) {
+            if (buf[i] != '#') {
+                guard_ok = false;
+                break;
+            }
+        }
+        if ((result.size != ref_size) || (result.truncated != (ref_size > capacity)) ||
+            (result.out != buf + written) || (std::memcmp(buf, ref, written) != 0) || !guard_ok) {
+            printf("format_to(buf, %" PRIuPTR ") error: \"%.*s\", expect: \"%.*s\", "
+                   "size = %" PRIuPTR ", truncated = %d, guard = %d\n",
+                   capacity, int(written), buf, int(written), ref,
+                   result.size, int(result.truncated), int(guard_ok));
+            errors++;
+            break;
+        }
+    }
+
+    return errors;
+}
+
+void format_to_test()
+{
+    std::size_t errors = 0;
+
+    errors += format_to_check("num1 = %d, num2 = %d", 100, 220);
+    errors += format_to_check("%d, %u, %d, %u", INT32_MIN, UINT32_MAX, -1, 0u);
+    errors += format_to_check("no argument, 100%% literal");
+    errors += format_to_check("%%%d%% and %u%% tail", 25, 75u);
+    errors += format_to_check("x = %.2f%%, y = %f, z = %.0f", 2.5, -1.0 / 3.0, 12345.678);
+    errors += format_to_check("w = %.3e, v = %.10f", 6.02214076e23, 1e-7);
+    errors += format_to_check("%d", 123456789);
+
+    printf("format_to_test(): errors = %" PRIuPTR "\n\n", errors);
+    printf("result: %s\n\n", (errors == 0) ? "Passed" : "Failed");
+}
+
+template <typename ...Args>
+std::size_t precompiled_format_check(const jstd::precompiled_format & pfmt, Args && ... args)
+{
+    char ref[256];
+    int ref_len = snprintf(ref, sizeof(ref), pfmt.format(), args...);
+
+    // The output is appended to str.
+    static const char kPrefix[] = "prefix:";
+    jstd::formatter fmt;
+    std::string str(kPrefix);
+    std::size_t out_len = fmt.sprintf(str, pfmt, args...);
+    std::size_t fmt_size = fmt.formatted_size(pfmt, args...);
+
+    std::string expect(kPrefix);
+    expect.append(ref, static_cast<std::size_t>(ref_len));
+    if ((str != expect) || (out_len != std::size_t(ref_len)) || (fmt_size != std::size_t(ref_len))) {
+        printf("precompiled_format error: format = \"%s\"\n"
+               "    output: \"%s\", length = %" PRIuPTR ", formatted_size = %" PRIuPTR "\n"
+               "    expect: \"%s\", length = %d\n",
+               pfmt.format(), str.c_str(), out_len, fmt_size, expect.c_str(), ref_len);
+        return 1;
+    }
+    return 0;
+}
+
+void precompiled_format_test()
+{
+    std::size_t errors = 0;
+
+    static const jstd::precompiled_format s_fmt_ints(
+                "num1 = %d, num2 = %d\n"
+                "num3 = %u, num4 = %d\n"
+                "num4 = %u, num5 = %d\n"
+                "num7 = %u, num8 = %d\n\n");
+    errors += precompiled_format_check(s_fmt_ints, 100, 220, 500u, 1024, 2048u, 4096, 16384u, 65536);
+    errors += precompiled_format_check(s_fmt_ints, 0, -1, 0u, INT32_MIN, UINT32_MAX, INT32_MAX, 9u, -10);
+
+    static const jstd::precompiled_format s_fmt_literal("no argument, 100%% literal");
+    errors += precompiled_format_check(s_fmt_literal);
+
+    static const jstd::precompiled_format s_fmt_percent("%%%d%% and %u%%");
+    errors += precompiled_format_check(s_fmt_percent, 25, 75u);
+    errors += precompiled_format_check(s_fmt_percent, -99999, 0u);
+
+    static const jstd::precompiled_format s_fmt_float("x = %.2f%%, y = %f, z = %.0f, w = %.3e");
+    errors += precompiled_format_check(s_fmt_float, 2.5, -1.0 / 3.0, 12345.678, 6.02214076e23);
+    errors += precompiled_format_check(s_fmt_float, 0.0, 1e-7, 0.5, -1.5e-300);
+
+    static const jstd::precompiled_format s_fmt_first("%d");
+    errors += precompiled_format_check(s_fmt_first, 123456789);
+
+    printf("precompiled_format_test(): errors = %" PRIuPTR "\n\n", errors);
+    printf("result: %s\n\n", (errors == 0) ? "Passed" : "Failed");
+}
+
+//
+// The three sprintf() output passes must be the same as snprintf(),
+// and the same as the size pass (formatted_size()).
+//
+template <typename ...Args>
+std::size_t sprintf_float_check(const char * format, Args && ... args)
+{
+    char ref[256];
+    int ref_len = snprintf(ref, sizeof(ref), format, args...);
+    std::size_t ref_size = static_cast<std::size_t>(ref_len);
+
+    jstd::formatter fmt;
+    std::string str1, str2, str3;
+    std::size_t len1 = fmt.sprintf(str1, format, args...);
+    std::size_t len2 = fmt.sprintf_direct(str2, format, args...);
+    std::size_t len3 = fmt.sprintf_no_prepare(str3, format, args...);
+    std::size_t fmt_size = fmt.formatted_size(format, args...);
+
+    bool is_ok = (str1 == ref) && (str2 == ref) && (str3 == ref) &&
+                 (len1 == ref_size) && (len2 == ref_size) && (len3 == ref_size) &&
+                 (fmt_size == ref_size);
+    if (!is_ok) {
+        printf("fmt.sprintf() error: format = \"%s\", formatted_size = %" PRIuPTR "\n"
+               "    sprintf(): \"%s\", sprintf_direct(): \"%s\", sprintf_no_prepare(): \"%s\"\n"
+               "    expect: \"%s\"\n",
+               format, fmt_size, str1.c_str(), str2.c_str(), str3.c_str(), ref);
+    }
+    assert(is_ok);
+    return (is_ok ? 0 : 1);
+}
+
+void dtoa_test()
+{
+#ifdef NDEBUG
+    static const std::size_t kTestCount = 2000000;
+#else
+    static const std::size_t kTestCount = 20000;
+#endif
+
+    jstd::MtRandomGen64 mtRandomGen64(20200831);
+
+    char buf[jstd::kMaxDtoaFixedSize + 1];
+    char ref[jstd::kMaxDtoaFixedSize + 1];
+    std::size_t double_errors = 0, float_errors = 0, fixed_errors = 0;
+
+    // The random bit patterns must round-trip.
+    for (std::size_t i = 0; i < kTestCount; i++) {
+        std::uint64_t bits = jstd::MtRandomGen64::nextUInt64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        if (std::isnan(value))
+            continue;
+        std::size_t len = jstd::dtoa(value, buf);
+        buf[len] = '\0';
+        double result = std::strtod(buf, nullptr);
+        if (std::memcmp(&result, &value, sizeof(value)) != 0) {
+            if (double_errors < 10)
+                printf("dtoa() error: \"%s\", expect: %.17g\n", buf, value);
+            double_errors++;
+        }
+    }
+
+    for (std::size_t i = 0; i < kTestCount; i++) {
+        std::uint32_t bits = jstd::MtRandomGen64::nextUInt32();
+        float value;
+        std::memcpy(&value, &bits, sizeof(value));
+        if (std::isnan(value))
+            continue;
+        std::size_t len = jstd::ftoa(value, buf);
+        buf[len] = '\0';
+        float result = std::strtof(buf, nullptr);
+        if (std::memcmp(&result, &value, sizeof(value)) != 0) {
+            if (float_errors < 10)
+                printf("ftoa() error: \"%s\", expect: %.9g\n", buf, value);
+            float_errors++;
+        }
+    }
+
+    // The fixed precision must be the same as printf("%.*f").
+    for (std::size_t i = 0; i < kTestCount; i++) {
+        std::uint64_t bits = jstd::MtRandomGen64::nextUInt64();
+        double value;
+        if ((i & 1) == 0) {
+            std::memcpy(&value, &bits, sizeof(value));
+        }
+        else {
+            value = static_cast<double>(static_cast<std::int64_t>(bits)) /
+                    static_cast<double>(std::uint64_t(1) << (bits % 64));
+        }
+        int precision = static_cast<int>(i % 20);
+        std::size_t len = jstd::dtoa_fixed(value, precision, buf);
+        buf[len] = '\0';
+        snprintf(ref, sizeof(ref), "%.*f", precision, value);
+        if (std::strcmp(buf, ref) != 0) {
+            if (fixed_errors < 10)
+                printf("dtoa_fixed() error: \"%s\", expect: \"%s\"\n", buf, ref);
+            fixed_errors++;
+        }
+    }
+
+    // The "%.Nf%%" and the literal after "%%".
+    std::size_t sprintf_errors = 0;
+    sprintf_errors += sprintf_float_check("x=%.2f%%", 2.5);
+    sprintf_errors += sprintf_float_check("x=%.2f%% y", 2.5);
+    sprintf_errors += sprintf_float_check("x=%d%% y", 25);
+    sprintf_errors += sprintf_float_check("%%%.1f%% and %.0f%%%% tail", 99.95, 0.5);
+    sprintf_errors += sprintf_float_check("%.3f%% tail %d, %f", -1.0 / 3.0, 7, 1e-7);
+    sprintf_errors += sprintf_float_check("%.10e%%, %g%%, %f%%", 6.02214076e23, 0.1, 12345.678);
+
+    std::string str;
+    jstd::formatter fmt;
+    fmt.sprintf(str, "pi = %g, e = %.3f, f = %g", 3.141592653589793, 2.718281828459045, 0.1f);
+
+    printf("\n");
+    printf("dtoa_test(): count = %" PRIuPTR "\n\n", kTestCount);
+    printf("dtoa()       round-trip errors: %" PRIuPTR "\n", double_errors);
+    printf("ftoa()       round-trip errors: %" PRIuPTR "\n", float_errors);
+    printf("dtoa_fixed() printf diff errors: %" PRIuPTR "\n", fixed_errors);
+    printf("fmt.sprintf() snprintf diff errors: %" PRIuPTR "\n", sprintf_errors);
+    printf("fmt.sprintf() = \"%s\"\n", str.c_str());
+    printf("\n");
+    printf("result: %s\n\n",
+           ((double_errors + float_errors + fixed_errors + sprintf_errors) == 0) ? "Passed" : "Failed");
+}
+
+void itoa_simd_test()
+{
+#ifdef NDEBUG
+    static const std::size_t kTestCount = 2000000;
+#else
+    static const std::size_t kTestCount = 20000;
+#endif
+
+    jstd::MtRandomGen64 mtRandomGen64(20200831);
+
+    char buf[64];
+    std::string ref;
+    std::size_t errors = 0;
+
+    // The boundaries of all the lengths, and the random values.
+    std::vector<uint64_t> values;
+    uint64_t pow10 = 1;
+    for (std::size_t n = 0; n < 20; n++) {
+        for (uint64_t delta = 0; delta < 3; delta++) {
+            values.push_back(pow10 - delta);
+            values.push_back(pow10 + delta);
+        }
+        pow10 *= 10;
+    }
+    values.push_back(UINT32_MAX);
+    values.push_back(UINT64_MAX);
+    values.push_back(static_cast<uint64_t>(INT64_MIN));
+    for (std::size_t i = 0; i < kTestCount; i++) {
+        uint64_t value = jstd::MtRandomGen64::nextUInt64();
+        values.push_back(value >> (value % 64));
+    }
+
+    for (std::size_t i = 0; i < values.size(); i++) {
+        uint64_t value = values[i];
+        std::size_t len;
+
+        ref.clear();
+        jstd::itoa(ref, static_cast<uint32_t>(value));
+        len = jstd::u32toa_simd(static_cast<uint32_t>(value), buf);
+        if (ref.size() != len || std::memcmp(ref.c_str(), buf, len) != 0) {
+            if (errors < 10)
+                printf("u32toa_simd() error: \"%.*s\", expect: \"%s\"\n", (int)len, buf, ref.c_str());
+            errors++;
+        }
+
+        ref.clear();
+        jstd::itoa(ref, static_cast<int32_t>(value));
+        len = jstd::i32toa_simd(static_cast<int32_t>(value), buf);
+        if (ref.size() != len || std::memcmp(ref.c_str(), buf, len) != 0) {
+            if (errors < 10)
+                printf("i32toa_simd() error: \"%.*s\", expect: \"%s\"\n", (int)len, buf, ref.c_str());
+            errors++;
+        }
+
+        ref.clear();
+        jstd::itoa(ref, value);
+        len = jstd::u64toa_simd(value, buf);
+        if (ref.size() != len || std::memcmp(ref.c_str(), buf, len) != 0) {
+            if (errors < 10)
+                printf("u64toa_simd() error: \"%.*s\", expect: \"%s\"\n", (int)len, buf, ref.c_str());
+            errors++;
+        }
+
+        ref.clear();
+        jstd::itoa(ref, static_cast<int64_t>(value));
+        len = jstd::i64toa_simd(static_cast<int64_t>(value), buf);
+        if (ref.size() != len || std::memcmp(ref.c_str(), buf, len) != 0) {
+            if (errors < 10)
+                printf("i64toa_simd() error: \"%.*s\", expect: \"%s\"\n", (int)len, buf, ref.c_str());
+            errors++;
+        }
+    }
+
+    // The batch output must be the same as joining the itoa() results.
+    std::vector<char> batch_buf(jstd::itoa_batch_max_size<uint64_t>(values.size()));
+    std::size_t batch_len = jstd::itoa_batch(&values[0], values.size(), &batch_buf[0], '\n');
+    ref.clear();
+    for (std::size_t i = 0; i < values.size(); i++) {
+        if (i != 0)
+            ref.push_back('\n');
+        jstd::itoa(ref, values[i]);
+    }
+    if (ref.size() != batch_len || std::memcmp(ref.c_str(), &batch_buf[0], batch_len) != 0) {
+        printf("itoa_batch() error: the output is different.\n");
+        errors++;
+    }
+
+    printf("\n");
+    printf("itoa_simd_test(): count = %" PRIuPTR "\n\n", values.size());
+    printf("itoa_simd errors: %" PRIuPTR "\n", errors);
+    printf("\n");
+    printf("result: %s\n\n", (errors == 0) ? "Passed" : "Failed");
+}
+
+void from_chars_test()
+{
+#ifdef NDEBUG
+    static const std::size_t kTestCount = 2000000;
+    static const uint32_t kFloatStep = 251;
+#else
+    static const std::size_t kTestCount = 20000;
+    static const uint32_t kFloatStep = 65521;
+#endif
+
+    jstd::MtRandomGen64 mtRandomGen64(20200831);
+
+    char buf[jstd::kMaxDtoaSize + 1];
+    std::string str;
+    jstd::formatter fmt;
+    std::size_t int_errors = 0, double_errors = 0, float_errors = 0, error_errors = 0;
+
+    // All the int16 values, and the random int32/int64/uint64 values, formatted by the formatter.
+    for (int32_t n = INT16_MIN; n <= INT16_MAX; n++) {
+        str.clear();
+        fmt.sprintf(str, "%d", n);
+        int32_t value = 0;
+        jstd::from_chars_result result = jstd::from_chars(jstd::string_view(str.c_str(), str.size()), value);
+        if (result.ec != std::errc() || result.ptr != (str.c_str() + str.size()) || value != n) {
+            if (int_errors < 10)
+                printf("from_chars(int32_t) error: \"%s\"\n", str.c_str());
+            int_errors++;
+        }
+    }
+
+    for (std::size_t i = 0; i < kTestCount; i++) {
+        uint64_t u64 = jstd::MtRandomGen64::nextUInt64();
+        u64 >>= (u64 % 64);
+        int64_t i64 = static_cast<int64_t>(jstd::MtRandomGen64::nextUInt64()) >> (u64 % 64);
+        int32_t i32 = static_cast<int32_t>(i64);
+
+        str.clear();
+        jstd::itoa(str, u64);
+        str.push_back(',');
+        jstd::itoa(str, i64);
+        str.push_back(',');
+        jstd::itoa(str, i32);
+
+        uint64_t u64_value = 0;
+        int64_t i64_value = 0;
+        int32_t i32_value = 0;
+        const char * last = str.c_str() + str.size();
+        jstd::from_chars_result result1 = jstd::from_chars(str.c_str(), last, u64_value);
+        jstd::from_chars_result result2 = jstd::from_chars(result1.ptr + 1, last, i64_value);
+        jstd::from_chars_result result3 = jstd::from_chars(result2.ptr + 1, last, i32_value);
+        if (result1.ec != std::errc() || result2.ec != std::errc() || result3.ec != std::errc() ||
+            result3.ptr != last || u64_value != u64 || i64_value != i64 || i32_value != i32) {
+            if (int_errors < 10)
+                printf("from_chars(integer) error: \"%s\"\n", str.c_str());
+            int_errors++;
+        }
+    }
+
+    // The doubles formatted by dtoa() and fmt.sprintf("%g") must round-trip.
+    for (std::size_t i = 0; i < kTestCount; i++) {
+        uint64_t bits = jstd::MtRandomGen64::nextUInt64();
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        if (std::isnan(value))
+            continue;
+
+        std::size_t len = jstd::dtoa(value, buf);
+        double result = 0.0;
+        jstd::from_chars(buf, buf + len, result);
+        if (std::memcmp(&result, &value, sizeof(value)) != 0) {
+            if (double_errors < 10)
+                printf("from_chars(double) error: \"%.*s\", expect: %.17g\n", (int)len, buf, value);
+            double_errors++;
+        }
+
+        str.clear();
+        fmt.sprintf(str, "%g", value);
+        result = 0.0;
+        jstd::from_chars(jstd::string_view(str.c_str(), str.size()), result);
+        if (std::memcmp(&result, &value, sizeof(value)) != 0) {
+            if (double_errors < 10)
+                printf("from_chars(double) error: \"%s\", expect: %.17g\n", str.c_str(), value);
+            double_errors++;
+        }
+    }
+
+    // The floats are tested in the steps of kFloatStep bit patterns.
+    for (uint64_t bits = 0; bits <= UINT32_MAX; bits += kFloatStep) {
+        uint32_t bits32 = static_cast<uint32_t>(bits);
+        float value;
+        std::memcpy(&value, &bits32, sizeof(value));
+        if (std::isnan(value))
+            continue;
+
+        std::size_t len = jstd::ftoa(value, buf);
+        float result = 0.0f;
+        jstd::from_chars(buf, buf + len, result);
+        if (std::memcmp(&result, &value, sizeof(value)) != 0) {
+            if (float_errors < 10)
+                printf("from_chars(float) error: \"%.*s\", expect: %.9g\n", (int)len, buf, value);
+            float_errors++;
+        }
+    }
+
+    // More than 19 digits near the halfway point of two doubles: exactly halfway,
+    // a little above (beyond the 769 kept digits) and a little below it, and the
+    // random long digits. The slow path must be the same as strtod().
+    std::size_t halfway_errors = 0;
+    if (std::numeric_limits<long double>::digits >= 64) {
+        char halfway[1024];
+        for (std::size_t i = 0; i < kTestCount / 100; i++) {
+            uint64_t bits = jstd::MtRandomGen64::nextUInt64() & 0x7FFFFFFFFFFFFFFEULL;
+            if ((i & 3) == 0)
+                bits &= 0x000FFFFFFFFFFFFEULL;
+            double value;
+            std::memcpy(&value, &bits, sizeof(value));
+            double next = std::nextafter(value, std::numeric_limits<double>::infinity());
+            if (std::isnan(value) || std::isinf(next))
+                continue;
+
+            // The halfway point is exact in the 64 bits mantissa of long double.
+            long double half = (static_cast<long double>(value) + static_cast<long double>(next)) / 2;
+            int len = snprintf(halfway, sizeof(halfway), "%.800Le", half);
+            char * e_pos = std::strchr(halfway, 'e');
+            assert(len > 0 && e_pos != nullptr);
+            std::string exact(halfway);
+            std::string above(exact);
+            above[e_pos - halfway - 10] = '1';
+            std::string below(exact);
+            for (std::ptrdiff_t n = e_pos - halfway - 1; n >= 0; n--) {
+                if (below[n] == '.')
+                    continue;
+                if (below[n] != '0') {
+                    below[n]--;
+                    break;
+                }
+                below[n] = '9';
+            }
+
+            std::string random_digits;
+            std::size_t digits = 20 + jstd::MtRandomGen64::nextUInt32() % 40;
+            for (std::size_t n = 0; n < digits; n++) {
+                random_digits.push_back(static_cast<char>('0' + jstd::MtRandomGen64::nextUInt32() % 10));
+            }
+            random_digits[0] = (random_digits[0] == '0') ? '1' : random_digits[0];
+            random_digits.insert(1 + jstd::MtRandomGen64::nextUInt32() % digits, 1, '.');
+            random_digits += "e" + std::to_string(static_cast<int>(jstd::MtRandomGen64::nextUInt32() % 660) - 340);
+
+            const std::string * inputs[] = { &exact, &above, &below, &random_digits };
+            for (std::size_t n = 0; n < sizeof(inputs) / sizeof(inputs[0]); n++) {
+                const std::string & input = *inputs[n];
+                double expect = std::strtod(input.c_str(), nullptr);
+                if (std::isinf(expect) || expect == 0.0)
+                    continue;
+                double result = 0.0;
+                jstd::from_chars_result ret = jstd::from_chars(jstd::string_view(input.c_str(), input.size()), result);
+                bool is_ok = (ret.ptr == input.c_str() + input.size()) &&
+                             (std::memcmp(&result, &expect, sizeof(result)) == 0);
+                if (!is_ok) {
+                    if (halfway_errors < 10)
+                        printf("from_chars(double) halfway error: \"%.60s...\", result: %.17g, expect: %.17g\n",
+                               input.c_str(), result, expect);
+                    halfway_errors++;
+                }
+            }
+        }
+    }
+
+    // The errors and the end position.
+    {
+        int32_t i32 = 7;
+        uint64_t u64 = 7;
+        double d = 7.0;
+        jstd::string_view sv1("2147483648");
+        jstd::string_view sv2("-1");
+        jstd::string_view sv3("1e400");
+        jstd::string_view sv4("1.5e+x");
+        jstd::string_view sv5(".e1");
+        jstd::from_chars_result result1 = jstd::from_chars(sv1, i32);
+        jstd::from_chars_result result2 = jstd::from_chars(sv2, u64);
+        jstd::from_chars_result result3 = jstd::from_chars(sv3, d);
+        jstd::from_chars_result result4 = jstd::from_chars(sv4, d);
+        jstd::from_chars_result result5 = jstd::from_chars(sv5, d);
+        if (result1.ec != std::errc::result_out_of_range || i32 != 7 ||
+            result2.ec != std::errc::invalid_argument || u64 != 7 ||
+            result3.ec != std::errc::result_out_of_range ||
+            result4.ec != std::errc() || result4.ptr != (sv4.data() + 3) || d != 1.5 ||
+            result5.ec != std::errc::invalid_argument || result5.ptr != sv5.data()) {
+            error_errors++;
+        }
+    }
+
+    printf("\n");
+    printf("from_chars_test(): count = %" PRIuPTR "\n\n", kTestCount);
+    printf("from_chars(integer) round-trip errors: %" PRIuPTR "\n", int_errors);
+    printf("from_chars(double)  round-trip errors: %" PRIuPTR "\n", double_errors);
+    printf("from_chars(float)   round-trip errors: %" PRIuPTR "\n", float_errors);
+    printf("from_chars(double)  halfway    errors: %" PRIuPTR "\n", halfway_errors);
+    printf("from_chars()        error code errors: %" PRIuPTR "\n", error_errors);
+    printf("\n");
+    printf("result: %s\n\n",
+           ((int_errors + double_errors + float_errors + halfway_errors + error_errors) == 0) ? "Passed" : "Failed");
+}
+
 void fnv1a_hash_test()
 {
     const char * test_str = "abcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyzabcdefghijklmnopqrstuvwxyz"
@@ -2354,19 +5451,16 @@ bool read_dict_file(const std::string & filename)
 {
     bool is_ok = false;
     try {
-        std::ifstream dict(filename.c_str());
-
-        if (dict.is_open()) {
-            std::string word;
-            while (!dict.eof()) {
-                char buf[256];
-                dict.getline(buf, sizeof(buf));
-                word = buf;
-                dict_words.push_back(word);
+        jstd::mapped_file dict;
+        if (dict.open(filename.c_str())) {
+            dict_words.reserve(jstd::line_splitter::count_lines(dict.data(), dict.size()));
+            jstd::line_splitter splitter(dict.data(), dict.size());
+            jstd::string_view line;
+            while (splitter.next_line(line)) {
+                if (!line.empty())
+                    dict_words.push_back(std::string(line.data(), line.size()));
             }
-
             is_ok = true;
-            dict.close();
         }
     }
     catch (const std::exception & ex) {
@@ -2390,8 +5484,25 @@ int main(int argc, char * argv[])
     }
 
     if (1) string_view_test();
+    if (1) string_view_find_test();
+    if (1) string_utils_compare_test();
+    if (1) line_splitter_test();
+    if (1) flat_string_view_array_test();
+    if (1) utf_convert_test();
+    if (1) rdtsc_stopwatch_test();
+    if (1) latency_histogram_test();
+    if (1) workload_test();
+    if (1) random_engine_test();
+    if (1) thread_bench_test();
+    if (1) hash_aggregator_test();
+    if (1) cpu_frequency_test();
     if (0) shiftable_ptr_test();
     if (0) formatter_test();
+    if (1) precompiled_format_test();
+    if (1) format_to_test();
+    if (1) dtoa_test();
+    if (1) itoa_simd_test();
+    if (1) from_chars_test();
     if (1) fnv1a_hash_test();
     if (1) realloc_test();
 #ifdef _MSC_VER
@@ -2400,7 +5511,14 @@ int main(int argc, char * argv[])
     if (1) jm_aligned_realloc_test();
 
     if (0) formatter_benchmark();
+    if (0) from_chars_benchmark();
+    if (0) string_view_find_benchmark();
+    if (0) string_utils_compare_benchmark();
+    if (0) string_view_array_benchmark();
+    if (0) line_splitter_benchmark();
+    if (0) utf_convert_benchmark();
     if (1) hashtable_uinttest();
+    if (1) dictionary_node_handle_test();
     if (1) hashtable_benchmark();
 
     printf("sizeof(long double) = %u\n\n", (uint32_t)sizeof(long double));
@@ -88,7 +88,11 @@
 #include <jstd/system/RandomGen.h>
 #include <jstd/test/StopWatch.h>
 #include <jstd/test/CPUWarmUp.h>
-#include <jstd/test/ProcessMemInfo.h>
+#include <jstd/test/MemoryTracker.h>
+#include <jstd/test/BenchmarkRunner.h>
+#include <jstd/test/BenchmarkReport.h>
+#include <jstd/test/LatencyHistogram.h>
+#include <jstd/test/Workload.h>
 
 #include "BenchmarkResult.h"
 
@@ -162,6 +166,8 @@ static const std::size_t kDefaultIters = 10000;
 
 static const std::size_t kInitCapacity = 8;
 
+static jtest::BenchmarkRunner s_runner;
+
 // Returns the number of hashes that have been done since the last
 // call to NumHashesSinceLastCall().  This is shared across all
 // HashObject instances, which isn't super-OO, but avoids two issues:
@@ -187,12 +193,6 @@ static void reset_counter()
 #endif
 }
 
-static inline
-size_t CurrentMemoryUsage()
-{
-    return jtest::GetCurrentMemoryUsage();
-}
-
 namespace test {
 
 template <typename T>
@@ -688,40 +688,50 @@ void print_test_time(std::size_t checksum, double elapsedTime)
     printf("sum = %-10" PRIuPTR "  time: %8.3f ms\n", checksum, elapsedTime);
 }
 
-static void report_result(char const * title, double ut, std::size_t iters,
-                          size_t start_memory, size_t end_memory) {
-    // Construct heap growth report text if applicable
-    char heap[128] = "";
-    if (end_memory > start_memory) {
-        snprintf(heap, sizeof(heap), "%7.1f MB",
-                 (end_memory - start_memory) / 1048576.0);
-    }
-
-#if (USE_STAT_COUNTER == 0)
-    printf("%-25s %8.2f ns  %s\n", title, (ut * 1000000000.0 / iters), heap);
-#else
+typedef void (*time_map_func_t)(jtest::BenchmarkState & state, std::size_t iters);
+
+//
+// One pass of iters operations is one iteration, the counters are the counts
+// of the last measured pass.
+//
+static void run_map_case(const std::string & prefix, char const * title,
+                         std::size_t iters, time_map_func_t time_map_func) {
+    const jtest::BenchmarkStats * stats =
+        s_runner.run(prefix + title, [&](jtest::BenchmarkState & state) {
+            time_map_func(state, iters);
+        }, 1);
+
+#if (USE_STAT_COUNTER != 0)
+    if (stats != nullptr) {
   #if USE_CTOR_COUNTER
-    printf("%-25s %8.2f ns  (%8" PRIuPTR " hashes, %8" PRIuPTR " copies, %8" PRIuPTR " ctor) %s\n",
-           title, (ut * 1000000000.0 / iters),
-           g_num_hashes, g_num_copies, g_num_constructor,
-           heap);
+        printf(" %-60s %8" PRIuPTR " hashes, %8" PRIuPTR " copies, %8" PRIuPTR " ctor\n",
+               "", g_num_hashes, g_num_copies, g_num_constructor);
   #else
-    printf("%-25s %8.2f ns  (%8" PRIuPTR " hashes, %8" PRIuPTR " copies) %s\n",
-           title, (ut * 1000000000.0 / iters),
-           g_num_hashes, g_num_copies,
-           heap);
+        printf(" %-60s %8" PRIuPTR " hashes, %8" PRIuPTR " copies\n",
+               "", g_num_hashes, g_num_copies);
   #endif
+        ::fflush(stdout);
+    }
+#else
+    JSTD_UNUSED_VAR(stats);
 #endif
+}
+
+static void report_memory(char const * title, const jstd::allocation_stats & stats,
+                          std::size_t entries) {
+    printf("%-25s %8.2f bytes/entry  (live: %9" PRIuPTR " bytes, peak: %9" PRIuPTR " bytes, "
+           "%" PRIuPTR " allocs)\n",
+           title, stats.bytes_per_entry(entries), stats.live_bytes.load(), stats.peak_bytes.load(),
+           stats.alloc_count.load());
     ::fflush(stdout);
 }
 
 template <class MapType, class Vector>
-static void time_map_find(char const * title, std::size_t iters,
+static void time_map_find(jtest::BenchmarkState & state, std::size_t iters,
                           const Vector & indices) {
     typedef typename MapType::mapped_type mapped_type;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
     std::size_t r;
     mapped_type i;
     mapped_type max_iters = static_cast<mapped_type>(iters);
@@ -732,19 +742,18 @@ static void time_map_find(char const * title, std::size_t iters,
 
     r = 1;
     reset_counter();
-    sw.start();
-    for (i = 0; i < max_iters; i++) {
-        r ^= static_cast<std::size_t>(hashmap.find(indices[i]) != hashmap.end());
+    while (state.keep_running()) {
+        for (i = 0; i < max_iters; i++) {
+            r ^= static_cast<std::size_t>(hashmap.find(indices[i]) != hashmap.end());
+        }
     }
-    sw.stop();
-    double ut = sw.getElapsedSecond();
 
-    ::srand(static_cast<unsigned int>(r));   // keep compiler from optimizing away r (we never call rand())
-    report_result(title, ut, iters, 0, 0);
+    jtest::DoNotOptimize(r);
+    state.set_items_per_iteration(iters);
 }
 
 template <class MapType>
-static void time_map_find_sequential(std::size_t iters) {
+static void time_map_find_sequential(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     mapped_type max_iters = static_cast<mapped_type>(iters);
@@ -753,11 +762,11 @@ static void time_map_find_sequential(std::size_t iters) {
         v[i] = i + 1;
     }
 
-    time_map_find<MapType>("map_find_sequential", iters, v);
+    time_map_find<MapType>(state, iters, v);
 }
 
 template <class MapType>
-static void time_map_find_random(std::size_t iters) {
+static void time_map_find_random(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     mapped_type max_iters = static_cast<mapped_type>(iters);
@@ -768,15 +777,14 @@ static void time_map_find_random(std::size_t iters) {
 
     shuffle_vector(v);
 
-    time_map_find<MapType>("map_find_random", iters, v);
+    time_map_find<MapType>(state, iters, v);
 }
 
 template <class MapType>
-static void time_map_find_failed(std::size_t iters) {
+static void time_map_find_failed(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
     std::size_t r;
     mapped_type i;
     mapped_type max_iters = static_cast<mapped_type>(iters);
@@ -787,338 +795,384 @@ static void time_map_find_failed(std::size_t iters) {
 
     r = 1;
     reset_counter();
-    sw.start();
-    for (i = max_iters; i < max_iters * 2; i++) {
-        r ^= static_cast<std::size_t>(hashmap.find(i) != hashmap.end());
+    while (state.keep_running()) {
+        for (i = max_iters; i < max_iters * 2; i++) {
+            r ^= static_cast<std::size_t>(hashmap.find(i) != hashmap.end());
+        }
     }
-    sw.stop();
-    double ut = sw.getElapsedSecond();
 
-    ::srand(static_cast<unsigned int>(r));   // keep compiler from optimizing away r (we never call rand())
-    report_result("map_find_failed", ut, iters, 0, 0);
+    jtest::DoNotOptimize(r);
+    state.set_items_per_iteration(iters);
 }
 
 template <class MapType>
-static void time_map_find_empty(std::size_t iters) {
+static void time_map_find_empty(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
     std::size_t r;
     mapped_type i;
     mapped_type max_iters = static_cast<mapped_type>(iters);
 
     r = 1;
     reset_counter();
-    sw.start();
-    for (i = 0; i < max_iters; i++) {
-        r ^= static_cast<std::size_t>(hashmap.find(i) != hashmap.end());
+    while (state.keep_running()) {
+        for (i = 0; i < max_iters; i++) {
+            r ^= static_cast<std::size_t>(hashmap.find(i) != hashmap.end());
+        }
     }
-    sw.stop();
-    double ut = sw.getElapsedSecond();
 
-    ::srand(static_cast<unsigned int>(r));   // keep compiler from optimizing away r (we never call rand())
-    report_result("map_find_empty", ut, iters, 0, 0);
+    jtest::DoNotOptimize(r);
+    state.set_items_per_iteration(iters);
 }
 
 template <class MapType>
-static void time_map_insert(std::size_t iters) {
+static void time_map_insert(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
 
     mapped_type max_iters = static_cast<mapped_type>(iters);
-    const std::size_t start = CurrentMemoryUsage();
 
     reset_counter();
-    sw.start();
-    for (mapped_type i = 0; i < max_iters; i++) {
-        hashmap.insert(std::make_pair(i, i + 1));
+    while (state.keep_running()) {
+        for (mapped_type i = 0; i < max_iters; i++) {
+            hashmap.insert(std::make_pair(i, i + 1));
+        }
     }
-    sw.stop();
 
-    double ut = sw.getElapsedSecond();
-    const std::size_t finish = CurrentMemoryUsage();
-    report_result("map_insert", ut, iters, start, finish);
+    state.set_items_per_iteration(iters);
 }
 
 template <class MapType>
-static void time_map_insert_predicted(std::size_t iters) {
+static void time_map_insert_predicted(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
 
     mapped_type max_iters = static_cast<mapped_type>(iters);
-    const std::size_t start = CurrentMemoryUsage();
 
     hashmap.rehash(max_iters);
 
     reset_counter();
-    sw.start();
-    for (mapped_type i = 0; i < max_iters; i++) {
-        hashmap.insert(std::make_pair(i, i + 1));
+    while (state.keep_running()) {
+        for (mapped_type i = 0; i < max_iters; i++) {
+            hashmap.insert(std::make_pair(i, i + 1));
+        }
     }
-    sw.stop();
 
-    double ut = sw.getElapsedSecond();
-    const std::size_t finish = CurrentMemoryUsage();
-    report_result("map_insert_predicted", ut, iters, start, finish);
+    state.set_items_per_iteration(iters);
 }
 
 template <class MapType>
-static void time_map_insert_replace(std::size_t iters) {
+static void time_map_insert_replace(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
 
     mapped_type max_iters = static_cast<mapped_type>(iters);
     for (mapped_type i = 0; i < max_iters; i++) {
         hashmap.insert(std::make_pair(i, i + 1));
     }
 
-    const std::size_t start = CurrentMemoryUsage();
-
     reset_counter();
-    sw.start();
-    for (mapped_type i = 0; i < max_iters; i++) {
-        hashmap.insert(std::make_pair(i, i + 2));
+    while (state.keep_running()) {
+        for (mapped_type i = 0; i < max_iters; i++) {
+            hashmap.insert(std::make_pair(i, i + 2));
+        }
     }
-    sw.stop();
 
-    double ut = sw.getElapsedSecond();
-    const std::size_t finish = CurrentMemoryUsage();
-    report_result("map_insert_replace", ut, iters, start, finish);
+    state.set_items_per_iteration(iters);
 }
 
 template <class MapType>
-static void time_map_emplace(std::size_t iters) {
+static void time_map_emplace(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
 
     mapped_type max_iters = static_cast<mapped_type>(iters);
-    const std::size_t start = CurrentMemoryUsage();
 
     reset_counter();
-    sw.start();
-    for (mapped_type i = 0; i < max_iters; i++) {
-        hashmap.emplace(i, i + 1);
+    while (state.keep_running()) {
+        for (mapped_type i = 0; i < max_iters; i++) {
+            hashmap.emplace(i, i + 1);
+        }
     }
-    sw.stop();
 
-    double ut = sw.getElapsedSecond();
-    const std::size_t finish = CurrentMemoryUsage();
-    report_result("map_emplace", ut, iters, start, finish);
+    state.set_items_per_iteration(iters);
 }
 
 template <class MapType>
-static void time_map_emplace_predicted(std::size_t iters) {
+static void time_map_emplace_predicted(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
 
     mapped_type max_iters = static_cast<mapped_type>(iters);
-    const std::size_t start = CurrentMemoryUsage();
 
     hashmap.rehash(iters);
 
     reset_counter();
-    sw.start();
-    for (mapped_type i = 0; i < max_iters; i++) {
-        hashmap.emplace(i, i + 1);
+    while (state.keep_running()) {
+        for (mapped_type i = 0; i < max_iters; i++) {
+            hashmap.emplace(i, i + 1);
+        }
     }
-    sw.stop();
 
-    double ut = sw.getElapsedSecond();
-    const std::size_t finish = CurrentMemoryUsage();
-    report_result("map_emplace_predicted", ut, iters, start, finish);
+    state.set_items_per_iteration(iters);
 }
 
 template <class MapType>
-static void time_map_emplace_replace(std::size_t iters) {
+static void time_map_emplace_replace(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
 
     mapped_type max_iters = static_cast<mapped_type>(iters);
     for (mapped_type i = 0; i < max_iters; i++) {
         hashmap.emplace(i, i + 1);
     }
 
-    const std::size_t start = CurrentMemoryUsage();
-
     reset_counter();
-    sw.start();
-    for (mapped_type i = 0; i < max_iters; i++) {
-        hashmap.emplace(i, i + 2);
+    while (state.keep_running()) {
+        for (mapped_type i = 0; i < max_iters; i++) {
+            hashmap.emplace(i, i + 2);
+        }
     }
-    sw.stop();
 
-    double ut = sw.getElapsedSecond();
-    const std::size_t finish = CurrentMemoryUsage();
-    report_result("map_emplace_replace", ut, iters, start, finish);
+    state.set_items_per_iteration(iters);
 }
 
 template <class MapType>
-static void time_map_operator_at(std::size_t iters) {
+static void time_map_operator_at(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
 
     mapped_type max_iters = static_cast<mapped_type>(iters);
-    const std::size_t start = CurrentMemoryUsage();
 
     reset_counter();
-    sw.start();
-    for (mapped_type i = 0; i < max_iters; i++) {
-        hashmap[i] = i + 1;
+    while (state.keep_running()) {
+        for (mapped_type i = 0; i < max_iters; i++) {
+            hashmap[i] = i + 1;
+        }
     }
-    sw.stop();
 
-    double ut = sw.getElapsedSecond();
-    const std::size_t finish = CurrentMemoryUsage();
-    report_result("map_operator []", ut, iters, start, finish);
+    state.set_items_per_iteration(iters);
 }
 
 template <class MapType>
-static void time_map_operator_at_predicted(std::size_t iters) {
+static void time_map_operator_at_predicted(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
 
     mapped_type max_iters = static_cast<mapped_type>(iters);
-    const std::size_t start = CurrentMemoryUsage();
 
     hashmap.rehash(max_iters);
 
     reset_counter();
-    sw.start();
-    for (mapped_type i = 0; i < max_iters; i++) {
-        hashmap[i] = i + 1;
+    while (state.keep_running()) {
+        for (mapped_type i = 0; i < max_iters; i++) {
+            hashmap[i] = i + 1;
+        }
     }
-    sw.stop();
 
-    double ut = sw.getElapsedSecond();
-    const std::size_t finish = CurrentMemoryUsage();
-    report_result("map_operator_predicted []", ut, iters, start, finish);
+    state.set_items_per_iteration(iters);
 }
 
 template <class MapType>
-static void time_map_operator_at_replace(std::size_t iters) {
+static void time_map_operator_at_replace(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
 
     mapped_type max_iters = static_cast<mapped_type>(iters);
     for (mapped_type i = 0; i < max_iters; i++) {
         hashmap[i] = i + 1;
     }
 
-    const std::size_t start = CurrentMemoryUsage();
-
     reset_counter();
-    sw.start();
-    for (mapped_type i = 0; i < max_iters; i++) {
-        hashmap[i] = i + 2;
+    while (state.keep_running()) {
+        for (mapped_type i = 0; i < max_iters; i++) {
+            hashmap[i] = i + 2;
+        }
     }
-    sw.stop();
 
-    double ut = sw.getElapsedSecond();
-    const std::size_t finish = CurrentMemoryUsage();
-    report_result("map_operator_replace []", ut, iters, start, finish);
+    state.set_items_per_iteration(iters);
 }
 
 template <class MapType>
-static void time_map_erase(std::size_t iters) {
+static void time_map_erase(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
 
     mapped_type max_iters = static_cast<mapped_type>(iters);
     for (mapped_type i = 0; i < max_iters; i++) {
         hashmap.emplace(i, i + 1);
     }
 
-    const std::size_t start = CurrentMemoryUsage();
-
     reset_counter();
-    sw.start();
-    for (mapped_type i = 0; i < max_iters; i++) {
-        hashmap.erase(i);
+    while (state.keep_running()) {
+        for (mapped_type i = 0; i < max_iters; i++) {
+            hashmap.erase(i);
+        }
     }
-    sw.stop();
 
-    double ut = sw.getElapsedSecond();
-    const std::size_t finish = CurrentMemoryUsage();
-    report_result("map_erase", ut, iters, start, finish);
+    state.set_items_per_iteration(iters);
 }
 
 template <class MapType>
-static void time_map_erase_failed(std::size_t iters) {
+static void time_map_erase_failed(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
 
     mapped_type max_iters = static_cast<mapped_type>(iters);
     for (mapped_type i = 0; i < max_iters; i++) {
         hashmap.emplace(i, i + 1);
     }
 
-    const std::size_t start = CurrentMemoryUsage();
+    reset_counter();
+    while (state.keep_running()) {
+        for (mapped_type i = max_iters; i < max_iters * 2; i++) {
+            hashmap.erase(i);
+        }
+    }
+
+    state.set_items_per_iteration(iters);
+}
+
+template <class MapType>
+static void time_map_toggle(jtest::BenchmarkState & state, std::size_t iters) {
+    typedef typename MapType::mapped_type mapped_type;
+
+    MapType hashmap(kInitCapacity);
+
+    mapped_type max_iters = static_cast<mapped_type>(iters);
+
+    reset_counter();
+    while (state.keep_running()) {
+        for (mapped_type i = 0; i < max_iters; i++) {
+            hashmap.emplace(i, i + 1);
+            hashmap.erase(i);
+        }
+    }
+
+    state.set_items_per_iteration(iters);
+}
+
+//
+// The latency cases: one of every latency_sample operations is timed alone,
+// the tails (p99, p999, max) show the rehash pauses and the chunk allocations.
+//
+template <class MapType>
+static void time_map_find_latency(jtest::BenchmarkState & state, std::size_t iters) {
+    typedef typename MapType::mapped_type mapped_type;
+
+    MapType hashmap(kInitCapacity);
+    std::size_t r;
+    mapped_type i;
+    mapped_type max_iters = static_cast<mapped_type>(iters);
+
+    std::vector<mapped_type> v(iters);
+    for (i = 0; i < max_iters; i++) {
+        hashmap.emplace(i, i + 1);
+        v[i] = i;
+    }
+
+    shuffle_vector(v);
 
+    jtest::LatencySampler sampler(state.latency(), state.latency_sample_rate());
+    r = 1;
     reset_counter();
-    sw.start();
-    for (mapped_type i = max_iters; i < max_iters * 2; i++) {
-        hashmap.erase(i);
+    while (state.keep_running()) {
+        for (i = 0; i < max_iters; i++) {
+            sampler.start();
+            r ^= static_cast<std::size_t>(hashmap.find(v[i]) != hashmap.end());
+            sampler.stop();
+        }
     }
-    sw.stop();
 
-    double ut = sw.getElapsedSecond();
-    const std::size_t finish = CurrentMemoryUsage();
-    report_result("map_erase_failed", ut, iters, start, finish);
+    jtest::DoNotOptimize(r);
+    state.set_items_per_iteration(iters);
 }
 
 template <class MapType>
-static void time_map_toggle(std::size_t iters) {
+static void time_map_insert_latency(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type mapped_type;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
 
     mapped_type max_iters = static_cast<mapped_type>(iters);
-    const std::size_t start = CurrentMemoryUsage();
 
+    jtest::LatencySampler sampler(state.latency(), state.latency_sample_rate());
     reset_counter();
-    sw.start();
+    while (state.keep_running()) {
+        for (mapped_type i = 0; i < max_iters; i++) {
+            sampler.start();
+            hashmap.insert(std::make_pair(i, i + 1));
+            sampler.stop();
+        }
+    }
+
+    state.set_items_per_iteration(iters);
+}
+
+template <class MapType>
+static void time_map_erase_latency(jtest::BenchmarkState & state, std::size_t iters) {
+    typedef typename MapType::mapped_type mapped_type;
+
+    MapType hashmap(kInitCapacity);
+
+    mapped_type max_iters = static_cast<mapped_type>(iters);
     for (mapped_type i = 0; i < max_iters; i++) {
         hashmap.emplace(i, i + 1);
-        hashmap.erase(i);
     }
-    sw.stop();
 
-    double ut = sw.getElapsedSecond();
-    const std::size_t finish = CurrentMemoryUsage();
-    report_result("map_toggle", ut, iters, start, finish);
+    jtest::LatencySampler sampler(state.latency(), state.latency_sample_rate());
+    reset_counter();
+    while (state.keep_running()) {
+        for (mapped_type i = 0; i < max_iters; i++) {
+            sampler.start();
+            hashmap.erase(i);
+            sampler.stop();
+        }
+    }
+
+    state.set_items_per_iteration(iters);
+}
+
+template <class MapType>
+static void time_map_toggle_latency(jtest::BenchmarkState & state, std::size_t iters) {
+    typedef typename MapType::mapped_type mapped_type;
+
+    MapType hashmap(kInitCapacity);
+
+    mapped_type max_iters = static_cast<mapped_type>(iters);
+
+    jtest::LatencySampler sampler(state.latency(), state.latency_sample_rate());
+    reset_counter();
+    while (state.keep_running()) {
+        for (mapped_type i = 0; i < max_iters; i++) {
+            sampler.start();
+            hashmap.emplace(i, i + 1);
+            hashmap.erase(i);
+            sampler.stop();
+        }
+    }
+
+    state.set_items_per_iteration(iters);
 }
 
 template <class MapType>
-static void time_map_iterate(std::size_t iters) {
+static void time_map_iterate(jtest::BenchmarkState & state, std::size_t iters) {
     typedef typename MapType::mapped_type       mapped_type;
     typedef typename MapType::const_iterator    const_iterator;
 
     MapType hashmap(kInitCapacity);
-    jtest::StopWatch sw;
     mapped_type r;
 
     mapped_type max_iters = static_cast<mapped_type>(iters);
@@ -1126,71 +1180,152 @@ static void time_map_iterate(std::size_t iters) {
         hashmap.emplace(i, i + 1);
     }
 
-    const std::size_t start = CurrentMemoryUsage();
-
     r = 1;
     reset_counter();
-    sw.start();
-    for (const_iterator it = hashmap.begin(), it_end = hashmap.end(); it != it_end; ++it) {
-        r ^= it->second;
+    while (state.keep_running()) {
+        for (const_iterator it = hashmap.begin(), it_end = hashmap.end(); it != it_end; ++it) {
+            r ^= it->second;
+        }
+    }
+
+    jtest::DoNotOptimize(r);
+    state.set_items_per_iteration(iters);
+}
+
+//
+// The keys [0, records) are loaded (not timed), then the operations of
+// the workload are one iteration.
+//
+template <class MapType>
+static void time_map_workload(jtest::BenchmarkState & state, const jtest::Workload & workload) {
+    typedef typename MapType::mapped_type mapped_type;
+
+    MapType hashmap(kInitCapacity);
+
+    mapped_type records = static_cast<mapped_type>(workload.records());
+    for (mapped_type i = 0; i < records; i++) {
+        hashmap.emplace(i, i + 1);
+    }
+
+    std::size_t found = 0;
+    reset_counter();
+    while (state.keep_running()) {
+        found += workload.run<MapType, mapped_type>(hashmap);
+    }
+
+    jtest::DoNotOptimize(found);
+    state.set_items_per_iteration(workload.size());
+}
+
+//
+// The YCSB core workloads A ~ F, every container runs the same operations.
+//
+template <class MapType>
+static void run_workload_cases(const std::string & prefix, std::size_t iters) {
+    static const char kWorkloads[] = { 'A', 'B', 'C', 'D', 'E', 'F' };
+
+    for (std::size_t i = 0; i < sizeof(kWorkloads) / sizeof(kWorkloads[0]); i++) {
+        jtest::Workload workload(jtest::WorkloadSpec::ycsb(kWorkloads[i]));
+        std::string name = prefix + "map_" + workload.name();
+        if (!s_runner.is_selected(name))
+            continue;
+        if (!s_runner.options().list_only)
+            workload.generate(iters, iters, 20200831);
+
+        s_runner.set_label("workload", workload.name());
+        s_runner.set_label("distribution", jtest::get_distribution_name(workload.spec().distribution));
+        const jtest::BenchmarkStats * stats =
+            s_runner.run(name, [&](jtest::BenchmarkState & state) {
+                time_map_workload<MapType>(state, workload);
+            }, 1);
+        if (stats != nullptr && stats->median > 0.0) {
+            printf(" %-60s throughput: %0.3f Mops/s\n", "", 1000.0 / stats->median);
+            ::fflush(stdout);
+        }
     }
-    sw.stop();
 
-    double ut = sw.getElapsedSecond();
-    const std::size_t finish = CurrentMemoryUsage();
-    ::srand(static_cast<unsigned int>(r));   // keep compiler from optimizing away r (we never call rand())
-    report_result("map_iterate", ut, iters, start, finish);
+    s_runner.erase_label("workload");
+    s_runner.erase_label("distribution");
+}
+
+template <class MapType>
+static void time_map_memory(char const * title, std::size_t iters, bool is_predicted) {
+    typedef typename jtest::TrackedContainer<MapType>::type TrackedMapType;
+    typedef typename TrackedMapType::mapped_type            mapped_type;
+
+    if (!jtest::TrackedContainer<MapType>::is_tracked) {
+        printf("%-25s %8s\n", title, "n/a");
+        return;
+    }
+
+    jstd::allocation_stats stats;
+    {
+        jstd::allocation_tracking_scope scope(stats);
+        TrackedMapType hashmap(kInitCapacity);
+
+        mapped_type max_iters = static_cast<mapped_type>(iters);
+        if (is_predicted) {
+            hashmap.rehash(max_iters);
+        }
+        for (mapped_type i = 0; i < max_iters; i++) {
+            hashmap.emplace(i, i + 1);
+        }
+
+        report_memory(title, stats, hashmap.size());
+    }
 }
 
 template <class MapType>
-static void stress_hash_function(std::size_t desired_insertions,
+static void stress_hash_function(const std::string & prefix,
+                                 std::size_t desired_insertions,
                                  std::size_t map_size,
                                  std::size_t stride) {
-    jtest::StopWatch sw;
-    std::uint32_t num_insertions = 0;
-    // One measurement of user time (in seconds) is done for each iteration of
-    // the outer loop.  The times are summed.
-    double total_seconds = 0;
+    // One iteration is one refill of the map, the clear() and rehash() are not timed.
     const std::size_t k = desired_insertions / map_size;
+    if (k == 0)
+        return;
+
+    const std::size_t maxint = (1ull << (sizeof(uint32_t) * 8 - 1)) - 1;
+    // Use n arithmetic sequences.  Using just one may lead to overflow
+    // if stride * map_size > maxint.  Compute n by requiring
+    // stride * map_size/n < maxint, i.e., map_size/(maxint/stride) < n
+    const std::size_t n = map_size / (maxint / stride) + 1;
+
+    std::string name = prefix + "stress_hash_function/map_size=" + std::to_string(map_size)
+                     + "/stride=" + std::to_string(stride);
 
     MapType hashmap;
-    for (std::size_t o = 0; o < k; o++) {
-        hashmap.clear();
-        hashmap.rehash(map_size);
-        sw.start();
-        const std::size_t maxint = (1ull << (sizeof(uint32_t) * 8 - 1)) - 1;
-        // Use n arithmetic sequences.  Using just one may lead to overflow
-        // if stride * map_size > maxint.  Compute n by requiring
-        // stride * map_size/n < maxint, i.e., map_size/(maxint/stride) < n
-        char * key;   // something we can do math on
-        const std::size_t n = map_size / (maxint / stride) + 1;
-        for (std::size_t i = 0; i < n; i++) {
-            key = nullptr;
-            key += i;
-            for (std::size_t j = 0; j < map_size / n; j++) {
-                key += stride;
-                hashmap[reinterpret_cast<typename MapType::key_type>(key)]
-                        = ++num_insertions;
+    s_runner.run(name, [&](jtest::BenchmarkState & state) {
+        std::uint32_t num_insertions = 0;
+        while (state.keep_running()) {
+            state.pause_timing();
+            hashmap.clear();
+            hashmap.rehash(map_size);
+            state.resume_timing();
+
+            char * key;   // something we can do math on
+            for (std::size_t i = 0; i < n; i++) {
+                key = nullptr;
+                key += i;
+                for (std::size_t j = 0; j < map_size / n; j++) {
+                    key += stride;
+                    hashmap[reinterpret_cast<typename MapType::key_type>(key)]
+                            = ++num_insertions;
+                }
             }
         }
-        sw.stop();
-        total_seconds += sw.getElapsedSecond();
-    }
-
-    if (num_insertions != 0) {
-        printf("stress_hash_function: map_size = %-4" PRIuPTR " stride = %-4" PRIuPTR ": %.2f ns/insertion\n",
-               map_size, stride, total_seconds * 1e9 / num_insertions);
-    }
+        state.set_items_per_iteration((map_size / n) * n);
+    }, k);
 }
 
 template <class MapType>
-static void stress_hash_function(std::size_t num_inserts) {
+static void stress_hash_function(const std::string & prefix, std::size_t num_inserts) {
     static const std::size_t kMapSizes [] = { 256, 1024 };
     std::size_t len = sizeof(kMapSizes) / sizeof(kMapSizes[0]);
     for (std::size_t i = 0; i < len; i++) {
         const std::size_t map_size = kMapSizes[i];
         for (std::size_t stride = 1; stride <= map_size; stride *= map_size) {
-            stress_hash_function<MapType>(num_inserts, map_size, stride);
+            stress_hash_function<MapType>(prefix, num_inserts, map_size, stride);
         }
     }
 }
@@ -1208,40 +1343,62 @@ static void measure_hashmap(const char * name, std::size_t obj_size, std::size_t
     }
     if (1) printf("\n");
 
-    if (1) time_map_find_sequential<MapType>(iters);
-    if (1) time_map_find_random<MapType>(iters);
-    if (1) time_map_find_failed<MapType>(iters);
-    if (1) time_map_find_empty<MapType>(iters);
+    std::string prefix = std::string(name) + "/" + std::to_string(obj_size) + "_bytes/";
+
+    s_runner.clear_labels();
+    s_runner.set_label("container", name);
+    s_runner.set_label("key_size", obj_size);
+    s_runner.set_label("data_size", iters);
+
+    if (1) run_map_case(prefix, "map_find_sequential", iters, time_map_find_sequential<MapType>);
+    if (1) run_map_case(prefix, "map_find_random", iters, time_map_find_random<MapType>);
+    if (1) run_map_case(prefix, "map_find_failed", iters, time_map_find_failed<MapType>);
+    if (1) run_map_case(prefix, "map_find_empty", iters, time_map_find_empty<MapType>);
+    if (1) printf("\n");
+
+    if (1) run_map_case(prefix, "map_insert", iters, time_map_insert<MapType>);
+    if (1) run_map_case(prefix, "map_insert_predicted", iters, time_map_insert_predicted<MapType>);
+    if (1) run_map_case(prefix, "map_insert_replace", iters, time_map_insert_replace<MapType>);
     if (1) printf("\n");
 
-    if (1) time_map_insert<MapType>(iters);
-    if (1) time_map_insert_predicted<MapType>(iters);
-    if (1) time_map_insert_replace<MapType>(iters);
+    if (1) run_map_case(prefix, "map_emplace", iters, time_map_emplace<MapType>);
+    if (1) run_map_case(prefix, "map_emplace_predicted", iters, time_map_emplace_predicted<MapType>);
+    if (1) run_map_case(prefix, "map_emplace_replace", iters, time_map_emplace_replace<MapType>);
     if (1) printf("\n");
 
-    if (1) time_map_emplace<MapType>(iters);
-    if (1) time_map_emplace_predicted<MapType>(iters);
-    if (1) time_map_emplace_replace<MapType>(iters);
+    if (1) run_map_case(prefix, "map_operator []", iters, time_map_operator_at<MapType>);
+    if (1) run_map_case(prefix, "map_operator_predicted []", iters, time_map_operator_at_predicted<MapType>);
+    if (1) run_map_case(prefix, "map_operator_replace []", iters, time_map_operator_at_replace<MapType>);
     if (1) printf("\n");
 
-    if (1) time_map_operator_at<MapType>(iters);
-    if (1) time_map_operator_at_predicted<MapType>(iters);
-    if (1) time_map_operator_at_replace<MapType>(iters);
+    if (1) run_map_case(prefix, "map_erase", iters, time_map_erase<MapType>);
+    if (1) run_map_case(prefix, "map_erase_failed", iters, time_map_erase_failed<MapType>);
+    if (1) run_map_case(prefix, "map_toggle", iters, time_map_toggle<MapType>);
+    if (1) run_map_case(prefix, "map_iterate", iters, time_map_iterate<MapType>);
     if (1) printf("\n");
 
-    if (1) time_map_erase<MapType>(iters);
-    if (1) time_map_erase_failed<MapType>(iters);
-    if (1) time_map_toggle<MapType>(iters);
-    if (1) time_map_iterate<MapType>(iters);
+    if (1) run_map_case(prefix, "map_find_latency", iters, time_map_find_latency<MapType>);
+    if (1) run_map_case(prefix, "map_insert_latency", iters, time_map_insert_latency<MapType>);
+    if (1) run_map_case(prefix, "map_erase_latency", iters, time_map_erase_latency<MapType>);
+    if (1) run_map_case(prefix, "map_toggle_latency", iters, time_map_toggle_latency<MapType>);
+    if (1) printf("\n");
 
+    if (1) run_workload_cases<MapType>(prefix, iters);
     if (1) printf("\n");
 
+    // The memory usage is not timed, but it follows the filters too.
+    if (!s_runner.options().list_only && s_runner.is_selected(prefix + "map_memory")) {
+        time_map_memory<MapType>("map_memory", iters, false);
+        time_map_memory<MapType>("map_memory_predicted", iters, true);
+        printf("\n");
+    }
+
     // This last test is useful only if the map type uses hashing.
     // And it's slow, so use fewer iterations.
     if (is_stress_hash_function) {
         // Blank line in the output makes clear that what follows isn't part of the
         // table of results that we just printed.
-        stress_hash_function<StressMapType>(iters / 4);
+        stress_hash_function<StressMapType>(prefix, iters / 4);
         printf("\n");
     }
 }
@@ -1342,13 +1499,25 @@ int main(int argc, char * argv[])
     jstd::RandomGen   RandomGen(20200831);
     jstd::MtRandomGen mtRandomGen(20200831);
 
+    // One pass of iters operations is long enough, 3 measured runs are enough.
+    s_runner.options().repetitions = 3;
+    // Count the hardware events per operation if the PMU is accessible.
+    s_runner.options().perf_counters = true;
+    if (!s_runner.parse_args(argc, argv)) {
+        return 0;
+    }
+
     std::size_t iters = kDefaultIters;
-    if (argc > 1) {
+    if (s_runner.args().size() > 0) {
         // first arg is # of iterations
-        iters = ::atoi(argv[1]);
+        iters = ::atoi(s_runner.args()[0].c_str());
     }
 
-    jtest::CPU::warm_up(1000);
+    s_runner.metadata().set("hash_func", PRINT_MACRO(HASH_MAP_FUNCTION));
+    s_runner.metadata().set("key_type", "HashObject<K, Size, HashSize>");
+    s_runner.metadata().set("iterations", iters);
+
+    s_runner.warm_up();
 
     printf("#define HASH_MAP_FUNCTION = %s\n\n", PRINT_MACRO(HASH_MAP_FUNCTION));
 
@@ -1362,6 +1531,10 @@ int main(int argc, char * argv[])
 
     printf("------------------------------------------------------------------------------------\n\n");
 
+    if (!jtest::write_reports(s_runner)) {
+        return 1;
+    }
+
     //jstd::Console::ReadKey();
     return 0;
 }